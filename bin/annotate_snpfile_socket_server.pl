@@ -5,6 +5,8 @@ use warnings;
 use Carp;
 use Getopt::Long;
 use File::Spec;
+use FindBin qw/ $Bin /;
+use POSIX qw/ :sys_wait_h /;
 
 use Pod::Usage;
 use Type::Params qw/ compile /;
@@ -20,6 +22,61 @@ use Cpanel::JSON::XS;
 use Data::Dumper;
 
 use Seq;
+use Seq::Annotate;
+
+# the assemblies' genome-sized tracks are mapped once, by a genome_server
+#   (c/bin) this server starts, and every job asks it for them rather than
+#   mapping and faulting in the tracks itself
+my ( @configs, $help );
+my $daemon  = File::Spec->catfile( $Bin, '..', 'c', 'bin', 'genome_server' );
+my $threads = 4;
+my $socket  = File::Spec->catfile( File::Spec->tmpdir, "seq_genome_server.$$.sock" );
+
+GetOptions(
+  'c|config=s'      => \@configs,
+  'genome_server=s' => \$daemon,
+  'threads=i'       => \$threads,
+  'socket=s'        => \$socket,
+  'h|help'          => \$help,
+);
+
+if ( $help || !@configs ) {
+  Pod::Usage::pod2usage(1);
+  exit;
+}
+
+my $daemon_pid = start_genome_server( $daemon, $socket, $threads, @configs );
+# the worker threads run END blocks too
+END {
+  if ( $daemon_pid && !threads->tid ) {
+    kill 'TERM', $daemon_pid and waitpid $daemon_pid, 0;
+    unlink "$socket.manifest";
+  }
+}
+
+sub start_genome_server {
+  my ( $daemon, $socket, $threads, @configs ) = @_;
+
+  my $manifest = "$socket.manifest";
+  open my $fh, '>', $manifest or die "ERROR: cannot write $manifest: $!\n";
+  for my $config (@configs) {
+    print {$fh} Seq::Annotate->new_with_config( { configfile => $config } )
+      ->genome_server_manifest;
+  }
+  close $fh;
+
+  my $pid = fork // die "ERROR: cannot fork: $!\n";
+  if ( !$pid ) {
+    exec $daemon, '--socket', $socket, '--manifest', $manifest, '--threads', $threads;
+    die "ERROR: cannot run $daemon: $!\n";
+  }
+  for ( 1 .. 600 ) {
+    return $pid if -S $socket;
+    die "ERROR: $daemon exited\n" if waitpid( $pid, WNOHANG ) == $pid;
+    select undef, undef, undef, 0.1;
+  }
+  die "ERROR: $daemon did not start\n";
+}
 
 my $semSTDOUT : shared;
 
@@ -39,20 +96,15 @@ my $done : shared = 0;
 sub coerce_inputs {
   my $userChoicesHref = shift;
 
-  my $out_file = $userChoicesHref->{o} || $userChoicesHref->{outfile} | "";
+  my $out_file = $userChoicesHref->{o} || $userChoicesHref->{outfile} || "";
   my $force    = $userChoicesHref->{f} || $userChoicesHref->{force};
-  my $db_location = $userChoicesHref->{location}
-    || $userChoicesHref->{l} | get_db_path($userChoicesHref);
   my $snpfile =
     $userChoicesHref->{s} || $userChoicesHref->{snpfile} || $userChoicesHref->{infile};
-  my $yaml_config =
-       $userChoicesHref->{c}
-    || $userChoicesHref->{config}
-    || get_yaml_config_path($userChoicesHref);
-  # my $verbose     = $userChoicesHref->{v}        || $userChoicesHref->{verbose};
-  my $debug = $userChoicesHref->{d} || $userChoicesHref->{debug};
-
-  return ( $snpfile, $yaml_config, $out_file, $debug );
+  my $yaml_config = $userChoicesHref->{c} || $userChoicesHref->{config};
+  my $verbose     = $userChoicesHref->{v} || $userChoicesHref->{verbose};
+  my $debug       = $userChoicesHref->{d} || $userChoicesHref->{debug};
+
+  return ( $snpfile, $yaml_config, $out_file, $force, $verbose, $debug );
 }
 
 sub worker {
@@ -75,11 +127,14 @@ sub worker {
 
       print Dumper( \%user_choices );
 
-      my ( $snpfile, $yaml_config, $out_file, $debug ) = coerce_inputs( \%user_choices );
+      my ( $snpfile, $yaml_config, $out_file, $force, $verbose, $debug ) =
+        coerce_inputs( \%user_choices );
       # sanity checks mostly now not needed, will be checked in Seq.pm using MooseX:Type:Path:Tiny
       if ( -f $out_file && !$force ) {
         say "ERROR: '$out_file' already exists. Use '--force' switch to over write it.";
-        exit;
+        close $client;
+        $Qdone->enqueue($fno);
+        next;
       }
 
       # get absolute path not needed anymore, handled by coercison in Seq.pm, closer to where file is actually written
@@ -98,10 +153,11 @@ sub worker {
       # create the annotator
       my $annotate_instance = Seq->new(
         {
-          snpfile    => $snpfile,
-          configfile => $yaml_config,
-          out_file   => $out_file,
-          debug      => $debug,
+          snpfile       => $snpfile,
+          config_file   => $yaml_config,
+          out_file      => $out_file,
+          debug         => $debug,
+          genome_server => $socket,
         }
       );
 
@@ -154,3 +210,23 @@ tprint "Listener closed";
 $_->join for @workers;
 
 tprint "Workers done";
+
+__END__
+
+=head1 NAME
+
+annotate_snpfile_socket_server - annotates snpfiles sent as JSON jobs on port 9003
+
+=head1 SYNOPSIS
+
+annotate_snpfile_socket_server.pl --config <assembly.yml> [--config ..]
+  [--genome_server <c/bin/genome_server>] [--threads <num>] [--socket <file>]
+
+=head1 DESCRIPTION
+
+Starts a genome_server for the genome-sized tracks of the assemblies given
+and then annotates each job sent by annotate_snpfile_socket_client.pl, a job
+at a time per worker thread, with the genome-sized tracks looked up through
+the genome_server. A job's config must be one of the assemblies given.
+
+=cut
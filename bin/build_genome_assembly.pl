@@ -19,9 +19,11 @@ my (
   $yaml_config, $build_type,        $db_location,       $verbose,
   $no_bdb,      $help,              $wanted_chr,        $force,
   $debug,       $genome_hasher_bin, $genome_scorer_bin, $genome_cadd_bin,
+  $genome_snpdb_bin, $genome_genedb_bin, $threads,
 );
 $wanted_chr = 0;
 $debug = 0;
+$threads = 1;
 # cmd to method
 my %cmd_2_method = (
   genome        => 'build_genome_index',
@@ -52,6 +54,9 @@ GetOptions(
   'cadd=s'       => \$bin_2_path{genome_cadd_bin},
   'ngene=s'      => \$bin_2_path{ngene_bin},
   'wanted_chr=s' => \$wanted_chr,
+  'snpdb=s'      => \$genome_snpdb_bin,
+  'genedb=s'     => \$genome_genedb_bin,
+  'threads=i'    => \$threads,
 );
 
 if ($help) {
@@ -91,6 +96,14 @@ for my $binary ( keys %bin_2_path ) {
   }
 }
 
+# the native snp and gene builders are optional; use them when given or built
+$genome_snpdb_bin //= $config_href->{genome_snpdb_bin} // "bin/genome_snpdb";
+$genome_snpdb_bin = path($genome_snpdb_bin)->absolute->stringify;
+undef $genome_snpdb_bin unless -f $genome_snpdb_bin;
+$genome_genedb_bin //= $config_href->{genome_genedb_bin} // "bin/genome_genedb";
+$genome_genedb_bin = path($genome_genedb_bin)->absolute->stringify;
+undef $genome_genedb_bin unless -f $genome_genedb_bin;
+
 # get absolute path for YAML file and db_location
 $yaml_config = path($yaml_config)->absolute->stringify;
 
@@ -103,6 +116,9 @@ my $builder_options_href = {
   wanted_chr    => $wanted_chr,
   force         => $force,
   debug         => $debug,
+  threads       => $threads,
+  ( $genome_snpdb_bin ? ( genome_snpdb => $genome_snpdb_bin ) : () ),
+  ( $genome_genedb_bin ? ( genome_genedb => $genome_genedb_bin ) : () ),
 };
 
 if ( $method and $config_href ) {
@@ -132,6 +148,7 @@ build_genome_assembly
   --config <file>
   --type <'genome', 'conserv', 'transcript_db', 'snp_db', 'gene_db'>
   [ --wanted_chr ]
+  [ --snpdb <genome_snpdb binary> --genedb <genome_genedb binary> --threads <num> ]
 
 =head1 DESCRIPTION
 
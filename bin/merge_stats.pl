@@ -0,0 +1,43 @@
+#!/usr/bin/env perl
+use lib './lib';
+
+use 5.10.0;
+use strict;
+use warnings;
+
+use Getopt::Long;
+use Seq::Statistics;
+
+my $out;
+GetOptions( 'o|out=s' => \$out );
+die "usage: $0 -o <out base path> <file.counts> ...\n" unless $out && @ARGV;
+
+# the counts of jobs over parts of one snpfile, each written by
+#   annotate_snpfile --store_counts, add up to those of a job over all of it
+my $stats = Seq::Statistics->new;
+for my $file (@ARGV) {
+  open my $fh, '<', $file or die "Cannot read $file: $!\n";
+  binmode $fh;
+  my $bytes = do { local $/; <$fh> };
+  close $fh;
+  $stats->mergePartial($bytes);
+}
+$stats->summarize;
+$stats->storeStats($out);
+
+=head1 NAME
+
+merge_stats.pl
+
+=head1 DESCRIPTION
+
+Merges the statistics counts of several annotation jobs, each over part of
+the sites of one cohort (e.g., a chromosome per node), summarizes them as
+annotate_snpfile would have for the whole and writes <out base path>.json.
+
+  merge_stats.pl -o cohort.annotation chr*.annotation.counts
+
+The counts are written by annotate_snpfile with --store_counts, next to the
+annotation, and need Seq::Native (c/perl).
+
+=cut
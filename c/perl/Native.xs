@@ -0,0 +1,2239 @@
+/*
+ * Name: Native.xs
+ * Description: Perl binding for libseq; see lib/Seq/Native.pm for the
+ *  perl-side documentation of each class.
+ */
+
+#define PERL_NO_GET_CONTEXT
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+#include <math.h>
+#include "seq_track.h"
+#include "seq_batch.h"
+#include "seq_sitecode.h"
+#include "seq_snpdb.h"
+#include "seq_codec.h"
+#include "seq_genedb.h"
+#include "seq_csq.h"
+#include "seq_txmap.h"
+#include "seq_generange.h"
+#include "seq_snpreader.h"
+#include "seq_genotype.h"
+#include "seq_writer.h"
+#include "seq_cost.h"
+#include "seq_stats.h"
+#include "seq_quantile.h"
+#include "seq_buf.h"
+
+/* a score as Seq::GenomeBin::get_score renders it, 'NA' or %0.3f, copied
+   from the text seq_track_set_score made of its code */
+static SV *
+score_sv( pTHX_ const SEQ_TRACK *track, int code )
+{
+  return newSVpvn( track->score_text[code], track->score_len[code] );
+}
+
+/* unwrap a Seq::Native::Track; undef gives NULL when allow_undef is set */
+static SEQ_TRACK *
+sv_to_track( pTHX_ SV *sv, const char *what, int allow_undef )
+{
+  if ( allow_undef && !SvOK(sv) )
+    return NULL;
+  if ( !sv_isobject(sv) || !sv_derived_from( sv, "Seq::Native::Track" ) )
+    croak( "%s is not a Seq::Native::Track", what );
+  return INT2PTR( SEQ_TRACK *, SvIV( (SV *)SvRV(sv) ) );
+}
+
+static AV *
+sv_to_av( pTHX_ SV *sv, const char *what )
+{
+  if ( !SvROK(sv) || SvTYPE( SvRV(sv) ) != SVt_PVAV )
+    croak( "%s is not an array reference", what );
+  return (AV *)SvRV(sv);
+}
+
+static SV *
+score_array( pTHX_ const SEQ_TRACK *track, const unsigned char *code, long n )
+{
+  AV *av = newAV();
+  av_extend( av, n - 1 );
+  for ( long i = 0; i < n; i++ )
+    av_store( av, i, score_sv( aTHX_ track, code[i] ) );
+  return newRV_noinc( (SV *)av );
+}
+
+static SV *
+int_array( pTHX_ const int *val, long n )
+{
+  AV *av = newAV();
+  av_extend( av, n - 1 );
+  for ( long i = 0; i < n; i++ )
+    av_store( av, i, val[i] < 0 ? newSV(0) : newSViv( val[i] ) );
+  return newRV_noinc( (SV *)av );
+}
+
+static HV *
+sv_to_hv( pTHX_ SV *sv, const char *what )
+{
+  if ( !SvROK(sv) || SvTYPE( SvRV(sv) ) != SVt_PVHV )
+    croak( "%s is not a hash reference", what );
+  return (HV *)SvRV(sv);
+}
+
+/* the hash under key, made when there is none */
+static HV *
+child_hv( pTHX_ HV *hv, const char *key, I32 len )
+{
+  SV **svp = hv_fetch( hv, key, len, 1 );
+  if ( !SvROK(*svp) || SvTYPE( SvRV(*svp) ) != SVt_PVHV )
+    sv_setsv( *svp, sv_2mortal( newRV_noinc( (SV *)newHV() ) ) );
+  return (HV *)SvRV(*svp);
+}
+
+static SV *
+fetch_required( pTHX_ HV *hv, const char *key )
+{
+  SV **svp = hv_fetch( hv, key, strlen(key), 0 );
+  if ( !svp || !SvOK(*svp) )
+    croak( "transcript has no %s", key );
+  return *svp;
+}
+
+static SV *
+genedb_str_sv( pTHX_ const SEQ_GENEDB *db, uint32_t code )
+{
+  size_t len;
+  const char *str;
+  if ( code == 0 )
+    return newSV(0);
+  str = seq_genedb_str( db, code, &len );
+  return newSVpvn( str, len );
+}
+
+/* one site, shaped like Seq::Site::Gene->as_href */
+static SV *
+genedb_site( pTHX_ const SEQ_GENEDB *db, long row )
+{
+  const SEQ_GENEDB_SITE *site = &db->site[row];
+  const SEQ_GENEDB_TX *tx = &db->tx[site->tx];
+  const uint32_t *attr = db->attr + tx->attr_off;
+  HV *rec = newHV();
+  HV *alt = newHV();
+  AV *err = newAV();
+  char codon[4];
+  long codon_number;
+  int codon_position;
+
+  hv_stores( rec, "abs_pos", newSViv( db->pos[row] ) );
+  hv_stores( rec, "ref_base", newSVpvn( &site->ref, 1 ) );
+  hv_stores( rec, "transcript_id", genedb_str_sv( aTHX_ db, tx->id ) );
+  hv_stores( rec, "site_type", newSVpv( seq_gene_site_type[site->type], 0 ) );
+  hv_stores( rec, "strand", newSVpvn( &tx->strand, 1 ) );
+  for ( uint16_t i = 0; i < tx->n_alt; i++ )
+  {
+    size_t len;
+    const char *key = attr[2 * i] ? seq_genedb_str( db, attr[2 * i], &len ) : ( len = 0, "" );
+    (void)hv_store( alt, key, (I32)len, genedb_str_sv( aTHX_ db, attr[2 * i + 1] ), 0 );
+  }
+  hv_stores( rec, "alt_names", newRV_noinc( (SV *)alt ) );
+  for ( uint16_t i = 0; i < tx->n_error; i++ )
+    av_push( err, genedb_str_sv( aTHX_ db, attr[2 * tx->n_alt + i] ) );
+  hv_stores( rec, "error_code", newRV_noinc( (SV *)err ) );
+
+  if ( seq_genedb_codon( db, row, codon, &codon_number, &codon_position ) )
+  {
+    char aa = strlen(codon) == 3 ? seq_codon_to_aa(codon) : '\0';
+    hv_stores( rec, "codon_number", newSViv( codon_number ) );
+    hv_stores( rec, "codon_position", newSViv( codon_position ) );
+    hv_stores( rec, "ref_codon_seq", newSVpv( codon, 0 ) );
+    if ( aa )
+      hv_stores( rec, "ref_aa_residue", newSVpvn( &aa, 1 ) );
+  }
+  return newRV_noinc( (SV *)rec );
+}
+
+static SV *
+genedb_get( pTHX_ const SEQ_GENEDB *db, long abs_pos )
+{
+  long first, n = seq_genedb_find( db, abs_pos, &first );
+  AV *out;
+
+  if ( n == 0 )
+    return NULL;
+  out = newAV();
+  av_extend( out, n - 1 );
+  for ( long row = first; row < first + n; row++ )
+    av_push( out, genedb_site( aTHX_ db, row ) );
+  return newRV_noinc( (SV *)out );
+}
+
+static int
+cmp_long( const void *a, const void *b )
+{
+  long x = *(const long *)a, y = *(const long *)b;
+  return ( x > y ) - ( x < y );
+}
+
+/* a snpfile reader and the batch it fills, with the names of the samples
+ *  once they are set and room for a row's carrier sets */
+typedef struct seq_snpstream
+{
+  SEQ_SNPREADER *reader;
+  SEQ_SNPBATCH batch;
+  char **name;
+  STRLEN *name_len;
+  uint64_t *het;
+  uint64_t *hom;
+  uint64_t *other;
+} SEQ_SNPSTREAM;
+
+static void
+snpstream_free_samples( SEQ_SNPSTREAM *stream )
+{
+  if ( stream->name )
+    for ( long i = 0; i < stream->reader->n_sample; i++ )
+      Safefree( stream->name[i] );
+  Safefree( stream->name );
+  Safefree( stream->name_len );
+  Safefree( stream->het );
+  Safefree( stream->hom );
+  Safefree( stream->other );
+  stream->name = NULL;
+  stream->name_len = NULL;
+  stream->het = stream->hom = stream->other = NULL;
+}
+
+/* the names of the samples in set, joined by ';' as _minor_allele_carriers
+ *  prints them, or NA when there are none */
+static SV *
+snpstream_ids( pTHX_ const SEQ_SNPSTREAM *stream, const uint64_t *set, long nWord )
+{
+  SV *ids = newSVpvs( "" );
+  int any = 0;
+
+  for ( long w = 0; w < nWord; w++ )
+    for ( uint64_t bits = set[w]; bits; bits &= bits - 1 )
+    {
+      const long i = w << 6 | __builtin_ctzll( bits );
+      if ( any++ )
+        sv_catpvs( ids, ";" );
+      sv_catpvn( ids, stream->name[i], stream->name_len[i] );
+    }
+  if ( !any )
+    sv_setpvs( ids, "NA" );
+  return ids;
+}
+
+/* what _minor_allele_carriers returns for row r, and the calls it would warn
+ *  about: [ $het_ids, $hom_ids, \%id_genos, \@unrecognized ] */
+static SV *
+snprow_carriers( pTHX_ SEQ_SNPSTREAM *stream, long r )
+{
+  const SEQ_SNPBATCH *batch = &stream->batch;
+  const SEQ_SNPROW *row = &batch->row[r];
+  const long nSample = batch->n_sample;
+  const long nWord = seq_geno_words( nSample );
+  const uint8_t *code = seq_snpbatch_geno( batch, r );
+  size_t refLen;
+  const char *ref = seq_snpbatch_field( batch, row->snp[SEQ_SNP_REF], &refLen );
+  HV *genos = newHV();
+  AV *unknown = newAV();
+  AV *out = newAV();
+
+  seq_geno_carriers( code, nSample, seq_geno_code( ref, refLen ), stream->het,
+    stream->hom, stream->other );
+  av_extend( out, 3 );
+  av_push( out, snpstream_ids( aTHX_ stream, stream->het, nWord ) );
+  av_push( out, snpstream_ids( aTHX_ stream, stream->hom, nWord ) );
+
+  for ( long w = 0; w < nWord; w++ )
+    for ( uint64_t bits = stream->het[w] | stream->hom[w]; bits; bits &= bits - 1 )
+    {
+      const long i = w << 6 | __builtin_ctzll( bits );
+      (void)hv_store( genos, stream->name[i], stream->name_len[i],
+        newSVpvn( &seq_geno_char[code[i]], 1 ), 0 );
+    }
+
+  /* calls that are not one recognized base are kept as they are, unless
+   *  they are the reference itself */
+  for ( uint32_t c = 0; c < row->n_call; c++ )
+  {
+    const SEQ_SNPCALL *call = &batch->call[row->call + c];
+    size_t len;
+    const char *s = seq_snpbatch_field( batch, call->field, &len );
+    if ( len == refLen && memcmp( s, ref, len ) == 0 )
+      continue;
+    (void)hv_store( genos, stream->name[call->sample], stream->name_len[call->sample],
+      newSVpvn( s, len ), 0 );
+    av_push( unknown, newSVpvn( s, len ) );
+  }
+  av_push( out, newRV_noinc( (SV *)genos ) );
+  av_push( out, newRV_noinc( (SV *)unknown ) );
+  return newRV_noinc( (SV *)out );
+}
+
+static SV *
+snpbatch_sv( pTHX_ const SEQ_SNPBATCH *batch, long f )
+{
+  size_t len;
+  const char *s;
+
+  if ( f < 0 )
+    return newSV( 0 );
+  s = seq_snpbatch_field( batch, f, &len );
+  return newSVpvn( s, len );
+}
+
+/* the fields of row r, as get_clean_fields returns them */
+static SV *
+snprow_fields( pTHX_ const SEQ_SNPBATCH *batch, long r )
+{
+  const SEQ_SNPROW *row = &batch->row[r];
+  AV *fields = newAV();
+
+  av_extend( fields, row->n_field - 1 );
+  for ( uint32_t i = 0; i < row->n_field; i++ )
+    av_push( fields, snpbatch_sv( aTHX_ batch, row->field + i ) );
+  return newRV_noinc( (SV *)fields );
+}
+
+/* the range index of a store, made on first use */
+static const SEQ_GENERANGE *
+genedb_range( pTHX_ SEQ_GENEDB *db )
+{
+  if ( !db->range )
+    db->range = seq_generange_new( db );
+  if ( !db->range )
+    croak( "Seq::Native::GeneDb: cannot index '%s'", db->path );
+  return db->range;
+}
+
+/* the indel terms of the sites at one position, rows [row, end) */
+static void
+indel_position( pTHX_ const SEQ_GENEDB *db, long row, long end, SV *sugar, SV *ref,
+    int *has_coding )
+{
+  sv_catpvn( ref, &db->site[row].ref, 1 );
+  for ( ; row < end; row++ )
+  {
+    int coding;
+    sv_catpv( sugar, seq_generange_indel_term( db, row, &coding ) );
+    sv_catpvs( sugar, "|" );
+    *has_coding |= coding;
+  }
+}
+
+static SV *
+txmap_hit( pTHX_ const SEQ_TXMAP *map, const SEQ_TXMAP_POS *pos )
+{
+  const SEQ_GENEDB_TX *tx = &map->db->tx[pos->tx];
+  HV *rec = newHV();
+  char name[64];
+
+  seq_txmap_format( pos, name, sizeof(name) );
+  hv_stores( rec, "transcript_id", genedb_str_sv( aTHX_ map->db, tx->id ) );
+  hv_stores( rec, "strand", newSVpvn( &tx->strand, 1 ) );
+  hv_stores( rec, "tx_offset", newSViv( pos->tx_offset ) );
+  hv_stores( rec, "intron", newSViv( pos->intron ) );
+  hv_stores( rec, "hgvs_c", newSVpv( name, 0 ) );
+  if ( pos->p_pos )
+  {
+    snprintf( name, sizeof(name), "p.%ld", pos->p_pos );
+    hv_stores( rec, "codon_number", newSViv( pos->p_pos ) );
+    hv_stores( rec, "hgvs_p", newSVpv( name, 0 ) );
+  }
+  return newRV_noinc( (SV *)rec );
+}
+
+#define CODEC_MAX_DEPTH 64
+
+static void codec_encode( pTHX_ SEQ_CODEC *codec, SEQ_BUF *out, SV *sv, int depth );
+
+typedef struct codec_field
+{
+  uint32_t key;
+  SV *val;
+} CODEC_FIELD;
+
+static int
+codec_field_cmp( const void *a, const void *b )
+{
+  uint32_t x = ( (const CODEC_FIELD *)a )->key, y = ( (const CODEC_FIELD *)b )->key;
+  return ( x > y ) - ( x < y );
+}
+
+/* a hash as a RECORD of its shape, its values in the order of its key codes,
+ * or as a HASH when it has no shape */
+static int
+codec_encode_hash( pTHX_ SEQ_CODEC *codec, SEQ_BUF *out, HV *hv, int depth )
+{
+  CODEC_FIELD field[SEQ_CODEC_MAX_SHAPE_KEYS];
+  uint32_t key[SEQ_CODEC_MAX_SHAPE_KEYS];
+  uint32_t shape = 0;
+  int n = 0;
+  HE *he;
+
+  if ( HvUSEDKEYS(hv) <= SEQ_CODEC_MAX_SHAPE_KEYS )
+  {
+    hv_iterinit(hv);
+    while ( ( he = hv_iternext(hv) ) )
+    {
+      STRLEN klen;
+      const char *str = HePV( he, klen );
+      if ( !( field[n].key = seq_codec_key( codec, str, klen ) ) )
+        return 1;
+      field[n++].val = HeVAL(he);
+    }
+    qsort( field, n, sizeof(CODEC_FIELD), codec_field_cmp );
+    for ( int i = 0; i < n; i++ )
+      key[i] = field[i].key;
+    shape = seq_codec_shape( codec, key, n );
+  }
+  if ( shape )
+  {
+    if ( seq_buf_putc( out, SEQ_CODEC_RECORD ) || seq_codec_put_varint( out, shape ) )
+      return 1;
+    for ( int i = 0; i < n; i++ )
+      codec_encode( aTHX_ codec, out, field[i].val, depth + 1 );
+    return 0;
+  }
+
+  if ( seq_buf_putc( out, SEQ_CODEC_HASH ) || seq_codec_put_varint( out, HvUSEDKEYS(hv) ) )
+    return 1;
+  hv_iterinit(hv);
+  while ( ( he = hv_iternext(hv) ) )
+  {
+    STRLEN klen;
+    const char *str = HePV( he, klen );
+    if ( seq_codec_put_key( codec, out, str, klen ) )
+      return 1;
+    codec_encode( aTHX_ codec, out, HeVAL(he), depth + 1 );
+  }
+  return 0;
+}
+
+/* Seq::Native::Codec: perl data to the record encoding of seq_codec.h; plain
+ * numbers keep their type (the way JSON would see them), anything that has
+ * been used as a string is a string */
+static void
+codec_encode( pTHX_ SEQ_CODEC *codec, SEQ_BUF *out, SV *sv, int depth )
+{
+  int err = 0;
+
+  if ( depth > CODEC_MAX_DEPTH )
+    croak( "Seq::Native::Codec: data nested too deeply" );
+  SvGETMAGIC(sv);
+  if ( !SvOK(sv) )
+    err = seq_buf_putc( out, SEQ_CODEC_UNDEF );
+  else if ( SvROK(sv) )
+  {
+    SV *rv = SvRV(sv);
+    if ( SvTYPE(rv) == SVt_PVAV )
+    {
+      AV *av = (AV *)rv;
+      SSize_t n = av_len(av) + 1;
+      err = seq_buf_putc( out, SEQ_CODEC_ARRAY ) || seq_codec_put_varint( out, n );
+      for ( SSize_t i = 0; !err && i < n; i++ )
+      {
+        SV **svp = av_fetch( av, i, 0 );
+        codec_encode( aTHX_ codec, out, svp ? *svp : &PL_sv_undef, depth + 1 );
+      }
+    }
+    else if ( SvTYPE(rv) == SVt_PVHV )
+      err = codec_encode_hash( aTHX_ codec, out, (HV *)rv, depth );
+    else
+      croak( "Seq::Native::Codec: cannot encode a %s reference", sv_reftype( rv, 0 ) );
+  }
+  else if ( SvIOK(sv) && !SvPOK(sv) && !SvIsUV(sv) )
+    err = seq_codec_put_int( out, SvIVX(sv) );
+  else if ( SvNOK(sv) && !SvPOK(sv) && !SvIOK(sv) )
+    err = seq_codec_put_double( out, SvNVX(sv) );
+  else
+  {
+    STRLEN len;
+    const char *str = SvPV( sv, len );
+    err = seq_codec_put_str( codec, out, str, len, SvUTF8(sv) ? 1 : 0 );
+  }
+  if ( err )
+    croak( "Seq::Native::Codec: out of memory" );
+}
+
+static SV *
+codec_decode( pTHX_ const SEQ_CODEC *codec, const char **p, const char *end, int depth )
+{
+  uint64_t v;
+  size_t len;
+  const char *str;
+  SV *sv;
+  char tag;
+
+  if ( *p >= end || depth > CODEC_MAX_DEPTH )
+    croak( "Seq::Native::Codec: truncated record" );
+  tag = *(*p)++;
+  switch ( tag )
+  {
+  case SEQ_CODEC_UNDEF:
+    return newSV(0);
+  case SEQ_CODEC_INT:
+    if ( seq_codec_get_varint( p, end, &v ) )
+      break;
+    return newSViv( (IV)seq_codec_unzigzag(v) );
+  case SEQ_CODEC_DOUBLE:
+    {
+      double d;
+      if ( end - *p < (ptrdiff_t)sizeof(double) )
+        break;
+      memcpy( &d, *p, sizeof(double) );
+      *p += sizeof(double);
+      return newSVnv(d);
+    }
+  case SEQ_CODEC_STR:
+  case SEQ_CODEC_UTF8:
+    if ( seq_codec_get_varint( p, end, &v ) || v > (uint64_t)( end - *p ) )
+      break;
+    sv = newSVpvn( *p, v );
+    if ( tag == SEQ_CODEC_UTF8 )
+      SvUTF8_on(sv);
+    *p += v;
+    return sv;
+  case SEQ_CODEC_ATOM:
+    if ( seq_codec_get_varint( p, end, &v ) || !( str = seq_codec_atom( codec, v, &len ) ) )
+      break;
+    return newSVpvn( str, len );
+  case SEQ_CODEC_ARRAY:
+    {
+      AV *av;
+      if ( seq_codec_get_varint( p, end, &v ) || v > (uint64_t)( end - *p ) )
+        break;
+      av = newAV();
+      sv = newRV_noinc( (SV *)av );
+      if ( v )
+        av_extend( av, v - 1 );
+      for ( uint64_t i = 0; i < v; i++ )
+        av_push( av, codec_decode( aTHX_ codec, p, end, depth + 1 ) );
+      return sv;
+    }
+  case SEQ_CODEC_HASH:
+    {
+      HV *hv;
+      uint64_t key;
+      if ( seq_codec_get_varint( p, end, &v ) || v > (uint64_t)( end - *p ) )
+        break;
+      hv = newHV();
+      sv = newRV_noinc( (SV *)hv );
+      for ( uint64_t i = 0; i < v; i++ )
+      {
+        if ( seq_codec_get_varint( p, end, &key ) || !( str = seq_codec_atom( codec, key, &len ) ) )
+        {
+          SvREFCNT_dec(sv);
+          croak( "Seq::Native::Codec: bad key in record" );
+        }
+        (void)hv_store( hv, str, (I32)len, codec_decode( aTHX_ codec, p, end, depth + 1 ), 0 );
+      }
+      return sv;
+    }
+  case SEQ_CODEC_RECORD:
+    {
+      HV *hv;
+      uint32_t key[SEQ_CODEC_MAX_SHAPE_KEYS];
+      int n;
+      if ( seq_codec_get_varint( p, end, &v ) || ( n = seq_codec_shape_keys( codec, v, key ) ) < 0 )
+        croak( "Seq::Native::Codec: unknown shape in record" );
+      hv = newHV();
+      sv = newRV_noinc( (SV *)hv );
+      for ( int i = 0; i < n; i++ )
+      {
+        if ( !( str = seq_codec_atom( codec, key[i], &len ) ) )
+        {
+          SvREFCNT_dec(sv);
+          croak( "Seq::Native::Codec: bad key in record" );
+        }
+        (void)hv_store( hv, str, (I32)len, codec_decode( aTHX_ codec, p, end, depth + 1 ), 0 );
+      }
+      return sv;
+    }
+  }
+  croak( "Seq::Native::Codec: corrupt record" );
+  return NULL;
+}
+
+/* the plan of an output row: the key of each column in the entry hashes,
+ *  hashed once, and room to format rows into */
+typedef struct seq_format
+{
+  long n;
+  SV **key;
+  U32 *hash;
+  SEQ_BUF text;
+} SEQ_FORMAT;
+
+/* adds a line per entry, its columns' values tab separated, 'NA' for those
+ *  it has no key for, as Seq::Role::ProcessFile::print_annotations does, to
+ *  out or, when w is given, to the batch the writer is filling (handing it
+ *  on when full). 0 once the writer has failed. */
+static int
+format_rows( pTHX_ SEQ_FORMAT *f, AV *entries, SEQ_BUF *out, SEQ_WRITER *w )
+{
+  long n = av_len( entries ) + 1;
+  for ( long i = 0; i < n; i++ ) {
+    SV **e = av_fetch( entries, i, 0 );
+    HV *hv;
+    if ( !e || !SvROK( *e ) || SvTYPE( SvRV( *e ) ) != SVt_PVHV )
+      croak( "Seq::Native::Formatter: entry %ld is not a hash reference", i );
+    hv = (HV *)SvRV( *e );
+    if ( w && !( out = seq_writer_text( w ) ) )
+      return 0;
+    for ( long c = 0; c < f->n; c++ ) {
+      HE *he = hv_fetch_ent( hv, f->key[c], 0, f->hash[c] );
+      const char *v = "NA";
+      STRLEN len = 2;
+      if ( he ) {
+        SV *val = HeVAL( he );
+        if ( SvOK( val ) )
+          v = SvPV( val, len );
+        else
+          len = 0;
+      }
+      if ( ( c && seq_buf_putc( out, '\t' ) ) || seq_buf_add( out, v, len ) )
+        croak( "Seq::Native::Formatter: out of memory" );
+    }
+    if ( seq_buf_putc( out, '\n' ) )
+      croak( "Seq::Native::Formatter: out of memory" );
+    if ( w && !seq_writer_commit( w ) )
+      return 0;
+  }
+  return 1;
+}
+
+MODULE = Seq::Native    PACKAGE = Seq::Native
+
+PROTOTYPES: DISABLE
+
+BOOT:
+{
+  HV *stash = gv_stashpv( "Seq::Native", GV_ADD );
+  newCONSTSUB( stash, "SITE_GAN", newSViv(SEQ_SITE_GAN) );
+  newCONSTSUB( stash, "SITE_EXON", newSViv(SEQ_SITE_EXON) );
+  newCONSTSUB( stash, "SITE_GENE", newSViv(SEQ_SITE_GENE) );
+  newCONSTSUB( stash, "SITE_SNP", newSViv(SEQ_SITE_SNP) );
+  newCONSTSUB( stash, "CSQ_MASK", newSViv(SEQ_CSQ_MASK) );
+  newCONSTSUB( stash, "CSQ_MULTI", newSViv(SEQ_CSQ_MULTI) );
+}
+
+SV *
+csq_name( code )
+    IV code
+  CODE:
+    code &= SEQ_CSQ_MASK;
+    RETVAL = code < SEQ_CSQ_N_CODE ? newSVpv( seq_csq_name[code], 0 ) : &PL_sv_undef;
+  OUTPUT:
+    RETVAL
+
+SV *
+lookup_batch( genome_sv, ngene_sv, score_sv, cadd_sv, pos_sv )
+    SV *genome_sv
+    SV *ngene_sv
+    SV *score_sv
+    SV *cadd_sv
+    SV *pos_sv
+  PREINIT:
+    SEQ_TRACKS tracks;
+    SEQ_BATCH *batch;
+    AV *score_av, *cadd_av, *pos_av;
+    long *pos;
+    long n;
+    HV *out;
+  CODE:
+    memset( &tracks, 0, sizeof(tracks) );
+    tracks.genome = sv_to_track( aTHX_ genome_sv, "genome", 0 );
+    tracks.ngene  = sv_to_track( aTHX_ ngene_sv, "ngene", 1 );
+    if ( tracks.ngene && tracks.ngene->width != SEQ_TRACK_NGENE )
+      croak( "ngene track is not 16-bit" );
+
+    score_av = sv_to_av( aTHX_ score_sv, "score tracks" );
+    tracks.n_score = av_len(score_av) + 1;
+    if ( tracks.n_score > SEQ_MAX_SCORE_TRACKS )
+      croak( "at most %d score tracks are supported", SEQ_MAX_SCORE_TRACKS );
+    for ( int t = 0; t < tracks.n_score; t++ ) {
+      tracks.score[t] = sv_to_track( aTHX_ *av_fetch( score_av, t, 0 ), "score track", 0 );
+      if ( !tracks.score[t]->has_score )
+        croak( "score track '%s' has no score range", tracks.score[t]->path );
+    }
+
+    cadd_av = sv_to_av( aTHX_ cadd_sv, "cadd tracks" );
+    if ( av_len(cadd_av) + 1 == SEQ_CADD_TRACKS ) {
+      for ( int k = 0; k < SEQ_CADD_TRACKS; k++ ) {
+        tracks.cadd[k] = sv_to_track( aTHX_ *av_fetch( cadd_av, k, 0 ), "cadd track", 0 );
+        if ( !tracks.cadd[k]->has_score )
+          croak( "cadd track '%s' has no score range", tracks.cadd[k]->path );
+      }
+      tracks.has_cadd = 1;
+    }
+    else if ( av_len(cadd_av) != -1 )
+      croak( "expected 0 or %d cadd tracks", SEQ_CADD_TRACKS );
+
+    pos_av = sv_to_av( aTHX_ pos_sv, "positions" );
+    n = av_len(pos_av) + 1;
+    out = newHV();
+    if ( n > 0 ) {
+      Newx( pos, n, long );
+      for ( long i = 0; i < n; i++ )
+        pos[i] = (long)SvIV( *av_fetch( pos_av, i, 0 ) );
+
+      batch = seq_batch_new( n, tracks.n_score );
+      if ( !batch || seq_batch_lookup( &tracks, pos, n, batch ) ) {
+        Safefree(pos);
+        seq_batch_free(batch);
+        croak( "lookup_batch() failed" );
+      }
+
+      AV *scores = newAV();
+      for ( int t = 0; t < tracks.n_score; t++ )
+        av_push( scores, score_array( aTHX_ tracks.score[t],
+          batch->score_code + (long)t * batch->cap, n ) );
+      AV *cadd = newAV();
+      if ( tracks.has_cadd )
+        for ( int k = 0; k < SEQ_CADD_TRACKS; k++ )
+          av_push( cadd, score_array( aTHX_ tracks.cadd[k],
+            batch->cadd_code + (long)k * batch->cap, n ) );
+
+      hv_stores( out, "site_code", int_array( aTHX_ batch->site_code, n ) );
+      hv_stores( out, "nearest_gene", int_array( aTHX_ batch->nearest_gene, n ) );
+      hv_stores( out, "scores", newRV_noinc( (SV *)scores ) );
+      hv_stores( out, "cadd", newRV_noinc( (SV *)cadd ) );
+
+      Safefree(pos);
+      seq_batch_free(batch);
+    }
+    RETVAL = newRV_noinc( (SV *)out );
+  OUTPUT:
+    RETVAL
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::Track
+
+PROTOTYPES: DISABLE
+
+IV
+count_sites( track, start, end, mask )
+    SEQ_TRACK *track
+    IV start
+    IV end
+    int mask
+  CODE:
+    if ( track->width != SEQ_TRACK_CHAR )
+      croak( "count_sites() called on a track that is not char encoded" );
+    if ( start < 0 || end < start || end >= track->length )
+      croak( "count_sites() expects 0 <= start <= end < %ld, got %" IVdf " - %" IVdf,
+        track->length, start, end );
+    RETVAL = seq_site_count( track->data + start, end - start + 1, (unsigned char)mask );
+  OUTPUT:
+    RETVAL
+
+SV *
+decode_sites( track, start, end )
+    SEQ_TRACK *track
+    IV start
+    IV end
+  PREINIT:
+    SEQ_SITE_BLOCK block;
+    long n;
+    HV *out;
+  CODE:
+    if ( track->width != SEQ_TRACK_CHAR )
+      croak( "decode_sites() called on a track that is not char encoded" );
+    if ( start < 0 || end < start || end >= track->length )
+      croak( "decode_sites() expects 0 <= start <= end < %ld, got %" IVdf " - %" IVdf,
+        track->length, start, end );
+    n = end - start + 1;
+    Newx( block.base, n, char );
+    Newx( block.in_gan, 4 * n, unsigned char );
+    block.in_exon = block.in_gan + n;
+    block.in_gene = block.in_gan + 2 * n;
+    block.in_snp  = block.in_gan + 3 * n;
+    seq_site_decode_block( track->data + start, n, &block );
+
+    /* flags come back as strings of "\0" / "\1" bytes, unpack with 'C*' */
+    out = newHV();
+    hv_stores( out, "base", newSVpvn( block.base, n ) );
+    hv_stores( out, "in_gan", newSVpvn( (char *)block.in_gan, n ) );
+    hv_stores( out, "in_exon", newSVpvn( (char *)block.in_exon, n ) );
+    hv_stores( out, "in_gene", newSVpvn( (char *)block.in_gene, n ) );
+    hv_stores( out, "in_snp", newSVpvn( (char *)block.in_snp, n ) );
+    Safefree( block.base );
+    Safefree( block.in_gan );
+    RETVAL = newRV_noinc( (SV *)out );
+  OUTPUT:
+    RETVAL
+
+SV *
+cost_tasks( track, path, header_sv, offsets_sv, start, end, task_cost, max_bytes )
+    SEQ_TRACK *track
+    char *path
+    SV *header_sv
+    SV *offsets_sv
+    UV start
+    UV end
+    UV task_cost
+    UV max_bytes
+  PREINIT:
+    AV *header;
+    HV *offsets;
+    SV *line;
+    SEQ_SNP_COLS cols;
+    SEQ_COST_CHROM *chrom;
+    SEQ_COST_TASK *tasks;
+    int n_chrom = 0;
+    long n, i;
+    HE *he;
+    AV *out;
+  CODE:
+    if ( track->width != SEQ_TRACK_CHAR )
+      croak( "cost_tasks() called on a track that is not char encoded" );
+    header  = sv_to_av( aTHX_ header_sv, "header" );
+    offsets = sv_to_hv( aTHX_ offsets_sv, "offsets" );
+
+    line = sv_2mortal( newSVpvs( "" ) );
+    for ( i = 0; i <= av_len( header ); i++ ) {
+      SV **f = av_fetch( header, i, 0 );
+      if ( i )
+        sv_catpvs( line, "\t" );
+      if ( f && SvOK( *f ) )
+        sv_catsv( line, *f );
+    }
+    if ( seq_snp_cols_parse( &cols, SvPV_nolen( line ), SvCUR( line ) ) )
+      croak( "cost_tasks() cannot find the snpfile columns in its header" );
+
+    /* the names point into the hash, which outlives the call */
+    Newx( chrom, HvUSEDKEYS( offsets ) + 1, SEQ_COST_CHROM );
+    hv_iterinit( offsets );
+    while ( ( he = hv_iternext( offsets ) ) ) {
+      I32 len;
+      chrom[n_chrom].name   = hv_iterkey( he, &len );
+      chrom[n_chrom].len    = (int)len;
+      chrom[n_chrom].offset = (long)SvIV( hv_iterval( offsets, he ) );
+      n_chrom++;
+    }
+    n = seq_cost_tasks( track, &cols, chrom, n_chrom, path, start, end,
+      task_cost ? task_cost : 1, max_bytes ? max_bytes : UINT64_MAX, &tasks );
+    Safefree( chrom );
+    if ( n < 0 )
+      croak( "cost_tasks() cannot read '%s'", path );
+
+    out = newAV();
+    av_extend( out, n );
+    for ( i = 0; i < n; i++ ) {
+      AV *task = newAV();
+      av_push( task, newSVuv( tasks[i].start ) );
+      av_push( task, newSVuv( tasks[i].end ) );
+      av_push( task, newSVuv( tasks[i].cost ) );
+      av_push( out, newRV_noinc( (SV *)task ) );
+    }
+    free( tasks );
+    RETVAL = newRV_noinc( (SV *)out );
+  OUTPUT:
+    RETVAL
+
+SEQ_TRACK *
+new( CLASS, path, width = SEQ_TRACK_CHAR )
+    char *CLASS
+    char *path
+    int width
+  CODE:
+    RETVAL = seq_track_open( path, width );
+    if ( !RETVAL )
+      croak( "Seq::Native::Track: cannot map '%s'", path );
+  OUTPUT:
+    RETVAL
+
+void
+set_score( track, min, max, R )
+    SEQ_TRACK *track
+    double min
+    double max
+    int R
+  CODE:
+    if ( seq_track_set_score( track, min, max, R ) )
+      croak( "Seq::Native::Track: impossible score range for '%s'", track->path );
+
+IV
+length( track )
+    SEQ_TRACK *track
+  CODE:
+    RETVAL = track->length;
+  OUTPUT:
+    RETVAL
+
+IV
+size( track )
+    SEQ_TRACK *track
+  CODE:
+    RETVAL = track->size;
+  OUTPUT:
+    RETVAL
+
+IV
+get_base( track, pos )
+    SEQ_TRACK *track
+    IV pos
+  CODE:
+    RETVAL = seq_track_get_base( track, pos );
+    if ( RETVAL < 0 )
+      croak( "get_base() expects a position between 0 and %ld, got %" IVdf,
+        track->length, pos );
+  OUTPUT:
+    RETVAL
+
+IV
+get_nearest_gene( track, pos )
+    SEQ_TRACK *track
+    IV pos
+  CODE:
+    if ( track->width != SEQ_TRACK_NGENE )
+      croak( "get_nearest_gene() called on a track that is not ngene" );
+    RETVAL = seq_track_get_nearest_gene( track, pos );
+    if ( RETVAL < 0 )
+      croak( "get_nearest_gene() expects a position between 0 and %ld, got %" IVdf,
+        track->length, pos );
+  OUTPUT:
+    RETVAL
+
+SV *
+get_score( track, pos )
+    SEQ_TRACK *track
+    IV pos
+  CODE:
+    if ( !track->has_score )
+      croak( "get_score() called on non-score track" );
+    if ( pos < 0 || pos >= track->length )
+      croak( "get_score() expects a position between 0 and %ld, got %" IVdf,
+        track->length, pos );
+    RETVAL = score_sv( aTHX_ track, seq_track_get_base( track, pos ) );
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY( track )
+    SEQ_TRACK *track
+  CODE:
+    seq_track_close( track );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::SnpDb
+
+PROTOTYPES: DISABLE
+
+SEQ_SNPDB *
+new( CLASS, path )
+    char *CLASS
+    char *path
+  CODE:
+    RETVAL = seq_snpdb_open( path );
+    if ( !RETVAL )
+      croak( "Seq::Native::SnpDb: cannot open '%s'", path );
+  OUTPUT:
+    RETVAL
+
+IV
+count( db )
+    SEQ_SNPDB *db
+  CODE:
+    RETVAL = db->header->n_row;
+  OUTPUT:
+    RETVAL
+
+char *
+filename( db )
+    SEQ_SNPDB *db
+  CODE:
+    RETVAL = db->path;
+  OUTPUT:
+    RETVAL
+
+void
+features( db )
+    SEQ_SNPDB *db
+  PPCODE:
+    EXTEND( SP, db->header->n_feature );
+    for ( uint32_t k = 0; k < db->header->n_feature; k++ )
+      mPUSHs( newSVpv( db->column[k].name, 0 ) );
+
+void
+db_get( db, abs_pos )
+    SEQ_SNPDB *db
+    IV abs_pos
+  PREINIT:
+    long first, n;
+    AV *out;
+    char idBuf[16];
+  PPCODE:
+    /* same shape as Seq::KCManager::db_get: [ Seq::Site::Snp->as_href, ... ] */
+    n = seq_snpdb_find( db, abs_pos, &first );
+    if ( n == 0 )
+      XSRETURN_EMPTY;
+    out = newAV();
+    av_extend( out, n - 1 );
+    for ( long row = first; row < first + n; row++ )
+    {
+      HV *rec = newHV();
+      HV *feature = newHV();
+      size_t len;
+      const char *str = seq_snpdb_snp_id( db, row, idBuf, &len );
+
+      hv_stores( rec, "abs_pos", newSViv( abs_pos ) );
+      hv_stores( rec, "ref_base", newSVpvn( db->ref + row, 1 ) );
+      hv_stores( rec, "snp_id", newSVpvn( str, len ) );
+      for ( uint32_t k = 0; k < db->header->n_feature; k++ )
+      {
+        str = seq_snpdb_feature( db, row, (int)k, &len );
+        if ( str )
+          (void)hv_store( feature, db->column[k].name, strlen( db->column[k].name ),
+            newSVpvn( str, len ), 0 );
+      }
+      hv_stores( rec, "snp_feature", newRV_noinc( (SV *)feature ) );
+      av_push( out, newRV_noinc( (SV *)rec ) );
+    }
+    mXPUSHs( newRV_noinc( (SV *)out ) );
+
+void
+DESTROY( db )
+    SEQ_SNPDB *db
+  CODE:
+    seq_snpdb_close( db );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::SnpWriter
+
+PROTOTYPES: DISABLE
+
+SEQ_SNPDB_WRITER *
+new( CLASS, features_sv )
+    char *CLASS
+    SV *features_sv
+  PREINIT:
+    AV *av;
+    const char *name[SEQ_SNPDB_MAX_FEATURES];
+    SSize_t n;
+  CODE:
+    av = sv_to_av( aTHX_ features_sv, "features" );
+    n = av_len( av ) + 1;
+    if ( n > SEQ_SNPDB_MAX_FEATURES )
+      croak( "Seq::Native::SnpWriter: at most %d features", SEQ_SNPDB_MAX_FEATURES );
+    for ( SSize_t k = 0; k < n; k++ )
+    {
+      SV **svp = av_fetch( av, k, 0 );
+      name[k] = svp ? SvPV_nolen( *svp ) : "";
+    }
+    RETVAL = seq_snpdb_writer_new( name, (int)n );
+    if ( !RETVAL )
+      croak( "Seq::Native::SnpWriter: cannot create writer" );
+  OUTPUT:
+    RETVAL
+
+void
+add( w, abs_pos, snp_id, ref_base, values_sv )
+    SEQ_SNPDB_WRITER *w
+    IV abs_pos
+    char *snp_id
+    char *ref_base
+    SV *values_sv
+  PREINIT:
+    AV *av;
+    const char *value[SEQ_SNPDB_MAX_FEATURES];
+  CODE:
+    av = sv_to_av( aTHX_ values_sv, "values" );
+    if ( av_len( av ) + 1 != w->n_feature )
+      croak( "Seq::Native::SnpWriter::add() expects %d values", w->n_feature );
+    for ( int k = 0; k < w->n_feature; k++ )
+    {
+      SV **svp = av_fetch( av, k, 0 );
+      value[k] = ( svp && SvOK( *svp ) ) ? SvPV_nolen( *svp ) : NULL;
+    }
+    if ( seq_snpdb_writer_add( w, abs_pos, snp_id, ref_base[0], value ) )
+      croak( "Seq::Native::SnpWriter: cannot add %s at %" IVdf, snp_id, abs_pos );
+
+IV
+count( w )
+    SEQ_SNPDB_WRITER *w
+  CODE:
+    RETVAL = w->n;
+  OUTPUT:
+    RETVAL
+
+void
+write( w, path )
+    SEQ_SNPDB_WRITER *w
+    char *path
+  CODE:
+    if ( seq_snpdb_writer_write( w, path ) )
+      croak( "Seq::Native::SnpWriter: cannot write '%s'", path );
+
+void
+DESTROY( w )
+    SEQ_SNPDB_WRITER *w
+  CODE:
+    seq_snpdb_writer_free( w );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::Codec
+
+PROTOTYPES: DISABLE
+
+SEQ_CODEC *
+new( CLASS, max_intern = -1 )
+    char *CLASS
+    int max_intern
+  CODE:
+    RETVAL = seq_codec_new( max_intern );
+    if ( !RETVAL )
+      croak( "Seq::Native::Codec: out of memory" );
+  OUTPUT:
+    RETVAL
+
+SV *
+encode( codec, data )
+    SEQ_CODEC *codec
+    SV *data
+  CODE:
+    seq_buf_reset( &codec->buf );
+    codec_encode( aTHX_ codec, &codec->buf, data, 0 );
+    RETVAL = newSVpvn( codec->buf.s, codec->buf.len );
+  OUTPUT:
+    RETVAL
+
+SV *
+decode( codec, bytes )
+    SEQ_CODEC *codec
+    SV *bytes
+  PREINIT:
+    STRLEN len;
+    const char *p, *end;
+  CODE:
+    p = SvPVbyte( bytes, len );
+    end = p + len;
+    RETVAL = codec_decode( aTHX_ codec, &p, end, 0 );
+    if ( p != end )
+    {
+      SvREFCNT_dec( RETVAL );
+      croak( "Seq::Native::Codec: trailing bytes after record" );
+    }
+  OUTPUT:
+    RETVAL
+
+IV
+atoms( codec )
+    SEQ_CODEC *codec
+  CODE:
+    RETVAL = codec->dict.n;
+  OUTPUT:
+    RETVAL
+
+bool
+dirty( codec )
+    SEQ_CODEC *codec
+  CODE:
+    RETVAL = codec->dirty;
+  OUTPUT:
+    RETVAL
+
+SV *
+dict_dump( codec )
+    SEQ_CODEC *codec
+  PREINIT:
+    SEQ_BUF out = { 0 };
+  CODE:
+    if ( seq_codec_dict_dump( codec, &out ) )
+    {
+      seq_buf_free( &out );
+      croak( "Seq::Native::Codec: out of memory" );
+    }
+    RETVAL = newSVpvn( out.s, out.len );
+    seq_buf_free( &out );
+    codec->dirty = 0;
+  OUTPUT:
+    RETVAL
+
+void
+dict_load( codec, bytes )
+    SEQ_CODEC *codec
+    SV *bytes
+  PREINIT:
+    STRLEN len;
+    const char *p;
+  CODE:
+    p = SvPVbyte( bytes, len );
+    if ( seq_codec_dict_load( codec, p, len ) )
+      croak( "Seq::Native::Codec: bad dictionary" );
+
+SV *
+schema_dump( codec )
+    SEQ_CODEC *codec
+  PREINIT:
+    SEQ_BUF out = { 0 };
+  CODE:
+    if ( seq_codec_schema_dump( codec, &out ) )
+    {
+      seq_buf_free( &out );
+      croak( "Seq::Native::Codec: out of memory" );
+    }
+    RETVAL = newSVpvn( out.s, out.len );
+    seq_buf_free( &out );
+  OUTPUT:
+    RETVAL
+
+void
+schema_load( codec, bytes )
+    SEQ_CODEC *codec
+    SV *bytes
+  PREINIT:
+    STRLEN len;
+    const char *p;
+  CODE:
+    p = SvPVbyte( bytes, len );
+    if ( seq_codec_schema_load( codec, p, len ) )
+      croak( "Seq::Native::Codec: bad schema" );
+
+void
+DESTROY( codec )
+    SEQ_CODEC *codec
+  CODE:
+    seq_codec_free( codec );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::GeneDb
+
+PROTOTYPES: DISABLE
+
+SEQ_GENEDB *
+new( CLASS, path )
+    char *CLASS
+    char *path
+  CODE:
+    RETVAL = seq_genedb_open( path );
+    if ( !RETVAL )
+      croak( "Seq::Native::GeneDb: cannot open '%s'", path );
+  OUTPUT:
+    RETVAL
+
+IV
+count( db )
+    SEQ_GENEDB *db
+  CODE:
+    RETVAL = db->header->n_site;
+  OUTPUT:
+    RETVAL
+
+IV
+transcripts( db )
+    SEQ_GENEDB *db
+  CODE:
+    RETVAL = db->header->n_tx;
+  OUTPUT:
+    RETVAL
+
+char *
+filename( db )
+    SEQ_GENEDB *db
+  CODE:
+    RETVAL = db->path;
+  OUTPUT:
+    RETVAL
+
+void
+db_get( db, abs_pos )
+    SEQ_GENEDB *db
+    IV abs_pos
+  PREINIT:
+    SV *rec;
+  PPCODE:
+    rec = genedb_get( aTHX_ db, abs_pos );
+    if ( !rec )
+      XSRETURN_EMPTY;
+    mXPUSHs( rec );
+
+void
+db_bulk_get( db, keys_sv, reverse = 0 )
+    SEQ_GENEDB *db
+    SV *keys_sv
+    int reverse
+  PREINIT:
+    AV *av;
+    SSize_t n, m = 0;
+    long *key;
+  PPCODE:
+    /* like Seq::KCManager::db_bulk_get: the records of each distinct key that
+     * has any, in numeric key order */
+    av = sv_to_av( aTHX_ keys_sv, "keys" );
+    n = av_len( av ) + 1;
+    Newx( key, n ? n : 1, long );
+    SAVEFREEPV( key );
+    for ( SSize_t i = 0; i < n; i++ )
+    {
+      SV **svp = av_fetch( av, i, 0 );
+      if ( svp && SvOK( *svp ) )
+        key[m++] = (long)SvIV( *svp );
+    }
+    qsort( key, m, sizeof(long), cmp_long );
+    n = 0;
+    for ( SSize_t i = 0; i < m; i++ )
+    {
+      if ( n == 0 || key[i] != key[n - 1] )
+        key[n++] = key[i];
+    }
+    for ( SSize_t i = 0; i < n; i++ )
+    {
+      SV *rec = genedb_get( aTHX_ db, key[ reverse ? n - 1 - i : i ] );
+      if ( rec )
+        mXPUSHs( rec );
+    }
+
+void
+db_get_alleles( db, abs_pos, alleles_sv )
+    SEQ_GENEDB *db
+    IV abs_pos
+    SV *alleles_sv
+  PREINIT:
+    AV *alleles, *out;
+    long first, n;
+    SSize_t nAllele;
+  PPCODE:
+    /* db_get's records once for each allele, in the order Seq::Annotate
+     * makes Seq::Site::Annotation's of them: with the allele as minor_allele
+     * and the attributes its substitution gives filled in */
+    alleles = sv_to_av( aTHX_ alleles_sv, "alleles" );
+    n = seq_genedb_find( db, abs_pos, &first );
+    nAllele = av_len( alleles ) + 1;
+    if ( n == 0 || nAllele == 0 )
+      XSRETURN_EMPTY;
+    out = newAV();
+    av_extend( out, n * nAllele - 1 );
+    for ( long row = first; row < first + n; row++ )
+      for ( SSize_t i = 0; i < nAllele; i++ )
+      {
+        SV **svp = av_fetch( alleles, i, 0 );
+        SV *allele = svp ? *svp : &PL_sv_undef;
+        const char *alt = SvOK( allele ) ? SvPV_nolen( allele ) : "";
+        SV *rec = genedb_site( aTHX_ db, row );
+        HV *hv = (HV *)SvRV( rec );
+        SV *codon_sv = &PL_sv_undef, *aa_sv = &PL_sv_undef;
+        const char *type = "Non-Coding";
+        char codon[4];
+
+        if ( seq_csq_substitute( db, row, alt[0], codon ) )
+        {
+          char aa = seq_codon_to_aa( codon );
+          codon_sv = newSVpv( codon, 0 );
+          if ( aa )
+          {
+            SV **ref = hv_fetchs( hv, "ref_aa_residue", 0 );
+            aa_sv = newSVpvn( &aa, 1 );
+            type = ref && SvPV_nolen( *ref )[0] == aa ? "Silent" : "Replacement";
+          }
+        }
+        hv_stores( hv, "minor_allele", newSVsv( allele ) );
+        hv_stores( hv, "new_codon_seq", codon_sv == &PL_sv_undef ? newSV( 0 ) : codon_sv );
+        hv_stores( hv, "new_aa_residue", aa_sv == &PL_sv_undef ? newSV( 0 ) : aa_sv );
+        hv_stores( hv, "annotation_type", newSVpv( type, 0 ) );
+        av_push( out, rec );
+      }
+    mXPUSHs( newRV_noinc( (SV *)out ) );
+
+void
+csq( db, abs_pos, alt )
+    SEQ_GENEDB *db
+    IV abs_pos
+    char *alt
+  PREINIT:
+    long first, n;
+  PPCODE:
+    n = seq_genedb_find( db, abs_pos, &first );
+    EXTEND( SP, n );
+    for ( long row = first; row < first + n; row++ )
+      mPUSHi( seq_csq_code( db, row, alt[0] ) );
+
+void
+overlap( db, start, end )
+    SEQ_GENEDB *db
+    IV start
+    IV end
+  PREINIT:
+    const SEQ_GENERANGE *range;
+    SEQ_GENERANGE_HIT *hit;
+    long n;
+  PPCODE:
+    /* transcripts and exons over [start, end], both inclusive */
+    range = genedb_range( aTHX_ db );
+    n = seq_generange_overlap( range, start, end + 1, NULL, 0 );
+    Newx( hit, n ? n : 1, SEQ_GENERANGE_HIT );
+    SAVEFREEPV( hit );
+    seq_generange_overlap( range, start, end + 1, hit, n );
+    EXTEND( SP, n );
+    for ( long i = 0; i < n; i++ )
+    {
+      HV *rec = newHV();
+      hv_stores( rec, "transcript_id", genedb_str_sv( aTHX_ db, db->tx[hit[i].tx].id ) );
+      hv_stores( rec, "feature",
+        newSVpv( hit[i].kind == SEQ_GENERANGE_EXON ? "exon" : "transcript", 0 ) );
+      hv_stores( rec, "start", newSVuv( hit[i].start ) );
+      hv_stores( rec, "end", newSVuv( hit[i].end - 1 ) );
+      mPUSHs( newRV_noinc( (SV *)rec ) );
+    }
+
+void
+indel_sites( db, start, end, reverse = 0 )
+    SEQ_GENEDB *db
+    IV start
+    IV end
+    int reverse
+  PREINIT:
+    long first, n, nPos = 0;
+    int has_coding = 0;
+    SV *sugar, *ref;
+  PPCODE:
+    /* what Seq::Sites::Indels makes of db_bulk_get over [start, end] */
+    n = seq_generange_sites( genedb_range( aTHX_ db ), start, end + 1, &first );
+    if ( n == 0 )
+      XSRETURN_EMPTY;
+    sugar = sv_2mortal( newSVpvs( "" ) );
+    ref = sv_2mortal( newSVpvs( "" ) );
+    if ( reverse )
+    {
+      for ( long e = first + n, g; e > first; e = g, nPos++ )
+      {
+        for ( g = e - 1; g > first && db->pos[g - 1] == db->pos[e - 1]; g-- )
+          ;
+        indel_position( aTHX_ db, g, e, sugar, ref, &has_coding );
+      }
+    }
+    else
+    {
+      for ( long g = first, e; g < first + n; g = e, nPos++ )
+      {
+        for ( e = g + 1; e < first + n && db->pos[e] == db->pos[g]; e++ )
+          ;
+        indel_position( aTHX_ db, g, e, sugar, ref, &has_coding );
+      }
+    }
+    SvCUR_set( sugar, SvCUR( sugar ) - 1 );
+    EXTEND( SP, 4 );
+    PUSHs( sugar );
+    mPUSHi( has_coding );
+    PUSHs( ref );
+    mPUSHi( nPos );
+
+void
+DESTROY( db )
+    SEQ_GENEDB *db
+  CODE:
+    seq_genedb_close( db );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::TxMap
+
+PROTOTYPES: DISABLE
+
+SEQ_TXMAP *
+new( CLASS, path )
+    char *CLASS
+    char *path
+  CODE:
+    RETVAL = seq_txmap_open( path );
+    if ( !RETVAL )
+      croak( "Seq::Native::TxMap: cannot open '%s'", path );
+  OUTPUT:
+    RETVAL
+
+IV
+transcripts( map )
+    SEQ_TXMAP *map
+  CODE:
+    RETVAL = map->n_tx;
+  OUTPUT:
+    RETVAL
+
+IV
+exons( map )
+    SEQ_TXMAP *map
+  CODE:
+    RETVAL = map->n_exon;
+  OUTPUT:
+    RETVAL
+
+void
+map( map, abs_pos )
+    SEQ_TXMAP *map
+    IV abs_pos
+  PREINIT:
+    SEQ_TXMAP_POS *pos;
+    long n;
+  PPCODE:
+    n = seq_txmap_find( map, abs_pos, NULL, 0 );
+    Newx( pos, n ? n : 1, SEQ_TXMAP_POS );
+    SAVEFREEPV( pos );
+    seq_txmap_find( map, abs_pos, pos, n );
+    EXTEND( SP, n );
+    for ( long i = 0; i < n; i++ )
+      mPUSHs( txmap_hit( aTHX_ map, &pos[i] ) );
+
+SV *
+map_sorted( map, pos_sv )
+    SEQ_TXMAP *map
+    SV *pos_sv
+  PREINIT:
+    AV *av, *out;
+    SSize_t n;
+    long *abs_pos, *idx, nHit;
+    SEQ_TXMAP_POS *hit;
+  CODE:
+    /* one array of hits per position, in the order given */
+    av = sv_to_av( aTHX_ pos_sv, "positions" );
+    n = av_len( av ) + 1;
+    Newx( abs_pos, n ? n : 1, long );
+    SAVEFREEPV( abs_pos );
+    for ( SSize_t i = 0; i < n; i++ )
+    {
+      SV **svp = av_fetch( av, i, 0 );
+      abs_pos[i] = svp && SvOK( *svp ) ? (long)SvIV( *svp ) : -1;
+      if ( i && abs_pos[i] < abs_pos[i - 1] )
+        croak( "Seq::Native::TxMap::map_sorted: positions are not sorted" );
+    }
+    nHit = seq_txmap_find_sorted( map, abs_pos, n, NULL, NULL, 0 );
+    Newx( hit, nHit ? nHit : 1, SEQ_TXMAP_POS );
+    SAVEFREEPV( hit );
+    Newx( idx, nHit ? nHit : 1, long );
+    SAVEFREEPV( idx );
+    seq_txmap_find_sorted( map, abs_pos, n, hit, idx, nHit );
+    out = newAV();
+    av_extend( out, n ? n - 1 : 0 );
+    for ( SSize_t i = 0; i < n; i++ )
+      av_store( out, i, newRV_noinc( (SV *)newAV() ) );
+    for ( long h = 0; h < nHit; h++ )
+    {
+      SV **slot = av_fetch( out, idx[h], 0 );
+      av_push( (AV *)SvRV( *slot ), txmap_hit( aTHX_ map, &hit[h] ) );
+    }
+    RETVAL = newRV_noinc( (SV *)out );
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY( map )
+    SEQ_TXMAP *map
+  CODE:
+    seq_txmap_free( map );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::SnpReader
+
+PROTOTYPES: DISABLE
+
+SEQ_SNPSTREAM *
+new( CLASS, path, start = 0, end = 0 )
+    char *CLASS
+    char *path
+    UV start
+    UV end
+  CODE:
+    Newxz( RETVAL, 1, SEQ_SNPSTREAM );
+    RETVAL->reader = seq_snpreader_open_range( path, start, end );
+    if ( !RETVAL->reader )
+    {
+      Safefree( RETVAL );
+      croak( "Seq::Native::SnpReader: cannot open '%s'", path );
+    }
+  OUTPUT:
+    RETVAL
+
+SV *
+header( stream )
+    SEQ_SNPSTREAM *stream
+  PREINIT:
+    long n;
+  CODE:
+    /* the next row, split but not checked for snp columns */
+    n = seq_snpreader_read( stream->reader, &stream->batch, 1 );
+    if ( n < 0 )
+      croak( "Seq::Native::SnpReader: cannot read the snpfile" );
+    RETVAL = n ? snprow_fields( aTHX_ &stream->batch, 0 ) : newSV( 0 );
+  OUTPUT:
+    RETVAL
+
+void
+set_columns( stream, col_sv )
+    SEQ_SNPSTREAM *stream
+    SV *col_sv
+  PREINIT:
+    AV *av;
+    int col[SEQ_SNP_N_COL];
+  CODE:
+    av = sv_to_av( aTHX_ col_sv, "columns" );
+    for ( int c = 0; c < SEQ_SNP_N_COL; c++ )
+    {
+      SV **svp = av_fetch( av, c, 0 );
+      col[c] = svp && SvOK( *svp ) ? (int)SvIV( *svp ) : -1;
+    }
+    seq_snpreader_set_columns( stream->reader, col );
+
+void
+set_samples( stream, col_sv, name_sv )
+    SEQ_SNPSTREAM *stream
+    SV *col_sv
+    SV *name_sv
+  PREINIT:
+    AV *cols;
+    AV *names;
+    long n;
+    int *col;
+    long nWord;
+  CODE:
+    cols = sv_to_av( aTHX_ col_sv, "sample columns" );
+    names = sv_to_av( aTHX_ name_sv, "sample names" );
+    n = av_len( cols ) + 1;
+    if ( av_len( names ) + 1 != n )
+      croak( "Seq::Native::SnpReader: %ld sample columns but %ld names", n,
+        (long)( av_len( names ) + 1 ) );
+    snpstream_free_samples( stream );
+    nWord = seq_geno_words( n ) + 1;
+    Newx( col, n + 1, int );
+    Newxz( stream->name, n + 1, char * );
+    Newx( stream->name_len, n + 1, STRLEN );
+    Newx( stream->het, nWord, uint64_t );
+    Newx( stream->hom, nWord, uint64_t );
+    Newx( stream->other, nWord, uint64_t );
+    for ( long i = 0; i < n; i++ )
+    {
+      SV **colp = av_fetch( cols, i, 0 );
+      SV **namep = av_fetch( names, i, 0 );
+      STRLEN len = 0;
+      const char *name = namep ? SvPV( *namep, len ) : "";
+      col[i] = colp && SvOK( *colp ) ? (int)SvIV( *colp ) : -1;
+      stream->name[i] = savepvn( name, len );
+      stream->name_len[i] = len;
+    }
+    if ( !seq_snpreader_set_samples( stream->reader, col, n ) )
+    {
+      Safefree( col );
+      croak( "Seq::Native::SnpReader: out of memory" );
+    }
+    Safefree( col );
+
+SV *
+next_batch( stream, max = 1000 )
+    SEQ_SNPSTREAM *stream
+    IV max
+  PREINIT:
+    const SEQ_SNPBATCH *batch;
+    long n;
+    AV *rows;
+  CODE:
+    batch = &stream->batch;
+    n = seq_snpreader_read( stream->reader, &stream->batch, max > 0 ? max : 1 );
+    if ( n < 0 )
+      croak( "Seq::Native::SnpReader: cannot read the snpfile" );
+    if ( n == 0 )
+      XSRETURN_UNDEF;
+    rows = newAV();
+    av_extend( rows, n - 1 );
+    for ( long r = 0; r < n; r++ )
+    {
+      const SEQ_SNPROW *row = &batch->row[r];
+      AV *out;
+      if ( !stream->reader->have_col )
+      {
+        av_push( rows, snprow_fields( aTHX_ batch, r ) );
+        continue;
+      }
+      /* chr, pos, ref, type, alleles, allele_count, \@fields, and with
+       *  samples set the carriers in place of the fields */
+      out = newAV();
+      av_extend( out, SEQ_SNP_N_COL + 1 );
+      for ( int c = 0; c < SEQ_SNP_N_COL; c++ )
+        av_push( out, c == SEQ_SNP_POS ? newSViv( row->pos )
+          : snpbatch_sv( aTHX_ batch, row->snp[c] ) );
+      if ( stream->name )
+      {
+        av_push( out, newSV( 0 ) );
+        av_push( out, snprow_carriers( aTHX_ stream, r ) );
+      }
+      else
+        av_push( out, snprow_fields( aTHX_ batch, r ) );
+      av_push( rows, newRV_noinc( (SV *)out ) );
+    }
+    RETVAL = newRV_noinc( (SV *)rows );
+  OUTPUT:
+    RETVAL
+
+UV
+offset( stream )
+    SEQ_SNPSTREAM *stream
+  CODE:
+    RETVAL = seq_snpreader_offset( stream->reader );
+  OUTPUT:
+    RETVAL
+
+IV
+lines( stream )
+    SEQ_SNPSTREAM *stream
+  CODE:
+    RETVAL = stream->reader->lines;
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY( stream )
+    SEQ_SNPSTREAM *stream
+  CODE:
+    snpstream_free_samples( stream );
+    seq_snpreader_close( stream->reader );
+    seq_snpbatch_free( &stream->batch );
+    Safefree( stream );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::Writer
+
+PROTOTYPES: DISABLE
+
+SEQ_WRITER *
+new( CLASS, path, threads = 0, index = 0 )
+    char *CLASS
+    char *path
+    int threads
+    int index
+  CODE:
+    RETVAL = seq_writer_open( path, NULL, threads );
+    if ( !RETVAL )
+      croak( "Seq::Native::Writer: cannot write '%s'", path );
+    /* rows of chr and pos first, as annotate_snpfile writes them */
+    if ( index && RETVAL->gz && !seq_writer_index( RETVAL, 1, 2 ) ) {
+      seq_writer_close( RETVAL );
+      seq_writer_free( RETVAL );
+      croak( "Seq::Native::Writer: out of memory" );
+    }
+  OUTPUT:
+    RETVAL
+
+void
+write( w, text )
+    SEQ_WRITER *w
+    SV *text
+  PREINIT:
+    STRLEN len;
+    const char *s;
+  CODE:
+    if ( !w->fh )
+      croak( "Seq::Native::Writer: write after close" );
+    s = SvPV( text, len );
+    if ( !seq_writer_add( w, s, len ) )
+      croak( "Seq::Native::Writer: cannot write the output" );
+
+void
+close( w )
+    SEQ_WRITER *w
+  CODE:
+    if ( !seq_writer_close( w ) )
+      croak( "Seq::Native::Writer: cannot finish writing the output" );
+
+SV *
+stats( w )
+    SEQ_WRITER *w
+  PREINIT:
+    HV *all;
+  CODE:
+    /* { stage => { threads, items, depth, max_depth, wait_in, wait_out, busy } } */
+    all = newHV();
+    for ( int i = 0; i < w->pipe->n_stage; i++ )
+    {
+      SEQ_PIPE_STATS st;
+      HV *stage = newHV();
+      seq_pipe_stats( w->pipe, i, &st );
+      hv_stores( stage, "threads", newSViv( st.threads ) );
+      hv_stores( stage, "items", newSVuv( st.items ) );
+      hv_stores( stage, "depth", newSViv( st.depth ) );
+      hv_stores( stage, "max_depth", newSViv( st.max_depth ) );
+      hv_stores( stage, "wait_in", newSVnv( st.wait_in ) );
+      hv_stores( stage, "wait_out", newSVnv( st.wait_out ) );
+      hv_stores( stage, "busy", newSVnv( st.busy ) );
+      hv_store( all, st.name, strlen( st.name ), newRV_noinc( (SV *)stage ), 0 );
+    }
+    RETVAL = newRV_noinc( (SV *)all );
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY( w )
+    SEQ_WRITER *w
+  CODE:
+    seq_writer_close( w );
+    seq_writer_free( w );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::Formatter
+
+PROTOTYPES: DISABLE
+
+SEQ_FORMAT *
+new( CLASS, header_sv )
+    char *CLASS
+    SV *header_sv
+  PREINIT:
+    AV *header;
+  CODE:
+    header = sv_to_av( aTHX_ header_sv, "header" );
+    Newxz( RETVAL, 1, SEQ_FORMAT );
+    RETVAL->n = av_len( header ) + 1;
+    Newx( RETVAL->key, RETVAL->n + 1, SV * );
+    Newx( RETVAL->hash, RETVAL->n + 1, U32 );
+    for ( long c = 0; c < RETVAL->n; c++ ) {
+      SV **f = av_fetch( header, c, 0 );
+      STRLEN len;
+      const char *name = f && SvOK( *f ) ? SvPV( *f, len ) : ( len = 0, "" );
+      RETVAL->key[c] = newSVpvn( name, len );
+      PERL_HASH( RETVAL->hash[c], name, len );
+    }
+  OUTPUT:
+    RETVAL
+
+SV *
+format( f, entries_sv )
+    SEQ_FORMAT *f
+    SV *entries_sv
+  PREINIT:
+    AV *entries;
+  CODE:
+    entries = sv_to_av( aTHX_ entries_sv, "entries" );
+    f->text.len = 0;
+    format_rows( aTHX_ f, entries, &f->text, NULL );
+    RETVAL = newSVpvn( f->text.s ? f->text.s : "", f->text.len );
+  OUTPUT:
+    RETVAL
+
+void
+write( f, entries_sv, w )
+    SEQ_FORMAT *f
+    SV *entries_sv
+    SEQ_WRITER *w
+  CODE:
+    if ( !w->fh )
+      croak( "Seq::Native::Writer: write after close" );
+    if ( !format_rows( aTHX_ f, sv_to_av( aTHX_ entries_sv, "entries" ), NULL, w ) )
+      croak( "Seq::Native::Writer: cannot write the output" );
+
+void
+DESTROY( f )
+    SEQ_FORMAT *f
+  CODE:
+    for ( long c = 0; c < f->n; c++ )
+      SvREFCNT_dec( f->key[c] );
+    Safefree( f->key );
+    Safefree( f->hash );
+    seq_buf_free( &f->text );
+    Safefree( f );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::Stats
+
+PROTOTYPES: DISABLE
+
+SEQ_STATS *
+new( CLASS )
+    char *CLASS
+  CODE:
+    RETVAL = seq_stats_new();
+    if ( !RETVAL )
+      croak( "Seq::Native::Stats: out of memory" );
+  OUTPUT:
+    RETVAL
+
+IV
+cell( stats, path )
+    SEQ_STATS *stats
+    SV *path
+  PREINIT:
+    STRLEN len;
+    const char *s;
+  CODE:
+    s = SvPV( path, len );
+    RETVAL = seq_stats_cell( stats, s, len );
+    if ( RETVAL < 0 )
+      croak( "Seq::Native::Stats: out of memory" );
+  OUTPUT:
+    RETVAL
+
+void
+record( stats, genos_sv, ref, tv_cell, tr_cell, snp_cell, features_sv )
+    SEQ_STATS *stats
+    SV *genos_sv
+    char ref
+    int tv_cell
+    int tr_cell
+    int snp_cell
+    SV *features_sv
+  PREINIT:
+    HV *genos;
+    AV *features;
+    HE *he;
+    SEQ_STATS_SITE site;
+    long i;
+  CODE:
+    genos = sv_to_hv( aTHX_ genos_sv, "genotypes" );
+    site.ref     = ref;
+    site.trtv[0] = tv_cell;
+    site.trtv[1] = tr_cell;
+    site.snp     = snp_cell;
+    site.n_feature = 0;
+    if ( SvOK( features_sv ) ) {
+      features = sv_to_av( aTHX_ features_sv, "features" );
+      for ( i = 0; i <= av_len( features ) && i < SEQ_STATS_FEATURES; i++ ) {
+        SV **f = av_fetch( features, i, 0 );
+        site.feature[site.n_feature++] = f ? (int)SvIV( *f ) : -1;
+        if ( site.feature[site.n_feature - 1] < 0 || site.feature[site.n_feature - 1]
+            >= (int)stats->cells.n )
+          croak( "Seq::Native::Stats::record() got an unknown cell" );
+      }
+    }
+    if ( tv_cell >= (int)stats->cells.n || tr_cell >= (int)stats->cells.n
+        || snp_cell >= (int)stats->cells.n )
+      croak( "Seq::Native::Stats::record() got an unknown cell" );
+
+    hv_iterinit( genos );
+    while ( ( he = hv_iternext( genos ) ) ) {
+      I32 idLen;
+      STRLEN genoLen;
+      const char *id = hv_iterkey( he, &idLen );
+      const char *geno = SvPV( hv_iterval( genos, he ), genoLen );
+      long sample = seq_stats_sample( stats, id, (size_t)idLen );
+      if ( sample < 0 )
+        croak( "Seq::Native::Stats: out of memory" );
+      seq_stats_carrier( stats, sample, &site, geno, genoLen );
+    }
+
+SV *
+export( stats, stats_key, count_key )
+    SEQ_STATS *stats
+    SV *stats_key
+    SV *count_key
+  PREINIT:
+    HV *out;
+    uint32_t s, c;
+  CODE:
+    /* { sample => { feature => { feature => .., stats_key => { count_key => n } } } } */
+    out = newHV();
+    for ( s = 0; s < stats->samples.n; s++ ) {
+      size_t idLen;
+      const char *id = seq_dict_str( &stats->samples, s + 1, &idLen );
+      HV *sample;
+      if ( !stats->seen[s] )
+        continue;
+      sample = newHV();
+      hv_store( out, id, (I32)idLen, newRV_noinc( (SV *)sample ), 0 );
+      for ( c = 0; c < stats->cells.n; c++ ) {
+        uint32_t n = seq_stats_get( stats, s, c );
+        size_t pathLen;
+        const char *path, *end, *key;
+        STRLEN keyLen;
+        HV *at = sample;
+        if ( !n )
+          continue;
+        path = seq_dict_str( &stats->cells, c + 1, &pathLen );
+        end = path + pathLen;
+        while ( path < end ) {
+          const char *tab = memchr( path, '\t', end - path );
+          const char *stop = tab ? tab : end;
+          at = child_hv( aTHX_ at, path, (I32)( stop - path ) );
+          path = tab ? tab + 1 : end;
+        }
+        key = SvPV( stats_key, keyLen );
+        at = child_hv( aTHX_ at, key, (I32)keyLen );
+        key = SvPV( count_key, keyLen );
+        hv_store( at, key, (I32)keyLen, newSVuv( n ), 0 );
+      }
+    }
+    RETVAL = newRV_noinc( (SV *)out );
+  OUTPUT:
+    RETVAL
+
+void
+reset( stats )
+    SEQ_STATS *stats
+  CODE:
+    seq_stats_reset( stats );
+
+SV *
+dump( stats )
+    SEQ_STATS *stats
+  PREINIT:
+    SEQ_BUF buf = { 0 };
+  CODE:
+    if ( !seq_stats_dump( stats, &buf ) ) {
+      seq_buf_free( &buf );
+      croak( "Seq::Native::Stats: out of memory" );
+    }
+    RETVAL = newSVpvn( buf.s ? buf.s : "", buf.len );
+    seq_buf_free( &buf );
+  OUTPUT:
+    RETVAL
+
+SEQ_STATS *
+load( CLASS, bytes )
+    char *CLASS
+    SV *bytes
+  PREINIT:
+    STRLEN len;
+    const char *s;
+  CODE:
+    s = SvPV( bytes, len );
+    RETVAL = seq_stats_load( s, len );
+    if ( !RETVAL )
+      croak( "Seq::Native::Stats: not a statistics dump" );
+  OUTPUT:
+    RETVAL
+
+void
+merge( stats, from )
+    SEQ_STATS *stats
+    SEQ_STATS *from
+  CODE:
+    if ( !seq_stats_merge( stats, from ) )
+      croak( "Seq::Native::Stats: out of memory" );
+
+IV
+samples( stats )
+    SEQ_STATS *stats
+  CODE:
+    RETVAL = stats->samples.n;
+  OUTPUT:
+    RETVAL
+
+IV
+cells( stats )
+    SEQ_STATS *stats
+  CODE:
+    RETVAL = stats->cells.n;
+  OUTPUT:
+    RETVAL
+
+void
+DESTROY( stats )
+    SEQ_STATS *stats
+  CODE:
+    seq_stats_free( stats );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::Quantiles
+
+PROTOTYPES: DISABLE
+
+void
+screen( ratios_sv, thresholds_sv, lower, upper )
+    SV *ratios_sv
+    SV *thresholds_sv
+    int lower
+    int upper
+  PREINIT:
+    AV *ratios;
+    AV *thresholds;
+    double th[SEQ_QUANTILE_MAX];
+    double q[SEQ_QUANTILE_MAX];
+    double *vals;
+    double *work;
+    long *outside;
+    long n, n_out, i;
+    int n_th;
+    AV *q_av;
+    AV *ids;
+  PPCODE:
+    ratios     = sv_to_av( aTHX_ ratios_sv, "ratios" );
+    thresholds = sv_to_av( aTHX_ thresholds_sv, "thresholds" );
+    n_th = (int)( av_len( thresholds ) + 1 );
+    if ( n_th > SEQ_QUANTILE_MAX )
+      croak( "Seq::Native::Quantiles: at most %d thresholds", SEQ_QUANTILE_MAX );
+    if ( lower < 0 || lower >= n_th || upper < 0 || upper >= n_th )
+      croak( "Seq::Native::Quantiles: no threshold %d or %d", lower, upper );
+    for ( i = 0; i < n_th; i++ ) {
+      SV **t = av_fetch( thresholds, i, 0 );
+      th[i] = t ? SvNV( *t ) : 0;
+    }
+
+    n = av_len( ratios ) + 1;
+    for ( i = 0; i < n; i++ ) {
+      SV **r = av_fetch( ratios, i, 0 );
+      if ( !r || !SvROK( *r ) || SvTYPE( SvRV( *r ) ) != SVt_PVAV )
+        croak( "Seq::Native::Quantiles: ratio %ld is not an [id, ratio] pair", i );
+    }
+    Newx( vals, n + 1, double );
+    Newx( work, n + 1, double );
+    Newx( outside, n + 1, long );
+    for ( i = 0; i < n; i++ ) {
+      SV **v = av_fetch( (AV *)SvRV( *av_fetch( ratios, i, 0 ) ), 1, 0 );
+      vals[i] = work[i] = v ? SvNV( *v ) : 0;
+    }
+
+    /* the quantiles from a copy, so the screen sees the ratios in order */
+    seq_quantiles( work, n, th, n_th, q );
+    n_out = n ? seq_quantile_outside( vals, n, q[lower], q[upper], outside ) : 0;
+
+    q_av = newAV();
+    for ( i = 0; i < n_th; i++ )
+      av_push( q_av, isnan( q[i] ) ? newSV( 0 ) : newSVnv( q[i] ) );
+    ids = newAV();
+    for ( i = 0; i < n_out; i++ ) {
+      SV **id = av_fetch( (AV *)SvRV( *av_fetch( ratios, outside[i], 0 ) ), 0, 0 );
+      av_push( ids, id ? newSVsv( *id ) : newSV( 0 ) );
+    }
+    Safefree( vals );
+    Safefree( work );
+    Safefree( outside );
+
+    EXTEND( SP, 2 );
+    PUSHs( sv_2mortal( newRV_noinc( (SV *)q_av ) ) );
+    PUSHs( sv_2mortal( newRV_noinc( (SV *)ids ) ) );
+
+MODULE = Seq::Native    PACKAGE = Seq::Native::GeneWriter
+
+PROTOTYPES: DISABLE
+
+SEQ_GENEDB_WRITER *
+new( CLASS )
+    char *CLASS
+  CODE:
+    RETVAL = seq_genedb_writer_new();
+    if ( !RETVAL )
+      croak( "Seq::Native::GeneWriter: cannot create writer" );
+  OUTPUT:
+    RETVAL
+
+IV
+add_transcript( w, tx_sv )
+    SEQ_GENEDB_WRITER *w
+    SV *tx_sv
+  PREINIT:
+    HV *tx, *alt_hv = NULL;
+    AV *err_av = NULL;
+    SV **svp;
+    STRLEN seq_len, ann_len;
+    const char *id, *strand, *seq, *ann;
+    const char **alt = NULL, **err = NULL;
+    int n_alt = 0, n_err = 0;
+    int32_t cds_start = -1;
+  CODE:
+    /* the transcript, as Seq::Gene has it; its sites are added separately */
+    tx = sv_to_hv( aTHX_ tx_sv, "transcript" );
+    id = SvPV_nolen( fetch_required( aTHX_ tx, "transcript_id" ) );
+    strand = SvPV_nolen( fetch_required( aTHX_ tx, "strand" ) );
+    seq = SvPV( fetch_required( aTHX_ tx, "transcript_seq" ), seq_len );
+    ann = SvPV( fetch_required( aTHX_ tx, "transcript_annotation" ), ann_len );
+    if ( seq_len != ann_len )
+      croak( "Seq::Native::GeneWriter: sequence and annotation of %s differ in length", id );
+    for ( STRLEN i = 0; i < ann_len; i++ )
+    {
+      if ( ann[i] == 'A' || ann[i] == 'C' || ann[i] == 'G' || ann[i] == 'T' )
+      {
+        cds_start = (int32_t)i;
+        break;
+      }
+    }
+
+    if ( ( svp = hv_fetchs( tx, "alt_names", 0 ) ) && SvOK(*svp) )
+    {
+      HE *he;
+      alt_hv = sv_to_hv( aTHX_ *svp, "alt_names" );
+      Newx( alt, 2 * HvUSEDKEYS(alt_hv) + 1, const char * );
+      SAVEFREEPV( alt );
+      hv_iterinit( alt_hv );
+      while ( ( he = hv_iternext( alt_hv ) ) )
+      {
+        SV *val = HeVAL(he);
+        STRLEN klen;
+        alt[2 * n_alt] = HePV( he, klen );
+        alt[2 * n_alt + 1] = SvOK(val) ? SvPV_nolen(val) : NULL;
+        n_alt++;
+      }
+    }
+    if ( ( svp = hv_fetchs( tx, "error_code", 0 ) ) && SvOK(*svp) )
+    {
+      err_av = sv_to_av( aTHX_ *svp, "error_code" );
+      Newx( err, av_len(err_av) + 2, const char * );
+      SAVEFREEPV( err );
+      for ( SSize_t i = 0; i <= av_len(err_av); i++ )
+      {
+        SV **e = av_fetch( err_av, i, 0 );
+        err[n_err++] = ( e && SvOK(*e) ) ? SvPV_nolen(*e) : NULL;
+      }
+    }
+
+    RETVAL = seq_genedb_writer_add_tx( w, id, strand[0], seq, (uint32_t)seq_len, cds_start,
+      alt, n_alt, err, n_err );
+    if ( RETVAL < 0 )
+      croak( "Seq::Native::GeneWriter: cannot add transcript %s", id );
+  OUTPUT:
+    RETVAL
+
+void
+add_transcript_sites( w, tx, pos_sv, annotation_sv )
+    SEQ_GENEDB_WRITER *w
+    IV tx
+    SV *pos_sv
+    SV *annotation_sv
+  PREINIT:
+    AV *pos_av;
+    STRLEN n;
+    const char *ann;
+    const SEQ_GENEDB_TX *t;
+  CODE:
+    /* one site per transcript base: Seq::Gene's transcript_abs_position and
+     * transcript_annotation */
+    if ( tx < 0 || tx >= w->n_tx )
+      croak( "Seq::Native::GeneWriter: unknown transcript %" IVdf, tx );
+    t = &w->tx[tx];
+    pos_av = sv_to_av( aTHX_ pos_sv, "positions" );
+    ann = SvPV( annotation_sv, n );
+    if ( n != t->seq_len || (STRLEN)( av_len(pos_av) + 1 ) != n )
+      croak( "Seq::Native::GeneWriter: transcript %" IVdf " has %u bases", tx, t->seq_len );
+    for ( STRLEN i = 0; i < n; i++ )
+    {
+      SV **svp = av_fetch( pos_av, i, 0 );
+      int type;
+      switch ( ann[i] )
+      {
+      case '5': type = SEQ_GENE_UTR5; break;
+      case '3': type = SEQ_GENE_UTR3; break;
+      case '0': type = SEQ_GENE_NCRNA; break;
+      case 'A': case 'C': case 'G': case 'T': type = SEQ_GENE_CODING; break;
+      default:
+        croak( "Seq::Native::GeneWriter: unknown site code %c", ann[i] );
+      }
+      if ( !svp || seq_genedb_writer_add_site( w, SvIV(*svp), tx, (uint32_t)i, type,
+            w->seq[t->seq_off + i] ) )
+        croak( "Seq::Native::GeneWriter: cannot add site %lu of transcript %" IVdf,
+          (unsigned long)i, tx );
+    }
+
+void
+add_site( w, abs_pos, tx, site_type, ref_base )
+    SEQ_GENEDB_WRITER *w
+    IV abs_pos
+    IV tx
+    char *site_type
+    char *ref_base
+  PREINIT:
+    int type;
+  CODE:
+    /* splice sites, which are off the transcript */
+    type = seq_gene_site_type_code( site_type );
+    if ( type < 0 )
+      croak( "Seq::Native::GeneWriter: unknown site type '%s'", site_type );
+    if ( seq_genedb_writer_add_site( w, abs_pos, tx, 0, type, ref_base[0] ) )
+      croak( "Seq::Native::GeneWriter: cannot add site at %" IVdf, abs_pos );
+
+IV
+count( w )
+    SEQ_GENEDB_WRITER *w
+  CODE:
+    RETVAL = w->n;
+  OUTPUT:
+    RETVAL
+
+void
+write( w, path )
+    SEQ_GENEDB_WRITER *w
+    char *path
+  CODE:
+    if ( seq_genedb_writer_write( w, path ) )
+      croak( "Seq::Native::GeneWriter: cannot write '%s'", path );
+
+void
+DESTROY( w )
+    SEQ_GENEDB_WRITER *w
+  CODE:
+    seq_genedb_writer_free( w );
@@ -0,0 +1,378 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+package Seq::Native;
+
+our $VERSION = '0.001';
+
+# ABSTRACT: XS binding to libseq, the native runtime for Seq
+# VERSION
+
+=head1 DESCRIPTION
+
+  @class B<Seq::Native>
+
+  Loads the XS half of libseq (see c/src). The classes it provides are thin
+  handles over C structures; they have no Moose meta and are meant to sit
+  underneath the Moose classes that already exist.
+
+  Build with `make -C c xs` and add c/perl/blib/{lib,arch} to @INC, or
+  install from c/perl in the usual ExtUtils::MakeMaker way.
+
+Used in:
+
+=for :list
+* @class Seq::GenomeBin
+* @class Seq::Annotate
+* @class Seq::Build::SnpTrack
+
+=head2 Seq::Native::Track
+
+  A read-only, memory-mapped genome-sized track. Forked workers that map the
+  same file share the page cache instead of each reading its own copy.
+
+  my $track = Seq::Native::Track->new( $idx_file, $width );
+
+@param $width
+  1 for genome, score and cadd tracks; 2 for the ngene track (16-bit in
+  network order)
+
+  $track->set_score( $min, $max, $R );  # score and cadd tracks only
+  $track->get_base($abs_pos);           # site code, 0-255
+  $track->get_score($abs_pos);          # '%0.3f' formatted score or 'NA'
+  $track->get_nearest_gene($abs_pos);   # gene number, ngene tracks only
+  $track->length;                       # number of positions
+  $track->size;                         # bytes in the file
+
+  All positions are zero-indexed absolute positions; accessors croak when the
+  position is outside the track, like Seq::GenomeBin always has.
+
+  Genome tracks can also be decoded a region at a time; both ranges are
+  inclusive and the decode runs over the whole block with AVX2 or SSSE3
+  when available (see c/src/seq_sitecode.h):
+
+  # number of sites with every bit of the mask set, e.g., exonic snp sites
+  $track->count_sites( $start, $end, Seq::Native::SITE_EXON | Seq::Native::SITE_SNP );
+
+  # { base => 'ACGN..', in_gan => "\0\1..", in_exon, in_gene, in_snp }
+  $track->decode_sites( $start, $end );
+
+  The feature bits are the constants SITE_GAN, SITE_EXON, SITE_GENE and
+  SITE_SNP, matching Seq::Config::GenomeSizedTrack.
+
+  A plain snpfile, from just after its header, can be cut into tasks of
+  about equal annotation cost (see c/src/seq_cost.h), as a parallel
+  Seq::annotate_snpfile schedules them; a row costs more in a gene, more
+  again in an exon, and a deletion that for each base it covers:
+
+  my $tasks = $track->cost_tasks( $snpfile, \@header, \%chr_offset, $start, $end,
+    $task_cost, $max_bytes );      # [ [ start, end, cost ], ... ]; end 0 for all
+
+=head2 lookup_batch
+
+  Reads every genome-sized track of an assembly for a batch of positions in
+  one call, prefetching ahead of each lookup (see c/src/seq_batch.h).
+
+  my $batch = Seq::Native::lookup_batch( $genome, $ngene_or_undef,
+    \@score_tracks, \@cadd_tracks_or_empty, \@abs_pos );
+
+@returns {HashRef} one array per field, each parallel to \@abs_pos:
+
+  {
+    site_code    => [ ... ],            # undef when out of range
+    nearest_gene => [ ... ],            # undef without an ngene track
+    scores       => [ [ ... ], ... ],   # one array per score track
+    cadd         => [ [ ... ] x 3 ],    # empty without cadd tracks
+  }
+
+  Scores are formatted like get_score().
+
+=head2 Seq::Native::SnpDb
+
+  A memory-mapped, position-sorted columnar snp store (see
+  c/src/seq_snpdb.h); one per chromosome, in place of the snp kch file.
+
+  my $db = Seq::Native::SnpDb->new( $sdb_file );
+  $db->db_get($abs_pos);  # like Seq::KCManager::db_get, or empty
+  $db->features;          # names of the feature columns
+  $db->count;             # number of records
+  $db->filename;          # path of the store
+
+  db_get() returns the array of records Seq::Build::SnpTrack stored at the
+  position, each shaped like Seq::Site::Snp->as_href:
+
+  [ { abs_pos => .., ref_base => .., snp_id => .., snp_feature => { .. } } ]
+
+  Features that were undefined are left out of snp_feature.
+
+=head2 Seq::Native::SnpWriter
+
+  Collects records in any order and writes the store sorted by position.
+
+  my $writer = Seq::Native::SnpWriter->new( \@features );
+  $writer->add( $abs_pos, $snp_id, $ref_base, \@values );  # undef for missing
+  $writer->write( $sdb_file );
+
+=head2 Seq::Native::GeneDb
+
+  A memory-mapped gene site store (see c/src/seq_genedb.h); one per
+  chromosome, in place of the gene kch file. Each site refers to its
+  transcript, and the codon, residue and codon number are worked out from the
+  transcript sequence on the way out.
+
+  my $db = Seq::Native::GeneDb->new( $gdb_file );
+  $db->db_get($abs_pos);                  # like Seq::KCManager::db_get
+  $db->db_bulk_get( \@abs_pos, $reverse ); # like Seq::KCManager::db_bulk_get
+  $db->count;                             # number of sites
+  $db->transcripts;                       # number of transcripts
+  $db->filename;
+
+  Records are shaped like Seq::Site::Gene->as_href.
+
+  The records at a position once for each snp allele (transcripts outer,
+  alleles inner), with minor_allele set and the new_codon_seq, new_aa_residue
+  and annotation_type of Seq::Site::Annotation filled in, so its builders
+  have nothing left to do:
+
+  $db->db_get_alleles( $abs_pos, \@alleles );
+
+  The consequence of a substitution (alt given on the + strand) for each
+  record at a position, in db_get() order (see c/src/seq_csq.h):
+
+  my @codes = $db->csq( $abs_pos, $alt );
+  Seq::Native::csq_name( $codes[0] );  # 'Synonymous', 'Missense', 'Nonsense',
+                                       # 'Stop Loss', 'Start Loss', 'Splice'
+                                       # or 'None'
+
+  The same codes make up the consequence track genome_genedb --csq writes,
+  one byte per position and alternate base, like the cadd track; the
+  CSQ_MULTI bit marks sites with more than one transcript, and CSQ_MASK
+  takes it off again.
+
+  Range queries, for indels, use an interval index of the transcripts and
+  exons of the store (see c/src/seq_generange.h), made on first use; start
+  and end are both inclusive:
+
+  my @features = $db->overlap( $start, $end );  # { transcript_id, start, end,
+                                                #   feature => 'transcript'
+                                                #   or 'exon' }
+  my ( $sugar, $has_coding, $ref_bases, $n_pos ) =
+    $db->indel_sites( $start, $end, $reverse );  # () when no sites
+
+  indel_sites gives what Seq::Sites::Indels makes of db_bulk_get over the
+  range: the site types joined by '|' (StartLoss and StopLoss for first and
+  stop codons), whether any site is coding, and the first record's reference
+  base at each position.
+
+=head2 Seq::Native::TxMap
+
+  Genomic to cDNA and protein positions over a gene site store (see
+  c/src/seq_txmap.h); the exons are recovered from the transcript sites.
+
+  my $map = Seq::Native::TxMap->new( $gdb_file );
+  my @hits = $map->map($abs_pos);       # one per transcript over abs_pos
+  my $aref = $map->map_sorted( \@abs_pos ); # sorted; an array of hits each
+  $map->transcripts;                    # number of transcripts mapped
+  $map->exons;
+
+  Each hit is { transcript_id, strand, tx_offset, intron, hgvs_c } and, for
+  exonic coding positions, codon_number and hgvs_p; hgvs_c is 'c.12',
+  'c.-3', 'c.*7', 'c.88+2' or, for non-coding transcripts, 'n.5'.
+
+=head2 Seq::Native::SnpReader
+
+  Streams a snpfile, plain or gzipped (see c/src/seq_snpreader.h): a thread
+  inflates it while rows are split, checked as get_clean_fields checks them,
+  and handed out in batches. Bgzipped files are inflated by a few threads,
+  a round of blocks at a time, and a VCF reads as the snpfile
+  bin/Vcf2SeqAnt_SNP_4_1.pl would make of it (c/src/seq_vcf.h): its header
+  is Fragment, Position, Reference, Alleles, Allele_Counts, Type and the
+  samples, each record a row per position it changes, with the GT calls
+  coded as the sample columns of a snpfile.
+
+  my $reader = Seq::Native::SnpReader->new( $snpfile );
+  my $header = $reader->header;               # fields of the first row
+  $reader->set_columns( [ $self->allSnpFieldIdx ] );
+  while ( my $rows = $reader->next_batch( $max ) ) {
+    for my $row (@$rows) {
+      my ( $chr, $pos, $ref, $type, $alleles, $allele_count, $fields_aref ) = @$row;
+    }
+  }
+  $reader->offset;                            # compressed bytes read so far
+  $reader->lines;                             # lines read, kept or not
+
+  A range of a plain snpfile, from just after a newline, reads on its own;
+  each worker of a parallel Seq::annotate_snpfile reads its chunks this way:
+
+  my $reader = Seq::Native::SnpReader->new( $snpfile, $start, $end );  # bytes
+                                                 # [start, end), end 0 for all
+
+  Once the columns are set, rows missing Chr, Position, Reference, Type or
+  Alleles are skipped, as annotate_snpfile would skip them; before that,
+  each row is just its fields.
+
+  $reader->set_samples( [ @ids{@sample_ids} ], \@sample_ids );
+  my ( $het_ids, $hom_ids, $id_genos_href, $unrecognized_aref ) = @{ $row->[7] };
+
+  With the sample columns set as well, each call is coded as the row is read
+  (c/src/seq_genotype.h) and a row holds what Seq::_minor_allele_carriers
+  returns for it, plus the calls it would warn about, in place of its fields
+  ($row->[6] is undef).
+
+=head2 Seq::Native::Writer
+
+  Output that the caller only formats: batches of text go through a
+  pipeline of threads (see c/src/seq_pipe.h and c/src/seq_writer.h) that
+  gzips them, when the path ends in .gz, and writes them in order, so print
+  returns as soon as the text is copied.
+
+  my $writer = Seq::Native::Writer->new( $path, $threads, $index );
+                                              # $threads 0: one per cpu
+  $writer->write($text);
+  $writer->close;                             # croaks if anything failed
+  my $stats = $writer->stats;                 # { format => {..},
+                                              #   compress => {..}, write => {..} }
+
+  Each stage has threads, items, depth and max_depth (of its input queue),
+  and wait_in, wait_out and busy, the seconds its threads spent waiting for
+  input, held back by the next stage, and working; format is the caller.
+
+  Gzipped output is BGZF, blocks of at most 64K that gunzip reads as one
+  stream and tabix can seek in. Given $index, the rows are indexed as they
+  are written, by chromosome (column 1) and position (column 2), and close
+  writes $path.tbi for tabix; rows out of order are written all the same,
+  with a warning in place of the index. Lines before the first row are
+  header lines, as are later ones starting with '#'.
+
+  A writer also ties to a handle, as Seq::Role::ProcessFile makes the
+  output of annotate_snpfile:
+
+  tie *$fh, 'Seq::Native::Writer', $path, $threads, $index;
+  say {$fh} join "\t", @fields;
+
+=head2 Seq::Native::Formatter
+
+  The rows of annotate_snpfile's output made in C from the entry hashes
+  Seq::Annotate returns, as Seq::Role::ProcessFile::print_annotations has
+  them: the values of the header's keys tab separated, 'NA' for a key an
+  entry lacks. The keys are hashed once, at new.
+
+  my $formatter = Seq::Native::Formatter->new( \@header );
+  my $text = $formatter->format( \@entries );
+  $formatter->write( \@entries, $writer );   # a Seq::Native::Writer
+
+  write() formats into the batch the writer is filling, so the text is only
+  ever copied into the buffer it is compressed and written from.
+
+  Scores, from get_score and lookup_batch, are copied from text made for
+  each of a track's 256 codes by set_score, rather than printed each time.
+
+=head2 Seq::Native::Stats
+
+  The per-sample counts of Seq::Statistics::Record as one dense table (see
+  c/src/seq_stats.h): a row per sample and a cell per place in the record,
+  named by the features down to it joined by tabs.
+
+  my $stats = Seq::Native::Stats->new;
+  my $cell  = $stats->cell("SNP\tExonic");   # interned on first use
+  $stats->record( \%id_genos, $ref_base, $tv_cell, $tr_cell, $snp_cell,
+    \@feature_cells );                        # -1, or undef, for none
+  my $href = $stats->export( 'statistics', 'count' );
+  $stats->reset;
+
+  record() counts each call other than $ref_base: 1 in the transition or
+  transversion cell, 1 in the snp cell, and its alleles (2 when homozygous)
+  in each feature cell. export() makes the nested hashes Record would have,
+  { $id => { SNP => { Exonic => { statistics => { count => n } }, .. } } }.
+
+  my $bytes = $stats->dump;                   # samples and cells by name
+  $stats->merge( Seq::Native::Stats->load($bytes) );
+
+  merge() adds another table's counts, matching samples and cells by name,
+  so partial tables of any split of the sites merge, in any order, into
+  the table of all of them. load() croaks on bytes that are not a dump.
+
+=head2 Seq::Native::Quantiles
+
+  Percentiles of the per-sample ratios without sorting them (see
+  c/src/seq_quantile.h), for Seq::Statistics::Percentiles.
+
+  my ( $values, $outsideIds ) = Seq::Native::Quantiles::screen(
+    [ [ $id, $ratio ], .. ], [ .05, .50, .95 ], 0, 2 );
+
+  $values holds the quantile at each threshold (undef with no ratios),
+  interpolated as Percentiles::_calcPercentile does; $outsideIds the ids of
+  the ratios below the quantile of the third argument's threshold or above
+  that of the fourth's.
+
+=head2 Seq::Native::GeneWriter
+
+  my $writer = Seq::Native::GeneWriter->new;
+  my $tx = $writer->add_transcript( \%tx );  # transcript_id, strand,
+                                             # transcript_seq,
+                                             # transcript_annotation,
+                                             # alt_names, error_code
+  $writer->add_site( $abs_pos, $tx, $site_type, $ref_base );  # splice sites
+  $writer->add_transcript_sites( $tx, \@abs_pos, $annotation );
+  $writer->write( $gdb_file );
+
+=head2 Seq::Native::Client
+
+  A pure perl client of genome_server (c/bin), the daemon that maps the
+  tracks of its assemblies once and answers batched lookups over a Unix
+  domain socket; its lookup returns the columns lookup_batch does.
+
+  my $client = Seq::Native::Client->new($socket_path);
+  my $id     = $client->info->{hg38}{id};
+  $client->lookup( $id, \@abs_pos, ( 1 << $n_scores ) - 1 | Seq::Native::Client::TRACK_CADD_ALL );
+
+=head2 Seq::Native::Codec
+
+  Compact binary encoding of the records Seq::KCManager stores; hash keys and
+  short strings are interned into a dictionary, and the key sets of hashes
+  into a schema, so a record is written as its shape and values alone. Both
+  are kept with the db.
+
+  my $codec = Seq::Native::Codec->new;          # or ->new( $max_intern_len )
+  my $bytes = $codec->encode( \@records );
+  my $aref  = $codec->decode($bytes);
+  if ( $codec->dirty ) {
+    my $schema = $codec->schema_dump;
+    my $dict   = $codec->dict_dump;             # marks the codec clean
+  }
+  my $reader = Seq::Native::Codec->new;         # a reader of the same db
+  $reader->schema_load($schema);
+  $reader->dict_load($dict);
+
+=cut
+
+require XSLoader;
+XSLoader::load( 'Seq::Native', $VERSION );
+
+# a Writer tied to a handle takes print, printf and say
+package Seq::Native::Writer;
+
+sub TIEHANDLE {
+  my ( $class, @args ) = @_;
+  return $class->new(@args);
+}
+
+sub PRINT {
+  my $self = shift;
+  $self->write( join( $, // '', @_ ) . ( $\ // '' ) );
+  return 1;
+}
+
+sub PRINTF {
+  my $self = shift;
+  $self->write( sprintf( shift, @_ ) );
+  return 1;
+}
+
+sub CLOSE {
+  $_[0]->close;
+  return 1;
+}
+
+1;
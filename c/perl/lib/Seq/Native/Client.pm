@@ -0,0 +1,162 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+package Seq::Native::Client;
+
+our $VERSION = '0.001';
+
+# ABSTRACT: Client of genome_server, the index-serving daemon
+# VERSION
+
+# Speaks the protocol of c/src/seq_proto.h over the daemon's Unix domain
+# socket. Pure perl, so it needs neither the XS nor the tracks themselves.
+#
+#   my $client = Seq::Native::Client->new($socket_path);
+
+use Carp qw/ croak /;
+use IO::Socket::UNIX;
+use Socket qw/ SOCK_STREAM /;
+
+use constant {
+  MAGIC_REQ   => 0x51514553,
+  MAGIC_RESP  => 0x52514553,
+  VERSION     => 1,
+  OP_INFO     => 1,
+  OP_LOOKUP   => 2,
+  MAX_SITES   => 1 << 20,
+  RESULT_SIZE => 16,
+};
+
+use constant {
+  TRACK_CADD      => 1 << 31,
+  TRACK_CADD_ALL  => 1 << 30,
+  MAX_SCORE_BITS  => 30,
+};
+
+my @status = ( 'ok', 'bad request', 'no such assembly', 'too many sites', 'server error' );
+
+sub new {
+  my ( $class, $socket_path ) = @_;
+
+  my $sock = IO::Socket::UNIX->new( Type => SOCK_STREAM, Peer => $socket_path )
+    or croak "Seq::Native::Client: cannot connect to '$socket_path': $!";
+  binmode $sock;
+  return bless { socket => $sock, path => $socket_path, pid => $$ }, $class;
+}
+
+# the process that connected; a forked child needs a client of its own
+sub pid { $_[0]{pid} }
+
+sub _send {
+  my ( $self, $data ) = @_;
+  my $off = 0;
+  while ( $off < length $data ) {
+    my $put = syswrite( $self->{socket}, $data, length($data) - $off, $off );
+    croak "Seq::Native::Client: cannot write to '$self->{path}': $!" unless $put;
+    $off += $put;
+  }
+}
+
+sub _read {
+  my ( $self, $len ) = @_;
+  my $data = '';
+  while ( length $data < $len ) {
+    my $got = sysread( $self->{socket}, $data, $len - length $data, length $data );
+    croak "Seq::Native::Client: '$self->{path}' hung up" unless $got;
+  }
+  return $data;
+}
+
+# sends a request and returns the response's record count (or payload bytes)
+#   and record size; croaks on a failed request
+sub _request {
+  my ( $self, $op, $assembly, $tracks, $n, $body ) = @_;
+  $self->_send( pack( 'VvvvvVV', MAGIC_REQ, VERSION, $op, $assembly, 0, $tracks, $n ) . $body );
+  my ( $magic, $version, $status, $count, $record_size ) =
+    unpack( 'VvvVV', $self->_read(16) );
+  croak "Seq::Native::Client: '$self->{path}' is not a genome_server"
+    unless $magic == MAGIC_RESP && $version == VERSION;
+  croak sprintf( "Seq::Native::Client: request failed: %s", $status[$status] // $status )
+    if $status;
+  return ( $count, $record_size );
+}
+
+=head2 info
+
+  The assemblies served, keyed by name:
+  { name => { id => 0, scores => [ names.. ], cadd => 0|1 } }
+
+=cut
+
+sub info {
+  my $self = shift;
+  my ($len) = $self->_request( OP_INFO, 0, 0, 0, '' );
+  my %info;
+  for my $line ( split /\n/, $self->_read($len) ) {
+    my ( $id, $name, $scores, $cadd ) = split /\t/, $line, -1;
+    $info{$name} = { id => $id, scores => [ split /,/, $scores ], cadd => $cadd };
+  }
+  return \%info;
+}
+
+sub _score_text {
+  my $val = shift;
+  return $val != $val ? 'NA' : sprintf( "%0.3f", $val );
+}
+
+=head2 lookup
+
+  my $res = $client->lookup( $assembly_id, \@sites, $tracks );
+
+  @sites are zero-indexed absolute positions, or [ abs_pos, ref, alt ] when
+  the cadd score of ref -> alt is wanted; $tracks is a mask of score tracks
+  (bit i for the i-th score of info, of those the assembly has) and
+  TRACK_CADD and TRACK_CADD_ALL.
+  Returns the columns of lookup_batch:
+  { site_code, base, nearest_gene, scores => [ [..] per score track asked ],
+    cadd => [ [..] x 3 ] (TRACK_CADD_ALL), allele_cadd => [..] (TRACK_CADD) }
+  Positions outside the genome have no site_code or base, invalid site codes
+  have no base and without an ngene track there are no nearest genes; all
+  are undef.
+
+=cut
+
+sub lookup {
+  my ( $self, $assembly, $sites_aref, $tracks ) = @_;
+  $tracks //= 0;
+
+  my @score_bits = grep { $tracks & ( 1 << $_ ) } 0 .. MAX_SCORE_BITS - 1;
+  my %res = ( site_code => [], base => [], nearest_gene => [],
+    scores => [ map { [] } @score_bits ] );
+  $res{allele_cadd} = [] if $tracks & TRACK_CADD;
+  $res{cadd} = [ [], [], [] ] if $tracks & TRACK_CADD_ALL;
+
+  for ( my $start = 0; $start < @$sites_aref; $start += MAX_SITES ) {
+    my $end = $start + MAX_SITES - 1;
+    $end = $#$sites_aref if $end > $#$sites_aref;
+    my $body = join '', map {
+      ref $_ ? pack( 'q<a1a1x6', $_->[0], $_->[1] // '', $_->[2] // '' ) : pack( 'q<x8', $_ )
+    } @{$sites_aref}[ $start .. $end ];
+
+    my ( $n, $record_size ) =
+      $self->_request( OP_LOOKUP, $assembly, $tracks, $end - $start + 1, $body );
+    my $n_float = ( $record_size - RESULT_SIZE ) / 4;
+    my $data = $self->_read( $n * $record_size );
+    for my $i ( 0 .. $n - 1 ) {
+      my ( undef, $gene, $code, $base, undef, @val ) =
+        unpack( "q<l<s<a1Cf<$n_float", substr( $data, $i * $record_size, $record_size ) );
+      push @{ $res{site_code} },    $code < 0 ? undef : $code;
+      push @{ $res{base} },         $base eq "\0" ? undef : $base;
+      push @{ $res{nearest_gene} }, $gene < 0 ? undef : $gene;
+      push @{ $res{scores}[$_] }, _score_text( shift @val ) for 0 .. $#score_bits;
+      # the server leaves out cadd for an assembly without it
+      next unless @val;
+      push @{ $res{allele_cadd} }, _score_text( shift @val ) if $res{allele_cadd};
+      push @{ $res{cadd}[$_] }, _score_text( shift @val ) for 0 .. ( @val == 3 ? 2 : -1 );
+    }
+  }
+  return \%res;
+}
+
+1;
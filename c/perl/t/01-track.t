@@ -0,0 +1,95 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 16;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+# char track: every code 0..255 once
+my $char_file = spew_raw( 'test.genome.idx', pack( 'C*', 0 .. 255 ) );
+
+my $track = Seq::Native::Track->new($char_file);
+isa_ok( $track, 'Seq::Native::Track' );
+is( $track->length, 256, 'length of char track' );
+is( $track->size,   256, 'size of char track' );
+is_deeply( [ map { $track->get_base($_) } ( 0 .. 255 ) ], [ 0 .. 255 ], 'get_base' );
+eval { $track->get_base(256) };
+like( $@, qr/get_base\(\) expects a position/, 'get_base() croaks past the end' );
+eval { $track->get_score(0) };
+like( $@, qr/non-score track/, 'get_score() croaks on non-score track' );
+
+# score decoding should match Seq::Config::GenomeSizedTrack::_build_score_lu
+{
+  my ( $min, $max, $R ) = ( -30, 30, 255 );
+  my $beta = ( $R - 1 ) / ( $max - $min );
+  my @exp = ('NA');
+  push @exp, map { sprintf( "%0.3f", ( ( $_ - 1 ) / $beta ) + $min ) } ( 1 .. 255 );
+  $track->set_score( $min, $max, $R );
+  is_deeply( [ map { $track->get_score($_) } ( 0 .. 255 ) ], \@exp, 'get_score' );
+
+  $track->set_score( 0, 1, 101 );
+  is( $track->get_score(102), 'NA', 'codes above R are NA' );
+  eval { $track->set_score( 1, 0, 101 ) };
+  like( $@, qr/impossible score range/, 'set_score() croaks on min > max' );
+}
+
+# ngene track: 16-bit network order
+{
+  my @genes      = ( 0, 1, 255, 256, 65535 );
+  my $ngene_file = spew_raw( 'test.ngene.idx', pack( 'n*', @genes ) );
+  my $ngene = Seq::Native::Track->new( $ngene_file, 2 );
+  is( $ngene->length, scalar @genes, 'length of ngene track' );
+  is_deeply( [ map { $ngene->get_nearest_gene($_) } ( 0 .. $#genes ) ],
+    \@genes, 'get_nearest_gene' );
+  eval { $track->get_nearest_gene(0) };
+  like( $@, qr/not ngene/, 'get_nearest_gene() croaks on char track' );
+}
+
+# cost hints: chr1 at 0, chr2 at 500; sites 100..199 of chr1 are exonic gene
+# sites, the rest intergenic
+{
+  my $genome_file = spew_raw( 'cost.genome.idx',
+    pack( 'C*', (1) x 100, (57) x 100, (1) x 800 ) );
+  my $genome  = Seq::Native::Track->new($genome_file);
+  my @header  = qw/ Fragment Position Reference Type Alleles Allele_Counts /;
+  my $header  = join( "\t", @header ) . "\n";
+  my @rows    = (
+    "chr1\t50\tA\tSNP\tA,C\t2",      # intergenic: 1 + 1
+    "chr1\t150\tA\tSNP\tA,C\t2",     # exonic: 1 + 15
+    "chr1\t150\tA\tDEL\tA,-10\t2",   # 10 exonic bases: 1 + 150
+    "chr9\t10\tA\tSNP\tA,C\t2",      # unknown chromosome: 1
+    "chr2\t1\tA\tMESS\tA,C\t2",      # skipped: 1
+  );
+  my $snpfile = spew_raw( 'cost.snp', $header . join( '', map { "$_\n" } @rows ) );
+  my %offsets = ( chr1 => 0, chr2 => 500 );
+
+  my $tasks = $genome->cost_tasks( $snpfile, \@header, \%offsets, length $header, 0, 1, 0 );
+  is_deeply( [ map { $_->[2] } @$tasks ], [ 2, 16, 151, 1, 1 ],
+    'cost_tasks() hints each row by its sites' );
+  $tasks = $genome->cost_tasks( $snpfile, \@header, \%offsets, length $header, 0, 18, 0 );
+  my @ends = map { length( $header . join '', map { "$_\n" } @rows[ 0 .. $_ ] ) } 1, 2, 4;
+  is_deeply( $tasks,
+    [ [ length $header, $ends[0], 18 ], [ $ends[0], $ends[1], 151 ], [ $ends[1], $ends[2], 2 ] ],
+    'cost_tasks() cuts whole lines once a task costs enough' );
+}
+
+eval { Seq::Native::Track->new( File::Spec->catfile( $dir, 'missing.idx' ) ) };
+like( $@, qr/cannot map/, 'new() croaks on missing file' );
+
+sub spew_raw {
+  my ( $name, $data ) = @_;
+  my $file = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $file or die "cannot write $file: $!";
+  binmode $fh;
+  print {$fh} $data;
+  close $fh;
+  return $file;
+}
@@ -0,0 +1,71 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 8;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+my $size   = 1000;
+my @codes  = map { ( $_ * 7 ) % 256 } ( 0 .. $size - 1 );
+my @genes  = map { ( $_ * 13 ) % 65536 } ( 0 .. $size - 1 );
+my $genome = Seq::Native::Track->new( spew_raw( 'genome', pack( 'C*', @codes ) ) );
+my $ngene  = Seq::Native::Track->new( spew_raw( 'ngene', pack( 'n*', @genes ) ), 2 );
+my $phylop = Seq::Native::Track->new( spew_raw( 'phyloP', pack( 'C*', @codes ) ) );
+$phylop->set_score( -30, 30, 255 );
+
+my @cadd;
+for my $i ( 0 .. 2 ) {
+  my $track = Seq::Native::Track->new(
+    spew_raw( "cadd.$i", pack( 'C*', map { ( $_ + $i ) % 128 } @codes ) ) );
+  $track->set_score( 0, 127, 255 );
+  push @cadd, $track;
+}
+
+my @pos = ( 0, 5, 17, 17, 400, 999, $size, 3 );
+my $batch = Seq::Native::lookup_batch( $genome, $ngene, [$phylop], \@cadd, \@pos );
+
+my @in_range = grep { $pos[$_] < $size } ( 0 .. $#pos );
+
+is_deeply(
+  [ map { $batch->{site_code}[$_] } @in_range ],
+  [ map { $genome->get_base( $pos[$_] ) } @in_range ],
+  'site codes match get_base'
+);
+is_deeply(
+  [ map { $batch->{nearest_gene}[$_] } @in_range ],
+  [ map { $ngene->get_nearest_gene( $pos[$_] ) } @in_range ],
+  'nearest genes match get_nearest_gene'
+);
+is_deeply(
+  [ map { $batch->{scores}[0][$_] } @in_range ],
+  [ map { $phylop->get_score( $pos[$_] ) } @in_range ],
+  'scores match get_score'
+);
+is_deeply(
+  [ map { my $i = $_; [ map { $batch->{cadd}[$_][$i] } ( 0 .. 2 ) ] } @in_range ],
+  [ map { my $p = $pos[$_]; [ map { $_->get_score($p) } @cadd ] } @in_range ],
+  'cadd scores match get_score'
+);
+ok( !defined $batch->{site_code}[6], 'out of range site code is undef' );
+is( $batch->{scores}[0][6], 'NA', 'out of range score is NA' );
+
+$batch = Seq::Native::lookup_batch( $genome, undef, [], [], [ 1, 2 ] );
+is_deeply( $batch->{nearest_gene}, [ undef, undef ], 'no ngene track gives undef' );
+
+sub spew_raw {
+  my ( $name, $data ) = @_;
+  my $file = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $file or die "cannot write $file: $!";
+  binmode $fh;
+  print {$fh} $data;
+  close $fh;
+  return $file;
+}
@@ -0,0 +1,52 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 9;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+# long enough to run through the vector loops and the scalar tail
+my @codes = map { ( $_ * 37 + 11 ) % 256 } ( 0 .. 1000 );
+my $file = File::Spec->catfile( $dir, 'genome.idx' );
+open my $fh, '>', $file or die "cannot write $file: $!";
+binmode $fh;
+print {$fh} pack( 'C*', @codes );
+close $fh;
+
+my $track = Seq::Native::Track->new($file);
+
+# same scheme as Seq::Config::GenomeSizedTrack
+my %base = ( 0 => 'N', 1 => 'A', 2 => 'C', 3 => 'G', 4 => 'T' );
+my ( $start, $end ) = ( 3, 998 );
+my @slice = @codes[ $start .. $end ];
+
+my $decoded = $track->decode_sites( $start, $end );
+is(
+  $decoded->{base},
+  join( '', map { $base{ $_ & 7 } // "\0" } @slice ),
+  'decoded bases'
+);
+
+my %bit = ( in_gan => 8, in_exon => 16, in_gene => 32, in_snp => 64 );
+for my $flag ( sort keys %bit ) {
+  is_deeply(
+    [ unpack( 'C*', $decoded->{$flag} ) ],
+    [ map { ( $_ & $bit{$flag} ) ? 1 : 0 } @slice ], "decoded $flag"
+  );
+}
+
+my $mask = Seq::Native::SITE_EXON() | Seq::Native::SITE_SNP();
+is( $track->count_sites( $start, $end, $mask ),
+  scalar( grep { ( $_ & $mask ) == $mask } @slice ), 'count exonic snp sites' );
+is( $track->count_sites( 0, 0, 0 ), 1, 'empty mask matches every site' );
+
+eval { $track->count_sites( 0, 1001, $mask ) };
+like( $@, qr/count_sites\(\) expects/, 'count_sites() croaks past the end' );
@@ -0,0 +1,68 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 10;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+my $file = File::Spec->catfile( $dir, 'test.snp.chr1.sdb' );
+
+my @features = qw/ alleles alleleFreqs maf /;
+my $writer   = Seq::Native::SnpWriter->new( \@features );
+
+# enough rows to span many fences, added out of order, with a few duplicate
+# positions and ids that don't fit the integer column
+my ( %expect, @order );
+for my $i ( reverse 0 .. 999 ) {
+  my $pos = 10 * $i + 3;
+  my $rec = {
+    abs_pos     => $pos,
+    ref_base    => (qw/ A C G T /)[ $i % 4 ],
+    snp_id      => "rs" . ( 1000 + $i ),
+    snp_feature => {
+      alleles     => ( $i % 2 ? 'A,G' : 'C,T' ),
+      alleleFreqs => '0.25,0.75',
+      ( $i % 3 ? ( maf => sprintf( "%0.6f", $i / 1000 ) ) : () ),
+    },
+  };
+  push @{ $expect{$pos} }, $rec;
+  if ( $i % 100 == 0 ) {
+    push @{ $expect{$pos} },
+      { %$rec, snp_id => ( $i ? "rs0$i" : 'esv123' ), snp_feature => {} };
+  }
+}
+for my $pos ( keys %expect ) {
+  for my $rec ( @{ $expect{$pos} } ) {
+    $writer->add( $pos, $rec->{snp_id}, $rec->{ref_base},
+      [ map { $rec->{snp_feature}{$_} } @features ] );
+  }
+}
+is( $writer->count, 1010, 'writer counts rows' );
+$writer->write($file);
+
+my $db = Seq::Native::SnpDb->new($file);
+is( $db->count, 1010, 'store counts rows' );
+is( $db->filename, $file, 'filename, as Seq::KCManager has' );
+is_deeply( [ $db->features ], \@features, 'features' );
+
+my $got = {};
+for my $pos ( 0 .. 10_010 ) {
+  my $rec_aref = $db->db_get($pos);
+  $got->{$pos} = $rec_aref if defined $rec_aref;
+}
+is_deeply( [ sort { $a <=> $b } keys %$got ], [ sort { $a <=> $b } keys %expect ],
+  'db_get finds every position and nothing else' );
+is_deeply( $got->{9993}, $expect{9993}, 'single record' );
+is_deeply( $got->{3}, $expect{3}, 'records at one position keep their order' );
+is_deeply( $got, \%expect, 'all records round trip' );
+
+my $empty = File::Spec->catfile( $dir, 'empty.sdb' );
+Seq::Native::SnpWriter->new( [] )->write($empty);
+ok( !defined Seq::Native::SnpDb->new($empty)->db_get(3), 'empty store' );
@@ -0,0 +1,105 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use JSON::PP;
+use Test::More;
+
+plan tests => 21;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $codec = Seq::Native::Codec->new;
+
+# the shape of a gene site record (Seq::Site::Gene->as_href)
+my $site = {
+  abs_pos        => 1_234_567,
+  ref_base       => 'A',
+  transcript_id  => 'NM_001005484',
+  site_type      => 'Coding',
+  strand         => '+',
+  codon_number   => 12,
+  codon_position => 0,
+  ref_codon_seq  => 'ATG',
+  ref_aa_residue => 'M',
+  alt_names      => { geneSymbol => 'OR4F5', spID => 'Q8NH21', kgID => 'uc001aal.1' },
+  error_code     => [],
+};
+my $bytes = $codec->encode( [$site] );
+is_deeply( $codec->decode($bytes), [$site], 'gene site round trips' );
+ok( $codec->dirty, 'new strings mark the dictionary' );
+
+my $atoms  = $codec->atoms;
+my $schema = $codec->schema_dump;
+my $again  = $codec->encode( [ { %$site, abs_pos => 1_234_568, codon_position => 1 } ] );
+is( $codec->atoms, $atoms, 'repeated strings are interned once' );
+is( $codec->schema_dump, $schema, 'and a hash of the same keys has the same shape' );
+cmp_ok( 6 * length $again, '<', length encode_json( [$site] ), 'a fraction of the json' );
+
+# a record of a known shape is its values: a tag and a byte or so for each of
+#   the 11 + 3 fields, and no keys
+cmp_ok( length $again, '<=', 2 + 2 + 14 * 2 + 3, 'no bytes for the keys' );
+
+my $mixed = [
+  undef, 0, -1, 2**40, -2**40, 0.25, '0.300000', '007', 'x' x 1000, "caf\x{e9}\x{263a}",
+  [ [], {} ], { '' => '' },
+];
+is_deeply( $codec->decode( $codec->encode($mixed) ), $mixed, 'values keep their type' );
+ok( utf8::is_utf8( $codec->decode( $codec->encode( ["\x{263a}"] ) )->[0] ), 'utf8 flag' );
+
+# more keys than a shape has are written with them
+my %wide = map { ( "key$_" => $_ ) } 1 .. 100;
+is_deeply( $codec->decode( $codec->encode( [ \%wide ] ) ), [ \%wide ], 'a wide hash round trips' );
+
+# a fresh codec with the dumped schema and dictionary reads what the first
+#   one wrote
+$schema = $codec->schema_dump;
+my $dict   = $codec->dict_dump;
+my $reader = Seq::Native::Codec->new;
+eval { $reader->decode($bytes) };
+like( $@, qr/unknown shape/, 'records need the schema they were written with' );
+$reader->schema_load($schema);
+$reader->dict_load($dict);
+ok( !$reader->dirty, 'loaded dictionary is clean' );
+is_deeply( $reader->decode($bytes), [$site], 'records decode with a loaded dictionary' );
+is( $reader->encode( [$site] ), $bytes, 'and encode the same way' );
+
+eval { $reader->decode( substr( $bytes, 0, -1 ) ) };
+like( $@, qr/truncated|corrupt/, 'truncated record croaks' );
+
+# records of one list whose keys are not those of the first: fewer, more,
+#   others, undef and missing fields; the first record's shape must not be
+#   applied to the rest
+my @shapes = (
+  { abs_pos => 10, ref_base => 'C', snp_id => 'rs1', snp_feature => { maf => '0.1' } },
+  { abs_pos => 11, ref_base => 'G' },
+  { abs_pos => 12, ref_base => 'T', snp_id => 'rs2', snp_feature => { maf => undef }, extra => 1 },
+  { snp_id => 'rs3', abs_pos => 13 },
+  { abs_pos => undef, ref_base => undef, snp_id => undef, snp_feature => undef },
+  { other => [ { abs_pos => 14 }, {} ], ref_base => 'A' },
+  {},
+);
+$codec = Seq::Native::Codec->new;
+$bytes = $codec->encode( \@shapes );
+is_deeply( $codec->decode($bytes), \@shapes, 'records of different shapes round trip' );
+my $got = $codec->decode($bytes);
+ok( !exists $got->[1]{snp_id} && exists $got->[4]{snp_id} && !defined $got->[4]{snp_id},
+  'a missing field stays missing and an undef one undef' );
+is_deeply( [ map { $codec->decode( $codec->encode( [$_] ) ) } reverse @shapes ],
+  [ map { [$_] } reverse @shapes ], 'each alone, in any order' );
+
+# as a db keeps them: a reader made from the dumps, and a shape added later
+#   read by a reader made from the grown schema
+$reader = Seq::Native::Codec->new;
+$reader->schema_load( $codec->schema_dump );
+$reader->dict_load( $codec->dict_dump );
+is_deeply( $reader->decode($bytes), \@shapes, 'and decode with the dumped schema and dictionary' );
+my $later = [ { abs_pos => 15, ref_base => 'A', new_field => 'late' }, $shapes[1] ];
+my $laterBytes = $reader->encode($later);
+ok( $reader->dirty, 'a new shape marks the codec' );
+my $third = Seq::Native::Codec->new;
+$third->schema_load( $reader->schema_dump );
+$third->dict_load( $reader->dict_dump );
+is_deeply( [ $third->decode($bytes), $third->decode($laterBytes) ], [ \@shapes, $later ],
+  'a grown schema reads old and new records' );
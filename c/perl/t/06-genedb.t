@@ -0,0 +1,195 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 22;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+my $file = File::Spec->catfile( $dir, 'test.gene.chr1.gdb' );
+
+my %aa = ( ATG => 'M', AAA => 'K', TTT => 'F', TAG => '*', CCC => 'P' );
+
+# a plus strand transcript whose last codon is cut short, a minus strand one
+# (positions run backwards) and a non-coding one
+my @tx = (
+  {
+    transcript_id           => 'NM_1',
+    strand                  => '+',
+    transcript_seq          => 'GGATGAAATTTTAGCC',
+    transcript_annotation   => '55ATGAAATTTTAG33',
+    transcript_abs_position => [ 100 .. 115 ],
+    alt_names               => { geneSymbol => 'ONE', kgID => 'uc1', spID => undef },
+    error_code              => [],
+  },
+  {
+    transcript_id           => 'NM_2',
+    strand                  => '-',
+    transcript_seq          => 'ATGCCCTTTCC',
+    transcript_annotation   => 'ATGCCCTTTCC',
+    transcript_abs_position => [ reverse 110 .. 120 ],
+    alt_names               => { geneSymbol => 'TWO' },
+    error_code => [ 'coding sequence not divisible by 3', 'transcript does not end with stop codon' ],
+  },
+  {
+    transcript_id           => 'NR_3',
+    strand                  => '+',
+    transcript_seq          => 'ACGT',
+    transcript_annotation   => '0000',
+    transcript_abs_position => [ 200 .. 203 ],
+    alt_names               => {},
+    error_code              => [],
+  },
+);
+
+# what Seq::Gene / Seq::Site::Gene->as_href would give for each site
+my %expect;
+my $writer = Seq::Native::GeneWriter->new;
+for my $tx (@tx) {
+  my $ord = $writer->add_transcript($tx);
+  my %base = map { $_ => $tx->{$_} } qw/ transcript_id strand alt_names error_code /;
+
+  # a splice site ahead of the transcript sites, as the gene build adds them
+  my $splice = $tx->{transcript_abs_position}[0] - 1;
+  $writer->add_site( $splice, $ord, 'Splice Acceptor', 'N' );
+  push @{ $expect{$splice} },
+    { %base, abs_pos => $splice, ref_base => 'N', site_type => 'Splice Acceptor' };
+
+  $writer->add_transcript_sites( $ord, $tx->{transcript_abs_position},
+    $tx->{transcript_annotation} );
+  my $coding = 0;
+  my $ann    = $tx->{transcript_annotation};
+  for my $i ( 0 .. length($ann) - 1 ) {
+    my $pos = $tx->{transcript_abs_position}[$i];
+    my $code = substr $ann, $i, 1;
+    my %site = ( %base, abs_pos => $pos, ref_base => substr( $tx->{transcript_seq}, $i, 1 ) );
+    if ( $code =~ m/[ACGT]/ ) {
+      $site{site_type}      = 'Coding';
+      $site{codon_number}   = 1 + int( $coding / 3 );
+      $site{codon_position} = $coding % 3;
+      $site{ref_codon_seq}  = substr $tx->{transcript_seq}, $i - $site{codon_position}, 3;
+      $site{ref_aa_residue} = $aa{ $site{ref_codon_seq} } if exists $aa{ $site{ref_codon_seq} };
+      $coding++;
+    }
+    else {
+      $site{site_type} = { 5 => '5UTR', 3 => '3UTR', 0 => 'non-coding RNA' }->{$code};
+    }
+    push @{ $expect{$pos} }, \%site;
+  }
+}
+is( $writer->count, 34, 'writer counts sites' );
+$writer->write($file);
+
+my $db = Seq::Native::GeneDb->new($file);
+is( $db->count,       34,    'store counts sites' );
+is( $db->transcripts, 3,     'store counts transcripts' );
+is( $db->filename,    $file, 'filename' );
+
+my $got = {};
+for my $pos ( 0 .. 300 ) {
+  my $rec_aref = $db->db_get($pos);
+  $got->{$pos} = $rec_aref if defined $rec_aref;
+}
+is_deeply( [ sort { $a <=> $b } keys %$got ], [ sort { $a <=> $b } keys %expect ],
+  'db_get finds every position and nothing else' );
+is_deeply( $got->{103}, $expect{103}, 'coding site' );
+is_deeply( $got->{115}, $expect{115}, 'overlapping transcripts keep their order' );
+is_deeply( $got, \%expect, 'all sites match Seq::Site::Gene' );
+
+is_deeply( [ $db->db_bulk_get( [ 112, 99, 112, 5, 110 ], 1 ) ],
+  [ @expect{ 112, 110, 99 } ], 'db_bulk_get, reversed' );
+
+eval { $writer->add_site( 1, 99, 'Coding', 'A' ) };
+like( $@, qr/cannot add site/, 'unknown transcript croaks' );
+
+# substitution consequences, per record; 112 is in both coding transcripts
+my %csq = map { Seq::Native::csq_name($_) => $_ } 0 .. 6;
+is_deeply( [ map { Seq::Native::csq_name($_) } $db->csq( 102, 'G' ) ], ['Start Loss'],
+  'ATG > GTG loses the start' );
+is_deeply( [ map { Seq::Native::csq_name($_) } map { $db->csq( @$_ ) } [ 107, 'G' ],
+    [ 105, 'T' ], [ 105, 'C' ] ], [ 'Synonymous', 'Nonsense', 'Missense' ],
+  'synonymous, nonsense and missense' );
+is_deeply( [ map { Seq::Native::csq_name($_) } $db->csq( 112, 'C' ) ],
+  [ 'Stop Loss', 'Missense' ], 'each transcript, minus strand complemented' );
+is_deeply( [ map { Seq::Native::csq_name($_) } map { $db->csq( $_, 'A' ) } 99, 201, 114 ],
+  [ 'Splice', 'None', 'None', 'Synonymous' ], 'splice and non-coding sites' );
+is( Seq::Native::csq_name( $csq{Missense} | Seq::Native::CSQ_MULTI() ), 'Missense',
+  'csq_name ignores the multiple transcript bit' );
+
+# the records of each allele, with Seq::Site::Annotation's substitution done
+my @bases = qw/ A C G T /;
+my %comp  = ( A => 'T', C => 'G', G => 'C', T => 'A' );
+my $table = 'KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF';
+my %code  = map {
+  my $i = $_;
+  ( join( '', map { $bases[ $i >> 2 * ( 2 - $_ ) & 3 ] } 0 .. 2 ) => substr $table, $i, 1 )
+} 0 .. 63;
+my ( %gotAlleles, %expectAlleles );
+for my $pos ( keys %expect ) {
+  $gotAlleles{$pos} = $db->db_get_alleles( $pos, [qw/ A G /] );
+  for my $rec ( @{ $expect{$pos} } ) {
+    for my $allele (qw/ A G /) {
+      my %site = ( %$rec, minor_allele => $allele, new_codon_seq => undef,
+        new_aa_residue => undef, annotation_type => 'Non-Coding' );
+      if ( $rec->{ref_codon_seq} ) {
+        substr( $site{new_codon_seq} = $rec->{ref_codon_seq}, $rec->{codon_position}, 1,
+          $rec->{strand} eq '-' ? $comp{$allele} : $allele );
+        $site{new_aa_residue} = $code{ $site{new_codon_seq} };
+        $site{annotation_type} =
+            !defined $site{new_aa_residue} ? 'Non-Coding'
+          : ( $rec->{ref_aa_residue} // '' ) eq $site{new_aa_residue} ? 'Silent'
+          :                                                              'Replacement';
+      }
+      push @{ $expectAlleles{$pos} }, \%site;
+    }
+  }
+}
+is_deeply( \%gotAlleles, \%expectAlleles, 'db_get_alleles substitutes each allele' );
+is_deeply( [ $db->db_get_alleles( 5, ['A'] ) ], [], 'db_get_alleles: nothing without sites' );
+
+# interval index: transcripts (splice sites included) and exons over a range
+is_deeply( [ map { "$_->{transcript_id} $_->{feature} $_->{start}-$_->{end}" } $db->overlap( 115, 130 ) ],
+  [ 'NM_1 transcript 99-115', 'NM_1 exon 100-115', 'NM_2 transcript 110-120', 'NM_2 exon 110-120' ],
+  'overlap finds transcripts and exons' );
+is_deeply( [ $db->overlap( 122, 198 ) ], [], 'nothing between transcripts' );
+
+# indel_sites is what Seq::Sites::Indels makes of db_bulk_get over the range
+sub indel_sites {
+  my ( $start, $end, $reverse ) = @_;
+  my @data = $db->db_bulk_get( [ $start .. $end ], $reverse );
+  return () unless @data;
+  my ( @sugar, $coding, $ref );
+  for my $rec_aref (@data) {
+    $ref .= $rec_aref->[0]{ref_base};
+    for my $rec (@$rec_aref) {
+      if ( defined $rec->{codon_number} ) {
+        $coding = 1;
+        push @sugar, $rec->{codon_number} == 1 ? 'StartLoss'
+          : ( $rec->{ref_aa_residue} // '' ) eq '*' ? 'StopLoss' : $rec->{site_type};
+      }
+      else {
+        push @sugar, $rec->{site_type};
+      }
+    }
+  }
+  return ( join( '|', @sugar ), $coding ? 1 : 0, $ref, scalar @data );
+}
+my @bad;
+for my $start ( 90 .. 125, 195 .. 205 ) {
+  for my $len ( 1, 2, 5, 20 ) {
+    for my $reverse ( 0, 1 ) {
+      my @args = ( $start, $start + $len - 1, $reverse );
+      push @bad, "@args"
+        unless join( ',', $db->indel_sites(@args) ) eq join( ',', indel_sites(@args) );
+    }
+  }
+}
+is_deeply( \@bad, [], 'indel_sites matches db_bulk_get over every range' );
+is_deeply( [ $db->indel_sites( 101, 103, 1 ) ], [ 'StartLoss|StartLoss|5UTR', 1, 'TAG', 3 ],
+  'deletion over the start codon' );
@@ -0,0 +1,76 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 10;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+my $file = File::Spec->catfile( $dir, 'test.gene.chr1.gdb' );
+
+# NM_1: plus strand, exons 100..105 and 110..117, cds at offsets 2 .. 10
+# NM_2: minus strand, exons 300..303 and 310..315, read from 315 down
+# NR_3: non-coding, one exon 200..203
+my @tx = (
+  {
+    transcript_id           => 'NM_1',
+    strand                  => '+',
+    transcript_seq          => 'GGATGAAATTTTCC',
+    transcript_annotation   => '55ATGAAATTT333',
+    transcript_abs_position => [ 100 .. 105, 110 .. 117 ],
+  },
+  {
+    transcript_id           => 'NM_2',
+    strand                  => '-',
+    transcript_seq          => 'CATGCCCTAG',
+    transcript_annotation   => '5ATGCCCTAG',
+    transcript_abs_position => [ reverse( 310 .. 315 ), reverse( 300 .. 303 ) ],
+  },
+  {
+    transcript_id           => 'NR_3',
+    strand                  => '+',
+    transcript_seq          => 'ACGT',
+    transcript_annotation   => '0000',
+    transcript_abs_position => [ 200 .. 203 ],
+  },
+);
+
+my $writer = Seq::Native::GeneWriter->new;
+for my $tx (@tx) {
+  my $ord = $writer->add_transcript( { %$tx, alt_names => {}, error_code => [] } );
+  $writer->add_site( $tx->{transcript_abs_position}[0] - 1, $ord, 'Splice Acceptor', 'N' );
+  $writer->add_transcript_sites( $ord, $tx->{transcript_abs_position},
+    $tx->{transcript_annotation} );
+}
+$writer->write($file);
+
+my $map = Seq::Native::TxMap->new($file);
+is( $map->transcripts, 3, 'every transcript is mapped' );
+is( $map->exons,       5, 'exons are recovered from the sites' );
+
+sub names { return map { $_->{hgvs_c} } @_ }
+
+is_deeply( [ names( map { $map->map($_) } 100, 101, 102, 104, 110, 113, 115, 117 ) ],
+  [qw/ c.-2 c.-1 c.1 c.3 c.5 c.8 c.*1 c.*3 /], 'plus strand utr and cds, across the intron' );
+is_deeply( [ names( map { $map->map($_) } 106, 107, 108, 109 ) ],
+  [qw/ c.4+1 c.4+2 c.5-2 c.5-1 /], 'plus strand intron, ties go upstream' );
+is_deeply( [ names( map { $map->map($_) } 315, 314, 310, 303, 300, 309, 307, 304 ) ],
+  [qw/ c.-1 c.1 c.5 c.6 c.9 c.5+1 c.5+3 c.6-1 /], 'minus strand' );
+is_deeply( [ names( map { $map->map($_) } 200, 203 ) ], [qw/ n.1 n.4 /], 'non-coding' );
+
+my ($hit) = $map->map(113);
+is_deeply( $hit,
+  { transcript_id => 'NM_1', strand => '+', tx_offset => 9, intron => 0, hgvs_c => 'c.8',
+    codon_number => 3, hgvs_p => 'p.3' }, 'a coding position in full' );
+
+is_deeply( $map->map_sorted( [ 50, 102, 102, 250, 310 ] ),
+  [ [], [ $map->map(102) ], [ $map->map(102) ], [], [ $map->map(310) ] ],
+  'map_sorted, one array per position' );
+eval { $map->map_sorted( [ 5, 4 ] ) };
+like( $@, qr/not sorted/, 'unsorted positions croak' );
@@ -0,0 +1,96 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use IO::Compress::Gzip qw/ gzip $GzipError /;
+use Test::More;
+
+plan tests => 10;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+# what Seq::Role::IO::get_clean_fields makes of a line
+my $taint_check_regex = qr{\A([\+\,\.\-\=\:\/\t\s\w\d]+)\z};
+sub clean_fields {
+  my $line = shift;
+  return $line =~ m/$taint_check_regex/xm ? split( "\t", $1 ) : ();
+}
+
+# a header, then rows with long runs of sample columns (so lines cross the
+# reader's 1M chunks), rows annotate_snpfile would skip, empty trailing
+# fields, carriage returns and lines the taint check drops
+my @header = ( qw/ Fragment Position Reference Type Alleles Allele_Counts /, 'S1', '', 'S2', '' );
+my @lines = ( join "\t", @header );
+srand(11);
+my @types = qw/ SNP DEL INS MULTIALLELIC MESS LOW /;
+for my $i ( 1 .. 15_000 ) {
+  my @f = ( 'chr' . ( 1 + $i % 3 ), $i, (qw/ A C G T /)[ $i % 4 ], $types[ $i % 6 ], 'A,C', 2 );
+  push @f, map { ( (qw/ A C R N /)[ rand 4 ], sprintf '%.2f', rand ) } 1 .. 1 + int rand 30;
+  $f[1] = 0  if $i % 97 == 0;
+  $f[2] = '' if $i % 89 == 0;
+  push @f, '', '' if $i % 7 == 0;
+  my $line = join "\t", @f;
+  $line .= "\r"    if $i % 53 == 0;
+  $line .= ";bad"  if $i % 61 == 0;
+  $line = ''       if $i % 71 == 0;
+  $line = 'single' if $i % 73 == 0;
+  push @lines, $line;
+}
+my $text = join( "\n", @lines );    # no newline at the end
+
+my $plain = File::Spec->catfile( $dir, 'in.snp' );
+open my $fh, '>', $plain or die $!;
+print $fh $text;
+close $fh;
+my $gz = "$plain.gz";
+gzip \$text => $gz or die $GzipError;
+
+my @want = grep { $#$_ } map { [ clean_fields($_) ] } @lines;
+my @cols = ( 0, 1, 2, 3, 4, 5 );
+my @want_rows = map { [ @$_[@cols], $_ ] }
+  grep { $_->[0] && $_->[1] && $_->[2] && $_->[3] && $_->[4] } @want[ 1 .. $#want ];
+
+for my $file ( $plain, $gz ) {
+  my $reader = Seq::Native::SnpReader->new($file);
+  is_deeply( $reader->header, $want[0], 'header row' );
+
+  my ( @rows, $batches, $offset );
+  $reader->set_columns( \@cols );
+  while ( my $batch = $reader->next_batch(1000) ) {
+    push @rows, @$batch;
+    $batches++;
+    $offset = $reader->offset;
+  }
+  is( $batches, int( ( @want_rows + 999 ) / 1000 ), 'rows come in batches' );
+  is_deeply( \@rows, \@want_rows, 'rows match get_clean_fields and the snp columns' );
+}
+is( Seq::Native::SnpReader->new($gz)->offset <= -s $gz, 1, 'offset is in compressed bytes' );
+
+# line-aligned ranges of the plain file (as Seq::_lineRanges makes them)
+# read apart give the rows of the whole
+my ( @ranges, @rows );
+open $fh, '<', $plain or die $!;
+<$fh>;
+my $start = tell $fh;
+while ( $start < -s $plain ) {
+  seek $fh, $start + 300_000, 0;
+  <$fh>;
+  my $end = eof($fh) ? -s $plain : tell $fh;
+  push @ranges, [ $start, $end ];
+  $start = $end;
+}
+close $fh;
+for (@ranges) {
+  my $reader = Seq::Native::SnpReader->new( $plain, @$_ );
+  $reader->set_columns( \@cols );
+  while ( my $batch = $reader->next_batch(1000) ) {
+    push @rows, @$batch;
+  }
+}
+is_deeply( \@rows, \@want_rows, scalar(@ranges) . ' ranges read apart' );
+ok( !eval { Seq::Native::SnpReader->new( $gz, 10, 20 ) }, 'no ranges of a compressed file' );
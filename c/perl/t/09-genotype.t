@@ -0,0 +1,83 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+plan tests => 4;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+# Seq::_minor_allele_carriers, with Seq::Role::Genotypes' het and hom codes
+my %het = map { $_ => 1 } qw/ K M R S W Y E H /;
+my %hom = map { $_ => 1 } qw/ A C G T D I /;
+sub minor_allele_carriers {
+  my ( $fields_aref, $ids_href, $id_names_aref, $ref_allele ) = @_;
+  my ( %id_genos, @het, @hom, @unknown );
+  for my $id (@$id_names_aref) {
+    my $id_geno = $fields_aref->[ $ids_href->{$id} ];
+    next if ( !$id_geno || $id_geno eq $ref_allele || $id_geno eq 'N' );
+    if    ( $het{$id_geno} ) { push @het, $id }
+    elsif ( $hom{$id_geno} ) { push @hom, $id }
+    else                     { push @unknown, $id_geno }
+    $id_genos{$id} = $id_geno;
+  }
+  return [ @het ? join( ';', @het ) : 'NA', @hom ? join( ';', @hom ) : 'NA',
+    \%id_genos, \@unknown ];
+}
+
+# enough samples for whole blocks of 64 and a tail, in an order that sorting
+# changes, with every code, no calls, calls that are not codes, multi-base
+# references and rows cut short of their last samples
+my $n_sample = 150;
+my @names = map { sprintf 'S%d', ( $_ * 37 ) % 1000 } 1 .. $n_sample;
+my @header = ( qw/ Fragment Position Reference Type Alleles Allele_Counts / );
+push @header, $_, '' for @names;
+my @calls = ( qw/ A C G T D I R Y S W K M E H N 0 AC x /, '' );
+
+srand(7);
+my @lines = ( join "\t", @header );
+for my $i ( 1 .. 500 ) {
+  my $ref = $i % 11 == 0 ? 'AC' : (qw/ A C G T /)[ $i % 4 ];
+  my @f = ( 'chr1', $i, $ref, 'SNP', 'A,C', 2 );
+  for my $s ( 1 .. $n_sample ) {
+    my $call = $i % 3 ? $calls[ rand @calls ] : (qw/ A C G T N /)[ rand 5 ];
+    $call = 'AC' if $i % 11 == 0 && $s % 5 == 0;
+    push @f, $call, '0.9';
+  }
+  splice @f, 6 + 2 * int( rand $n_sample ) if $i % 13 == 0;
+  push @lines, join "\t", @f;
+}
+
+my $file = File::Spec->catfile( $dir, 'geno.snp' );
+open my $fh, '>', $file or die $!;
+print $fh join( "\n", @lines ), "\n";
+close $fh;
+
+my %ids;
+for ( my $i = 6; $i <= $#header; $i += 2 ) {
+  $ids{ $header[$i] } = $i;
+}
+my @sample_ids = sort keys %ids;
+
+my @want;
+for my $line ( @lines[ 1 .. $#lines ] ) {
+  my @f = split "\t", $line;
+  push @want, minor_allele_carriers( \@f, \%ids, \@sample_ids, $f[2] );
+}
+
+my $reader = Seq::Native::SnpReader->new($file);
+is_deeply( $reader->header, [ split "\t", $lines[0] ], 'header row' );
+$reader->set_columns( [ 0 .. 5 ] );
+$reader->set_samples( [ @ids{@sample_ids} ], \@sample_ids );
+my @got;
+while ( my $rows = $reader->next_batch(64) ) {
+  push @got, @$rows;
+}
+is( scalar @got, scalar @want, 'a row per line' );
+is_deeply( [ map { $_->[7] } @got ], \@want, 'carriers as _minor_allele_carriers finds them' );
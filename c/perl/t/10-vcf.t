@@ -0,0 +1,153 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use IO::Compress::Gzip qw/ gzip $GzipError /;
+use Test::More;
+
+plan tests => 12;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+# bgzip: members of at most 64K (16K here, for more of them) whose size is
+# in a BC extra field, then the empty member that ends the file
+sub bgzf {
+  my $data = shift;
+  my $out  = '';
+  for ( my $i = 0; $i < length $data; $i += 0x4000 ) {
+    my $chunk = substr $data, $i, 0x4000;
+    my $z;
+    gzip \$chunk => \$z, ExtraField => [ BC => pack( 'v', 0 ) ]
+      or die $GzipError;
+    substr( $z, 16, 2 ) = pack( 'v', length($z) - 1 );
+    $out .= $z;
+  }
+  return $out . pack( 'H*', '1f8b08040000000000ff0600424302001b0003000000000000000000' );
+}
+
+sub write_file {
+  my ( $name, $data ) = @_;
+  my $path = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $path or die $!;
+  binmode $fh;
+  print $fh $data;
+  close $fh;
+  return $path;
+}
+
+sub read_rows {
+  my ( $path, $samples ) = @_;
+  my $reader = Seq::Native::SnpReader->new($path);
+  my $header = $reader->header;
+  # Fragment Position Reference Alleles Allele_Counts Type, in the order of
+  #   allSnpFieldIdx
+  $reader->set_columns( [ 0, 1, 2, 5, 3, 4 ] );
+  $reader->set_samples( [ map { 6 + 2 * $_ } 0 .. $#$samples ], $samples ) if $samples;
+  my @rows;
+  while ( my $batch = $reader->next_batch(100) ) {
+    push @rows, @$batch;
+  }
+  return ( $header, \@rows, $reader );
+}
+
+my $meta = "##fileformat=VCFv4.1\n##source=test\n";
+my @fixed = ( '#CHROM', qw/ POS ID REF ALT QUAL FILTER INFO FORMAT / );
+my $vcf = $meta . join( "\t", @fixed, qw/ S1 S2 S3 / ) . "\n";
+for (
+  [ 1,  100, 'A',  'G',       'GT:GQ', '0/0:10', '0/1:20', '1|1:30' ],
+  [ 1,  150, 'A',  'C,T',     'GT',    '1/2',    '0/2',    './.' ],
+  [ 1,  200, 'ATG', 'A',      'GT',    '0/1',    '1/1',    '0/0' ],
+  [ 1,  300, 'C',  'CAT',     'GT',    '0/1',    '0',      '1' ],
+  [ 1,  400, 'ATG', 'A,ATGTG', 'GT',   '1/2',    '0/1',    '2/2' ],
+  [ 1,  500, 'AT', 'A,ATC',   'GT',    '1/2',    '0/1/1',  '0/0/0' ],
+  [ 1,  600, 'A',  '<DEL>',   'GT',    '0/1',    '0/1',    '0/1' ],
+  [ 1,  700, 'A',  '.',       'GT',    '0/0',    '0/0',    '0/0' ],
+  [ 1,  800, 'c',  't,<NON_REF>', 'DP:GT', '0/1', '1/1',   '0/0' ],
+  )
+{
+  $vcf .= join( "\t", "chr$_->[0]", $_->[1], '.', $_->[2], $_->[3], 50, 'PASS', 'X=1;Y=<a>',
+    @$_[ 4 .. 7 ] )
+    . "\n";
+}
+
+my @samples = qw/ S1 S2 S3 /;
+my $plain = write_file( 'small.vcf', $vcf );
+my ( $header, $rows ) = read_rows( $plain, \@samples );
+is_deeply(
+  $header,
+  [ qw/ Fragment Position Reference Alleles Allele_Counts Type S1 /, '', 'S2', '', 'S3' ],
+  'header as Vcf2SeqAnt writes it'
+);
+is_deeply(
+  [ map { [ @$_[ 0 .. 5 ] ] } @$rows ],
+  [
+    [ 'chr1', 100, 'A', 'SNP',          'A,G',    '3,3' ],
+    [ 'chr1', 150, 'A', 'SNP',          'A,C,T',  '1,1,2' ],
+    [ 'chr1', 202, 'G', 'DEL',          'G,-2',   '3,3' ],
+    [ 'chr1', 300, 'C', 'INS',          'C,+AT',  '2,2' ],
+    [ 'chr1', 400, 'A', 'INS',          'A,+TG',  '3,3' ],
+    [ 'chr1', 402, 'G', 'DEL',          'G,-2',   '4,2' ],
+    [ 'chr1', 501, 'T', 'MULTIALLELIC', 'T,-1,+C', '1,1,1' ],
+    [ 'chr1', 800, 'C', 'SNP',          'C,T',    '0,0' ],
+  ],
+  'a row per position changed'
+);
+is_deeply(
+  [ map { $_->[7] } @$rows ],
+  [
+    [ 'S2', 'S3', { S2 => 'R', S3 => 'G' }, [] ],
+    [ 'S1;S2', 'NA', { S1 => 'Y', S2 => 'W' }, [] ],
+    [ 'S1', 'S2', { S1 => 'E', S2 => 'D' }, [] ],
+    [ 'S1', 'S3', { S1 => 'H', S3 => 'I' }, [] ],
+    [ 'S1', 'S3', { S1 => 'H', S3 => 'I' }, [] ],
+    [ 'S1;S2', 'NA', { S1 => 'E', S2 => 'E' }, [] ],
+    [ 'NA', 'NA', { S1 => 'J', S2 => '0/1/1' }, [ 'J', '0/1/1' ] ],
+    [ 'NA', 'NA', {}, [] ],
+  ],
+  'GT calls coded as the snpfile would have them'
+);
+
+# FORMAT without GT (as the last record above), and a record with no samples column at all
+my $nogt = $meta . join( "\t", @fixed, 'S1' ) . "\n"
+  . join( "\t", qw/ 2 10 . A G 50 PASS . DP 7 / ) . "\n"
+  . join( "\t", qw/ 2 11 . A G 50 PASS . / ) . "\n";
+( undef, $rows ) = read_rows( write_file( 'nogt.vcf', $nogt ), ['S1'] );
+is_deeply( [ map { [ @$_[ 4, 5 ], $_->[7][0], $_->[7][1] ] } @$rows ],
+  [ [ 'A,G', '0,0', 'NA', 'NA' ], [ 'A,G', '0,0', 'NA', 'NA' ] ], 'no GT, no calls' );
+
+# a larger file, for rounds of many blocks: the same rows plain, gzipped and
+# bgzipped
+srand(3);
+my @names = map { "P$_" } 1 .. 40;
+my $big = $meta . join( "\t", @fixed, @names ) . "\n";
+my @gts = ( '0/0', '0/1', '1/1', './.', '0|2', '2/2', '1' );
+for my $i ( 1 .. 6_000 ) {
+  my ( $ref, $alt ) = @{ ( [ 'A', 'G' ], [ 'C', 'T,A' ], [ 'GTT', 'G' ], [ 'T', 'TCC,TC' ] )[ $i % 4 ] };
+  $big .= join( "\t", 'chr' . ( 1 + $i % 2 ), $i * 10, '.', $ref, $alt, 60, 'PASS', "DP=$i",
+    'GT:DP', map { $gts[ rand @gts ] . ':' . int rand 50 } @names )
+    . "\n";
+}
+my $bgz = write_file( 'big.vcf.gz', bgzf($big) );
+my $gz = File::Spec->catfile( $dir, 'big.gz.vcf.gz' );
+gzip \$big => $gz or die $GzipError;
+my ( $h1, $want ) = read_rows( write_file( 'big.vcf', $big ), \@names );
+my ( $h2, $got_bgzf, $reader ) = read_rows( $bgz, \@names );
+my ( $h3, $got_gz ) = read_rows( $gz, \@names );
+is( scalar @$want, 6_000, 'a row per record of the larger file' );
+is_deeply( $h2, $h1, 'bgzipped header' );
+is_deeply( $got_bgzf, $want, 'bgzipped rows' );
+is_deeply( $h3, $h1, 'gzipped header' );
+is_deeply( $got_gz, $want, 'gzipped rows' );
+is( $reader->offset, -s $bgz, 'bgzipped file read to its end' );
+
+# a bgzipped snpfile reads as it always did
+my @row = ( 'chr1', 5, 'A', 'SNP', 'A,G', '1,1', 'R', 1 );
+my $snp = join( "\n", join( "\t", qw/ Fragment Position Reference Type Alleles Allele_Counts S1 /, '' ),
+  join( "\t", @row ) ) . "\n";
+( undef, $rows ) = read_rows( write_file( 'snp.gz', bgzf($snp) ) );
+is_deeply( $rows->[0][6], \@row, 'bgzipped snpfile' );
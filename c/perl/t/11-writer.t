@@ -0,0 +1,75 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use IO::Uncompress::Gunzip qw/ gunzip $GunzipError /;
+use Symbol qw/ gensym /;
+use Test::More;
+
+plan tests => 9;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub slurp {
+  my $file = shift;
+  open my $fh, '<', $file or die "cannot read $file: $!";
+  local $/;
+  return <$fh>;
+}
+
+# a few MB of annotation-like lines, so the output spans several batches
+srand(44);
+my @lines = map {
+  join "\t", 'chr' . ( 1 + $_ % 22 ), $_ * 7, (qw/ A C G T /)[ $_ % 4 ], 'SNP',
+    join( ';', map { sprintf '%.3f', rand } 1 .. 1 + int rand 20 );
+} 1 .. 40_000;
+my $text = join '', map { "$_\n" } @lines;
+
+for my $name (qw/ out.txt out.txt.gz /) {
+  my $path = File::Spec->catfile( $dir, $name );
+  my $writer = Seq::Native::Writer->new( $path, 3 );
+  $writer->write("$_\n") for @lines;
+  $writer->close;
+
+  my $got = slurp($path);
+  if ( $name =~ m/\.gz\z/ ) {
+    my $raw = $got;
+    gunzip( \$raw => \$got, MultiStream => 1 ) or die $GunzipError;
+  }
+  ok( $got eq $text, "$name holds the text written, in order" );
+
+  my $stats = $writer->stats;
+  if ( $name =~ m/\.gz\z/ ) {
+    is_deeply( [ sort keys %$stats ], [qw/ compress format write /],
+      'gzipped output is formatted, compressed and written' );
+    is( $stats->{compress}{items}, $stats->{write}{items},
+      'every batch compressed is written' );
+  }
+  else {
+    is( $stats->{write}{items}, $stats->{format}{items},
+      'every batch formatted is written' );
+  }
+}
+
+my $path = File::Spec->catfile( $dir, 'tied.txt.gz' );
+my $fh = gensym;
+tie *$fh, 'Seq::Native::Writer', $path, 2;
+say {$fh} join "\t", qw/ a b c /;
+printf {$fh} "%s:%d\n", 'x', 42;
+print {$fh} "last\n";
+close $fh;
+my $raw = slurp($path);
+gunzip( \$raw => \my $got, MultiStream => 1 ) or die $GunzipError;
+is( $got, "a\tb\tc\nx:42\nlast\n", 'a tied handle takes say, printf and print' );
+
+my $writer = Seq::Native::Writer->new( File::Spec->catfile( $dir, 'closed.txt' ) );
+$writer->close;
+ok( !eval { $writer->write("late\n"); 1 }, 'writing after close croaks' );
+
+ok( !eval { Seq::Native::Writer->new( File::Spec->catfile( $dir, 'none', 'out.txt' ) ); 1 },
+  'an unwritable path croaks' );
@@ -0,0 +1,103 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use Test::More;
+
+plan tests => 9;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+# what Seq::Statistics::Record keeps, in its nested hashes, for the same calls
+my %tr = map { $_ => 1 } qw/ AG GA CT TC R Y /;
+my %tv = map { $_ => 1 } qw/ AT TA AC CA GT TG GC CG S W K M /;
+my %hom = map { $_ => 1 } qw/ A C G T D I /;
+sub record {
+  my ( $record, $genos, $ref, $snpKey, $features ) = @_;
+  for my $id ( keys %$genos ) {
+    my $geno = $genos->{$id};
+    next if $geno eq $ref;
+    my $target = \%{ $record->{$id} };
+    my $trTv =
+        $tr{$geno} || $tr{ $ref . $geno } ? 'Transitions'
+      : $tv{$geno} || $tv{ $ref . $geno } ? 'Transversions'
+      :                                     undef;
+    $target->{$trTv}{statistics}{count}   += 1 if $trTv;
+    $target->{$snpKey}{statistics}{count} += 1 if $snpKey;
+    for my $feature ( @{ $features // [] } ) {
+      last if $feature eq 'NA';
+      $target = \%{ $target->{$feature} };
+      $target->{statistics}{count} += $hom{$geno} ? 2 : 1;
+    }
+  }
+}
+
+my $stats = Seq::Native::Stats->new;
+my %cells;
+my $cell = sub { $cells{ $_[0] } //= $stats->cell( $_[0] ) };
+my $recordNative = sub {
+  my ( $genos, $ref, $snpKey, $features ) = @_;
+  my ( @cells, $path );
+  for my $feature ( @{ $features // [] } ) {
+    last if $feature eq 'NA';
+    $path = defined $path ? "$path\t$feature" : $feature;
+    push @cells, $cell->($path);
+  }
+  $stats->record( $genos, $ref, $cell->('Transversions'), $cell->('Transitions'),
+    $snpKey ? $cell->($snpKey) : -1, $features ? \@cells : undef );
+};
+
+srand(46);
+my @calls = qw/ A C G T R Y S W K M D I E H N 0 Q WS AG /;
+my @features = (
+  [qw/ SNP Exonic Replacement /], [qw/ SNP Exonic Silent /], [qw/ SNP Intronic Intronic /],
+  [qw/ DEL Exonic NA /], [qw/ MULTIALLELIC Intergenic Intergenic /], undef,
+);
+my %expect;
+for my $site ( 1 .. 2000 ) {
+  my %genos = map { ( "S$_" => $calls[ rand @calls ] ) } grep { rand() < 0.3 } 1 .. 40;
+  my $ref      = (qw/ A C G T /)[ rand 4 ];
+  my $snpKey   = (qw/ rs noRs /)[ rand 2 ];
+  my $features = $features[ rand @features ];
+  record( \%expect, \%genos, $ref, $snpKey, $features );
+  $recordNative->( \%genos, $ref, $snpKey, $features );
+}
+
+is_deeply( $stats->export( 'statistics', 'count' ), \%expect,
+  'the table exports the nested counts Record would keep' );
+ok( $stats->samples <= 40 && $stats->cells == keys %cells, 'samples and cells are interned' );
+
+$stats->reset;
+is_deeply( $stats->export( 'statistics', 'count' ), {}, 'reset empties the table' );
+
+$recordNative->( { S1 => 'N', S2 => 'A' }, 'A', undef, undef );
+is_deeply( $stats->export( 'statistics', 'count' ), { S1 => {} },
+  'a sample with a call other than ref is kept, even with nothing counted' );
+
+ok( !eval { $stats->record( { S1 => 'G' }, 'A', 1000, -1, -1, undef ); 1 },
+  'an unknown cell croaks' );
+
+# partials, of the same sites split any way, merge into the whole table
+{
+  my @parts = map { Seq::Native::Stats->new } 1 .. 3;
+  my $whole = Seq::Native::Stats->new;
+  my %expect;
+  for my $site ( 1 .. 600 ) {
+    my %genos = map { ( "S$_" => $calls[ rand @calls ] ) } grep { rand() < 0.3 } 1 .. 20;
+    my $ref = (qw/ A C G T /)[ rand 4 ];
+    record( \%expect, \%genos, $ref, 'rs', [qw/ SNP Exonic Silent /] );
+    for my $stats ( $whole, $parts[ $site % 3 ] ) {
+      my @cells = map { $stats->cell($_) } "SNP", "SNP\tExonic", "SNP\tExonic\tSilent";
+      $stats->record( \%genos, $ref, $stats->cell('Transversions'),
+        $stats->cell('Transitions'), $stats->cell('rs'), \@cells );
+    }
+  }
+  my $merged = Seq::Native::Stats->new;
+  $merged->merge( Seq::Native::Stats->load( $_->dump ) ) for reverse @parts;
+  is_deeply( $merged->export( 'statistics', 'count' ), \%expect,
+    'dumped partials merge into the counts of the whole' );
+  is( $merged->dump, $merged->dump, 'a dump is stable' );
+  ok( !eval { Seq::Native::Stats->load( substr( $whole->dump, 0, 40 ) ); 1 },
+    'a dump cut short croaks' );
+}
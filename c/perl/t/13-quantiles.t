@@ -0,0 +1,58 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use Test::More;
+use POSIX qw/ ceil floor /;
+
+plan tests => 7;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my @th = ( .05, .50, .95 );
+my $pinf = 9**9**9;
+
+# what Seq::Statistics::Percentiles and its qc make of the same ratios
+sub reference {
+  my $ratios = shift;
+  my @sorted = sort { $a->[1] <=> $b->[1] } @$ratios;
+  my @q;
+  for my $t (@th) {
+    if ( !@sorted ) { push @q, undef; next; }
+    my $at = $#sorted * $t;
+    my ( $lo, $hi ) = ( floor($at), ceil($at) );
+    push @q, $lo == $hi ? $sorted[$hi][1]
+      : $sorted[$lo][1] * ( $hi - $at ) + $sorted[$hi][1] * ( $at - $lo );
+  }
+  my @out = map { $_->[0] } grep { $_->[1] < $q[0] || $_->[1] > $q[2] } @$ratios;
+  return ( \@q, [ sort @out ] );
+}
+
+sub check {
+  my ( $ratios, $name ) = @_;
+  my ( $q, $out ) = Seq::Native::Quantiles::screen( $ratios, \@th, 0, 2 );
+  is_deeply( [ $q, [ sort @$out ] ], [ reference($ratios) ], $name );
+}
+
+check( [], 'no ratios' );
+check( [ [ 's1', 2.5 ] ], 'one ratio' );
+
+my @ties = map { [ "s$_", ( 0, 1, 1, 2 )[ $_ % 4 ] ] } 1 .. 1000;
+check( \@ties, 'ratios that repeat' );
+
+my @inf = map { [ "s$_", $_ % 7 ? $_ / 3 : $pinf ] } 1 .. 200;
+check( \@inf, 'ratios with no denominator (inf)' );
+
+my @wrong;
+for my $n ( 2 .. 60, 1000, 5001 ) {
+  my @r = map { [ "s$_", int( rand 50 ) / ( 1 + int rand 9 ) ] } 1 .. $n;
+  my ( $q, $out ) = Seq::Native::Quantiles::screen( \@r, \@th, 0, 2 );
+  my ( $refQ, $refOut ) = reference( \@r );
+  push @wrong, $n
+    if "@$q" ne "@$refQ" || join( ',', sort @$out ) ne join( ',', @$refOut );
+}
+is( "@wrong", '', 'random ratios of many sizes' );
+
+ok( !eval { Seq::Native::Quantiles::screen( [ [ 's1', 1 ] ], [ .5 ], 0, 2 ); 1 },
+  'a qc bound with no threshold croaks' );
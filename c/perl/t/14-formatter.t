@@ -0,0 +1,70 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Temp qw/ tempdir /;
+use IO::Uncompress::Gunzip qw/ gunzip $GunzipError /;
+use Symbol qw/ gensym /;
+use Test::More;
+
+plan tests => 6;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+# what Seq::Role::ProcessFile::print_annotations makes of the same entries
+sub reference {
+  my ( $header, $entries ) = @_;
+  no warnings 'uninitialized';
+  return join '', map {
+    my $e = $_;
+    join( "\t", map { exists $e->{$_} ? $e->{$_} : 'NA' } @$header ) . "\n"
+  } @$entries;
+}
+
+my @header = qw/ chr pos var_type alleles genomic_type scores.phastCons scores.cadd
+  gene_data.annotation_type snp_data.name /;
+srand(49);
+my @entries = map {
+  my %e = (
+    chr                  => 'chr' . ( 1 + $_ % 22 ),
+    pos                  => $_ * 13,
+    var_type             => (qw/ SNP INS DEL /)[ $_ % 3 ],
+    alleles              => 'A,G',
+    genomic_type         => (qw/ Exonic Intronic Intergenic /)[ $_ % 3 ],
+    'scores.phastCons'   => sprintf( '%0.3f', rand ),
+    'gene_data.annotation_type' => $_ % 5 ? 'Silent;Replacement' : undef,
+    'snp_data.name'      => "rs$_",
+    ignored              => 'not in the header',
+  );
+  delete $e{'snp_data.name'} if $_ % 7 == 0;
+  \%e;
+} 1 .. 50_000;
+
+my $formatter = Seq::Native::Formatter->new( \@header );
+my $expect    = reference( \@header, \@entries );
+
+is( $formatter->format( \@entries ), $expect, 'rows as print_annotations makes them' );
+is( $formatter->format( [] ), '', 'no entries, no text' );
+
+# straight into the batches of a writer, across several of them
+my $path   = "$dir/out.txt.gz";
+my $writer = Seq::Native::Writer->new( $path, 2 );
+$formatter->write( [ @entries[ 0 .. 999 ] ], $writer );
+$formatter->write( [ @entries[ 1000 .. $#entries ] ], $writer );
+$writer->close;
+gunzip( $path => \my $text, MultiStream => 1 ) or die $GunzipError;
+is( $text, $expect, 'rows written through the writer' );
+
+# as Seq::Role::ProcessFile finds the writer behind its output handle
+my $fh = gensym;
+tie *$fh, 'Seq::Native::Writer', "$dir/tied.txt";
+$formatter->write( [ @entries[ 0 .. 9 ] ], tied *$fh );
+close $fh;
+open my $in, '<', "$dir/tied.txt" or die $!;
+is( do { local $/; <$in> }, reference( \@header, [ @entries[ 0 .. 9 ] ] ),
+  'rows written to a tied handle' );
+
+ok( !eval { $formatter->format( [ {}, [] ] ); 1 }, 'an entry that is not a hash croaks' );
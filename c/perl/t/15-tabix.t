@@ -0,0 +1,153 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Temp qw/ tempdir /;
+use IO::Uncompress::Gunzip qw/ gunzip $GunzipError /;
+use IO::Uncompress::RawInflate qw/ rawinflate $RawInflateError /;
+use Test::More;
+
+plan tests => 9;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub slurp {
+  my $file = shift;
+  open my $fh, '<', $file or die "cannot read $file: $!";
+  binmode $fh;
+  local $/;
+  return <$fh>;
+}
+
+# sorted rows, as annotate_snpfile writes them for a sorted snpfile, over
+#   enough of each chromosome to use every level of bins
+srand(50);
+my @rows;
+for my $chr (qw/ chr1 chr2 chrX /) {
+  my $pos = 0;
+  for ( 1 .. 20_000 ) {
+    $pos += 1 + int rand( rand() < .01 ? 2_000_000 : 2_000 );
+    push @rows, [ $chr, $pos, join "\t", $chr, $pos, 'SNP', 'A,G', ( 'x' x int rand 60 ) ];
+  }
+}
+my $header = "chr\tpos\tvar_type\talleles\tnote\n";
+
+my $path   = "$dir/out.txt.gz";
+my $writer = Seq::Native::Writer->new( $path, 2, 1 );
+$writer->write($header);
+# in pieces that end mid line, as a caller's prints may
+my $text = join '', map { "$_->[2]\n" } @rows;
+$writer->write( substr( $text, $_ * 7777, 7777 ) ) for 0 .. length($text) / 7777;
+$writer->close;
+
+my $bgzf = slurp($path);
+gunzip( \$bgzf => \my $plain, MultiStream => 1 ) or die $GunzipError;
+is( $plain, $header . $text, 'the blocks read as the text' );
+is( substr( $bgzf, 12, 2 ), 'BC', 'the blocks are BGZF' );
+is( unpack( 'H*', substr( $bgzf, -28 ) ),
+  '1f8b080400000000' . '00ff060042430200' . '1b0003' . '0' x 18, 'an empty block ends it' );
+
+# a tabix reader, enough to query regions through the index
+my %block;
+for ( my $off = 0 ; $off < length $bgzf ; ) {
+  my $size = unpack( 'v', substr( $bgzf, $off + 16, 2 ) ) + 1;
+  my $data = substr( $bgzf, $off + 18, $size - 26 );
+  rawinflate( \$data => \my $out ) or die $RawInflateError;
+  $block{$off} = $out // '';
+  $off += $size;
+}
+my @offs = sort { $a <=> $b } keys %block;
+my %next = map { $offs[$_] => $offs[ $_ + 1 ] } 0 .. $#offs - 1;
+
+ok( -s "$path.tbi", 'the index is written' );
+gunzip( "$path.tbi" => \my $tbi, MultiStream => 1 ) or die $GunzipError;
+my $p = 0;
+my $take = sub { my ( $fmt, $n ) = @_; my @v = unpack $fmt, substr( $tbi, $p, $n ); $p += $n; @v };
+my ($magic) = $take->( 'a4', 4 );
+my ( $nRef, $format, $colSeq, $colBeg, $colEnd, $meta, $skip, $lNm ) = $take->( 'l<8', 32 );
+my @names = split /\0/, substr( $tbi, $p, $lNm );
+$p += $lNm;
+my %ref;
+for my $name (@names) {
+  my ($nBin) = $take->( 'l<', 4 );
+  my %bins;
+  for ( 1 .. $nBin ) {
+    my ( $bin, $nChunk ) = $take->( 'L<l<', 8 );
+    $bins{$bin} = [ map { [ $take->( 'Q<Q<', 16 ) ] } 1 .. $nChunk ];
+  }
+  my ($nIntv) = $take->( 'l<', 4 );
+  $ref{$name} = { bins => \%bins, ioff => [ map { $take->( 'Q<', 8 ) } 1 .. $nIntv ] };
+}
+is_deeply( [ $magic, $nRef, $format, $colSeq, $colBeg, $colEnd, $meta, $skip, \@names ],
+  [ "TBI\1", 3, 0, 1, 2, 0, ord('#'), 1, [qw/ chr1 chr2 chrX /] ],
+  'a tabix header for chr and pos, skipping the header line' );
+
+sub reg2bins {
+  my ( $beg, $end ) = @_;
+  $end--;
+  my @bins = (0);
+  for ( [ 26, 1 ], [ 23, 9 ], [ 20, 73 ], [ 17, 585 ], [ 14, 4681 ] ) {
+    my ( $shift, $first ) = @$_;
+    push @bins, $first + ( $beg >> $shift ) .. $first + ( $end >> $shift );
+  }
+  return @bins;
+}
+
+sub read_chunk {
+  my ( $beg, $end ) = @_;
+  my ( $block, $at ) = ( $beg >> 16, $beg & 0xffff );
+  my $out = '';
+  while ( defined $block ) {
+    if ( $block == $end >> 16 ) {
+      $out .= substr( $block{$block}, $at, ( $end & 0xffff ) - $at );
+      last;
+    }
+    $out .= substr( $block{$block}, $at );
+    ( $block, $at ) = ( $next{$block}, 0 );
+  }
+  return $out;
+}
+
+# the rows of [beg, end) (0-based) the index leads to
+sub query {
+  my ( $chr, $beg, $end ) = @_;
+  my $ref  = $ref{$chr};
+  my $ioff = $ref->{ioff};
+  my $min  = ( $beg >> 14 ) < @$ioff ? $ioff->[ $beg >> 14 ] : ~0;
+  my %found;
+  for my $bin ( reg2bins( $beg, $end ) ) {
+    for my $chunk ( @{ $ref->{bins}{$bin} // [] } ) {
+      next if $chunk->[1] <= $min;
+      for ( split /\n/, read_chunk(@$chunk) ) {
+        my ( $c, $pos ) = split /\t/;
+        $found{$_} = 1 if $c eq $chr && $pos > $beg && $pos <= $end;
+      }
+    }
+  }
+  return [ sort keys %found ];
+}
+
+my @wrong;
+for ( 1 .. 300 ) {
+  my $chr = (qw/ chr1 chr2 chrX /)[ rand 3 ];
+  my $beg = int rand 45_000_000;
+  my $end = $beg + (qw/ 1 500 20000 300000 5000000 /)[ rand 5 ];
+  my $expect = [ sort map { $_->[2] } grep { $_->[0] eq $chr && $_->[1] > $beg && $_->[1] <= $end } @rows ];
+  push @wrong, "$chr:$beg-$end" if join( "\n", @{ query( $chr, $beg, $end ) } ) ne join "\n", @$expect;
+}
+is( "@wrong", '', 'regions queried through the index have just their rows' );
+
+# rows out of order are written, but not indexed
+$writer = Seq::Native::Writer->new( "$dir/unsorted.txt.gz", 1, 1 );
+$writer->write("chr1\t9\tSNP\nchr1\t5\tSNP\n");
+$writer->close;
+ok( -s "$dir/unsorted.txt.gz" && !-e "$dir/unsorted.txt.gz.tbi", 'unsorted rows are not indexed' );
+
+# nor is plain text, which tabix could not seek in
+$writer = Seq::Native::Writer->new( "$dir/plain.txt", 1, 1 );
+$writer->write("chr1\t9\tSNP\n");
+$writer->close;
+ok( !-e "$dir/plain.txt.tbi", 'plain text is not indexed' );
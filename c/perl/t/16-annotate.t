@@ -0,0 +1,130 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+# genome_annotate on a small assembly, checked against the tracks read with
+#   Seq::Native::Track the way Seq::Annotate::annotate reads them
+
+my $engine = File::Spec->rel2abs('../bin/genome_annotate');
+plan skip_all => "$engine is not built" unless -x $engine;
+plan tests => 10;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub spew {
+  my ( $name, $data ) = @_;
+  my $file = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $file or die "cannot write $file: $!";
+  binmode $fh;
+  print {$fh} $data;
+  close $fh;
+  return $file;
+}
+
+# chr1 at 0 and chr2 at 1000; chr1 is intergenic A to 300, an exon of G to
+#   400 and an intron of C to 600, T after; chr2 is intergenic T
+my @codes = ( (1) x 300, (59) x 100, (34) x 200, (4) x 400, (4) x 1000 );
+my $genomeFile = spew( 'test.genome.idx', pack( 'C*', @codes ) );
+my $chrFile = spew( 'test.genome.chr_len.dat', "---\nchr1: 0\nchr2: 1000\n" );
+
+# GENEA is nearest to the first 500 bases, GENEB to the rest of chr1, and on
+#   chr2 no gene is
+my $ngeneFile = spew( 'test.ngene.idx', pack( 'n*', (1) x 500, (2) x 500, (0) x 1000 ) );
+my $genesFile =
+  spew( 'refGene.genome.gene.dat', "2000\nGENEA\t1\t310\t390\nGENEB\t2\t700\t800\n" );
+my %geneName = ( 1 => 'GENEA', 2 => 'GENEB' );
+
+my $phyloPFile = spew( 'phyloP.score.idx', pack( 'C*', map { $_ % 256 } 0 .. 1999 ) );
+
+my @rows = map { [ split / / ] } (
+  'chr1 10 A A,G 1,1 SNP',
+  'chr1 350 G G,T 1,1 SNP',
+  'chr1 351 G G,A,T 1,1 MULTIALLELIC',
+  'chr1 500 C C,-2 1,1 DEL',
+  'chr1 501 C C,+AT 1,1 INS',
+  'chr1 800 T T,C,-1 1,1 MULTIALLELIC',
+  'chr2 5 T T,A 1,1 SNP',
+  'chr3 5 T T,A 1,1 SNP',     # no such chromosome
+  'chr1 20 A A 2 SNP',        # no variant allele
+  'chr1 30 A A,G 1,1 LOW',    # no annotated type
+);
+my $snpfile = spew( 'test.snp',
+  join( '', map { join( "\t", @$_ ) . "\n" }
+    [qw/ Fragment Position Reference Alleles Allele_Counts Type Sample_0 /, ''],
+    map { [ @$_, $_->[2], 1 ] } @rows ) );
+
+my $out = File::Spec->catfile( $dir, 'out.txt' );
+is( system( $engine, '--chr', $chrFile, '--genome', $genomeFile, '--ngene', $ngeneFile,
+    '--genes', $genesFile, '--score', "phyloP=$phyloPFile:-30:30:255",
+    '--in', $snpfile, '--out', $out, '--threads', 2 ),
+  0, 'genome_annotate ran' );
+
+open my $fh, '<', $out or die "cannot read $out: $!";
+chomp( my @lines = <$fh> );
+close $fh;
+
+my $header = join( "\t", qw/ chr pos var_type alleles allele_count genomic_type ref_base
+    nearest_gene var_allele phyloP / );
+is( shift @lines, $header,
+  'the genome-sized track columns of the Seq::Annotate header, in its order' );
+
+# what Seq::Annotate::annotate makes of the same tracks
+my $genome = Seq::Native::Track->new($genomeFile);
+my $ngene  = Seq::Native::Track->new( $ngeneFile, 2 );
+my $phyloP = Seq::Native::Track->new($phyloPFile);
+$phyloP->set_score( -30, 30, 255 );
+my %offset = ( chr1 => 0, chr2 => 1000 );
+my @expect;
+for my $row ( @rows[ 0 .. 6 ] ) {
+  my ( $chr, $pos, undef, $alleles, $count, $type ) = @$row;
+  my $absPos = $offset{$chr} + $pos - 1;
+  my $code   = $genome->get_base($absPos);
+  my $base   = (qw/ N A C G T /)[ $code & 7 ];
+  my $genomicType =
+    ( $code & 32 ) ? ( ( $code & 16 ) ? 'Exonic' : 'Intronic' ) : 'Intergenic';
+  my $nearest =
+    $genomicType eq 'Exonic' ? 'NA' : $geneName{ $ngene->get_nearest_gene($absPos) } // 'NA';
+  my @var = grep { $_ ne $base } split /,/, $alleles;
+  @var = ( ( grep { length == 1 } @var ), ( grep { length > 1 } @var ) );
+  push @expect,
+    join( "\t", $chr, $pos, $type, $alleles, $count, $genomicType, $base, $nearest,
+    join( ',', @var ), $phyloP->get_score($absPos) );
+}
+is( scalar @lines, scalar @expect,
+  'rows without a known chromosome, variant or type are skipped' );
+is_deeply( \@lines, \@expect, 'rows as Seq::Annotate has them' );
+is_deeply( [ map { ( split /\t/ )[7] } @lines ],
+  [qw/ GENEA NA NA GENEA GENEB GENEB NA /], 'nearest genes by name, outside exons' );
+
+# with --fields each row is followed by its snpfile line, and a line without
+#   variant alleles is kept for perl to count its discordant base
+my $fieldsOut = File::Spec->catfile( $dir, 'fields.txt' );
+is( system( $engine, '--chr', $chrFile, '--genome', $genomeFile, '--ngene', $ngeneFile,
+    '--genes', $genesFile, '--score', "phyloP=$phyloPFile:-30:30:255",
+    '--in', $snpfile, '--out', $fieldsOut, '--threads', 2, '--fields' ),
+  0, 'genome_annotate ran with --fields' );
+open $fh, '<', $fieldsOut or die "cannot read $fieldsOut: $!";
+chomp( my @fieldLines = <$fh> );
+close $fh;
+open $fh, '<', $snpfile or die "cannot read $snpfile: $!";
+chomp( my @snpLines = <$fh> );
+close $fh;
+is( shift @fieldLines, join( "\t", $header, shift @snpLines ),
+  'the header is followed by the snpfile header' );
+my $noVariant = join( "\t", qw/ chr1 20 SNP A 2 Intergenic A GENEA /, '',
+  $phyloP->get_score(19) );
+is_deeply( \@fieldLines,
+  [ ( map { join "\t", $expect[$_], $snpLines[$_] } 0 .. 6 ), "$noVariant\t$snpLines[8]" ],
+  'and each row by its line' );
+
+# an ngene track is no use without the names of its genes
+is( system("$engine --chr $chrFile --genome $genomeFile --ngene $ngeneFile --in $snpfile "
+      . "--out $out 2>/dev/null") >> 8,
+  1, 'an ngene track needs its gene names' );
@@ -0,0 +1,151 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use IO::Socket::UNIX;
+use Socket qw/ SOCK_STREAM /;
+use Test::More;
+
+# genome_server on a small assembly: lookups through Seq::Native::Client
+#   checked against Seq::Native::Track and lookup_batch, and clients that
+#   send their requests in pieces, stall or misbehave
+
+my $daemon = File::Spec->rel2abs('../bin/genome_server');
+plan skip_all => "$daemon is not built" unless -x $daemon;
+plan tests => 18;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+use_ok('Seq::Native::Client') || die "Seq::Native::Client cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub spew {
+  my ( $name, $data ) = @_;
+  my $file = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $file or die "cannot write $file: $!";
+  binmode $fh;
+  print {$fh} $data;
+  close $fh;
+  return $file;
+}
+
+my $size       = 1000;
+my @codes      = map { ( $_ * 7 ) % 256 } 0 .. $size - 1;
+my $genomeFile = spew( 'test.genome.idx', pack( 'C*', @codes ) );
+my $chrFile    = spew( 'test.genome.chr_len.dat', "---\nchr1: 0\nchr2: 600\n" );
+my $ngeneFile  = spew( 'test.ngene.idx', pack( 'n*', map { ( $_ * 13 ) % 65536 } 0 .. $size - 1 ) );
+my $phyloPFile = spew( 'phyloP.score.idx', pack( 'C*', @codes ) );
+my $phastFile  = spew( 'phastCons.score.idx', pack( 'C*', reverse @codes ) );
+spew( "cadd.idx.$_", pack( 'C*', map { ( $_ * 3 + 1 ) % 128 } @codes ) ) for 0 .. 2;
+
+my $manifest = spew( 'manifest', <<"EOF" );
+# a test assembly
+assembly test
+chr    $chrFile
+genome $genomeFile
+ngene  $ngeneFile
+score  phyloP $phyloPFile -30 30
+score  phastCons $phastFile 0 1 254
+cadd   $dir/cadd.idx
+EOF
+
+# one worker, so a client that pinned it would hold up every other
+my $socket = File::Spec->catfile( $dir, 'server.sock' );
+my $pid    = fork // die "cannot fork: $!";
+if ( !$pid ) {
+  open STDERR, '>', File::Spec->devnull;
+  exec $daemon, '--socket', $socket, '--manifest', $manifest, '--threads', 1;
+  exit 127;
+}
+END { kill 'TERM', $pid and waitpid $pid, 0 if $pid }
+for ( 1 .. 100 ) { last if -S $socket; select undef, undef, undef, 0.05 }
+
+my $client = Seq::Native::Client->new($socket);
+my $info   = $client->info;
+is_deeply( $info, { test => { id => 0, scores => [qw/ phyloP phastCons /], cadd => 1 } },
+  'info has the assembly of the manifest' );
+
+# what Seq::Annotate has from the same tracks
+my $genome = Seq::Native::Track->new($genomeFile);
+my $ngene  = Seq::Native::Track->new( $ngeneFile, 2 );
+my $phyloP = Seq::Native::Track->new($phyloPFile);
+$phyloP->set_score( -30, 30, 255 );
+my $phast = Seq::Native::Track->new($phastFile);
+$phast->set_score( 0, 1, 254 );
+my @cadd = map { Seq::Native::Track->new("$dir/cadd.idx.$_") } 0 .. 2;
+$_->set_score( 0, 127, 255 ) for @cadd;
+
+my @pos = ( 0, 5, 17, 17, 400, 599, 600, 999, 3 );
+my $res = $client->lookup( 0, \@pos, 3 | Seq::Native::Client::TRACK_CADD_ALL() );
+is_deeply( $res->{site_code}, [ map { $genome->get_base($_) } @pos ], 'site codes' );
+is_deeply( $res->{base}, [ map { (qw/ N A C G T /)[ $_ & 7 ] } @{ $res->{site_code} } ],
+  'reference bases, none for an invalid site code' );
+is_deeply( $res->{nearest_gene}, [ map { $ngene->get_nearest_gene($_) } @pos ], 'nearest genes' );
+is_deeply( $res->{scores},
+  [ [ map { $phyloP->get_score($_) } @pos ], [ map { $phast->get_score($_) } @pos ] ],
+  'scores, formatted as the tracks format them' );
+is_deeply( $res->{cadd}, [ map { my $t = $_; [ map { $t->get_score($_) } @pos ] } @cadd ],
+  'the three cadd scores' );
+
+my $batch = Seq::Native::lookup_batch( $genome, $ngene, [ $phyloP, $phast ], \@cadd, \@pos );
+is_deeply( [ @{$res}{qw/ site_code nearest_gene scores cadd /} ],
+  [ @{$batch}{qw/ site_code nearest_gene scores cadd /} ], 'the columns of lookup_batch' );
+
+# the cadd score of an allele; A to C, G and T are the first three tracks
+my $at = 4;
+$at++ while ( $genome->get_base($at) & 7 ) != 1;
+$res = $client->lookup( 0, [ map { [ $at, 'A', $_ ] } qw/ C G T A / ],
+  2 | Seq::Native::Client::TRACK_CADD() );
+is_deeply( $res->{allele_cadd}, [ ( map { $_->get_score($at) } @cadd ), 'NA' ],
+  'the cadd score of each allele' );
+is_deeply( $res->{scores}, [ [ ( $phast->get_score($at) ) x 4 ] ], 'just the score asked for' );
+
+$res = $client->lookup( 0, [$size], 1 );
+ok( !defined $res->{site_code}[0], 'a position outside the genome has no site code' );
+
+ok( !eval { $client->lookup( 3, [1], 1 ); 1 } && $@ =~ /no such assembly/,
+  'an assembly the server does not have' );
+
+sub raw_client {
+  my $sock = IO::Socket::UNIX->new( Type => SOCK_STREAM, Peer => $socket ) or die $!;
+  binmode $sock;
+  return $sock;
+}
+
+sub raw_status {
+  my $sock = shift;
+  my $got  = sysread( $sock, my $resp, 16 );
+  return $got ? ( unpack 'VvvVV', $resp )[2] : -1;
+}
+
+# a client that has sent part of a request holds up no one
+my $request = pack( 'VvvvvVV', 0x51514553, 1, 2, 0, 0, 1, 2 ) . pack( 'q<x8', 17 ) x 2;
+my $slow    = raw_client();
+syswrite( $slow, substr( $request, 0, 11 ) );
+my $other = eval {
+  local $SIG{ALRM} = sub { die "timeout\n" };
+  alarm 5;
+  my $res = Seq::Native::Client->new($socket)->lookup( 0, [17], 1 );
+  alarm 0;
+  $res;
+};
+is_deeply( $other && $other->{site_code}, [ $genome->get_base(17) ],
+  'another client is served while one has sent half a request' );
+
+syswrite( $slow, substr( $request, 11, 20 ) );
+select undef, undef, undef, 0.1;
+syswrite( $slow, substr( $request, 31 ) );
+is( raw_status($slow), 0, 'a request sent in pieces is served once whole' );
+sysread( $slow, my $records, 2 * 20 );
+is( ( unpack 'q<l<s<', $records )[2], $genome->get_base(17), 'with the records asked for' );
+
+my $bad = raw_client();
+syswrite( $bad, pack( 'VvvvvVV', 0x12345678, 1, 2, 0, 0, 1, 1 ) );
+is( raw_status($bad), 1, 'a request without the magic is refused' );
+
+my $large = raw_client();
+syswrite( $large, pack( 'VvvvvVV', 0x51514553, 1, 2, 0, 0, 1, ( 1 << 20 ) + 1 ) );
+is( raw_status($large), 3, 'too many sites are refused before they are read' );
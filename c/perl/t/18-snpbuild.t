@@ -0,0 +1,152 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Compare qw/ compare /;
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use IO::Compress::Gzip qw/ gzip $GzipError /;
+use Test::More;
+
+# genome_snpdb on a small assembly: the stores built with one thread and with
+#   four are the same, byte for byte, and the same as Seq::Native::SnpWriter
+#   writes for the records Seq::Build::SnpTrack reads from the snp files
+
+my $builder = File::Spec->rel2abs('../bin/genome_snpdb');
+plan skip_all => "$builder is not built" unless -x $builder;
+plan tests => 13;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub spew {
+  my ( $name, $data ) = @_;
+  my $file = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $file or die "cannot write $file: $!";
+  binmode $fh;
+  print {$fh} $data;
+  close $fh;
+  return $file;
+}
+
+sub slurp {
+  my $file = shift;
+  open my $fh, '<', $file or die "cannot read $file: $!";
+  binmode $fh;
+  local $/;
+  return scalar <$fh>;
+}
+
+# chr1 at 0, chr2 at 3000 and chr3 at 5000, to the end of the string genome
+my %offset = ( chr1 => 0, chr2 => 3000, chr3 => 5000 );
+my %end    = ( chr1 => 3000, chr2 => 5000, chr3 => 6000 );
+my $genomeStr = join '', map { (qw/ A C G T N /)[ ( $_ * 7 ) % 5 ] } 0 .. 5999;
+my $strFile = spew( 'test.genome.str.dat', $genomeStr );
+my $chrFile = spew( 'test.genome.chr_len.dat', "---\nchr1: 0\nchr2: 3000\nchr3: 5000\n" );
+
+my @header = qw/ bin chrom chromStart chromEnd name alleles alleleFreqCount alleleFreqs /;
+
+# rows of each snp file: many single sites, some that span a few, the same
+#   site more than once, sites off the end of a chromosome and chromosomes
+#   the assembly does not have
+sub snp_rows {
+  my $f = shift;
+  my @rows;
+  for my $i ( 0 .. 399 ) {
+    my $chr   = (qw/ chr1 chr2 chr3 chr1 /)[ $i % 4 ];
+    my $start = ( 37 * $i + 11 * $f ) % ( $end{$chr} - $offset{$chr} );
+    my $span  = $i % 25 == 0 ? 3 : $i % 50 == 1 ? 0 : 1;
+    my $count = $i % 7 == 0 ? 3 : 2;
+    my $freqs = $count == 2 ? sprintf( "0.%03d,0.%03d,", 1000 - $i, $i ) : '0.5,0.25,0.25,';
+    $freqs = '' if $i % 11 == 0;
+    push @rows, [ 585, $chr, $start, $start + $span, "rs$f$i", 'A/G', $count, $freqs ];
+  }
+  push @rows, [ 585, 'chr2', 1998, 2003, "rs${f}off", 'C/T', 2, '0.9,0.1,' ];
+  push @rows, [ 585, 'chrUn', 10, 11, "rs${f}un", 'C/T', 2, '0.9,0.1,' ];
+  return \@rows;
+}
+
+my @inFiles;
+my @inRows = map { snp_rows($_) } 0 .. 2;
+for my $f ( 0 .. $#inRows ) {
+  my $text = join '', map { join( "\t", @$_ ) . "\n" } \@header, @{ $inRows[$f] };
+  if ( $f == 1 ) {
+    my $file = File::Spec->catfile( $dir, "snp$f.txt.gz" );
+    gzip( \$text => $file ) or die "cannot gzip $file: $GzipError";
+    push @inFiles, $file;
+  }
+  else {
+    push @inFiles, spew( "snp$f.txt", $text );
+  }
+}
+
+sub build {
+  my ( $out, $threads ) = @_;
+  mkdir File::Spec->catdir( $dir, $out );
+  return system( "$builder --chr $chrFile --genome_str $strFile --name test --feature alleles "
+      . join( '', map { "--in $_ " } @inFiles )
+      . "--dir $dir/$out --threads $threads 2>/dev/null" );
+}
+
+is( build( 'one', 1 ), 0, 'genome_snpdb ran with one thread' );
+is( build( 'four', 4 ), 0, 'and with four' );
+
+my @chrs = qw/ chr1 chr2 chr3 /;
+my @sdb  = map { "test.snp.$_.sdb" } @chrs;
+my @dat  = map { "test.snp.$_.dat" } @chrs;
+is_deeply( [ grep { !-f "$dir/one/$_" } @sdb, @dat ], [], 'a store and site ranges per chromosome' );
+is_deeply( [ grep { compare( "$dir/one/$_", "$dir/four/$_" ) != 0 } @sdb ], [],
+  'the stores do not depend on the threads' );
+is_deeply( [ grep { compare( "$dir/one/$_", "$dir/four/$_" ) != 0 } @dat ], [],
+  'nor do the site ranges' );
+
+# the minor allele frequency of Seq::Build::SnpTrack, of bi-allelic records
+sub maf {
+  my ( $count, $freqs ) = @_;
+  return undef unless $count == 2;
+  my @freqs = grep { length } split /,/, $freqs;
+  return undef unless @freqs;
+  my ($max) = sort { $b <=> $a } @freqs;
+  return sprintf( "%0.6f", 1 - $max );
+}
+
+# the same records, chromosome by chromosome in the order of the input files
+for my $chr (@chrs) {
+  my $writer = Seq::Native::SnpWriter->new( [qw/ alleles maf /] );
+  my %sites;
+  for my $rows (@inRows) {
+    for my $row ( grep { $_->[1] eq $chr } @$rows ) {
+      my ( undef, undef, $start, $end, $name, $alleles, $count, $freqs ) = @$row;
+      for my $pos ( $start + 1 .. $end ) {
+        my $absPos = $offset{$chr} + $pos - 1;
+        next if $absPos >= $end{$chr};
+        $writer->add( $absPos, $name, substr( $genomeStr, $absPos, 1 ),
+          [ $alleles, maf( $count, $freqs ) ] );
+        $sites{$absPos} = 1;
+      }
+    }
+  }
+  my $file = File::Spec->catfile( $dir, "writer.$chr.sdb" );
+  $writer->write($file);
+  is( compare( "$dir/one/test.snp.$chr.sdb", $file ), 0,
+    "$chr: the store Seq::Native::SnpWriter writes" );
+
+  # runs of adjacent sites, as genome_hasher reads them
+  my @pos = sort { $a <=> $b } keys %sites;
+  my @ranges;
+  for my $p (@pos) {
+    if ( @ranges && $ranges[-1][1] + 1 == $p ) { $ranges[-1][1] = $p }
+    else                                      { push @ranges, [ $p, $p ] }
+  }
+  is( slurp("$dir/one/test.snp.$chr.dat"),
+    join( '', "64\n", map( {"$_->[0]\t$_->[1]\n"} @ranges ), "\n" ),
+    "$chr: the site ranges" );
+}
+
+my $db = Seq::Native::SnpDb->new("$dir/four/test.snp.chr2.sdb");
+is_deeply( [ grep { $_->{snp_id} eq 'rs1off' } @{ $db->db_get(3000 + 1998) // [] } ],
+  [ { abs_pos => 4998, ref_base => substr( $genomeStr, 4998, 1 ), snp_id => 'rs1off',
+      snp_feature => { alleles => 'C/T', maf => '0.100000' } } ],
+  'a record that runs off the end of chr2 keeps its sites on it' );
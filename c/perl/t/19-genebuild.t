@@ -0,0 +1,210 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Compare qw/ compare /;
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use IO::Compress::Gzip qw/ gzip $GzipError /;
+use Test::More;
+
+# genome_genedb on a small assembly: the stores, site ranges and consequence
+#   track built with one thread and with four are the same, byte for byte, and
+#   the stores the same as Seq::Native::GeneWriter writes for the transcripts
+#   Seq::Gene makes of the gene tables
+
+my $builder = File::Spec->rel2abs('../bin/genome_genedb');
+plan skip_all => "$builder is not built" unless -x $builder;
+plan tests => 11;
+
+my $package = 'Seq::Native';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir = tempdir( CLEANUP => 1 );
+
+sub spew {
+  my ( $name, $data ) = @_;
+  my $file = File::Spec->catfile( $dir, $name );
+  open my $fh, '>', $file or die "cannot write $file: $!";
+  binmode $fh;
+  print {$fh} $data;
+  close $fh;
+  return $file;
+}
+
+# chr1 at 0, chr2 at 2000 and chr3 at 4000, to the end of the string genome
+my @chrs   = qw/ chr1 chr2 chr3 /;
+my %offset = ( chr1 => 0, chr2 => 2000, chr3 => 4000 );
+my $chrLen = 2000;
+my @genome = map { (qw/ A C G T /)[ ( $_ * 7 + int( $_ / 5 ) ) % 4 ] } 0 .. 3 * $chrLen - 1;
+
+my @header = qw/ name chrom strand txStart txEnd cdsStart cdsEnd exonCount exonStarts
+  exonEnds geneSymbol /;
+
+# rows of each gene table: both strands, one to three exons, non-coding
+#   transcripts, overlapping transcripts, a few with a start and stop codon
+#   put in the genome for them, empty gene symbols and a chromosome the
+#   assembly does not have
+sub gene_rows {
+  my $f = shift;
+  my @rows;
+  for my $i ( 0 .. 29 ) {
+    my $chr    = $chrs[ $i % 3 ];
+    my $strand = $i % 4 < 2 ? '+' : '-';
+    my $start  = ( 97 * $i + 31 * $f ) % ( $chrLen - 300 );
+    my ( @s, @e );
+    for my $j ( 0 .. $i % 3 ) {
+      push @s, $start + 80 * $j;
+      push @e, $s[-1] + 40 + ( 7 * $i + 13 * $j ) % 30;
+    }
+    my ( $cdsStart, $cdsEnd ) = $i % 5 == 4 ? ( $e[-1], $e[-1] ) : ( $s[0] + 5, $e[-1] - 4 );
+    if ( $i % 6 == 0 ) {
+      $cdsEnd -= ( $cdsEnd - $cdsStart ) % 3;
+      my $at = $offset{$chr};
+      my ( $first, $last ) = $strand eq '+' ? qw/ ATG TAG / : qw/ TTA CAT /;
+      @genome[ $at + $cdsStart .. $at + $cdsStart + 2 ] = split //, $first;
+      @genome[ $at + $cdsEnd - 3 .. $at + $cdsEnd - 1 ] = split //, $last;
+    }
+    my $symbol = ( '', '0', "G$f$i" )[ $i % 6 > 1 ? 2 : $i % 6 ];
+    push @rows, [ "NM_$f$i", $chr, $strand, $s[0], $e[-1], $cdsStart, $cdsEnd, scalar @s,
+      join( '', map {"$_,"} @s ), join( '', map {"$_,"} @e ), $symbol ];
+  }
+  push @rows, [ "NM_${f}un", 'chrUn_gl000220', '+', 10, 90, 20, 80, 1, '10,', '90,', 'UN' ];
+  return \@rows;
+}
+
+my @inRows = map { gene_rows($_) } 0 .. 1;
+my $genomeStr = join '', @genome;
+my $strFile = spew( 'test.genome.str.dat', $genomeStr );
+my $chrFile = spew( 'test.genome.chr_len.dat', "---\nchr1: 0\nchr2: 2000\nchr3: 4000\n" );
+
+my @inFiles;
+for my $f ( 0 .. $#inRows ) {
+  my $text = join '', map { join( "\t", @$_ ) . "\n" } \@header, @{ $inRows[$f] };
+  if ($f) {
+    my $file = File::Spec->catfile( $dir, "genes$f.txt.gz" );
+    gzip( \$text => $file ) or die "cannot gzip $file: $GzipError";
+    push @inFiles, $file;
+  }
+  else {
+    push @inFiles, spew( "genes$f.txt", $text );
+  }
+}
+
+sub build {
+  my ( $out, $threads ) = @_;
+  mkdir File::Spec->catdir( $dir, $out );
+  return system( "$builder --chr $chrFile --genome_str $strFile --name test "
+      . "--feature geneSymbol --csq "
+      . join( '', map { "--in $_ " } @inFiles )
+      . "--dir $dir/$out --threads $threads 2>/dev/null" );
+}
+
+is( build( 'one', 1 ), 0, 'genome_genedb ran with one thread' );
+is( build( 'four', 4 ), 0, 'and with four' );
+
+my @gdb = map { "test.gene.$_.gdb" } @chrs;
+my @dat = map { ( "test.gene.$_.gan.dat", "test.gene.$_.exon.dat" ) } @chrs;
+my @csq = map {"test.csq.idx.$_"} 0 .. 2;
+is_deeply( [ grep { !-f "$dir/one/$_" } @gdb, @dat, @csq ], [],
+  'a store and site ranges per chromosome, and the consequence track' );
+is_deeply( [ grep { compare( "$dir/one/$_", "$dir/four/$_" ) != 0 } @gdb ], [],
+  'the stores do not depend on the threads' );
+is_deeply( [ grep { compare( "$dir/one/$_", "$dir/four/$_" ) != 0 } @dat ], [],
+  'nor do the site ranges' );
+is_deeply( [ grep { compare( "$dir/one/$_", "$dir/four/$_" ) != 0 } @csq ], [],
+  'nor does the consequence track' );
+
+sub revcomp {
+  my $seq = reverse shift;
+  $seq =~ tr/ACGT/TGCA/;
+  return $seq;
+}
+
+# the errors of Seq::Gene::_build_transcript_error; the coding bases are
+#   $seq from $a to $b
+sub tx_errors {
+  my ( $seq, $a, $b ) = @_;
+  my @error;
+  push @error, 'coding sequence not divisible by 3' if ( $b - $a ) % 3;
+  push @error, 'transcript does not begin with ATG'
+    if $b - $a < 3 || substr( $seq, $a, 3 ) ne 'ATG';
+  push @error, 'transcript does not end with stop codon'
+    if $b - $a < 3 || substr( $seq, $b - 3, 3 ) !~ m/^(?:TAA|TAG|TGA)$/;
+  return \@error;
+}
+
+# what Seq::Gene has for a row: the transcript, its splice sites (within 6 bp
+#   of an exon, in the coding range) and its sites 5' to 3'
+sub add_row {
+  my ( $writer, $row ) = @_;
+  my ( $id, $chr, $strand, undef, undef, $cdsStart, $cdsEnd, undef, $starts, $ends, $symbol ) =
+    @$row;
+  my $at = $offset{$chr};
+  my @s = map { $at + $_ } split /,/, $starts;
+  my @e = map { $at + $_ } split /,/, $ends;
+  $cdsStart += $at;
+  $cdsEnd   += $at;
+
+  my ( $fwd, @pos, $n5, $nCds ) = ('');
+  for my $i ( 0 .. $#s ) {
+    $fwd .= substr( $genomeStr, $s[$i], $e[$i] - $s[$i] );
+    push @pos, $s[$i] .. $e[$i] - 1;
+    $n5   += ( $cdsStart < $s[$i] ? $s[$i] : $cdsStart < $e[$i] ? $cdsStart : $e[$i] ) - $s[$i];
+    $nCds += ( $cdsEnd < $s[$i]   ? $s[$i] : $cdsEnd < $e[$i]   ? $cdsEnd   : $e[$i] ) - $s[$i];
+  }
+  my $minus  = $strand eq '-';
+  my $len    = length $fwd;
+  my $seq    = $minus ? revcomp($fwd) : $fwd;
+  my ( $a, $b ) = $minus ? ( $len - $nCds, $len - $n5 ) : ( $n5, $nCds );
+  @pos = reverse @pos if $minus;
+  my $coding = $cdsStart != $cdsEnd;
+  my $ann = join '', map {
+    !$coding ? '0' : $_ < $a ? '5' : $_ < $b ? substr( $seq, $_, 1 ) : '3'
+  } 0 .. $len - 1;
+
+  my $tx = $writer->add_transcript(
+    {
+      transcript_id         => $id,
+      strand                => $strand,
+      transcript_seq        => $seq,
+      transcript_annotation => $ann,
+      alt_names             => { geneSymbol => ( $symbol =~ m/^0?$/ ? 'NA' : $symbol ) },
+      error_code            => $coding ? tx_errors( $seq, $a, $b ) : [],
+    }
+  );
+  my ( $before, $after ) = $minus ? ( 'Splice Donor', 'Splice Acceptor' )
+    : ( 'Splice Acceptor', 'Splice Donor' );
+  for my $i ( 0 .. $#s ) {
+    for my $n ( 1 .. 6 ) {
+      for ( [ $s[$i] - $n, $before ], [ $e[$i] + $n - 1, $after ] ) {
+        my ( $p, $type ) = @$_;
+        $writer->add_site( $p, $tx, $type, substr( $genomeStr, $p, 1 ) )
+          if $p > $cdsStart && $p < $cdsEnd;
+      }
+    }
+  }
+  $writer->add_transcript_sites( $tx, \@pos, $ann );
+  return $tx;
+}
+
+# the same transcripts, chromosome by chromosome in the order of the tables
+for my $chr (@chrs) {
+  my $writer = Seq::Native::GeneWriter->new;
+  for my $rows (@inRows) {
+    add_row( $writer, $_ ) for grep { $_->[1] eq $chr } @$rows;
+  }
+  my $file = File::Spec->catfile( $dir, "writer.$chr.gdb" );
+  $writer->write($file);
+  is( compare( "$dir/one/test.gene.$chr.gdb", $file ), 0,
+    "$chr: the store Seq::Native::GeneWriter writes" );
+}
+
+# the start and stop codons of the second table are the last put in the genome
+my %error;
+my $db = Seq::Native::GeneDb->new("$dir/four/test.gene.chr1.gdb");
+for my $pos ( 0 .. $chrLen - 1 ) {
+  $error{ $_->{transcript_id} } = $_->{error_code} for @{ $db->db_get($pos) // [] };
+}
+is_deeply( [ @error{qw/ NM_10 NM_16 NM_112 NM_118 /} ], [ ( [] ) x 4 ],
+  'transcripts with a start and stop codon have no errors' );
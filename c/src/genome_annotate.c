@@ -0,0 +1,155 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: genome_annotate.c
+ * Compile: make genome_annotate
+ * Description: Annotates a snpfile against the genome-sized tracks of an
+ *  assembly, one thread per chromosome; see seq_annotate.h for the columns.
+ *  Input:  chr offset file (YAML), genome idx, optional ngene idx with the
+ *            gene region file naming its genes, score tracks given as
+ *            name=file[:min:max[:R]], cadd idx prefix, snpfile
+ *  Output: tab delimited annotation of the genome-sized track fields, with
+ *            --fields followed by the snpfile's own
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "argtable3.h"
+#include "dbg.h"
+#include "seq_genome.h"
+#include "seq_annotate.h"
+
+struct arg_lit *help, *argFields;
+struct arg_int *argThreads;
+struct arg_str *argScore;
+struct arg_file *argChrFile, *argGenome, *argNgene, *argGenes, *argCadd, *argInFile, *argOutFile;
+struct arg_end *end;
+
+/*
+ * name=file[:min:max[:R]]; min and max default to the ranges
+ * Seq::Config::GenomeSizedTrack::BUILDARGS uses for phastCons and phyloP,
+ * R to 255
+ */
+static int add_score( SEQ_GENOME *genome, const char *spec )
+{
+  char buf[4096];
+  double min = 0, max = 255;
+  int R = 255;
+
+  check( (strlen(spec) < sizeof(buf)), "Score spec too long '%s'.", spec );
+  strcpy(buf, spec);
+
+  char *eq = strchr(buf, '=');
+  check( (eq != NULL), "Expected name=file[:min:max[:R]], got '%s'.", spec );
+  *eq = '\0';
+  char *name = buf;
+  char *file = strtok(eq + 1, ":");
+  char *minStr = strtok(NULL, ":");
+  char *maxStr = strtok(NULL, ":");
+  char *RStr = strtok(NULL, ":");
+  check( (file != NULL), "Expected name=file[:min:max[:R]], got '%s'.", spec );
+
+  if(strcmp(name, "phastCons") == 0)
+  {
+    min = 0;
+    max = 1;
+  }
+  else if(strcmp(name, "phyloP") == 0)
+  {
+    min = -30;
+    max = 30;
+  }
+  if(minStr && maxStr)
+  {
+    min = atof(minStr);
+    max = atof(maxStr);
+  }
+  if(RStr)
+    R = atoi(RStr);
+
+  return seq_genome_add_score(genome, name, file, min, max, R);
+
+error:
+  return 1;
+}
+
+int main( int argc, char *argv[] )
+{
+  void *argtable[] = {
+    help        = arg_litn(NULL, "help", 0, 1, "display this help and exit"),
+    argChrFile  = arg_filen("c", "chr", "<file>", 1, 1, "chromosome offset file"),
+    argGenome   = arg_filen("g", "genome", "<file>", 1, 1, "genome idx file"),
+    argNgene    = arg_filen(NULL, "ngene", "<file>", 0, 1, "ngene idx file"),
+    argGenes    = arg_filen(NULL, "genes", "<file>", 0, 1, "gene region file naming the ngene codes"),
+    argScore    = arg_strn("s", "score", "<name=file[:min:max[:R]]>", 0, 32, "score idx file"),
+    argCadd     = arg_filen(NULL, "cadd", "<prefix>", 0, 1, "cadd idx prefix (prefix.0 .. prefix.2)"),
+    argInFile   = arg_filen("i", "in", "<file>", 1, 1, "snpfile, optionally gzipped"),
+    argOutFile  = arg_filen("o", "out", "<file>", 1, 1, "output file"),
+    argFields   = arg_litn(NULL, "fields", 0, 1, "follow each row with its snpfile line"),
+    argThreads  = arg_intn("t", "threads", "<num>", 0, 1, "number of threads (default 1)"),
+    end         = arg_end(20),
+  };
+
+  int exitcode = 0;
+  char progName[] = "genome_annotate";
+  SEQ_GENOME *genome = NULL;
+  int nerrors = arg_parse(argc, argv, argtable);
+
+  if (help->count > 0) {
+    printf("Usage: %s", progName);
+    arg_print_syntax( stdout, argtable, "\n");
+    arg_print_glossary(stdout, argtable, " %-25s %s\n");
+    exitcode = 0;
+    goto exit;
+  }
+
+  if (nerrors > 0)
+  {
+    arg_print_errors(stdout, end, progName);
+    printf("Try '%s --help' for further information.\n", progName);
+    exitcode = 1;
+    goto exit;
+  }
+
+  genome = seq_genome_new();
+  check( (genome != NULL), "Out of memory." );
+  check( (seq_genome_add_genome(genome, argGenome->filename[0]) == 0), "Cannot load genome." );
+  check( (seq_genome_read_offsets(genome, argChrFile->filename[0]) == 0),
+      "Cannot read chromosome offsets." );
+  if(argNgene->count)
+  {
+    check( (argGenes->count), "The ngene track needs the gene region file (--genes)." );
+    check( (seq_genome_add_ngene(genome, argNgene->filename[0]) == 0), "Cannot load ngene." );
+    check( (seq_genome_read_gene_names(genome, argGenes->filename[0]) == 0),
+        "Cannot read gene names." );
+  }
+  for(int i = 0; i < argScore->count; i++)
+    check( (add_score(genome, argScore->sval[i]) == 0), "Cannot load score '%s'.",
+        argScore->sval[i] );
+  // cadd ranges from Seq::Config::GenomeSizedTrack::BUILDARGS
+  if(argCadd->count)
+    check( (seq_genome_add_cadd(genome, argCadd->filename[0], 0, 127, 255) == 0),
+        "Cannot load cadd." );
+
+  log_info("Annotating %s with %d chromosomes and %d score tracks.",
+      argInFile->filename[0], genome->n_chrom, genome->tracks.n_score);
+  exitcode = seq_annotate_file(genome, argInFile->filename[0], argOutFile->filename[0],
+      argFields->count, argThreads->count ? argThreads->ival[0] : 1);
+  goto exit;
+
+error:
+  exitcode = 1;
+
+exit:
+  seq_genome_free(genome);
+  arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+  return exitcode;
+}
@@ -0,0 +1,111 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: genome_genedb.c
+ * Compile: make genome_genedb
+ * Description: Builds a gene track for every chromosome from the UCSC gene
+ *  tables; see seq_genebuild.h.
+ *  Input:  chr offset file (YAML), string genome (.str.dat), gene tables with a
+ *            header line (optionally gzipped), the alt name columns to keep
+ *  Output: <dir>/<name>.gene.<chr>.gdb, <dir>/<name>.gene.<chr>.gan.dat and
+ *            <dir>/<name>.gene.<chr>.exon.dat; with --csq also the consequence
+ *            track <dir>/<name>.csq.idx.0 .. 2 (see seq_csq.h)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "argtable3.h"
+#include "dbg.h"
+#include "seq_genome.h"
+#include "seq_track.h"
+#include "seq_genebuild.h"
+
+struct arg_lit *help, *argCsq;
+struct arg_int *argThreads, *argInGan, *argInExon;
+struct arg_str *argName, *argFeature;
+struct arg_file *argChrFile, *argGenomeStr, *argInFile, *argOutDir;
+struct arg_end *end;
+
+int main( int argc, char *argv[] )
+{
+  void *argtable[] = {
+    help         = arg_litn(NULL, "help", 0, 1, "display this help and exit"),
+    argChrFile   = arg_filen("c", "chr", "<file>", 1, 1, "chromosome offset file"),
+    argGenomeStr = arg_filen("g", "genome_str", "<file>", 1, 1, "string genome file"),
+    argName      = arg_strn("n", "name", "<name>", 1, 1, "gene track name, e.g., knownGene"),
+    argFeature   = arg_strn("f", "feature", "<column>", 0, SEQ_GENEBUILD_MAX_FEATURES,
+                     "alt name column to keep (repeat for each)"),
+    argInFile    = arg_filen("i", "in", "<file>", 1, 1000, "gene table, optionally gzipped"),
+    argOutDir    = arg_filen("d", "dir", "<dir>", 1, 1, "output directory"),
+    argInGan     = arg_intn(NULL, "in_gan", "<num>", 0, 1, "gene site range value (default 8)"),
+    argInExon    = arg_intn(NULL, "in_exon", "<num>", 0, 1, "exon site range value (default 16)"),
+    argCsq       = arg_litn(NULL, "csq", 0, 1, "also write the consequence track"),
+    argThreads   = arg_intn("t", "threads", "<num>", 0, 1, "number of threads (default 1)"),
+    end          = arg_end(20),
+  };
+
+  int exitcode = 0;
+  char progName[] = "genome_genedb";
+  SEQ_GENOME *genome = NULL;
+  SEQ_TRACK *genomeStr = NULL;
+  int nerrors = arg_parse(argc, argv, argtable);
+
+  if (help->count > 0) {
+    printf("Usage: %s", progName);
+    arg_print_syntax( stdout, argtable, "\n");
+    arg_print_glossary(stdout, argtable, " %-25s %s\n");
+    exitcode = 0;
+    goto exit;
+  }
+
+  if (nerrors > 0)
+  {
+    arg_print_errors(stdout, end, progName);
+    printf("Try '%s --help' for further information.\n", progName);
+    exitcode = 1;
+    goto exit;
+  }
+
+  genomeStr = seq_track_open(argGenomeStr->filename[0], SEQ_TRACK_CHAR);
+  check( (genomeStr != NULL), "Cannot load string genome." );
+  genome = seq_genome_new();
+  check( (genome != NULL), "Out of memory." );
+  check( (seq_genome_read_offsets(genome, argChrFile->filename[0]) == 0),
+      "Cannot read chromosome offsets." );
+  // the string genome stands in for the genome track to bound the last chr
+  genome->chrom[genome->n_chrom - 1].end = genomeStr->length;
+
+  SEQ_GENE_BUILD build = {
+    .genome     = genome,
+    .genome_str = genomeStr,
+    .name       = argName->sval[0],
+    .out_dir    = argOutDir->filename[0],
+    .feature    = argFeature->sval,
+    .n_feature  = argFeature->count,
+    .in_gan     = argInGan->count ? argInGan->ival[0] : 8,
+    .in_exon    = argInExon->count ? argInExon->ival[0] : 16,
+    .csq        = argCsq->count > 0,
+    .threads    = argThreads->count ? argThreads->ival[0] : 1,
+  };
+  log_info("Building %s for %d chromosomes from %d files.", build.name, genome->n_chrom,
+      argInFile->count);
+  exitcode = seq_gene_build(&build, argInFile->filename, argInFile->count);
+  goto exit;
+
+error:
+  exitcode = 1;
+
+exit:
+  seq_genome_free(genome);
+  seq_track_close(genomeStr);
+  arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+  return exitcode;
+}
@@ -0,0 +1,94 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: genome_server.c
+ * Compile: make genome_server
+ * Description: Keeps the genome-sized tracks of one or more assemblies mapped
+ *  and answers batched lookups over a Unix domain socket until SIGINT or
+ *  SIGTERM; see seq_server.h for the manifest and seq_proto.h for the protocol.
+ *  Input:  manifest of assemblies and their idx files
+ *  Output: none; serves on the given socket
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include "argtable3.h"
+#include "dbg.h"
+#include "seq_server.h"
+
+struct arg_lit *help;
+struct arg_int *argThreads;
+struct arg_file *argSocket, *argManifest;
+struct arg_end *end;
+
+static SEQ_SERVER *server = NULL;
+
+static void handle_stop( int sig )
+{
+  (void)sig;
+  if(server)
+    server->stop = 1;
+}
+
+int main( int argc, char *argv[] )
+{
+  void *argtable[] = {
+    help        = arg_litn(NULL, "help", 0, 1, "display this help and exit"),
+    argSocket   = arg_filen("s", "socket", "<file>", 1, 1, "path of the Unix domain socket"),
+    argManifest = arg_filen("m", "manifest", "<file>", 1, 1, "manifest of assemblies"),
+    argThreads  = arg_intn("t", "threads", "<num>", 0, 1, "number of worker threads (default 4)"),
+    end         = arg_end(20),
+  };
+
+  int exitcode = 0;
+  char progName[] = "genome_server";
+  int nerrors = arg_parse(argc, argv, argtable);
+
+  if (help->count > 0) {
+    printf("Usage: %s", progName);
+    arg_print_syntax( stdout, argtable, "\n");
+    arg_print_glossary(stdout, argtable, " %-25s %s\n");
+    exitcode = 0;
+    goto exit;
+  }
+
+  if (nerrors > 0)
+  {
+    arg_print_errors(stdout, end, progName);
+    printf("Try '%s --help' for further information.\n", progName);
+    exitcode = 1;
+    goto exit;
+  }
+
+  server = seq_server_new(argSocket->filename[0], argThreads->count ? argThreads->ival[0] : 4);
+  check( (server != NULL), "Cannot create server." );
+  check( (seq_server_load_manifest(server, argManifest->filename[0]) == 0),
+      "Cannot load manifest '%s'.", argManifest->filename[0] );
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handle_stop;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  exitcode = seq_server_run(server);
+  log_info("Server stopped.");
+  goto exit;
+
+error:
+  exitcode = 1;
+
+exit:
+  seq_server_free(server);
+  arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+  return exitcode;
+}
@@ -0,0 +1,106 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: genome_snpdb.c
+ * Compile: make genome_snpdb
+ * Description: Builds a snp track for every chromosome in one pass over the
+ *  UCSC snpNNN dumps; see seq_snpbuild.h.
+ *  Input:  chr offset file (YAML), string genome (.str.dat), snp files with a
+ *            header line (optionally gzipped), the feature columns to keep
+ *  Output: <dir>/<name>.snp.<chr>.sdb and <dir>/<name>.snp.<chr>.dat
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "argtable3.h"
+#include "dbg.h"
+#include "seq_genome.h"
+#include "seq_track.h"
+#include "seq_snpdb.h"
+#include "seq_snpbuild.h"
+
+struct arg_lit *help;
+struct arg_int *argThreads, *argInSnp;
+struct arg_str *argName, *argFeature;
+struct arg_file *argChrFile, *argGenomeStr, *argInFile, *argOutDir;
+struct arg_end *end;
+
+int main( int argc, char *argv[] )
+{
+  void *argtable[] = {
+    help         = arg_litn(NULL, "help", 0, 1, "display this help and exit"),
+    argChrFile   = arg_filen("c", "chr", "<file>", 1, 1, "chromosome offset file"),
+    argGenomeStr = arg_filen("g", "genome_str", "<file>", 1, 1, "string genome file"),
+    argName      = arg_strn("n", "name", "<name>", 1, 1, "snp track name, e.g., snp141"),
+    argFeature   = arg_strn("f", "feature", "<column>", 0, SEQ_SNPDB_MAX_FEATURES - 1,
+                     "feature column to keep (repeat for each)"),
+    argInFile    = arg_filen("i", "in", "<file>", 1, 1000, "snp file, optionally gzipped"),
+    argOutDir    = arg_filen("d", "dir", "<dir>", 1, 1, "output directory"),
+    argInSnp     = arg_intn(NULL, "in_snp", "<num>", 0, 1, "site range value (default 64)"),
+    argThreads   = arg_intn("t", "threads", "<num>", 0, 1, "number of threads (default 1)"),
+    end          = arg_end(20),
+  };
+
+  int exitcode = 0;
+  char progName[] = "genome_snpdb";
+  SEQ_GENOME *genome = NULL;
+  SEQ_TRACK *genomeStr = NULL;
+  int nerrors = arg_parse(argc, argv, argtable);
+
+  if (help->count > 0) {
+    printf("Usage: %s", progName);
+    arg_print_syntax( stdout, argtable, "\n");
+    arg_print_glossary(stdout, argtable, " %-25s %s\n");
+    exitcode = 0;
+    goto exit;
+  }
+
+  if (nerrors > 0)
+  {
+    arg_print_errors(stdout, end, progName);
+    printf("Try '%s --help' for further information.\n", progName);
+    exitcode = 1;
+    goto exit;
+  }
+
+  genomeStr = seq_track_open(argGenomeStr->filename[0], SEQ_TRACK_CHAR);
+  check( (genomeStr != NULL), "Cannot load string genome." );
+  genome = seq_genome_new();
+  check( (genome != NULL), "Out of memory." );
+  check( (seq_genome_read_offsets(genome, argChrFile->filename[0]) == 0),
+      "Cannot read chromosome offsets." );
+  // the string genome stands in for the genome track to bound the last chr
+  genome->chrom[genome->n_chrom - 1].end = genomeStr->length;
+
+  SEQ_SNP_BUILD build = {
+    .genome     = genome,
+    .genome_str = genomeStr,
+    .name       = argName->sval[0],
+    .out_dir    = argOutDir->filename[0],
+    .feature    = argFeature->sval,
+    .n_feature  = argFeature->count,
+    .in_snp     = argInSnp->count ? argInSnp->ival[0] : 64,
+    .threads    = argThreads->count ? argThreads->ival[0] : 1,
+  };
+  log_info("Building %s for %d chromosomes from %d files.", build.name, genome->n_chrom,
+      argInFile->count);
+  exitcode = seq_snp_build(&build, argInFile->filename, argInFile->count);
+  goto exit;
+
+error:
+  exitcode = 1;
+
+exit:
+  seq_genome_free(genome);
+  seq_track_close(genomeStr);
+  arg_freetable(argtable, sizeof(argtable) / sizeof(argtable[0]));
+  return exitcode;
+}
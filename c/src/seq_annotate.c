@@ -0,0 +1,464 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_annotate.c
+ * Description: Native snpfile annotation; see seq_annotate.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <zlib.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_annotate.h"
+#include "seq_sitecode.h"
+#include "seq_pipe.h"
+#include "seq_writer.h"
+
+#define READ_CHUNK (1 << 24)
+#define LINES_CHUNK (1 << 20)     // of the snpfile, for a batch of the pipeline
+
+static int field_is( const char *field, int len, const char *name )
+{
+  return (int)strlen(name) == len && strncmp(field, name, len) == 0;
+}
+
+int seq_snp_cols_parse( SEQ_SNP_COLS *cols, const char *header, size_t len )
+{
+  SEQ_SNP_ROW row;
+  int minor_allele = -1;
+
+  cols->chr = cols->pos = cols->ref = cols->type = -1;
+  cols->alleles = cols->allele_counts = -1;
+
+  seq_snp_row_split(&row, header, len, SEQ_MAX_FIELDS - 1);
+  for(int i = 0; i < row.n_field; i++)
+  {
+    if(field_is(row.field[i], row.len[i], "Fragment"))
+      cols->chr = i;
+    else if(field_is(row.field[i], row.len[i], "Position"))
+      cols->pos = i;
+    else if(field_is(row.field[i], row.len[i], "Reference"))
+      cols->ref = i;
+    else if(field_is(row.field[i], row.len[i], "Type"))
+      cols->type = i;
+    else if(field_is(row.field[i], row.len[i], "Alleles"))
+      cols->alleles = i;
+    else if(field_is(row.field[i], row.len[i], "Allele_Counts"))
+      cols->allele_counts = i;
+    else if(field_is(row.field[i], row.len[i], "Minor_allele"))
+      minor_allele = i;
+  }
+
+  // snp_1 files have Minor_allele where snp_2 files have Alleles
+  if(cols->alleles == -1)
+    cols->alleles = minor_allele;
+
+  check( (cols->chr != -1 && cols->pos != -1 && cols->ref != -1 && cols->type != -1
+        && cols->alleles != -1), "Input file header misformed; expected snp_1 or snp_2." );
+
+  cols->max_col = cols->chr;
+  int all[] = { cols->pos, cols->ref, cols->type, cols->alleles, cols->allele_counts };
+  for(int i = 0; i < 5; i++)
+    if(all[i] > cols->max_col)
+      cols->max_col = all[i];
+  return 0;
+
+error:
+  return 1;
+}
+
+int seq_snp_row_split( SEQ_SNP_ROW *row, const char *line, size_t len, int max_col )
+{
+  const char *p = line;
+  const char *end = line + len;
+
+  // tolerate a trailing '\r' from files written on windows
+  if(end > line && end[-1] == '\r')
+    end--;
+
+  row->n_field = 0;
+  while(p <= end && row->n_field <= max_col && row->n_field < SEQ_MAX_FIELDS)
+  {
+    const char *tab = memchr(p, '\t', (size_t)(end - p));
+    const char *stop = tab ? tab : end;
+    row->field[row->n_field] = p;
+    row->len[row->n_field] = (int)(stop - p);
+    row->n_field++;
+    if(!tab)
+      break;
+    p = tab + 1;
+  }
+  return row->n_field;
+}
+
+static int contains( const char *s, int len, const char *what )
+{
+  int n = (int)strlen(what);
+  for(int i = 0; i + n <= len; i++)
+    if(strncmp(s + i, what, n) == 0)
+      return 1;
+  return 0;
+}
+
+const char *seq_var_type( const char *type, int len )
+{
+  // same precedence as Seq::annotate_snpfile
+  if(contains(type, len, "SNP"))
+    return "SNP";
+  if(contains(type, len, "DEL"))
+    return "DEL";
+  if(contains(type, len, "INS"))
+    return "INS";
+  if(contains(type, len, "MULTIALLELIC"))
+    return "MULTIALLELIC";
+  return NULL;
+}
+
+int seq_annotate_header( const SEQ_GENOME *genome, SEQ_BUF *out )
+{
+  int err = seq_buf_puts(out, "chr\tpos\tvar_type\talleles\tallele_count\tgenomic_type\t"
+      "ref_base\tnearest_gene\tvar_allele");
+  for(int t = 0; t < genome->tracks.n_score; t++)
+  {
+    err |= seq_buf_putc(out, '\t');
+    err |= seq_buf_puts(out, genome->score_name[t]);
+  }
+  if(genome->tracks.has_cadd)
+    err |= seq_buf_puts(out, "\tcadd");
+  err |= seq_buf_putc(out, '\n');
+  return err ? -1 : 0;
+}
+
+// the score's text, made once per code by seq_track_set_score
+static int put_score( SEQ_BUF *out, const SEQ_TRACK *track, long pos )
+{
+  int len = 2;
+  const char *text = track ? seq_track_score_text(track, pos, &len) : "NA";
+  return seq_buf_putc(out, '\t') | seq_buf_add(out, text, len);
+}
+
+// a tab and the snpfile line, without a trailing '\r'
+static int put_line( SEQ_BUF *out, const char *line, size_t len )
+{
+  if(len && line[len - 1] == '\r')
+    len--;
+  return seq_buf_putc(out, '\t') | seq_buf_add(out, line, len);
+}
+
+int seq_annotate_line( const SEQ_GENOME *genome, const SEQ_SNP_COLS *cols,
+    const char *line, size_t len, int fields, SEQ_BUF *out )
+{
+  SEQ_SNP_ROW row;
+  char posStr[32];
+
+  if(seq_snp_row_split(&row, line, len, cols->max_col) <= cols->max_col)
+    return 0;
+
+  const char *varType = seq_var_type(row.field[cols->type], row.len[cols->type]);
+  if(!varType)
+    return 0;
+
+  const SEQ_CHROM *chrom = seq_genome_chrom_n(genome, row.field[cols->chr],
+      row.len[cols->chr]);
+  if(!chrom || row.len[cols->pos] == 0 || row.len[cols->pos] >= (int)sizeof(posStr))
+    return 0;
+
+  memcpy(posStr, row.field[cols->pos], row.len[cols->pos]);
+  posStr[row.len[cols->pos]] = '\0';
+  long pos = atol(posStr);
+  long absPos = seq_genome_abs_pos(chrom, pos);
+  int code = seq_track_get_base(genome->tracks.genome, absPos);
+  if(code < 0)
+    return 0;
+
+  SEQ_SITE site = seq_site_decode((unsigned char)code);
+  if(!site.base)
+    return 0;
+
+  // split the alleles into snp and indel alleles, dropping the reference
+  const char *alleles = row.field[cols->alleles];
+  const int allelesLen = row.len[cols->alleles];
+  const char *snp[64], *indel[64];
+  int snpLen[64], indelLen[64];
+  int nSnp = 0, nIndel = 0;
+
+  for(int i = 0; i < allelesLen && nSnp < 64 && nIndel < 64;)
+  {
+    const char *comma = memchr(alleles + i, ',', (size_t)(allelesLen - i));
+    int aLen = comma ? (int)(comma - (alleles + i)) : allelesLen - i;
+    const char *a = alleles + i;
+    if(!(aLen == 1 && a[0] == site.base) && aLen > 0)
+    {
+      if(aLen == 1)
+      {
+        snp[nSnp] = a;
+        snpLen[nSnp++] = 1;
+      }
+      else if(a[0] == '-' || a[0] == '+')
+      {
+        indel[nIndel] = a;
+        indelLen[nIndel++] = aLen;
+      }
+    }
+    i += aLen + 1;
+  }
+  if(nSnp == 0 && nIndel == 0 && !fields)
+    return 0;
+
+  const char *genomicType = site.in_gene ? (site.in_exon ? "Exonic" : "Intronic")
+    : "Intergenic";
+  int err = 0;
+  err |= seq_buf_add(out, row.field[cols->chr], row.len[cols->chr]);
+  err |= seq_buf_printf(out, "\t%ld\t%s\t", pos, varType);
+  err |= seq_buf_add(out, alleles, allelesLen);
+  err |= seq_buf_putc(out, '\t');
+  if(cols->allele_counts != -1)
+    err |= seq_buf_add(out, row.field[cols->allele_counts], row.len[cols->allele_counts]);
+  else
+    err |= seq_buf_add(out, "NA", 2);
+  err |= seq_buf_printf(out, "\t%s\t%c\t", genomicType, site.base);
+
+  // as Seq::Annotate, the name of the nearest gene of a site outside exons
+  const char *nearestGene = NULL;
+  if(genome->tracks.ngene && !(site.in_gene && site.in_exon))
+    nearestGene = seq_genome_gene_name(genome,
+        seq_track_get_nearest_gene(genome->tracks.ngene, absPos));
+  err |= seq_buf_puts(out, nearestGene ? nearestGene : "NA");
+
+  err |= seq_buf_putc(out, '\t');
+  for(int i = 0; i < nSnp + nIndel; i++)
+  {
+    if(i)
+      err |= seq_buf_putc(out, ',');
+    if(i < nSnp)
+      err |= seq_buf_add(out, snp[i], snpLen[i]);
+    else
+      err |= seq_buf_add(out, indel[i - nSnp], indelLen[i - nSnp]);
+  }
+
+  for(int t = 0; t < genome->tracks.n_score; t++)
+    err |= put_score(out, genome->tracks.score[t], absPos);
+
+  // like Seq::Annotate, the cadd score is that of the last snp allele
+  if(genome->tracks.has_cadd)
+  {
+    int k = nSnp ? seq_cadd_index(site.base, snp[nSnp - 1][0]) : -1;
+    err |= put_score(out, k < 0 ? NULL : genome->tracks.cadd[k], absPos);
+  }
+  if(fields)
+    err |= put_line(out, line, len);
+  err |= seq_buf_putc(out, '\n');
+
+  return err ? -1 : 1;
+}
+
+char *seq_read_file( const char *file, size_t *len )
+{
+  gzFile fh = NULL;
+  char *data = NULL;
+  size_t cap = READ_CHUNK;
+  size_t n = 0;
+
+  check( ((fh = gzopen(file, "r")) != (gzFile)NULL), "Cannot open '%s' for reading.", file );
+  gzbuffer(fh, 1 << 20);
+  data = (char *)malloc(cap + 1);
+  check_mem(data);
+
+  for(;;)
+  {
+    if(cap - n < READ_CHUNK)
+    {
+      cap *= 2;
+      char *bigger = (char *)realloc(data, cap + 1);
+      check_mem(bigger);
+      data = bigger;
+    }
+    int got = gzread(fh, data + n, READ_CHUNK);
+    check( (got >= 0), "Error reading '%s'.", file );
+    if(got == 0)
+      break;
+    n += (size_t)got;
+  }
+  gzclose(fh);
+  data[n] = '\0';
+  *len = n;
+  return data;
+
+error:
+  if(fh)
+    gzclose(fh);
+  free(data);
+  return NULL;
+}
+
+typedef struct annotate_ctx
+{
+  const SEQ_GENOME *genome;
+  const SEQ_SNP_COLS *cols;
+  int fields;
+  SEQ_PIPE *pipe;
+} ANNOTATE_CTX;
+
+// annotates the lines of a batch into its text
+static void *annotate_stage( void *arg, void *item )
+{
+  ANNOTATE_CTX *ctx = (ANNOTATE_CTX *)arg;
+  SEQ_WRITEBATCH *batch = (SEQ_WRITEBATCH *)item;
+  const char *p = batch->in;
+  const char *end = p ? p + batch->in_len : NULL;
+
+  while(p < end)
+  {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+    if(seq_annotate_line(ctx->genome, ctx->cols, p, len, ctx->fields, &batch->text) < 0)
+    {
+      seq_pipe_fail(ctx->pipe);
+      break;
+    }
+    p = nl ? nl + 1 : end;
+  }
+  free(batch->in);
+  batch->in = NULL;
+  return batch;
+}
+
+// reads on to the next newline past LINES_CHUNK bytes (or the end of the
+//  file) and hands back the whole lines; carry keeps the rest. *eof is set once
+//  nothing is left.
+static char *next_lines( gzFile fh, SEQ_BUF *carry, size_t *len, int *eof )
+{
+  char *lines = NULL;
+
+  while(!*eof)
+  {
+    check_mem(seq_buf_reserve(carry, LINES_CHUNK) == 0);
+    int got = gzread(fh, carry->s + carry->len, LINES_CHUNK);
+    check( (got >= 0), "Error reading the snpfile." );
+    carry->len += (size_t)got;
+    *eof = got == 0;
+    if(carry->len >= LINES_CHUNK && memchr(carry->s + carry->len - got, '\n', (size_t)got))
+      break;
+  }
+
+  const char *cut = carry->s + carry->len;
+  if(!*eof)
+  {
+    while(cut[-1] != '\n')
+      cut--;
+  }
+  *len = (size_t)(cut - carry->s);
+  check_mem((lines = (char *)malloc(*len ? *len : 1)));
+  memcpy(lines, carry->s, *len);
+  carry->len -= *len;
+  memmove(carry->s, cut, carry->len);
+  return lines;
+
+error:
+  free(lines);
+  return NULL;
+}
+
+int seq_annotate_file( const SEQ_GENOME *genome, const char *in_file,
+    const char *out_file, int fields, int threads )
+{
+  gzFile inFh = NULL;
+  SEQ_PIPE *pipe = NULL;
+  SEQ_WRITER *writer = NULL;
+  SEQ_WRITEBATCH *batch = NULL;
+  SEQ_BUF carry = { 0 };
+  SEQ_SNP_COLS cols;
+  int eof = 0;
+  int status = 1;
+
+  check( (genome->tracks.genome != NULL), "A genome track is required." );
+  check( (threads >= 1 && threads <= SEQ_PIPE_THREADS), "Impossible number of threads %d.",
+      threads );
+  check( ((inFh = gzopen(in_file, "r")) != (gzFile)NULL), "Cannot open '%s' for reading.",
+      in_file );
+  gzbuffer(inFh, 1 << 20);
+
+  // the first line is the header
+  char *nl = NULL;
+  while(!nl && !eof)
+  {
+    check_mem(seq_buf_reserve(&carry, 1 << 16) == 0);
+    int got = gzread(inFh, carry.s + carry.len, 1 << 16);
+    check( (got >= 0), "Error reading '%s'.", in_file );
+    carry.len += (size_t)got;
+    eof = got == 0;
+    nl = memchr(carry.s, '\n', carry.len);
+  }
+  size_t headLen = nl ? (size_t)(nl - carry.s) : carry.len;
+  check( (seq_snp_cols_parse(&cols, carry.s, headLen) == 0), "Cannot parse header of '%s'.",
+      in_file );
+
+  // the header, followed by the snpfile's when its fields are kept
+  check_mem((batch = seq_writebatch_new()));
+  check( (seq_annotate_header(genome, &batch->text) == 0), "Out of memory." );
+  if(fields)
+  {
+    batch->text.len--;
+    check_mem(put_line(&batch->text, carry.s, headLen) == 0
+        && seq_buf_putc(&batch->text, '\n') == 0);
+  }
+  headLen = nl ? headLen + 1 : headLen;
+  carry.len -= headLen;
+  memmove(carry.s, carry.s + headLen, carry.len);
+
+  // parse (this thread) -> annotate -> compress (for .gz) -> write
+  ANNOTATE_CTX ctx = { genome, &cols, fields, NULL };
+  check_mem((pipe = seq_pipe_new("parse", 4 * threads, seq_writebatch_free)));
+  ctx.pipe = pipe;
+  check_mem(seq_pipe_add(pipe, "annotate", annotate_stage, &ctx, threads, 0));
+  check( ((writer = seq_writer_open(out_file, pipe, threads)) != NULL),
+      "Cannot write output to '%s'.", out_file );
+  // .gz output is indexed on chr and pos as it is written
+  if(writer->gz)
+  {
+    check_mem(seq_writer_index(writer, 1, 2));
+  }
+  check( (seq_pipe_start(pipe)), "Cannot start annotation threads." );
+
+  while(batch)
+  {
+    if(!seq_pipe_put(pipe, batch))
+    {
+      batch = NULL;
+      break;
+    }
+    batch = NULL;
+    if(eof && carry.len == 0)
+      break;
+    check_mem((batch = seq_writebatch_new()));
+    check( ((batch->in = next_lines(inFh, &carry, &batch->in_len, &eof)) != NULL),
+        "Cannot read '%s'.", in_file );
+  }
+  check( (seq_pipe_finish(pipe)), "Annotation of '%s' failed.", in_file );
+  seq_pipe_report(pipe);
+  check( (seq_writer_close(writer)), "Cannot finish writing '%s'.", out_file );
+  status = 0;
+
+error:
+  if(pipe && status)
+  {
+    seq_pipe_fail(pipe);
+    seq_pipe_finish(pipe);
+  }
+  seq_writebatch_free(batch);
+  seq_writer_free(writer);
+  seq_pipe_free(pipe);
+  seq_buf_free(&carry);
+  if(inFh)
+    gzclose(inFh);
+  return status;
+}
@@ -0,0 +1,96 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_annotate.h
+ * Description: Native annotation of a snpfile against the genome-sized tracks
+ *  of an assembly. This is the table-lookup part of Seq::Annotate::annotate -
+ *  reference base, genomic type (Intergenic, Intronic, Exonic), nearest gene,
+ *  every score track and cadd - with the same rules for picking the variant
+ *  alleles as Seq::Annotate::_var_alleles. The gene and snp records of the
+ *  sparse tracks are left to perl (Seq::Annotate::annotate_genome_row).
+ *
+ *  Output columns, tab delimited, named and ordered as in the header of
+ *  Seq::Annotate, which Seq::Role::ProcessFile::print_annotations writes:
+ *    chr pos var_type alleles allele_count genomic_type ref_base
+ *    nearest_gene var_allele <one column per score> [cadd]
+ *  nearest_gene is the name of the ngene code (with seq_genome's gene
+ *  names), given for non-exonic sites only; NA otherwise.
+ *
+ *  With the snpfile's fields kept, each row (the header too) is followed by
+ *  the whole line of the snpfile it was made from, so that perl can find the
+ *  carriers of the row and count it in the statistics as annotate_snpfile
+ *  does; lines without variant alleles are then written too, with an empty
+ *  var_allele, as Seq::Annotate::annotate counts their discordant bases.
+ */
+
+#ifndef __seq_annotate_h__
+#define __seq_annotate_h__
+
+#include <stddef.h>
+#include "seq_genome.h"
+#include "seq_buf.h"
+
+#define SEQ_MAX_FIELDS 64
+
+// indices of the snpfile columns we use; see Seq::Role::ProcessFile
+typedef struct seq_snp_cols
+{
+  int chr;
+  int pos;
+  int ref;
+  int type;
+  int alleles;             // 'Alleles' (snp_2) or 'Minor_allele' (snp_1)
+  int allele_counts;       // -1 for snp_1 files
+  int max_col;
+} SEQ_SNP_COLS;
+
+/*
+ * A parsed snpfile row; fields point into the line and are not terminated,
+ * each has its length in the matching len array.
+ */
+typedef struct seq_snp_row
+{
+  const char *field[SEQ_MAX_FIELDS];
+  int len[SEQ_MAX_FIELDS];
+  int n_field;
+} SEQ_SNP_ROW;
+
+int seq_snp_cols_parse( SEQ_SNP_COLS *cols, const char *header, size_t len );
+int seq_snp_row_split( SEQ_SNP_ROW *row, const char *line, size_t len, int max_col );
+
+/*
+ * Maps the Type column onto the types Seq::annotate_snpfile recognizes (SNP,
+ * DEL, INS, MULTIALLELIC); NULL for anything else.
+ */
+const char *seq_var_type( const char *type, int len );
+
+int seq_annotate_header( const SEQ_GENOME *genome, SEQ_BUF *out );
+
+/*
+ * Annotates one snpfile line, appending a row to out, followed by the line
+ * itself when fields is set; returns 1 when a row was written, 0 when the line
+ * was skipped (unknown chr or type, no variant alleles, etc.) and -1 on error.
+ */
+int seq_annotate_line( const SEQ_GENOME *genome, const SEQ_SNP_COLS *cols,
+    const char *line, size_t len, int fields, SEQ_BUF *out );
+
+/*
+ * Annotates a whole (optionally gzipped) snpfile as a pipeline (seq_pipe.h):
+ * this thread parses the file into batches of lines, threads annotate them,
+ * and a writer (seq_writer.h) compresses them when out_file ends in .gz and
+ * writes them in input order. The counters of each stage are logged at the
+ * end. fields keeps the snpfile's fields, as seq_annotate_line does.
+ */
+int seq_annotate_file( const SEQ_GENOME *genome, const char *in_file,
+    const char *out_file, int fields, int threads );
+
+// reads a whole, possibly gzipped, file into memory; *len excludes the '\0'
+char *seq_read_file( const char *file, size_t *len );
+
+#endif
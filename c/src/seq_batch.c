@@ -0,0 +1,141 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_batch.c
+ * Description: Batched multi-track lookup; see seq_batch.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_batch.h"
+
+SEQ_BATCH *seq_batch_new( long cap, int n_score )
+{
+  SEQ_BATCH *batch = NULL;
+
+  check( (cap > 0), "Impossible batch capacity %ld.", cap );
+  check( (n_score >= 0 && n_score <= SEQ_MAX_SCORE_TRACKS),
+      "Impossible number of score tracks %d.", n_score );
+
+  batch = (SEQ_BATCH *)calloc(1, sizeof(SEQ_BATCH));
+  check_mem(batch);
+  batch->cap     = cap;
+  batch->n_score = n_score;
+
+  batch->site_code    = (int *)malloc(sizeof(int) * cap);
+  batch->nearest_gene = (int *)malloc(sizeof(int) * cap);
+  batch->score        = (double *)malloc(sizeof(double) * cap * (n_score ? n_score : 1));
+  batch->cadd         = (double *)malloc(sizeof(double) * cap * SEQ_CADD_TRACKS);
+  batch->score_code   = (unsigned char *)malloc(cap * (n_score ? n_score : 1));
+  batch->cadd_code    = (unsigned char *)malloc(cap * SEQ_CADD_TRACKS);
+  check_mem(batch->site_code && batch->nearest_gene && batch->score && batch->cadd
+      && batch->score_code && batch->cadd_code);
+
+  return batch;
+
+error:
+  seq_batch_free(batch);
+  return NULL;
+}
+
+void seq_batch_free( SEQ_BATCH *batch )
+{
+  if(!batch)
+    return;
+  free(batch->site_code);
+  free(batch->nearest_gene);
+  free(batch->score);
+  free(batch->cadd);
+  free(batch->score_code);
+  free(batch->cadd_code);
+  free(batch);
+}
+
+static inline void prefetch_track( const SEQ_TRACK *track, long pos )
+{
+  if(track && pos >= 0 && pos < track->length)
+    __builtin_prefetch(track->data + pos * track->width, 0, 0);
+}
+
+int seq_batch_lookup( const SEQ_TRACKS *tracks, const long *pos, long n, SEQ_BATCH *batch )
+{
+  check( (tracks->genome != NULL), "A genome track is required." );
+  check( (n <= batch->cap), "Batch of %ld exceeds capacity %ld.", n, batch->cap );
+  check( (tracks->n_score <= batch->n_score),
+      "Batch holds %d score tracks, %d requested.", batch->n_score, tracks->n_score );
+
+  const long cap = batch->cap;
+
+  // one pass per track keeps each loop's working set to a single mapping;
+  // with sorted positions the prefetches walk forward through that track
+  for(long i = 0; i < n; i++)
+  {
+    if(i + SEQ_PREFETCH_DIST < n)
+      prefetch_track(tracks->genome, pos[i + SEQ_PREFETCH_DIST]);
+    batch->site_code[i] = seq_track_get_base(tracks->genome, pos[i]);
+  }
+
+  for(long i = 0; i < n; i++)
+  {
+    if(!tracks->ngene)
+    {
+      batch->nearest_gene[i] = -1;
+      continue;
+    }
+    if(i + SEQ_PREFETCH_DIST < n)
+      prefetch_track(tracks->ngene, pos[i + SEQ_PREFETCH_DIST]);
+    batch->nearest_gene[i] = seq_track_get_nearest_gene(tracks->ngene, pos[i]);
+  }
+
+  for(int t = 0; t < tracks->n_score; t++)
+  {
+    const SEQ_TRACK *track = tracks->score[t];
+    double *out = batch->score + (long)t * cap;
+    unsigned char *code = batch->score_code + (long)t * cap;
+    for(long i = 0; i < n; i++)
+    {
+      if(i + SEQ_PREFETCH_DIST < n)
+        prefetch_track(track, pos[i + SEQ_PREFETCH_DIST]);
+      int c = seq_track_get_base(track, pos[i]);
+      code[i] = c < 0 ? 0 : (unsigned char)c;
+      out[i] = c < 0 ? NAN : track->score[c];
+    }
+  }
+
+  for(int k = 0; k < SEQ_CADD_TRACKS; k++)
+  {
+    const SEQ_TRACK *track = tracks->has_cadd ? tracks->cadd[k] : NULL;
+    double *out = batch->cadd + (long)k * cap;
+    unsigned char *code = batch->cadd_code + (long)k * cap;
+    for(long i = 0; i < n; i++)
+    {
+      if(!track)
+      {
+        code[i] = 0;
+        out[i] = NAN;
+        continue;
+      }
+      if(i + SEQ_PREFETCH_DIST < n)
+        prefetch_track(track, pos[i + SEQ_PREFETCH_DIST]);
+      int c = seq_track_get_base(track, pos[i]);
+      code[i] = c < 0 ? 0 : (unsigned char)c;
+      out[i] = c < 0 ? NAN : track->score[c];
+    }
+  }
+
+  batch->n = n;
+  return 0;
+
+error:
+  return 1;
+}
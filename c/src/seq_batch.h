@@ -0,0 +1,67 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_batch.h
+ * Description: Batched lookup of every genome-sized track of an assembly.
+ *  Given an array of absolute positions (ideally sorted) fills one output
+ *  array per field - site code, each score track, the three cadd tracks and
+ *  the nearest gene - prefetching SEQ_PREFETCH_DIST positions ahead so the
+ *  page and cache misses of consecutive lookups overlap.
+ */
+
+#ifndef __seq_batch_h__
+#define __seq_batch_h__
+
+#include "seq_track.h"
+
+#define SEQ_PREFETCH_DIST 16
+#define SEQ_MAX_SCORE_TRACKS 32
+#define SEQ_CADD_TRACKS 3
+
+/*
+ * The tracks of one assembly; the tracks are borrowed, not owned. Any of
+ * ngene, score and cadd may be absent (NULL / 0).
+ */
+typedef struct seq_tracks
+{
+  SEQ_TRACK *genome;
+  SEQ_TRACK *ngene;
+  SEQ_TRACK *score[SEQ_MAX_SCORE_TRACKS];
+  int n_score;
+  SEQ_TRACK *cadd[SEQ_CADD_TRACKS];
+  int has_cadd;
+} SEQ_TRACKS;
+
+/*
+ * Struct-of-arrays output of seq_batch_lookup(). Positions outside the
+ * genome get site code -1, nearest gene -1 and NAN scores.
+ *  score[t * cap + i] is score track t at position i
+ *  cadd[k * cap + i] is cadd track k (the k-th alternate allele) at position i
+ * and score_code and cadd_code hold the codes those were decoded from (0,
+ * 'NA', outside the track), to render with the track's score_text.
+ */
+typedef struct seq_batch
+{
+  long n;
+  long cap;
+  int n_score;
+  int *site_code;
+  int *nearest_gene;
+  double *score;
+  double *cadd;
+  unsigned char *score_code;
+  unsigned char *cadd_code;
+} SEQ_BATCH;
+
+SEQ_BATCH *seq_batch_new( long cap, int n_score );
+void seq_batch_free( SEQ_BATCH *batch );
+
+int seq_batch_lookup( const SEQ_TRACKS *tracks, const long *pos, long n, SEQ_BATCH *batch );
+
+#endif
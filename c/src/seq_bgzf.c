@@ -0,0 +1,353 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_bgzf.c
+ * Description: Parallel BGZF reader, and BGZF blocks; see seq_bgzf.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "dbg.h"
+#include "seq_bgzf.h"
+
+#define BGZF_HEADER 12           // up to and with XLEN
+
+static inline unsigned le16( const unsigned char *p )
+{
+  return p[0] | (unsigned)p[1] << 8;
+}
+
+static inline uint32_t le32( const unsigned char *p )
+{
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// the size of the member whose header and extra field (xlen bytes) are at
+//  head, or 0 when it is not a BGZF block
+static size_t block_size( const unsigned char *head, const unsigned char *extra,
+    unsigned xlen )
+{
+  if(head[0] != 0x1f || head[1] != 0x8b || head[2] != 8 || head[3] != 4)
+    return 0;
+  for(unsigned i = 0; i + 4 <= xlen; i += 4 + le16(extra + i + 2))
+    if(extra[i] == 'B' && extra[i + 1] == 'C' && le16(extra + i + 2) == 2 && i + 6 <= xlen)
+      return (size_t)le16(extra + i + 4) + 1;
+  return 0;
+}
+
+int seq_bgzf_check( const char *path )
+{
+  unsigned char head[BGZF_HEADER + 256];
+  FILE *fp = fopen(path, "rb");
+  if(!fp)
+    return 0;
+  size_t n = fread(head, 1, sizeof(head), fp);
+  fclose(fp);
+  if(n < BGZF_HEADER)
+    return 0;
+  unsigned xlen = le16(head + 10);
+  return BGZF_HEADER + xlen <= n && block_size(head, head + BGZF_HEADER, xlen) != 0;
+}
+
+// reads the next member into block; 1 when read, 0 at the end, -1 on error
+static int read_block( SEQ_BGZF *f, SEQ_BGZF_BLOCK *block )
+{
+  unsigned char *in = block->in;
+  size_t got = fread(in, 1, BGZF_HEADER, f->fp);
+  if(got == 0)
+    return 0;
+  check( (got == BGZF_HEADER), "Truncated BGZF block." );
+  const unsigned xlen = le16(in + 10);
+  check( (BGZF_HEADER + xlen < SEQ_BGZF_MAX
+        && fread(in + BGZF_HEADER, 1, xlen, f->fp) == xlen), "Truncated BGZF block." );
+  const size_t size = block_size(in, in + BGZF_HEADER, xlen);
+  check( (size >= BGZF_HEADER + xlen + 8 && size <= SEQ_BGZF_MAX),
+      "Not a BGZF block at offset %llu.", (unsigned long long)f->offset );
+  const size_t rest = size - BGZF_HEADER - xlen;
+  check( (fread(in + BGZF_HEADER + xlen, 1, rest, f->fp) == rest), "Truncated BGZF block." );
+  block->in_len = size;
+  f->offset += size;
+  return 1;
+
+error:
+  return -1;
+}
+
+static void inflate_block( SEQ_BGZF_BLOCK *block )
+{
+  const unsigned xlen = le16(block->in + 10);
+  const unsigned char *data = block->in + BGZF_HEADER + xlen;
+  const size_t dataLen = block->in_len - BGZF_HEADER - xlen - 8;
+  const uint32_t crc = le32(block->in + block->in_len - 8);
+  const uint32_t size = le32(block->in + block->in_len - 4);
+  z_stream zs;
+
+  block->out_len = 0;
+  block->bad = 1;
+  if(size > SEQ_BGZF_MAX)
+    return;
+  memset(&zs, 0, sizeof(zs));
+  if(inflateInit2(&zs, -15) != Z_OK)
+    return;
+  zs.next_in = (Bytef *)data;
+  zs.avail_in = (uInt)dataLen;
+  zs.next_out = (Bytef *)block->out;
+  zs.avail_out = SEQ_BGZF_MAX;
+  int ret = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+  if(ret != Z_STREAM_END || zs.total_out != size)
+    return;
+  if(crc32(crc32(0L, Z_NULL, 0), (const Bytef *)block->out, size) != crc)
+    return;
+  block->out_len = size;
+  block->bad = 0;
+}
+
+// inflates blocks of the round until there are none left to take
+static void inflate_round( SEQ_BGZF *f )
+{
+  for(;;)
+  {
+    pthread_mutex_lock(&f->lock);
+    if(f->next >= f->n_block)
+    {
+      pthread_mutex_unlock(&f->lock);
+      return;
+    }
+    const int i = f->next++;
+    pthread_mutex_unlock(&f->lock);
+
+    inflate_block(&f->block[i]);
+
+    pthread_mutex_lock(&f->lock);
+    if(++f->n_done == f->n_block)
+      pthread_cond_signal(&f->done);
+    pthread_mutex_unlock(&f->lock);
+  }
+}
+
+static void *inflate_worker( void *arg )
+{
+  SEQ_BGZF *f = (SEQ_BGZF *)arg;
+
+  for(;;)
+  {
+    pthread_mutex_lock(&f->lock);
+    while(!f->stop && f->next >= f->n_block)
+      pthread_cond_wait(&f->work, &f->lock);
+    const int stop = f->stop;
+    pthread_mutex_unlock(&f->lock);
+    if(stop)
+      return NULL;
+    inflate_round(f);
+  }
+}
+
+// reads and inflates the next round; 0 at the end of the file
+static int next_round( SEQ_BGZF *f )
+{
+  int n = 0;
+  int got;
+
+  while(n < SEQ_BGZF_ROUND && (got = read_block(f, &f->block[n])) > 0)
+    n++;
+  if(got < 0)
+  {
+    f->error = 1;
+    return 0;
+  }
+  if(n == 0)
+  {
+    f->eof = 1;
+    return 0;
+  }
+
+  pthread_mutex_lock(&f->lock);
+  f->n_block = n;
+  f->next = 0;
+  f->n_done = 0;
+  pthread_cond_broadcast(&f->work);
+  pthread_mutex_unlock(&f->lock);
+
+  inflate_round(f);
+
+  pthread_mutex_lock(&f->lock);
+  while(f->n_done < f->n_block)
+    pthread_cond_wait(&f->done, &f->lock);
+  pthread_mutex_unlock(&f->lock);
+
+  for(int i = 0; i < n; i++)
+    if(f->block[i].bad)
+    {
+      log_err("Cannot inflate the BGZF block %d of a round.", i);
+      f->error = 1;
+      return 0;
+    }
+  f->out = 0;
+  f->out_at = 0;
+  return 1;
+}
+
+SEQ_BGZF *seq_bgzf_open( const char *path, int n_thread )
+{
+  SEQ_BGZF *f = (SEQ_BGZF *)calloc(1, sizeof(SEQ_BGZF));
+  check_mem(f);
+  check( ((f->fp = fopen(path, "rb")) != NULL), "Cannot open '%s' for reading.", path );
+  for(int i = 0; i < SEQ_BGZF_ROUND; i++)
+  {
+    f->block[i].in = (unsigned char *)malloc(SEQ_BGZF_MAX);
+    f->block[i].out = (char *)malloc(SEQ_BGZF_MAX);
+    check_mem(f->block[i].in && f->block[i].out);
+  }
+  pthread_mutex_init(&f->lock, NULL);
+  pthread_cond_init(&f->work, NULL);
+  pthread_cond_init(&f->done, NULL);
+
+  if(n_thread <= 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n_thread = cpus > 0 ? (int)cpus : 1;
+  }
+  if(n_thread > SEQ_BGZF_THREADS)
+    n_thread = SEQ_BGZF_THREADS;
+
+  // the caller inflates too, so there is one thread fewer to start
+  f->thread = (pthread_t *)calloc(n_thread, sizeof(pthread_t));
+  check_mem(f->thread);
+  for(int i = 0; i < n_thread - 1; i++)
+  {
+    if(pthread_create(&f->thread[i], NULL, inflate_worker, f) != 0)
+      break;
+    f->n_thread++;
+  }
+  return f;
+
+error:
+  seq_bgzf_close(f);
+  return NULL;
+}
+
+void seq_bgzf_close( SEQ_BGZF *f )
+{
+  if(!f)
+    return;
+  if(f->thread)
+  {
+    pthread_mutex_lock(&f->lock);
+    f->stop = 1;
+    pthread_cond_broadcast(&f->work);
+    pthread_mutex_unlock(&f->lock);
+    for(int i = 0; i < f->n_thread; i++)
+      pthread_join(f->thread[i], NULL);
+    pthread_mutex_destroy(&f->lock);
+    pthread_cond_destroy(&f->work);
+    pthread_cond_destroy(&f->done);
+    free(f->thread);
+  }
+  if(f->fp)
+    fclose(f->fp);
+  for(int i = 0; i < SEQ_BGZF_ROUND; i++)
+  {
+    free(f->block[i].in);
+    free(f->block[i].out);
+  }
+  free(f);
+}
+
+long seq_bgzf_read( SEQ_BGZF *f, char *buf, size_t len )
+{
+  size_t got = 0;
+
+  while(got < len)
+  {
+    if(f->out >= f->n_block)
+    {
+      if(f->eof || f->error || !next_round(f))
+        break;
+      continue;
+    }
+    const SEQ_BGZF_BLOCK *block = &f->block[f->out];
+    size_t n = block->out_len - f->out_at;
+    if(n > len - got)
+      n = len - got;
+    memcpy(buf + got, block->out + f->out_at, n);
+    got += n;
+    f->out_at += n;
+    if(f->out_at == block->out_len)
+    {
+      f->out++;
+      f->out_at = 0;
+    }
+  }
+  return f->error ? -1 : (long)got;
+}
+
+const unsigned char seq_bgzf_eof[SEQ_BGZF_EOF_LEN] = {
+  0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0, 3, 0,
+  0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static inline void put_le16( unsigned char *p, unsigned v )
+{
+  p[0] = v & 0xff;
+  p[1] = (v >> 8) & 0xff;
+}
+
+static inline void put_le32( unsigned char *p, uint32_t v )
+{
+  put_le16(p, v & 0xffff);
+  put_le16(p + 2, v >> 16);
+}
+
+// deflates text into the block's data; 0 when it does not fit
+static size_t deflate_data( z_stream *zs, const char *text, size_t len, unsigned char *out,
+    size_t room )
+{
+  if(deflateReset(zs) != Z_OK)
+    return 0;
+  zs->next_in = (Bytef *)text;
+  zs->avail_in = (uInt)len;
+  zs->next_out = out;
+  zs->avail_out = (uInt)room;
+  if(deflate(zs, Z_FINISH) != Z_STREAM_END)
+    return 0;
+  return zs->total_out;
+}
+
+size_t seq_bgzf_deflate( z_stream *zs, int level, const char *text, size_t len,
+    unsigned char *out )
+{
+  const size_t head = BGZF_HEADER + 6, room = SEQ_BGZF_MAX - head - 8;
+  size_t dataLen;
+
+  check( (len <= SEQ_BGZF_TEXT), "%zu bytes are too many for a BGZF block.", len );
+  dataLen = deflate_data(zs, text, len, out + head, room);
+  if(!dataLen)
+  {
+    // stored, the text fits with room to spare
+    check( (deflateParams(zs, Z_NO_COMPRESSION, Z_DEFAULT_STRATEGY) == Z_OK),
+        "Cannot store a BGZF block." );
+    dataLen = deflate_data(zs, text, len, out + head, room);
+    check( (deflateParams(zs, level, Z_DEFAULT_STRATEGY) == Z_OK && dataLen),
+        "Cannot store a BGZF block." );
+  }
+
+  const size_t size = head + dataLen + 8;
+  memcpy(out, seq_bgzf_eof, head);
+  put_le16(out + 16, (unsigned)(size - 1));
+  put_le32(out + head + dataLen, (uint32_t)crc32(crc32(0L, Z_NULL, 0), (const Bytef *)text,
+        (uInt)len));
+  put_le32(out + head + dataLen + 4, (uint32_t)len);
+  return size;
+
+error:
+  return 0;
+}
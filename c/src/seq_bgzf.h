@@ -0,0 +1,90 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_bgzf.h
+ * Description: Reader of BGZF files (bgzip, as VCFs are compressed), whose
+ *  blocks are inflated in parallel, and the blocks of a writer's.
+ *
+ *  A BGZF file is a run of gzip members of at most 64K each, with the size
+ *  of the member in its header, so the blocks can be found without inflating
+ *  any. Rounds of blocks are read in order and inflated by a few threads,
+ *  the calling one among them, then handed out in order as gzread would.
+ *
+ *  A place in the text of a BGZF file is its virtual offset: the offset in
+ *  the file of the block it is in, shifted up 16 bits, plus its offset in
+ *  the block's text; indexes (seq_tabix.h) point into the file by them.
+ */
+
+#ifndef __seq_bgzf_h__
+#define __seq_bgzf_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <zlib.h>
+
+#define SEQ_BGZF_MAX     (1 << 16)     // bytes of a block, either way
+#define SEQ_BGZF_ROUND   64            // blocks inflated together
+#define SEQ_BGZF_THREADS 8             // at most
+#define SEQ_BGZF_TEXT    0xff00        // bytes of text a writer puts in a block
+#define SEQ_BGZF_EOF_LEN 28
+
+typedef struct seq_bgzf_block
+{
+  unsigned char *in;             // the whole member
+  size_t in_len;
+  char *out;
+  size_t out_len;
+  int bad;
+} SEQ_BGZF_BLOCK;
+
+typedef struct seq_bgzf
+{
+  FILE *fp;
+  uint64_t offset;               // compressed bytes read so far
+  SEQ_BGZF_BLOCK block[SEQ_BGZF_ROUND];
+  int n_block;                   // in this round
+  int next;                      // next block to inflate
+  int n_done;
+  int out;                       // block handed out from
+  size_t out_at;
+  int eof;
+  int error;
+  pthread_mutex_t lock;
+  pthread_cond_t work;           // a round is ready, or the reader is closing
+  pthread_cond_t done;           // the round is inflated
+  pthread_t *thread;
+  int n_thread;
+  int stop;
+} SEQ_BGZF;
+
+// 1 when the file starts with a BGZF block
+int seq_bgzf_check( const char *path );
+
+// n_thread is the threads to inflate with, the caller included; 0 for one
+//  per cpu, up to SEQ_BGZF_THREADS
+SEQ_BGZF *seq_bgzf_open( const char *path, int n_thread );
+void seq_bgzf_close( SEQ_BGZF *f );
+
+// as gzread: up to len bytes into buf; returns how many, 0 at the end and
+//  -1 when the file cannot be read or is not BGZF throughout
+long seq_bgzf_read( SEQ_BGZF *f, char *buf, size_t len );
+
+// the empty block that ends a BGZF file
+extern const unsigned char seq_bgzf_eof[SEQ_BGZF_EOF_LEN];
+
+// makes the len (up to SEQ_BGZF_TEXT) bytes of text one block, in out (room
+//  for SEQ_BGZF_MAX), with zs a raw deflate stream (deflateInit2 with
+//  windowBits -15) at level; text that will not go in 64K compressed is
+//  stored. Returns the size of the block, 0 when it cannot be made.
+size_t seq_bgzf_deflate( z_stream *zs, int level, const char *text, size_t len,
+    unsigned char *out );
+
+#endif
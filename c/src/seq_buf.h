@@ -0,0 +1,95 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_buf.h
+ * Description: A growable byte buffer for building output text.
+ */
+
+#ifndef __seq_buf_h__
+#define __seq_buf_h__
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+typedef struct seq_buf
+{
+  char *s;
+  size_t len;
+  size_t cap;
+} SEQ_BUF;
+
+// returns 0, or 1 when out of memory
+static inline int seq_buf_reserve( SEQ_BUF *buf, size_t extra )
+{
+  if(buf->len + extra + 1 <= buf->cap)
+    return 0;
+  size_t cap = buf->cap ? buf->cap : 4096;
+  while(buf->len + extra + 1 > cap)
+    cap *= 2;
+  char *s = (char *)realloc(buf->s, cap);
+  if(!s)
+    return 1;
+  buf->s = s;
+  buf->cap = cap;
+  return 0;
+}
+
+static inline int seq_buf_add( SEQ_BUF *buf, const char *s, size_t n )
+{
+  if(seq_buf_reserve(buf, n))
+    return 1;
+  memcpy(buf->s + buf->len, s, n);
+  buf->len += n;
+  buf->s[buf->len] = '\0';
+  return 0;
+}
+
+static inline int seq_buf_puts( SEQ_BUF *buf, const char *s )
+{
+  return seq_buf_add(buf, s, strlen(s));
+}
+
+static inline int seq_buf_putc( SEQ_BUF *buf, char c )
+{
+  return seq_buf_add(buf, &c, 1);
+}
+
+__attribute__((format(printf, 2, 3)))
+static inline int seq_buf_printf( SEQ_BUF *buf, const char *fmt, ... )
+{
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  if(n < 0 || seq_buf_reserve(buf, (size_t)n))
+    return 1;
+  va_start(ap, fmt);
+  vsnprintf(buf->s + buf->len, (size_t)n + 1, fmt, ap);
+  va_end(ap);
+  buf->len += (size_t)n;
+  return 0;
+}
+
+static inline void seq_buf_reset( SEQ_BUF *buf )
+{
+  buf->len = 0;
+  if(buf->s)
+    buf->s[0] = '\0';
+}
+
+static inline void seq_buf_free( SEQ_BUF *buf )
+{
+  free(buf->s);
+  buf->s = NULL;
+  buf->len = buf->cap = 0;
+}
+
+#endif
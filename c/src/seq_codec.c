@@ -0,0 +1,204 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_codec.c
+ * Description: Compact record encoding; see seq_codec.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_codec.h"
+
+SEQ_CODEC *seq_codec_new( int max_intern )
+{
+  SEQ_CODEC *codec = calloc(1, sizeof(SEQ_CODEC));
+  check_mem(codec);
+  codec->max_intern = max_intern < 0 ? SEQ_CODEC_MAX_INTERN : max_intern;
+  return codec;
+
+error:
+  return NULL;
+}
+
+void seq_codec_free( SEQ_CODEC *codec )
+{
+  if(codec)
+  {
+    seq_dict_free(&codec->dict);
+    seq_dict_free(&codec->schema);
+    seq_buf_free(&codec->buf);
+    free(codec);
+  }
+}
+
+static int dict_dump( const SEQ_DICT *dict, SEQ_BUF *out )
+{
+  check( (seq_codec_put_varint(out, dict->n) == 0), "Out of memory." );
+  for(uint32_t code = 1; code <= dict->n; code++)
+  {
+    size_t len;
+    const char *s = seq_dict_str(dict, code, &len);
+    check( (seq_codec_put_varint(out, len) == 0 && seq_buf_add(out, s, len) == 0),
+        "Out of memory." );
+  }
+  return 0;
+
+error:
+  return 1;
+}
+
+static int dict_load( SEQ_DICT *dict, const char *data, size_t len )
+{
+  const char *p = data, *end = data + len;
+  uint64_t n, slen;
+
+  // codes are handed out in order, so interning the strings in the order they
+  // were dumped gives every one of them its old code back
+  check( (dict->n == 0), "Dictionary is already loaded." );
+  check( (seq_codec_get_varint(&p, end, &n) == 0), "Truncated dictionary." );
+  for(uint64_t code = 1; code <= n; code++)
+  {
+    check( (seq_codec_get_varint(&p, end, &slen) == 0 && slen <= (uint64_t)(end - p)),
+        "Truncated dictionary." );
+    check( (seq_dict_intern(dict, p, slen) == code),
+        "Dictionary string %llu is a duplicate.", (unsigned long long)code );
+    p += slen;
+  }
+  return 0;
+
+error:
+  return 1;
+}
+
+int seq_codec_dict_dump( const SEQ_CODEC *codec, SEQ_BUF *out )
+{
+  return dict_dump(&codec->dict, out);
+}
+
+int seq_codec_dict_load( SEQ_CODEC *codec, const char *data, size_t len )
+{
+  if(dict_load(&codec->dict, data, len))
+    return 1;
+  codec->dirty = 0;
+  return 0;
+}
+
+int seq_codec_schema_dump( const SEQ_CODEC *codec, SEQ_BUF *out )
+{
+  return dict_dump(&codec->schema, out);
+}
+
+int seq_codec_schema_load( SEQ_CODEC *codec, const char *data, size_t len )
+{
+  return dict_load(&codec->schema, data, len);
+}
+
+int seq_codec_put_double( SEQ_BUF *out, double v )
+{
+  char b[1 + sizeof(double)];
+  b[0] = SEQ_CODEC_DOUBLE;
+  memcpy(b + 1, &v, sizeof(double));
+  return seq_buf_add(out, b, sizeof(b));
+}
+
+static uint32_t codec_intern( SEQ_CODEC *codec, const char *s, size_t len )
+{
+  uint32_t code = seq_dict_find(&codec->dict, s, len);
+  if(code || codec->dict.n >= SEQ_CODEC_MAX_ATOMS)
+    return code;
+  code = seq_dict_intern(&codec->dict, s, len);
+  codec->dirty = 1;
+  return code;
+}
+
+int seq_codec_put_str( SEQ_CODEC *codec, SEQ_BUF *out, const char *s, size_t len, int utf8 )
+{
+  if(!utf8 && len <= (size_t)codec->max_intern)
+  {
+    uint32_t code = codec_intern(codec, s, len);
+    if(code)
+      return seq_buf_putc(out, SEQ_CODEC_ATOM) || seq_codec_put_varint(out, code);
+  }
+  return seq_buf_putc(out, utf8 ? SEQ_CODEC_UTF8 : SEQ_CODEC_STR)
+    || seq_codec_put_varint(out, len) || seq_buf_add(out, s, len);
+}
+
+uint32_t seq_codec_key( SEQ_CODEC *codec, const char *s, size_t len )
+{
+  uint32_t code = seq_dict_find(&codec->dict, s, len);
+  if(!code)
+  {
+    // keys are few; they are interned even once the dictionary is full
+    code = seq_dict_intern(&codec->dict, s, len);
+    if(code)
+      codec->dirty = 1;
+  }
+  return code;
+}
+
+int seq_codec_put_key( SEQ_CODEC *codec, SEQ_BUF *out, const char *s, size_t len )
+{
+  uint32_t code = seq_codec_key(codec, s, len);
+  return !code || seq_codec_put_varint(out, code);
+}
+
+uint32_t seq_codec_shape( SEQ_CODEC *codec, const uint32_t *key, int n )
+{
+  // at most 5 bytes a varint of a 32-bit code
+  char sss[SEQ_CODEC_MAX_SHAPE_KEYS * 5];
+  size_t len = 0;
+
+  if(n > SEQ_CODEC_MAX_SHAPE_KEYS)
+    return 0;
+  for(int i = 0; i < n; i++)
+  {
+    uint32_t v = key[i];
+    while(v >= 0x80)
+    {
+      sss[len++] = (char)(v | 0x80);
+      v >>= 7;
+    }
+    sss[len++] = (char)v;
+  }
+  uint32_t code = seq_dict_find(&codec->schema, sss, len);
+  if(code || codec->schema.n >= SEQ_CODEC_MAX_SHAPES)
+    return code;
+  code = seq_dict_intern(&codec->schema, sss, len);
+  if(code)
+    codec->dirty = 1;
+  return code;
+}
+
+int seq_codec_shape_keys( const SEQ_CODEC *codec, uint64_t code,
+    uint32_t key[SEQ_CODEC_MAX_SHAPE_KEYS] )
+{
+  size_t len;
+  int n = 0;
+
+  if(code == 0 || code > codec->schema.n)
+    return -1;
+  const char *p = seq_dict_str(&codec->schema, (uint32_t)code, &len);
+  const char *end = p + len;
+  while(p < end)
+  {
+    uint64_t v;
+    if(n == SEQ_CODEC_MAX_SHAPE_KEYS || seq_codec_get_varint(&p, end, &v) || v > UINT32_MAX)
+      return -1;
+    key[n++] = (uint32_t)v;
+  }
+  return n;
+}
+
+const char *seq_codec_atom( const SEQ_CODEC *codec, uint64_t code, size_t *len )
+{
+  if(code == 0 || code > codec->dict.n)
+    return NULL;
+  return seq_dict_str(&codec->dict, (uint32_t)code, len);
+}
@@ -0,0 +1,141 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_codec.h
+ * Description: Compact binary encoding of sparse-track records (the gene
+ *  site, transcript and snp hashes kept in the kch files) in place of JSON.
+ *  Every value starts with a one byte tag:
+ *    UNDEF
+ *    INT     zigzag varint
+ *    DOUBLE  8 bytes
+ *    STR     varint length, bytes
+ *    UTF8    varint length, utf-8 bytes
+ *    ATOM    varint code into the dictionary
+ *    ARRAY   varint n, n values
+ *    HASH    varint n, n x (varint key code, value)
+ *    RECORD  varint shape code, a value per key of the shape
+ *  Hash keys are always interned and so are short strings (gene symbols,
+ *  transcript ids, site types, ...). A hash is written as a RECORD: the
+ *  codes of its keys, in ascending order, are its shape, which is interned in
+ *  a second dictionary, the schema, so a record carries its shape once and
+ *  then only its values. Hashes of more than SEQ_CODEC_MAX_SHAPE_KEYS keys, or
+ *  once the schema is full, are written as a HASH. The dictionary and the
+ *  schema belong to the database and are stored next to the records (see
+ *  Seq::KCManager).
+ */
+
+#ifndef __seq_codec_h__
+#define __seq_codec_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seq_dict.h"
+#include "seq_buf.h"
+
+#define SEQ_CODEC_UNDEF  0
+#define SEQ_CODEC_INT    1
+#define SEQ_CODEC_DOUBLE 2
+#define SEQ_CODEC_STR    3
+#define SEQ_CODEC_UTF8   4
+#define SEQ_CODEC_ATOM   5
+#define SEQ_CODEC_ARRAY  6
+#define SEQ_CODEC_HASH   7
+#define SEQ_CODEC_RECORD 8
+
+#define SEQ_CODEC_MAX_INTERN 40        // longest string value that is interned
+#define SEQ_CODEC_MAX_ATOMS (1 << 22)  // past this strings are stored inline
+#define SEQ_CODEC_MAX_SHAPES (1 << 16)
+#define SEQ_CODEC_MAX_SHAPE_KEYS 64
+
+typedef struct seq_codec
+{
+  SEQ_DICT dict;
+  SEQ_DICT schema;         // shapes: the varint key codes of each
+  int max_intern;
+  int dirty;               // the dictionary or schema grew since the last dump
+  SEQ_BUF buf;             // scratch space for the encoder
+} SEQ_CODEC;
+
+SEQ_CODEC *seq_codec_new( int max_intern );
+void seq_codec_free( SEQ_CODEC *codec );
+
+// dictionary as varint n, then n x (varint length, bytes)
+int seq_codec_dict_dump( const SEQ_CODEC *codec, SEQ_BUF *out );
+int seq_codec_dict_load( SEQ_CODEC *codec, const char *data, size_t len );
+
+// the schema, laid out like the dictionary
+int seq_codec_schema_dump( const SEQ_CODEC *codec, SEQ_BUF *out );
+int seq_codec_schema_load( SEQ_CODEC *codec, const char *data, size_t len );
+
+static inline int seq_codec_put_varint( SEQ_BUF *out, uint64_t v )
+{
+  char b[10];
+  int n = 0;
+  while(v >= 0x80)
+  {
+    b[n++] = (char)(v | 0x80);
+    v >>= 7;
+  }
+  b[n++] = (char)v;
+  return seq_buf_add(out, b, n);
+}
+
+// returns 0 on success, 1 at the end of the buffer or on a bad varint
+static inline int seq_codec_get_varint( const char **p, const char *end, uint64_t *v )
+{
+  uint64_t r = 0;
+  for(int shift = 0; shift < 64; shift += 7)
+  {
+    if(*p >= end)
+      return 1;
+    unsigned char c = (unsigned char)*(*p)++;
+    r |= (uint64_t)(c & 0x7f) << shift;
+    if(!(c & 0x80))
+    {
+      *v = r;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static inline int seq_codec_put_int( SEQ_BUF *out, int64_t v )
+{
+  return seq_buf_putc(out, SEQ_CODEC_INT)
+    || seq_codec_put_varint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static inline int64_t seq_codec_unzigzag( uint64_t v )
+{
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+int seq_codec_put_double( SEQ_BUF *out, double v );
+
+// a string value: interned when short enough, inline otherwise
+int seq_codec_put_str( SEQ_CODEC *codec, SEQ_BUF *out, const char *s, size_t len, int utf8 );
+
+// a hash key (always interned, no tag)
+int seq_codec_put_key( SEQ_CODEC *codec, SEQ_BUF *out, const char *s, size_t len );
+
+// the code of a hash key, interned as needed; 0 when out of memory
+uint32_t seq_codec_key( SEQ_CODEC *codec, const char *s, size_t len );
+
+// the code of the shape of n key codes, in ascending order, interned as
+//  needed; 0 when the schema is full or out of memory
+uint32_t seq_codec_shape( SEQ_CODEC *codec, const uint32_t *key, int n );
+
+// the key codes of a shape; returns their number, or -1 for an unknown shape
+int seq_codec_shape_keys( const SEQ_CODEC *codec, uint64_t code,
+    uint32_t key[SEQ_CODEC_MAX_SHAPE_KEYS] );
+
+// looks up an interned string; NULL for an unknown code
+const char *seq_codec_atom( const SEQ_CODEC *codec, uint64_t code, size_t *len );
+
+#endif
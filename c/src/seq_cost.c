@@ -0,0 +1,146 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_cost.c
+ * Description: Cost hints of snpfile rows and tasks cut by them; see seq_cost.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dbg.h"
+#include "seq_cost.h"
+
+// the sites a row's alleles cover: the bases of its longest deletion, or one
+static long row_sites( const char *alleles, int len )
+{
+  long sites = 1;
+  for(int i = 0; i < len;)
+  {
+    const char *comma = memchr(alleles + i, ',', (size_t)(len - i));
+    int aLen = comma ? (int)(comma - (alleles + i)) : len - i;
+    if(aLen > 1 && alleles[i] == '-')
+    {
+      long n = 0;
+      for(int j = i + 1; j < i + aLen && alleles[j] >= '0' && alleles[j] <= '9'; j++)
+        n = n < SEQ_COST_MAX_SITES ? 10 * n + (alleles[j] - '0') : n;
+      if(n > sites)
+        sites = n;
+    }
+    i += aLen + 1;
+  }
+  return sites < SEQ_COST_MAX_SITES ? sites : SEQ_COST_MAX_SITES;
+}
+
+static uint64_t row_cost( const SEQ_TRACK *genome, const SEQ_SNP_COLS *cols,
+    const SEQ_COST_CHROM *chrom, int n_chrom, int *last, const char *line, size_t len )
+{
+  SEQ_SNP_ROW row;
+  const uint64_t bytes = 1 + len / SEQ_COST_BYTES;
+
+  if(seq_snp_row_split(&row, line, len, cols->max_col) <= cols->max_col)
+    return bytes;
+  if(!seq_var_type(row.field[cols->type], row.len[cols->type]))
+    return bytes;
+
+  // rows come a chromosome at a time
+  const char *name = row.field[cols->chr];
+  const int nameLen = row.len[cols->chr];
+  if(*last < 0 || chrom[*last].len != nameLen || memcmp(chrom[*last].name, name, nameLen))
+  {
+    *last = -1;
+    for(int i = 0; i < n_chrom; i++)
+      if(chrom[i].len == nameLen && memcmp(chrom[i].name, name, nameLen) == 0)
+      {
+        *last = i;
+        break;
+      }
+    if(*last < 0)
+      return bytes;
+  }
+
+  long pos = 0;
+  for(int i = 0; i < row.len[cols->pos] && row.field[cols->pos][i] >= '0'
+      && row.field[cols->pos][i] <= '9' && pos < (1L << 40); i++)
+    pos = 10 * pos + (row.field[cols->pos][i] - '0');
+  const int code = pos ? seq_track_get_base(genome, chrom[*last].offset + pos - 1) : -1;
+  return bytes + seq_cost_sites(code, row_sites(row.field[cols->alleles],
+        row.len[cols->alleles]));
+}
+
+long seq_cost_tasks( const SEQ_TRACK *genome, const SEQ_SNP_COLS *cols,
+    const SEQ_COST_CHROM *chrom, int n_chrom, const char *path, uint64_t start,
+    uint64_t end, uint64_t task_cost, uint64_t max_bytes, SEQ_COST_TASK **tasks )
+{
+  int fd = -1;
+  const char *map = NULL;
+  size_t size = 0;
+  SEQ_COST_TASK *task = NULL;
+  long n = 0, cap = 0;
+  int last = -1;
+  struct stat st;
+
+  *tasks = NULL;
+  check( ((fd = open(path, O_RDONLY)) >= 0), "Cannot open '%s' for reading.", path );
+  check( (fstat(fd, &st) == 0), "Cannot stat '%s'.", path );
+  size = (size_t)st.st_size;
+  if(end == 0 || end > size)
+    end = size;
+  if(start < end)
+  {
+    map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    check( (map != MAP_FAILED), "Cannot map '%s'.", path );
+    madvise((void *)map, size, MADV_SEQUENTIAL);
+  }
+
+  uint64_t taskStart = start, cost = 0;
+  for(uint64_t p = start; p < end;)
+  {
+    const char *nl = memchr(map + p, '\n', (size_t)(end - p));
+    const uint64_t next = nl ? (uint64_t)(nl - map) + 1 : end;
+    size_t len = (size_t)(next - p) - (nl ? 1 : 0);
+    if(len && map[p + len - 1] == '\r')
+      len--;
+    cost += row_cost(genome, cols, chrom, n_chrom, &last, map + p, len);
+    p = next;
+
+    if(p == end || cost >= task_cost || p - taskStart >= max_bytes)
+    {
+      if(n == cap)
+      {
+        cap = cap ? 2 * cap : 64;
+        SEQ_COST_TASK *bigger = (SEQ_COST_TASK *)realloc(task, cap * sizeof(SEQ_COST_TASK));
+        check_mem(bigger);
+        task = bigger;
+      }
+      task[n].start = taskStart;
+      task[n].end = p;
+      task[n++].cost = cost;
+      taskStart = p;
+      cost = 0;
+    }
+  }
+
+  if(map)
+    munmap((void *)map, size);
+  close(fd);
+  *tasks = task;
+  return n;
+
+error:
+  if(map && map != MAP_FAILED)
+    munmap((void *)map, size);
+  if(fd >= 0)
+    close(fd);
+  free(task);
+  return -1;
+}
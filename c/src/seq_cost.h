@@ -0,0 +1,81 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_cost.h
+ * Description: Cost hints for annotating the rows of a snpfile, and tasks of
+ *  about equal cost cut from it.
+ *
+ *  What a row costs Seq::Annotate depends on where it falls far more than on
+ *  its length: an intergenic snp is a few track lookups, a site in a gene
+ *  brings transcript records out of the gene db, an exonic one codons and
+ *  residues as well, and a deletion does all that for every base it covers
+ *  (Seq::Sites::Indels). The hint of a row is 1, plus its bytes over
+ *  SEQ_COST_BYTES (the sample columns), plus, for each site it covers,
+ *  SEQ_COST_SITE and the weights of the flags of its first base's site code.
+ */
+
+#ifndef __seq_cost_h__
+#define __seq_cost_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seq_track.h"
+#include "seq_sitecode.h"
+#include "seq_annotate.h"
+
+#define SEQ_COST_BYTES  64
+#define SEQ_COST_SITE   1
+#define SEQ_COST_GAN    2
+#define SEQ_COST_GENE   4
+#define SEQ_COST_EXON   8
+#define SEQ_COST_MAX_SITES 100000  // of a deletion, counted
+
+typedef struct seq_cost_chrom
+{
+  const char *name;
+  int len;
+  long offset;             // absolute position of the chr's first base
+} SEQ_COST_CHROM;
+
+// a range of whole lines, [start, end) in bytes, and the hint of its rows
+typedef struct seq_cost_task
+{
+  uint64_t start;
+  uint64_t end;
+  uint64_t cost;
+} SEQ_COST_TASK;
+
+// the hint of a row of sites sites from one with the code of its first
+static inline uint64_t seq_cost_sites( int code, long sites )
+{
+  uint64_t site = SEQ_COST_SITE;
+  if(code >= 0)
+  {
+    if(code & SEQ_SITE_GAN)
+      site += SEQ_COST_GAN;
+    if(code & SEQ_SITE_GENE)
+      site += SEQ_COST_GENE;
+    if(code & SEQ_SITE_EXON)
+      site += SEQ_COST_EXON;
+  }
+  return site * (uint64_t)sites;
+}
+
+/*
+ * Cuts [start, end) of a plain snpfile, which start on a line after the
+ * header, into tasks of whole lines of about task_cost, and at most max_bytes
+ * unless a line is longer. Rows of chromosomes not in chrom, and rows
+ * annotate_snpfile skips, cost their bytes alone. Returns the number of
+ * tasks, in *tasks (to free), or -1 when the file cannot be read.
+ */
+long seq_cost_tasks( const SEQ_TRACK *genome, const SEQ_SNP_COLS *cols,
+    const SEQ_COST_CHROM *chrom, int n_chrom, const char *path, uint64_t start,
+    uint64_t end, uint64_t task_cost, uint64_t max_bytes, SEQ_COST_TASK **tasks );
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_csq.c
+ * Description: Substitution consequences; see seq_csq.h
+ */
+
+#include <string.h>
+#include "seq_csq.h"
+
+const char *seq_csq_name[SEQ_CSQ_N_CODE] = {
+  "None", "Synonymous", "Missense", "Nonsense", "Stop Loss", "Start Loss", "Splice"
+};
+
+static char complement( char b )
+{
+  switch(b)
+  {
+    case 'A': return 'T';
+    case 'C': return 'G';
+    case 'G': return 'C';
+    case 'T': return 'A';
+  }
+  return b;
+}
+
+int seq_csq_code( const SEQ_GENEDB *db, long row, char alt )
+{
+  const SEQ_GENEDB_SITE *site = &db->site[row];
+  char codon[4];
+  long codonNumber;
+  int codonPosition;
+
+  if(site->type == SEQ_GENE_SPLICE_ACCEPTOR || site->type == SEQ_GENE_SPLICE_DONOR)
+    return SEQ_CSQ_SPLICE;
+  if(!seq_genedb_codon(db, row, codon, &codonNumber, &codonPosition) || strlen(codon) != 3)
+    return SEQ_CSQ_NONE;
+
+  // the same substitution Seq::Site::Annotation makes in the reference codon
+  const char refAa = seq_codon_to_aa(codon);
+  codon[codonPosition] = db->tx[site->tx].strand == '-' ? complement(alt) : alt;
+  const char newAa = seq_codon_to_aa(codon);
+  if(!refAa || !newAa)
+    return SEQ_CSQ_NONE;
+
+  if(newAa == refAa)
+    return SEQ_CSQ_SYNONYMOUS;
+  if(codonNumber == 1 && refAa == 'M')
+    return SEQ_CSQ_START_LOSS;
+  if(refAa == '*')
+    return SEQ_CSQ_STOP_LOSS;
+  if(newAa == '*')
+    return SEQ_CSQ_NONSENSE;
+  return SEQ_CSQ_MISSENSE;
+}
+
+int seq_csq_substitute( const SEQ_GENEDB *db, long row, char alt, char codon[4] )
+{
+  long codonNumber;
+  int codonPosition;
+
+  if(!seq_genedb_codon(db, row, codon, &codonNumber, &codonPosition) || !codon[0])
+    return 0;
+  codon[codonPosition] = db->tx[db->site[row].tx].strand == '-' ? complement(alt) : alt;
+  return 1;
+}
+
+void seq_csq_fill( const SEQ_GENEDB *db, const char *genome, long base, long len,
+    unsigned char *out[3] )
+{
+  static const char *bases = "ACGT";
+  const long n = db->header->n_site;
+
+  for(long first = 0; first < n; )
+  {
+    // the sites at one position are next to each other
+    const long pos = db->pos[first];
+    long last = first;
+    while(last + 1 < n && db->pos[last + 1] == pos)
+      last++;
+
+    const char ref = genome[pos];
+    if(pos >= base && pos < base + len && ref && strchr(bases, ref))
+    {
+      for(int b = 0; b < 4; b++)
+      {
+        int slot = seq_csq_slot(ref, bases[b]);
+        if(slot < 0)
+          continue;
+        out[slot][pos - base] = (unsigned char)(seq_csq_code(db, first, bases[b])
+          | (last > first ? SEQ_CSQ_MULTI : 0));
+      }
+    }
+    first = last + 1;
+  }
+}
@@ -0,0 +1,74 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_csq.h
+ * Description: Consequence of a single base substitution on a transcript,
+ *  and the precomputed consequence track.
+ *
+ *  The track is laid out like the cadd track: three genome-sized byte files,
+ *  <name>.csq.idx.0 .. 2, one per alternate base, the alternates of each
+ *  reference base taken in ACGT order (see Seq::Annotate::_build_cadd_lookup).
+ *  Each byte is a SEQ_CSQ_* code in the low bits, plus SEQ_CSQ_MULTI when
+ *  more than one transcript covers the site; the code is then that of the
+ *  first transcript only and the gene site store has to be asked. Positions
+ *  that no transcript covers are 0.
+ */
+
+#ifndef __seq_csq_h__
+#define __seq_csq_h__
+
+#include <string.h>
+#include "seq_genedb.h"
+
+enum
+{
+  SEQ_CSQ_NONE = 0,        // not in a complete codon: UTR, ncRNA, ...
+  SEQ_CSQ_SYNONYMOUS,
+  SEQ_CSQ_MISSENSE,
+  SEQ_CSQ_NONSENSE,
+  SEQ_CSQ_STOP_LOSS,
+  SEQ_CSQ_START_LOSS,
+  SEQ_CSQ_SPLICE,
+  SEQ_CSQ_N_CODE
+};
+
+#define SEQ_CSQ_MASK  0x07
+#define SEQ_CSQ_MULTI 0x08
+
+extern const char *seq_csq_name[SEQ_CSQ_N_CODE];
+
+// slot of alt among the alternates of ref, as in the cadd track; -1 if either
+//  is not one of ACGT or they are the same base
+static inline int seq_csq_slot( char ref, char alt )
+{
+  static const char *bases = "ACGT";
+  const char *r = ref ? strchr(bases, ref) : NULL;
+  const char *a = alt ? strchr(bases, alt) : NULL;
+  if(!r || !a || r == a)
+    return -1;
+  return (int)(a - bases) - (a > r);
+}
+
+// consequence of alt (a base on the + strand) at gene site row of db
+int seq_csq_code( const SEQ_GENEDB *db, long row, char alt );
+
+// the codon of gene site row of db with alt (a base on the + strand) in place
+//  of its base, as Seq::Site::Annotation substitutes it; 0 if the site is not
+//  in a codon
+int seq_csq_substitute( const SEQ_GENEDB *db, long row, char alt, char codon[4] );
+
+/*
+ * Fills the consequence bytes of every site in db: out[slot][abs_pos - base]
+ * for abs_pos in [base, base + len); genome is the string genome, which gives
+ * the reference base the slots are relative to
+ */
+void seq_csq_fill( const SEQ_GENEDB *db, const char *genome, long base, long len,
+    unsigned char *out[3] );
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_dict.c
+ * Description: String interning; see seq_dict.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_dict.h"
+
+// FNV-1a
+static uint64_t hash_str( const char *s, size_t len )
+{
+  uint64_t h = 14695981039346656037ULL;
+  for(size_t i = 0; i < len; i++)
+  {
+    h ^= (unsigned char)s[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static int same( const SEQ_DICT *dict, uint32_t code, const char *s, size_t len )
+{
+  size_t have;
+  const char *str = seq_dict_str(dict, code, &have);
+  return have == len && memcmp(str, s, len) == 0;
+}
+
+uint32_t seq_dict_find( const SEQ_DICT *dict, const char *s, size_t len )
+{
+  if(!dict->n_slot)
+    return 0;
+  uint32_t mask = dict->n_slot - 1;
+  for(uint32_t i = (uint32_t)hash_str(s, len) & mask; dict->slot[i]; i = (i + 1) & mask)
+    if(same(dict, dict->slot[i], s, len))
+      return dict->slot[i];
+  return 0;
+}
+
+static int rehash( SEQ_DICT *dict, uint32_t n_slot )
+{
+  uint32_t *slot = (uint32_t *)calloc(n_slot, sizeof(uint32_t));
+  check_mem(slot);
+  for(uint32_t code = 1; code <= dict->n; code++)
+  {
+    size_t len;
+    const char *s = seq_dict_str(dict, code, &len);
+    uint32_t i = (uint32_t)hash_str(s, len) & (n_slot - 1);
+    while(slot[i])
+      i = (i + 1) & (n_slot - 1);
+    slot[i] = code;
+  }
+  free(dict->slot);
+  dict->slot = slot;
+  dict->n_slot = n_slot;
+  return 0;
+
+error:
+  return 1;
+}
+
+uint32_t seq_dict_intern( SEQ_DICT *dict, const char *s, size_t len )
+{
+  uint32_t code = seq_dict_find(dict, s, len);
+  if(code)
+    return code;
+
+  // keep the table at most half full
+  if(2 * (dict->n + 1) > dict->n_slot)
+    check( (rehash(dict, dict->n_slot ? 2 * dict->n_slot : 64) == 0), "Out of memory." );
+  check( ((uint64_t)dict->len + len < UINT32_MAX), "Dictionary larger than 4GB." );
+
+  if(dict->len + len > dict->cap)
+  {
+    uint32_t cap = dict->cap ? dict->cap : 4096;
+    while(cap < dict->len + len)
+      cap *= 2;
+    char *buf = (char *)realloc(dict->buf, cap);
+    check_mem(buf);
+    dict->buf = buf;
+    dict->cap = cap;
+  }
+  if(dict->n + 2 > dict->off_cap)
+  {
+    uint32_t off_cap = dict->off_cap ? 2 * dict->off_cap : 256;
+    uint32_t *off = (uint32_t *)realloc(dict->off, off_cap * sizeof(uint32_t));
+    check_mem(off);
+    dict->off = off;
+    dict->off_cap = off_cap;
+    dict->off[0] = 0;
+  }
+
+  memcpy(dict->buf + dict->len, s, len);
+  dict->len += (uint32_t)len;
+  code = ++dict->n;
+  dict->off[code] = dict->len;
+
+  uint32_t i = (uint32_t)hash_str(s, len) & (dict->n_slot - 1);
+  while(dict->slot[i])
+    i = (i + 1) & (dict->n_slot - 1);
+  dict->slot[i] = code;
+  return code;
+
+error:
+  return 0;
+}
+
+void seq_dict_free( SEQ_DICT *dict )
+{
+  free(dict->buf);
+  free(dict->off);
+  free(dict->slot);
+  memset(dict, 0, sizeof(SEQ_DICT));
+}
@@ -0,0 +1,50 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_dict.h
+ * Description: String interning; each distinct string gets a dense code,
+ *  starting at 1 (0 is left for 'no value'). Strings are kept back to back in
+ *  one buffer with an end offset per code, which is also how the dictionaries
+ *  of the on-disk stores are laid out:
+ *    string c = buf[off[c - 1] .. off[c]), off[0] = 0
+ */
+
+#ifndef __seq_dict_h__
+#define __seq_dict_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct seq_dict
+{
+  char *buf;
+  uint32_t len;
+  uint32_t cap;
+  uint32_t *off;           // n + 1 entries
+  uint32_t n;
+  uint32_t off_cap;
+  uint32_t *slot;          // open addressing table of codes, 0 is empty
+  uint32_t n_slot;         // power of 2
+} SEQ_DICT;
+
+// returns the code of the string, adding it as needed; 0 when out of memory
+uint32_t seq_dict_intern( SEQ_DICT *dict, const char *s, size_t len );
+
+// returns the code of the string or 0 when it is not in the dictionary
+uint32_t seq_dict_find( const SEQ_DICT *dict, const char *s, size_t len );
+
+static inline const char *seq_dict_str( const SEQ_DICT *dict, uint32_t code, size_t *len )
+{
+  *len = dict->off[code] - dict->off[code - 1];
+  return dict->buf + dict->off[code - 1];
+}
+
+void seq_dict_free( SEQ_DICT *dict );
+
+#endif
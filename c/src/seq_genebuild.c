@@ -0,0 +1,620 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genebuild.c
+ * Description: Native gene track build; see seq_genebuild.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <zlib.h>
+#include "dbg.h"
+#include "seq_genebuild.h"
+#include "seq_genedb.h"
+#include "seq_csq.h"
+
+#define MAX_LINE (1 << 20)
+#define MAX_COLS 256
+#define SPLICE_SITE_LENGTH 6     // as in Seq::Gene
+
+// one row of the gene table; coordinates are absolute
+typedef struct gene_tx
+{
+  char *id;
+  char strand;
+  long coding_start;
+  long coding_end;
+  long *exon_start;
+  long *exon_end;
+  int n_exon;
+  char **alt;              // SEQ_GENE_BUILD.feature values
+} GENE_TX;
+
+typedef struct gene_list
+{
+  GENE_TX *tx;
+  long n;
+  long cap;
+} GENE_LIST;
+
+typedef struct build_pool
+{
+  const SEQ_GENE_BUILD *build;
+  GENE_LIST *chrom;        // per chromosome, in the order of the gene tables
+  int csq_fd[3];           // consequence track, or -1
+  int next;
+  int *status;
+} BUILD_POOL;
+
+void seq_revcomp( char *dst, const char *src, size_t n )
+{
+  // complement front to back with compares and xors only, no table lookup, so
+  //  that the loop vectorizes; A^T and C^G flip a base into its complement and
+  //  leave anything else alone
+  for(size_t i = 0; i < n; i++)
+  {
+    unsigned char c = (unsigned char)src[i];
+    unsigned char at = (unsigned char)(-((c == 'A') | (c == 'T'))) & ('A' ^ 'T');
+    unsigned char cg = (unsigned char)(-((c == 'C') | (c == 'G'))) & ('C' ^ 'G');
+    dst[i] = (char)(c ^ at ^ cg);
+  }
+
+  // then reverse in place, 8 bytes at a time from both ends
+  size_t i = 0, j = n;
+  while(j - i >= 16)
+  {
+    uint64_t a, b;
+    memcpy(&a, dst + i, 8);
+    memcpy(&b, dst + j - 8, 8);
+    a = __builtin_bswap64(a);
+    b = __builtin_bswap64(b);
+    memcpy(dst + i, &b, 8);
+    memcpy(dst + j - 8, &a, 8);
+    i += 8;
+    j -= 8;
+  }
+  while(j - i >= 2)
+  {
+    char t = dst[i];
+    dst[i++] = dst[--j];
+    dst[j] = t;
+  }
+}
+
+static int split_tabs( char *line, char **field, int max )
+{
+  int n = 0;
+  field[n++] = line;
+  for(char *p = line; *p; p++)
+  {
+    if(*p == '\t')
+    {
+      *p = '\0';
+      if(n == max)
+        return -1;
+      field[n++] = p + 1;
+    }
+  }
+  return n;
+}
+
+static int column( char **field, int n, const char *name )
+{
+  for(int i = 0; i < n; i++)
+    if(strcmp(field[i], name) == 0)
+      return i;
+  return -1;
+}
+
+static int parse_long( const char *s, long *v )
+{
+  char *end;
+  *v = strtol(s, &end, 10);
+  return end == s || *end != '\0';
+}
+
+// comma separated positions, e.g., exonStarts; a trailing comma is allowed
+static long *parse_list( const char *s, long offset, int *n )
+{
+  long *v = NULL;
+  int cap = 1;
+  for(const char *p = s; *p; p++)
+    cap += *p == ',';
+  v = (long *)malloc(sizeof(long) * cap);
+  check_mem(v);
+
+  *n = 0;
+  for(const char *p = s; *p; )
+  {
+    char *end;
+    long x = strtol(p, &end, 10);
+    check( (end != p && (*end == ',' || *end == '\0')), "Bad position list '%s'.", s );
+    v[(*n)++] = offset + x;
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return v;
+
+error:
+  free(v);
+  return NULL;
+}
+
+static void free_tx( GENE_TX *tx, int n_feature )
+{
+  free(tx->id);
+  free(tx->exon_start);
+  free(tx->exon_end);
+  if(tx->alt)
+    for(int k = 0; k < n_feature; k++)
+      free(tx->alt[k]);
+  free(tx->alt);
+}
+
+static int read_table( BUILD_POOL *pool, const char *in_file )
+{
+  const SEQ_GENE_BUILD *build = pool->build;
+  const SEQ_GENOME *genome = build->genome;
+  gzFile in = NULL;
+  char *line = NULL;
+  char *field[MAX_COLS];
+  int want[9 + SEQ_GENEBUILD_MAX_FEATURES];
+  int maxCol = 0;
+  long nLine = 0, nSkip = 0;
+  GENE_TX tx;
+  int status = 1;
+
+  memset(&tx, 0, sizeof(tx));
+  line = (char *)malloc(MAX_LINE);
+  check_mem(line);
+  check( ((in = gzopen(in_file, "r")) != NULL), "Cannot open '%s' for reading.", in_file );
+  gzbuffer(in, 1 << 20);
+
+  // header; the columns Seq::Build::GeneTrack checks for
+  check( (gzgets(in, line, MAX_LINE) != NULL), "'%s' is empty.", in_file );
+  line[strcspn(line, "\r\n")] = '\0';
+  int nHead = split_tabs(line, field, MAX_COLS);
+  check( (nHead > 0), "Too many columns in the header of '%s'.", in_file );
+  const char *required[9] = { "name", "chrom", "strand", "cdsStart", "cdsEnd", "exonStarts",
+    "exonEnds", "txStart", "txEnd" };
+  for(int i = 0; i < 9 + build->n_feature; i++)
+  {
+    const char *name = i < 9 ? required[i] : build->feature[i - 9];
+    want[i] = column(field, nHead, name);
+    check( (want[i] >= 0), "Missing expected header '%s' in '%s'.", name, in_file );
+    if(want[i] > maxCol)
+      maxCol = want[i];
+  }
+
+  const SEQ_CHROM *chrom = NULL;
+  while(gzgets(in, line, MAX_LINE))
+  {
+    size_t len = strlen(line);
+    check( (len < MAX_LINE - 1 || line[len - 1] == '\n'), "Line %ld of '%s' is too long.",
+        nLine + 2, in_file );
+    line[strcspn(line, "\r\n")] = '\0';
+    nLine++;
+
+    int n = split_tabs(line, field, MAX_COLS);
+    if(n <= maxCol)
+    {
+      nSkip++;
+      continue;
+    }
+    // unassigned and alternative chromosomes are skipped
+    if(!chrom || strcmp(chrom->name, field[want[1]]) != 0)
+      chrom = seq_genome_chrom(genome, field[want[1]]);
+    if(!chrom)
+      continue;
+
+    // the tables are zero-based and relative to the chromosome
+    int nEnds;
+    tx.strand = field[want[2]][0];
+    check( (parse_long(field[want[3]], &tx.coding_start) == 0
+          && parse_long(field[want[4]], &tx.coding_end) == 0),
+        "Bad coding range on line %ld of '%s'.", nLine + 1, in_file );
+    tx.coding_start += chrom->offset;
+    tx.coding_end += chrom->offset;
+    tx.exon_start = parse_list(field[want[5]], chrom->offset, &tx.n_exon);
+    tx.exon_end = parse_list(field[want[6]], chrom->offset, &nEnds);
+    check( (tx.exon_start && tx.exon_end && tx.n_exon == nEnds),
+        "Bad exons on line %ld of '%s'.", nLine + 1, in_file );
+    tx.id = strdup(field[want[0]]);
+    tx.alt = (char **)calloc(build->n_feature ? build->n_feature : 1, sizeof(char *));
+    check_mem(tx.id && tx.alt);
+    // empty values would fail the type constraint on alt_names, hence 'NA'
+    for(int k = 0; k < build->n_feature; k++)
+    {
+      const char *v = field[want[9 + k]];
+      tx.alt[k] = strdup(*v && strcmp(v, "0") != 0 ? v : "NA");
+      check_mem(tx.alt[k]);
+    }
+
+    GENE_LIST *list = &pool->chrom[chrom->index];
+    if(list->n == list->cap)
+    {
+      long cap = list->cap ? 2 * list->cap : 1024;
+      GENE_TX *grown = (GENE_TX *)realloc(list->tx, sizeof(GENE_TX) * cap);
+      check_mem(grown);
+      list->tx = grown;
+      list->cap = cap;
+    }
+    list->tx[list->n++] = tx;
+    memset(&tx, 0, sizeof(tx));
+  }
+  int gzErr;
+  gzerror(in, &gzErr);
+  check( (gzErr == Z_OK || gzErr == Z_STREAM_END), "Error reading '%s'.", in_file );
+
+  if(nSkip)
+    log_warn("Skipped %ld short lines in '%s'.", nSkip, in_file);
+  log_info("Read %ld transcripts from '%s'.", nLine, in_file);
+  status = 0;
+
+error:
+  free_tx(&tx, build->n_feature);
+  if(in)
+    gzclose(in);
+  free(line);
+  return status;
+}
+
+static int compare_u32( const void *a, const void *b )
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// the site ranges of one transcript, as Seq::Build::SparseTrack::_get_range_list
+//  gives them
+static int put_ranges( FILE *fh, uint32_t *pos, long n )
+{
+  int err = 0;
+  qsort(pos, n, sizeof(uint32_t), compare_u32);
+  for(long i = 0; i < n; )
+  {
+    long j = i;
+    while(j + 1 < n && pos[j + 1] <= pos[j] + 1)
+      j++;
+    err |= fprintf(fh, "%u\t%u\n", pos[i], pos[j]) < 0;
+    i = j + 1;
+  }
+  return err;
+}
+
+// errors the way Seq::Gene::_build_transcript_error finds them; the coding
+//  bases are seq[a, b)
+static int tx_errors( const char *seq, long a, long b, const char **error )
+{
+  int n = 0;
+  if((b - a) % 3 != 0)
+    error[n++] = "coding sequence not divisible by 3";
+  if(b - a < 3 || seq_codon_to_aa(seq + a) != 'M')
+    error[n++] = "transcript does not begin with ATG";
+  if(b - a < 3 || seq_codon_to_aa(seq + b - 3) != '*')
+    error[n++] = "transcript does not end with stop codon";
+  return n;
+}
+
+// the consequence bytes of one chromosome's sites, written into its part of
+//  the (genome-sized) consequence track
+static int write_csq( BUILD_POOL *pool, const char *gdb_file )
+{
+  const SEQ_GENE_BUILD *build = pool->build;
+  SEQ_GENEDB *db = NULL;
+  unsigned char *out[3] = { NULL, NULL, NULL };
+  int status = 1;
+
+  check( ((db = seq_genedb_open(gdb_file)) != NULL), "Cannot read back '%s'.", gdb_file );
+  const long n = db->header->n_site;
+  if(n == 0)
+  {
+    seq_genedb_close(db);
+    return 0;
+  }
+  const long base = db->pos[0];
+  const long len = (long)db->pos[n - 1] - base + 1;
+  check( (db->pos[n - 1] < (uint64_t)build->genome_str->length),
+      "Gene sites of '%s' run past the genome.", gdb_file );
+  for(int i = 0; i < 3; i++)
+  {
+    out[i] = (unsigned char *)calloc(len, 1);
+    check_mem(out[i]);
+  }
+  seq_csq_fill(db, (const char *)build->genome_str->data, base, len, out);
+  for(int i = 0; i < 3; i++)
+  {
+    // chromosomes do not overlap, so the workers never write the same bytes
+    for(long off = 0; off < len; )
+    {
+      ssize_t w = pwrite(pool->csq_fd[i], out[i] + off, len - off, base + off);
+      check( (w > 0), "Cannot write the consequence track." );
+      off += w;
+    }
+  }
+  status = 0;
+
+error:
+  for(int i = 0; i < 3; i++)
+    free(out[i]);
+  seq_genedb_close(db);
+  return status;
+}
+
+static int build_chrom( BUILD_POOL *pool, int c )
+{
+  const SEQ_GENE_BUILD *build = pool->build;
+  const SEQ_CHROM *chrom = &build->genome->chrom[c];
+  const GENE_LIST *list = &pool->chrom[c];
+  const char *genome = (const char *)build->genome_str->data;
+  const long genomeLen = build->genome_str->length;
+  SEQ_GENEDB_WRITER *w = NULL;
+  FILE *ganFh = NULL, *exFh = NULL;
+  char *fwd = NULL, *seq = NULL;
+  uint32_t *fl = NULL, *ex = NULL;
+  long seqCap = 0, flCap = 0;
+  const char *alt[2 * SEQ_GENEBUILD_MAX_FEATURES];
+  const char *error[3];
+  char path[4200];
+  long nError = 0;
+  int err = 0;
+  int status = 1;
+
+  w = seq_genedb_writer_new();
+  check( (w != NULL), "Cannot create gene site store writer." );
+  snprintf(path, sizeof(path), "%s/%s.gene.%s.gan.dat", build->out_dir, build->name,
+      chrom->name);
+  check( ((ganFh = fopen(path, "w")) != NULL), "Cannot open '%s' for writing.", path );
+  snprintf(path, sizeof(path), "%s/%s.gene.%s.exon.dat", build->out_dir, build->name,
+      chrom->name);
+  check( ((exFh = fopen(path, "w")) != NULL), "Cannot open '%s' for writing.", path );
+
+  // the first line is the value genome_hasher adds for the listed sites
+  err |= fprintf(ganFh, "%d\n", build->in_gan) < 0;
+  err |= fprintf(exFh, "%d\n", build->in_exon) < 0;
+
+  for(long t = 0; t < list->n; t++)
+  {
+    const GENE_TX *tx = &list->tx[t];
+    const int minus = tx->strand == '-';
+    long len = 0, n5 = 0, nCds = 0;
+
+    for(int i = 0; i < tx->n_exon; i++)
+    {
+      check( (tx->exon_start[i] < tx->exon_end[i]),
+          "%s: exon start (%ld) >= exon end (%ld)", tx->id, tx->exon_start[i],
+          tx->exon_end[i] );
+      check( (tx->exon_start[i] >= chrom->offset && tx->exon_end[i] <= genomeLen),
+          "%s: exon %d is off the end of %s.", tx->id, i, chrom->name );
+      len += tx->exon_end[i] - tx->exon_start[i];
+    }
+    if(len > seqCap)
+    {
+      seqCap = len + len / 2;
+      free(fwd);
+      free(seq);
+      fwd = (char *)malloc(seqCap);
+      seq = (char *)malloc(seqCap);
+      ex = (uint32_t *)realloc(ex, sizeof(uint32_t) * seqCap);
+      check_mem(fwd && seq && ex);
+    }
+
+    // exons in genome order; the bases before the coding start and end tell
+    //  where the coding bases are in the transcript
+    long off = 0;
+    for(int i = 0; i < tx->n_exon; i++)
+    {
+      long s = tx->exon_start[i], e = tx->exon_end[i];
+      memcpy(fwd + off, genome + s, e - s);
+      for(long p = s; p < e; p++)
+        ex[off++] = (uint32_t)p;
+      n5 += (tx->coding_start < s ? s : tx->coding_start < e ? tx->coding_start : e) - s;
+      nCds += (tx->coding_end < s ? s : tx->coding_end < e ? tx->coding_end : e) - s;
+    }
+    long a = n5, b = nCds;
+    if(minus)
+    {
+      seq_revcomp(seq, fwd, len);
+      a = len - nCds;
+      b = len - n5;
+    }
+    else
+      memcpy(seq, fwd, len);
+
+    const int coding = tx->coding_start != tx->coding_end;
+    int nErr = coding ? tx_errors(seq, a, b, error) : 0;
+    if(nErr)
+      nError++;
+    for(int k = 0; k < build->n_feature; k++)
+    {
+      alt[2 * k] = build->feature[k];
+      alt[2 * k + 1] = tx->alt[k];
+    }
+    long ord = seq_genedb_writer_add_tx(w, tx->id, tx->strand, seq, (uint32_t)len,
+        coding && a < b ? (int32_t)a : -1, alt, build->n_feature, error, nErr);
+    check( (ord >= 0), "Cannot add transcript %s.", tx->id );
+
+    // splice sites within 6 bp of an exon's ends, if they are within the
+    //  coding range (see Seq::Gene::_build_flanking_sites)
+    long nFl = 0;
+    if(flCap < 2L * SPLICE_SITE_LENGTH * tx->n_exon)
+    {
+      flCap = 2L * SPLICE_SITE_LENGTH * tx->n_exon;
+      fl = (uint32_t *)realloc(fl, sizeof(uint32_t) * flCap);
+      check_mem(fl);
+    }
+    for(int i = 0; i < tx->n_exon; i++)
+    {
+      for(long n = 1; n <= SPLICE_SITE_LENGTH; n++)
+      {
+        long p = tx->exon_start[i] - n;
+        if(p > tx->coding_start && p < tx->coding_end)
+        {
+          err |= seq_genedb_writer_add_site(w, p, ord, 0,
+              minus ? SEQ_GENE_SPLICE_DONOR : SEQ_GENE_SPLICE_ACCEPTOR,
+              p < genomeLen ? genome[p] : 'N');
+          fl[nFl++] = (uint32_t)p;
+        }
+        p = tx->exon_end[i] + n - 1;
+        if(p > tx->coding_start && p < tx->coding_end)
+        {
+          err |= seq_genedb_writer_add_site(w, p, ord, 0,
+              minus ? SEQ_GENE_SPLICE_ACCEPTOR : SEQ_GENE_SPLICE_DONOR,
+              p < genomeLen ? genome[p] : 'N');
+          fl[nFl++] = (uint32_t)p;
+        }
+      }
+    }
+
+    // transcript sites, 5' to 3'
+    for(long i = 0; i < len; i++)
+    {
+      int type = !coding ? SEQ_GENE_NCRNA : i < a ? SEQ_GENE_UTR5 : i < b ? SEQ_GENE_CODING
+        : SEQ_GENE_UTR3;
+      err |= seq_genedb_writer_add_site(w, ex[minus ? len - 1 - i : i], ord, (uint32_t)i,
+          type, seq[i]);
+    }
+    check( (err == 0), "Cannot add the sites of %s.", tx->id );
+
+    // flanking sites go only to the gan file, transcript sites to both
+    err |= put_ranges(ganFh, fl, nFl);
+    err |= put_ranges(exFh, ex, len);
+    err |= put_ranges(ganFh, ex, len);
+  }
+
+  // a final blank line, so genome_hasher has something past the header
+  err |= fputc('\n', exFh) == EOF;
+  err |= fputc('\n', ganFh) == EOF;
+  err |= fclose(exFh) != 0;
+  err |= fclose(ganFh) != 0;
+  exFh = ganFh = NULL;
+  check( (err == 0), "Cannot write the site ranges of %s.", chrom->name );
+
+  snprintf(path, sizeof(path), "%s/%s.gene.%s.gdb", build->out_dir, build->name, chrom->name);
+  check( (seq_genedb_writer_write(w, path) == 0), "Cannot write gene site store." );
+  if(build->csq)
+    check( (write_csq(pool, path) == 0), "Cannot build the consequences of %s.", chrom->name );
+  if(nError)
+    log_warn("%s: %ld transcripts have errors.", chrom->name, nError);
+  log_info("%s: wrote %ld transcripts, %ld gene sites.", chrom->name, w->n_tx, w->n);
+  status = 0;
+
+error:
+  if(ganFh)
+    fclose(ganFh);
+  if(exFh)
+    fclose(exFh);
+  free(fwd);
+  free(seq);
+  free(fl);
+  free(ex);
+  seq_genedb_writer_free(w);
+  return status;
+}
+
+static void *chrom_worker( void *arg )
+{
+  BUILD_POOL *pool = (BUILD_POOL *)arg;
+  for(;;)
+  {
+    int i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    if(i >= pool->build->genome->n_chrom)
+      break;
+    pool->status[i] = build_chrom(pool, i);
+  }
+  return NULL;
+}
+
+static int run_pool( BUILD_POOL *pool )
+{
+  pthread_t tid[256];
+  int nThreads = 0;
+  int status = 0;
+  const int nJob = pool->build->genome->n_chrom;
+
+  pool->next = 0;
+  for(int i = 0; i < nJob; i++)
+    pool->status[i] = 1;
+  while(nThreads < pool->build->threads && nThreads < nJob)
+  {
+    if(pthread_create(&tid[nThreads], NULL, chrom_worker, pool) != 0)
+      break;
+    nThreads++;
+  }
+  // with no thread at all, do the work here
+  if(nThreads == 0)
+    chrom_worker(pool);
+  for(int i = 0; i < nThreads; i++)
+    pthread_join(tid[i], NULL);
+  for(int i = 0; i < nJob; i++)
+    status |= pool->status[i];
+  return status;
+}
+
+int seq_gene_build( const SEQ_GENE_BUILD *build, const char **in_file, int n_in )
+{
+  const SEQ_GENOME *genome = build->genome;
+  BUILD_POOL pool;
+  int status = 1;
+
+  memset(&pool, 0, sizeof(pool));
+  pool.csq_fd[0] = pool.csq_fd[1] = pool.csq_fd[2] = -1;
+  check( (build->threads >= 1 && build->threads <= 256), "Impossible number of threads %d.",
+      build->threads );
+  check( (build->n_feature <= SEQ_GENEBUILD_MAX_FEATURES), "Too many gene features." );
+  check( (genome->n_chrom > 0), "No chromosomes." );
+
+  pool.build = build;
+  pool.chrom = (GENE_LIST *)calloc(genome->n_chrom, sizeof(GENE_LIST));
+  pool.status = (int *)calloc(genome->n_chrom, sizeof(int));
+  check_mem(pool.chrom && pool.status);
+
+  if(build->csq)
+  {
+    // zero for every position no transcript covers; the file system fills
+    //  them in for free
+    for(int i = 0; i < 3; i++)
+    {
+      char path[4200];
+      snprintf(path, sizeof(path), "%s/%s.csq.idx.%d", build->out_dir, build->name, i);
+      pool.csq_fd[i] = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      check( (pool.csq_fd[i] >= 0), "Cannot open '%s' for writing.", path );
+      check( (ftruncate(pool.csq_fd[i], build->genome_str->length) == 0),
+          "Cannot size '%s'.", path );
+    }
+  }
+
+  // the tables are small next to the genome; they are read in one go and
+  //  the chromosomes built in parallel
+  for(int f = 0; f < n_in; f++)
+    check( (read_table(&pool, in_file[f]) == 0), "Cannot read the gene files." );
+  check( (run_pool(&pool) == 0), "Cannot build the gene site stores." );
+  status = 0;
+
+error:
+  for(int i = 0; i < 3; i++)
+    if(pool.csq_fd[i] >= 0 && close(pool.csq_fd[i]) != 0)
+      status = 1;
+  if(pool.chrom)
+  {
+    for(int c = 0; c < genome->n_chrom; c++)
+    {
+      for(long t = 0; t < pool.chrom[c].n; t++)
+        free_tx(&pool.chrom[c].tx[t], build->n_feature);
+      free(pool.chrom[c].tx);
+    }
+    free(pool.chrom);
+  }
+  free(pool.status);
+  return status;
+}
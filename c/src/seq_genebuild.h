@@ -0,0 +1,56 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genebuild.h
+ * Description: Native build of a gene track from UCSC gene tables (knownGene,
+ *  refGene, ...); does what Seq::Build::GeneTrack::build_gene_db_for_chr
+ *  does with Seq::Gene, for every chromosome at once.
+ *
+ *  The tables are read once and split by chromosome; the chromosomes are then
+ *  built concurrently. Each transcript's exons are copied straight out of the
+ *  string genome, reverse complemented for the minus strand, checked for a
+ *  start and stop codon and added, with its splice and transcript sites, to
+ *    <out_dir>/<name>.gene.<chr>.gdb        gene site store (seq_genedb.h)
+ *    <out_dir>/<name>.gene.<chr>.gan.dat    site ranges of all gene sites
+ *    <out_dir>/<name>.gene.<chr>.exon.dat   site ranges of transcript sites
+ *  and, when asked for, the consequence track of every substitution at those
+ *  sites (see seq_csq.h)
+ *    <out_dir>/<name>.csq.idx.0 .. 2
+ */
+
+#ifndef __seq_genebuild_h__
+#define __seq_genebuild_h__
+
+#include <stddef.h>
+#include "seq_genome.h"
+#include "seq_track.h"
+
+#define SEQ_GENEBUILD_MAX_FEATURES 64
+
+typedef struct seq_gene_build
+{
+  const SEQ_GENOME *genome;      // chromosome offsets
+  const SEQ_TRACK *genome_str;   // string genome (.str.dat), one base per byte
+  const char *name;              // track name
+  const char *out_dir;
+  const char **feature;          // alt name columns, e.g., geneSymbol
+  int n_feature;
+  int in_gan;                    // values written at the top of the site ranges
+  int in_exon;
+  int csq;                       // also write the consequence track
+  int threads;
+} SEQ_GENE_BUILD;
+
+int seq_gene_build( const SEQ_GENE_BUILD *build, const char **in_file, int n_in );
+
+// reverse complement of src (n bases) into dst, which must not overlap it;
+//  only ACGT are complemented, as Seq::Gene does
+void seq_revcomp( char *dst, const char *src, size_t n );
+
+#endif
@@ -0,0 +1,443 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genedb.c
+ * Description: Gene site store; see seq_genedb.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_genedb.h"
+#include "seq_generange.h"
+
+#define ALIGN8(x) (((x) + 7) & ~(uint64_t)7)
+
+const char *seq_gene_site_type[SEQ_GENE_N_SITE_TYPE] = {
+  "Coding", "5UTR", "3UTR", "Splice Acceptor", "Splice Donor", "non-coding RNA",
+};
+
+int seq_gene_site_type_code( const char *name )
+{
+  for(int i = 0; i < SEQ_GENE_N_SITE_TYPE; i++)
+  {
+    if(strcmp(name, seq_gene_site_type[i]) == 0)
+      return i;
+  }
+  return -1;
+}
+
+static int in_file( const SEQ_GENEDB *db, uint64_t off, uint64_t len )
+{
+  return off <= db->size && len <= db->size - off;
+}
+
+SEQ_GENEDB *seq_genedb_open( const char *path )
+{
+  SEQ_GENEDB *db = NULL;
+  struct stat st;
+  void *map = MAP_FAILED;
+
+  check( strlen(path) < sizeof(db->path), "Path too long '%s'.", path );
+  db = (SEQ_GENEDB *)calloc(1, sizeof(SEQ_GENEDB));
+  check_mem(db);
+  db->fd = -1;
+  strcpy(db->path, path);
+
+  check( ((db->fd = open(path, O_RDONLY)) != -1), "Cannot open gene store '%s'.", path );
+  check( (fstat(db->fd, &st) == 0), "Cannot stat gene store '%s'.", path );
+  check( ((size_t)st.st_size >= sizeof(SEQ_GENEDB_HEADER)), "Gene store '%s' is truncated.",
+      path );
+
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, db->fd, 0);
+  check( (map != MAP_FAILED), "Cannot map gene store '%s'.", path );
+  madvise(map, (size_t)st.st_size, MADV_RANDOM);
+  db->data = (const char *)map;
+  db->size = (size_t)st.st_size;
+
+  const SEQ_GENEDB_HEADER *h = db->header = (const SEQ_GENEDB_HEADER *)db->data;
+  check( (memcmp(h->magic, SEQ_GENEDB_MAGIC, sizeof(SEQ_GENEDB_MAGIC)) == 0),
+      "'%s' is not a gene store.", path );
+  check( (h->fence_step > 0 && h->n_fence == (h->n_site + h->fence_step - 1) / h->fence_step),
+      "Corrupt gene store header in '%s'.", path );
+  check( (in_file(db, h->pos_off, sizeof(uint32_t) * (uint64_t)h->n_site)
+        && in_file(db, h->fence_off, sizeof(uint32_t) * (uint64_t)h->n_fence)
+        && in_file(db, h->site_off, sizeof(SEQ_GENEDB_SITE) * (uint64_t)h->n_site)
+        && in_file(db, h->tx_off, sizeof(SEQ_GENEDB_TX) * (uint64_t)h->n_tx)
+        && in_file(db, h->attr_off, sizeof(uint32_t) * (uint64_t)h->n_attr)
+        && in_file(db, h->seq_off, h->seq_len)
+        && in_file(db, h->dict_off, sizeof(uint32_t) * ((uint64_t)h->n_dict + 1))),
+      "Gene store '%s' is truncated.", path );
+
+  db->pos      = (const uint32_t *)(db->data + h->pos_off);
+  db->fence    = (const uint32_t *)(db->data + h->fence_off);
+  db->site     = (const SEQ_GENEDB_SITE *)(db->data + h->site_off);
+  db->tx       = (const SEQ_GENEDB_TX *)(db->data + h->tx_off);
+  db->attr     = (const uint32_t *)(db->data + h->attr_off);
+  db->seq      = db->data + h->seq_off;
+  db->dict_off = (const uint32_t *)(db->data + h->dict_off);
+  db->dict_str = (const char *)(db->dict_off + h->n_dict + 1);
+  check( (db->dict_off[0] == 0
+        && in_file(db, h->dict_off + sizeof(uint32_t) * ((uint64_t)h->n_dict + 1),
+          db->dict_off[h->n_dict])),
+      "Gene store '%s' is truncated.", path );
+
+  // every reference the reader follows without checking
+  for(uint32_t t = 0; t < h->n_tx; t++)
+  {
+    const SEQ_GENEDB_TX *tx = &db->tx[t];
+    check( (tx->seq_off <= h->seq_len && tx->seq_len <= h->seq_len - tx->seq_off
+          && tx->id >= 1 && tx->id <= h->n_dict
+          && (uint64_t)tx->attr_off + 2 * tx->n_alt + tx->n_error <= h->n_attr),
+        "Corrupt transcript %u in gene store '%s'.", t, path );
+  }
+  for(uint32_t a = 0; a < h->n_attr; a++)
+    check( (db->attr[a] <= h->n_dict), "Corrupt gene store '%s'.", path );
+  for(uint32_t i = 0; i < h->n_site; i++)
+  {
+    const SEQ_GENEDB_SITE *site = &db->site[i];
+    check( (site->tx < h->n_tx && site->type < SEQ_GENE_N_SITE_TYPE
+          && (site->offset < db->tx[site->tx].seq_len || site->offset == 0)),
+        "Corrupt site %u in gene store '%s'.", i, path );
+  }
+  return db;
+
+error:
+  seq_genedb_close(db);
+  return NULL;
+}
+
+void seq_genedb_close( SEQ_GENEDB *db )
+{
+  if(!db)
+    return;
+  seq_generange_free(db->range);
+  if(db->data)
+    munmap((void *)db->data, db->size);
+  if(db->fd != -1)
+    close(db->fd);
+  free(db);
+}
+
+long seq_genedb_find( const SEQ_GENEDB *db, long abs_pos, long *first )
+{
+  const long n = db->header->n_site;
+  const long step = db->header->fence_step;
+  const long nFence = db->header->n_fence;
+
+  *first = 0;
+  if(abs_pos < 0 || abs_pos > (long)UINT32_MAX || n == 0)
+    return 0;
+  const uint32_t key = (uint32_t)abs_pos;
+
+  // first fence >= key, then the first site >= key between two fences
+  long lo = 0, hi = nFence;
+  while(lo < hi)
+  {
+    long mid = (lo + hi) >> 1;
+    if(db->fence[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  long rlo = lo ? (lo - 1) * step + 1 : 0;
+  long rhi = lo < nFence ? lo * step : n;
+  while(rlo < rhi)
+  {
+    long mid = (rlo + rhi) >> 1;
+    if(db->pos[mid] < key)
+      rlo = mid + 1;
+    else
+      rhi = mid;
+  }
+
+  long count = 0;
+  while(rlo + count < n && db->pos[rlo + count] == key)
+    count++;
+  *first = rlo;
+  return count;
+}
+
+int seq_genedb_codon( const SEQ_GENEDB *db, long row, char codon[4], long *codon_number,
+    int *codon_position )
+{
+  const SEQ_GENEDB_SITE *site = &db->site[row];
+  const SEQ_GENEDB_TX *tx = &db->tx[site->tx];
+
+  codon[0] = '\0';
+  if(site->type != SEQ_GENE_CODING || tx->cds_start < 0
+      || site->offset < (uint32_t)tx->cds_start)
+    return 0;
+
+  // coding bases are contiguous in the transcript, so the count of coding
+  // bases before the site is its distance from the start of the cds
+  uint32_t coding = site->offset - (uint32_t)tx->cds_start;
+  *codon_number = 1 + coding / 3;
+  *codon_position = (int)(coding % 3);
+
+  // a codon running off the end of a truncated transcript is short
+  uint32_t start = site->offset - (uint32_t)*codon_position;
+  int len = 0;
+  for(uint32_t j = start; j < start + 3 && j < tx->seq_len; j++)
+    codon[len++] = db->seq[tx->seq_off + j];
+  codon[len] = '\0';
+  return 1;
+}
+
+SEQ_GENEDB_WRITER *seq_genedb_writer_new( void )
+{
+  SEQ_GENEDB_WRITER *w = (SEQ_GENEDB_WRITER *)calloc(1, sizeof(SEQ_GENEDB_WRITER));
+  check_mem(w);
+  return w;
+
+error:
+  return NULL;
+}
+
+void seq_genedb_writer_free( SEQ_GENEDB_WRITER *w )
+{
+  if(!w)
+    return;
+  seq_dict_free(&w->dict);
+  free(w->pos);
+  free(w->site);
+  free(w->tx);
+  free(w->attr);
+  free(w->seq);
+  free(w);
+}
+
+// grows *buf to hold at least need elements of size bytes
+static int grow( void **buf, long *cap, long need, size_t size, long first )
+{
+  if(need <= *cap)
+    return 0;
+  long c = *cap ? *cap : first;
+  while(c < need)
+    c *= 2;
+  void *p = realloc(*buf, size * (size_t)c);
+  if(!p)
+    return 1;
+  *buf = p;
+  *cap = c;
+  return 0;
+}
+
+static int add_attr( SEQ_GENEDB_WRITER *w, const char *s )
+{
+  uint32_t code = 0;
+  if(s)
+  {
+    code = seq_dict_intern(&w->dict, s, strlen(s));
+    check( (code != 0), "Cannot intern '%s'.", s );
+  }
+  check_mem( (grow((void **)&w->attr, &w->attr_cap, w->n_attr + 1, sizeof(uint32_t), 1024) == 0) );
+  w->attr[w->n_attr++] = code;
+  return 0;
+
+error:
+  return 1;
+}
+
+long seq_genedb_writer_add_tx( SEQ_GENEDB_WRITER *w, const char *id, char strand,
+    const char *seq, uint32_t seq_len, int32_t cds_start, const char **alt, int n_alt,
+    const char **error, int n_error )
+{
+  check( (w->n_tx < (long)UINT32_MAX), "Too many transcripts for one gene store." );
+  check( (n_alt >= 0 && n_alt <= 0xffff && n_error >= 0 && n_error <= 0xffff),
+      "Too many alt names or errors for transcript '%s'.", id );
+  check( (cds_start < 0 || (uint32_t)cds_start < seq_len),
+      "Coding start %d is past the end of transcript '%s'.", cds_start, id );
+  check_mem( (grow((void **)&w->tx, &w->tx_cap, w->n_tx + 1, sizeof(SEQ_GENEDB_TX), 1024) == 0) );
+
+  if(w->seq_len + seq_len + 1 > w->seq_cap)
+  {
+    uint64_t cap = w->seq_cap ? w->seq_cap : 1 << 20;
+    while(w->seq_len + seq_len + 1 > cap)
+      cap *= 2;
+    char *s = (char *)realloc(w->seq, cap);
+    check_mem(s);
+    w->seq = s;
+    w->seq_cap = cap;
+  }
+
+  SEQ_GENEDB_TX *tx = &w->tx[w->n_tx];
+  memset(tx, 0, sizeof(SEQ_GENEDB_TX));
+  tx->seq_off = w->seq_len;
+  tx->seq_len = seq_len;
+  tx->cds_start = cds_start < 0 ? -1 : cds_start;
+  tx->id = seq_dict_intern(&w->dict, id, strlen(id));
+  check( (tx->id != 0), "Cannot intern transcript id '%s'.", id );
+  tx->attr_off = (uint32_t)w->n_attr;
+  tx->n_alt = (uint16_t)n_alt;
+  tx->n_error = (uint16_t)n_error;
+  tx->strand = strand;
+  for(int i = 0; i < 2 * n_alt; i++)
+    check( (add_attr(w, alt[i]) == 0), "Cannot add alt names of '%s'.", id );
+  for(int i = 0; i < n_error; i++)
+    check( (add_attr(w, error[i]) == 0), "Cannot add errors of '%s'.", id );
+
+  memcpy(w->seq + w->seq_len, seq, seq_len);
+  w->seq_len += seq_len;
+  return w->n_tx++;
+
+error:
+  return -1;
+}
+
+int seq_genedb_writer_add_site( SEQ_GENEDB_WRITER *w, long abs_pos, long tx, uint32_t offset,
+    int type, char ref )
+{
+  check( (abs_pos >= 0 && abs_pos <= (long)UINT32_MAX),
+      "Position %ld does not fit the gene store.", abs_pos );
+  check( (tx >= 0 && tx < w->n_tx), "Unknown transcript %ld.", tx );
+  check( (type >= 0 && type < SEQ_GENE_N_SITE_TYPE), "Unknown site type %d.", type );
+  check( (offset < w->tx[tx].seq_len || offset == 0),
+      "Offset %u is past the end of transcript %ld.", offset, tx );
+  check( (w->n < (long)UINT32_MAX), "Too many sites for one gene store." );
+
+  if(w->n == w->cap)
+  {
+    long cap = w->cap ? 2 * w->cap : 65536;
+    uint32_t *pos = (uint32_t *)realloc(w->pos, sizeof(uint32_t) * cap);
+    check_mem(pos);
+    w->pos = pos;
+    SEQ_GENEDB_SITE *sites = (SEQ_GENEDB_SITE *)realloc(w->site, sizeof(SEQ_GENEDB_SITE) * cap);
+    check_mem(sites);
+    w->site = sites;
+    w->cap = cap;
+  }
+
+  SEQ_GENEDB_SITE *site = &w->site[w->n];
+  memset(site, 0, sizeof(SEQ_GENEDB_SITE));
+  site->tx = (uint32_t)tx;
+  site->offset = offset;
+  site->type = (uint8_t)type;
+  site->ref = ref;
+  w->pos[w->n] = (uint32_t)abs_pos;
+  w->n++;
+  return 0;
+
+error:
+  return 1;
+}
+
+static int compare_key( const void *a, const void *b )
+{
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int write_at( FILE *fh, uint64_t *at, const void *data, uint64_t len )
+{
+  static const char zero[8] = { 0 };
+  if(len && fwrite(data, 1, len, fh) != len)
+    return 1;
+  *at += len;
+  uint64_t pad = ALIGN8(*at) - *at;
+  if(pad && fwrite(zero, 1, pad, fh) != pad)
+    return 1;
+  *at += pad;
+  return 0;
+}
+
+int seq_genedb_writer_write( SEQ_GENEDB_WRITER *w, const char *path )
+{
+  FILE *fh = NULL;
+  uint64_t *key = NULL;
+  void *buf = NULL;
+  SEQ_GENEDB_HEADER h;
+  const long n = w->n;
+  const SEQ_DICT *dict = &w->dict;
+
+  // stable sort: position, then the order sites were added
+  key = (uint64_t *)malloc(sizeof(uint64_t) * (n ? n : 1));
+  check_mem(key);
+  for(long i = 0; i < n; i++)
+    key[i] = ((uint64_t)w->pos[i] << 32) | (uint64_t)i;
+  qsort(key, n, sizeof(uint64_t), compare_key);
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, SEQ_GENEDB_MAGIC, sizeof(SEQ_GENEDB_MAGIC));
+  h.n_site = (uint32_t)n;
+  h.n_tx = (uint32_t)w->n_tx;
+  h.fence_step = SEQ_GENEDB_FENCE;
+  h.n_fence = (uint32_t)((n + SEQ_GENEDB_FENCE - 1) / SEQ_GENEDB_FENCE);
+  h.n_attr = (uint32_t)w->n_attr;
+  h.n_dict = dict->n;
+  h.seq_len = w->seq_len;
+
+  uint64_t at = ALIGN8(sizeof(h));
+  h.pos_off = at;
+  at += ALIGN8(sizeof(uint32_t) * (uint64_t)n);
+  h.fence_off = at;
+  at += ALIGN8(sizeof(uint32_t) * (uint64_t)h.n_fence);
+  h.site_off = at;
+  at += ALIGN8(sizeof(SEQ_GENEDB_SITE) * (uint64_t)n);
+  h.tx_off = at;
+  at += ALIGN8(sizeof(SEQ_GENEDB_TX) * (uint64_t)w->n_tx);
+  h.attr_off = at;
+  at += ALIGN8(sizeof(uint32_t) * (uint64_t)w->n_attr);
+  h.seq_off = at;
+  at += ALIGN8(w->seq_len);
+  h.dict_off = at;
+
+  buf = malloc(sizeof(SEQ_GENEDB_SITE) * (n ? n : 1));
+  check_mem(buf);
+  check( ((fh = fopen(path, "wb")) != NULL), "Cannot open '%s' for writing.", path );
+
+  at = 0;
+  check( (write_at(fh, &at, &h, sizeof(h)) == 0), "Cannot write '%s'.", path );
+
+  uint32_t *u32 = (uint32_t *)buf;
+  for(long i = 0; i < n; i++)
+    u32[i] = w->pos[key[i] & 0xffffffff];
+  check( (write_at(fh, &at, u32, sizeof(uint32_t) * n) == 0), "Cannot write '%s'.", path );
+  for(long i = 0; i < (long)h.n_fence; i++)
+    u32[i] = u32[i * SEQ_GENEDB_FENCE];
+  check( (write_at(fh, &at, u32, sizeof(uint32_t) * h.n_fence) == 0), "Cannot write '%s'.",
+      path );
+
+  SEQ_GENEDB_SITE *site = (SEQ_GENEDB_SITE *)buf;
+  for(long i = 0; i < n; i++)
+    site[i] = w->site[key[i] & 0xffffffff];
+  check( (write_at(fh, &at, site, sizeof(SEQ_GENEDB_SITE) * n) == 0
+        && write_at(fh, &at, w->tx, sizeof(SEQ_GENEDB_TX) * w->n_tx) == 0
+        && write_at(fh, &at, w->attr, sizeof(uint32_t) * w->n_attr) == 0
+        && write_at(fh, &at, w->seq, w->seq_len) == 0),
+      "Cannot write '%s'.", path );
+
+  uint32_t zero = 0;
+  const uint32_t *off = dict->n ? dict->off : &zero;
+  check( (fwrite(off, sizeof(uint32_t), dict->n + 1, fh) == dict->n + 1), "Cannot write '%s'.",
+      path );
+  at += sizeof(uint32_t) * ((uint64_t)dict->n + 1);
+  check( (write_at(fh, &at, dict->buf, dict->len) == 0), "Cannot write '%s'.", path );
+
+  check( (fclose(fh) == 0), "Cannot close '%s'.", path );
+  fh = NULL;
+  free(key);
+  free(buf);
+  return 0;
+
+error:
+  if(fh)
+    fclose(fh);
+  free(key);
+  free(buf);
+  return 1;
+}
@@ -0,0 +1,187 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genedb.h
+ * Description: Immutable, position-sorted store of gene sites; the
+ *  replacement for the per-chromosome gene kch files. Rather than a full
+ *  Seq::Site::Gene record per site, each site is a small entry that points at
+ *  its transcript; the codon, residue and codon number are worked out from
+ *  the transcript sequence when the site is read.
+ *
+ *    header
+ *    pos       uint32[n_site]  abs_pos, sorted ascending
+ *    fence     uint32[n_fence] pos[i * fence_step], searched before pos
+ *    site      SEQ_GENEDB_SITE[n_site]
+ *    tx        SEQ_GENEDB_TX[n_tx]
+ *    attr      uint32[n_attr]  dictionary codes: (key, value) pairs of the
+ *                              alt names, then the error strings, per tx
+ *    seq       char[seq_len]   transcript sequences, 5' to 3'
+ *    dict      uint32 off[n + 1] followed by the strings (see seq_dict.h)
+ *
+ *  Every section starts on an 8 byte boundary; integers are host order.
+ */
+
+#ifndef __seq_genedb_h__
+#define __seq_genedb_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seq_dict.h"
+
+#define SEQ_GENEDB_MAGIC "SEQGEN1"
+#define SEQ_GENEDB_FENCE 64
+
+// site types; the order of Seq::Site::Gene::Definition's GeneSiteType
+enum
+{
+  SEQ_GENE_CODING = 0,
+  SEQ_GENE_UTR5,
+  SEQ_GENE_UTR3,
+  SEQ_GENE_SPLICE_ACCEPTOR,
+  SEQ_GENE_SPLICE_DONOR,
+  SEQ_GENE_NCRNA,
+  SEQ_GENE_N_SITE_TYPE
+};
+
+extern const char *seq_gene_site_type[SEQ_GENE_N_SITE_TYPE];
+
+// returns the site type code of the name, or -1
+int seq_gene_site_type_code( const char *name );
+
+// standard genetic code; codons are indexed 16 * b0 + 4 * b1 + b2, ACGT = 0123
+static inline char seq_codon_to_aa( const char *codon )
+{
+  static const char aa[] = "KNKNTTTTRSRSIIMIQHQHPPPPRRRRLLLLEDEDAAAAGGGGVVVV*Y*YSSSS*CWCLFLF";
+  int idx = 0;
+  for(int i = 0; i < 3; i++)
+  {
+    switch(codon[i])
+    {
+      case 'A': idx = 4 * idx;     break;
+      case 'C': idx = 4 * idx + 1; break;
+      case 'G': idx = 4 * idx + 2; break;
+      case 'T': idx = 4 * idx + 3; break;
+      default: return '\0';
+    }
+  }
+  return aa[idx];
+}
+
+typedef struct seq_genedb_site
+{
+  uint32_t tx;             // ordinal of the transcript
+  uint32_t offset;         // offset into the transcript sequence; 0 for splice sites
+  uint8_t type;            // SEQ_GENE_*
+  char ref;                // reference base, as Seq::Site::Gene has it
+  uint8_t reserved[2];
+} SEQ_GENEDB_SITE;
+
+typedef struct seq_genedb_tx
+{
+  uint64_t seq_off;        // from the start of the seq section
+  uint32_t seq_len;
+  int32_t cds_start;       // offset of the first coding base, -1 for non-coding
+  uint32_t id;             // dictionary code of the transcript id
+  uint32_t attr_off;       // index into attr
+  uint16_t n_alt;          // alt name pairs at attr_off
+  uint16_t n_error;        // error strings after them
+  char strand;
+  char reserved[3];
+} SEQ_GENEDB_TX;
+
+typedef struct seq_genedb_header
+{
+  char magic[8];
+  uint32_t n_site;
+  uint32_t n_tx;
+  uint32_t fence_step;
+  uint32_t n_fence;
+  uint32_t n_attr;
+  uint32_t n_dict;
+  uint64_t seq_len;
+  uint64_t pos_off;
+  uint64_t fence_off;
+  uint64_t site_off;
+  uint64_t tx_off;
+  uint64_t attr_off;
+  uint64_t seq_off;
+  uint64_t dict_off;
+} SEQ_GENEDB_HEADER;
+
+// reader
+typedef struct seq_genedb
+{
+  char path[4096];
+  int fd;
+  const char *data;
+  size_t size;
+  const SEQ_GENEDB_HEADER *header;
+  const uint32_t *pos;
+  const uint32_t *fence;
+  const SEQ_GENEDB_SITE *site;
+  const SEQ_GENEDB_TX *tx;
+  const uint32_t *attr;
+  const char *seq;
+  const uint32_t *dict_off;
+  const char *dict_str;
+  struct seq_generange *range;   // made on the first range query; see seq_generange.h
+} SEQ_GENEDB;
+
+SEQ_GENEDB *seq_genedb_open( const char *path );
+void seq_genedb_close( SEQ_GENEDB *db );
+
+// returns the number of sites at abs_pos and sets *first to the first of them
+long seq_genedb_find( const SEQ_GENEDB *db, long abs_pos, long *first );
+
+static inline const char *seq_genedb_str( const SEQ_GENEDB *db, uint32_t code, size_t *len )
+{
+  *len = db->dict_off[code] - db->dict_off[code - 1];
+  return db->dict_str + db->dict_off[code - 1];
+}
+
+// codon of a coding site, the way Seq::Gene reads it off the transcript: up to
+//  3 bases into codon (NUL-terminated) and the codon number and position;
+//  returns 0 for sites that are not coding
+int seq_genedb_codon( const SEQ_GENEDB *db, long row, char codon[4], long *codon_number,
+    int *codon_position );
+
+// writer; sites may be added in any order, they are sorted (stably) on write
+typedef struct seq_genedb_writer
+{
+  SEQ_DICT dict;
+  uint32_t *pos;
+  SEQ_GENEDB_SITE *site;
+  long n;
+  long cap;
+  SEQ_GENEDB_TX *tx;
+  long n_tx;
+  long tx_cap;
+  uint32_t *attr;
+  long n_attr;
+  long attr_cap;
+  char *seq;
+  uint64_t seq_len;
+  uint64_t seq_cap;
+} SEQ_GENEDB_WRITER;
+
+SEQ_GENEDB_WRITER *seq_genedb_writer_new( void );
+void seq_genedb_writer_free( SEQ_GENEDB_WRITER *w );
+
+// adds a transcript; alt holds n_alt (key, value) pairs; returns its ordinal
+//  or -1
+long seq_genedb_writer_add_tx( SEQ_GENEDB_WRITER *w, const char *id, char strand,
+    const char *seq, uint32_t seq_len, int32_t cds_start, const char **alt, int n_alt,
+    const char **error, int n_error );
+
+int seq_genedb_writer_add_site( SEQ_GENEDB_WRITER *w, long abs_pos, long tx, uint32_t offset,
+    int type, char ref );
+
+int seq_genedb_writer_write( SEQ_GENEDB_WRITER *w, const char *path );
+
+#endif
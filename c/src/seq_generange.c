@@ -0,0 +1,171 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_generange.c
+ * Description: Range queries over a gene site store; see seq_generange.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_generange.h"
+
+SEQ_GENERANGE *seq_generange_new( const SEQ_GENEDB *db )
+{
+  const long nTx = db->header->n_tx;
+  const long nSite = db->header->n_site;
+  SEQ_GENERANGE *range = NULL;
+  uint32_t *first = NULL;        // per transcript: first and last position
+  uint32_t *lastPos = NULL;
+  long *last = NULL;             // per transcript: last transcript site, or -1
+  uint32_t *exonStart = NULL;
+
+  range = (SEQ_GENERANGE *)calloc(1, sizeof(SEQ_GENERANGE));
+  check_mem(range);
+  range->db = db;
+  range->index = seq_intervals_new();
+  first = (uint32_t *)malloc(sizeof(uint32_t) * (nTx ? nTx : 1));
+  lastPos = (uint32_t *)malloc(sizeof(uint32_t) * (nTx ? nTx : 1));
+  last = (long *)malloc(sizeof(long) * (nTx ? nTx : 1));
+  exonStart = (uint32_t *)malloc(sizeof(uint32_t) * (nTx ? nTx : 1));
+  check_mem(range->index && first && lastPos && last && exonStart);
+  for(long t = 0; t < nTx; t++)
+  {
+    first[t] = UINT32_MAX;
+    last[t] = -1;
+  }
+
+  // as in seq_txmap.c, an exon is a run of transcript sites whose genomic and
+  //  transcript positions both step by one
+  for(long i = 0; i < nSite; i++)
+  {
+    const SEQ_GENEDB_SITE *site = &db->site[i];
+    const uint32_t t = site->tx;
+    const uint32_t pos = db->pos[i];
+    if(first[t] == UINT32_MAX)
+      first[t] = pos;
+    lastPos[t] = pos;
+    if(site->type == SEQ_GENE_SPLICE_ACCEPTOR || site->type == SEQ_GENE_SPLICE_DONOR)
+      continue;
+
+    const long step = db->tx[t].strand == '-' ? -1 : 1;
+    const long prev = last[t];
+    last[t] = i;
+    if(prev >= 0 && db->pos[prev] + 1 == pos
+        && (long)db->site[prev].offset + step == (long)site->offset)
+      continue;
+    if(prev >= 0)
+      check_mem(seq_intervals_add(range->index, exonStart[t], db->pos[prev] + 1,
+            t << 1 | SEQ_GENERANGE_EXON));
+    exonStart[t] = pos;
+  }
+  for(long t = 0; t < nTx; t++)
+  {
+    if(last[t] >= 0)
+      check_mem(seq_intervals_add(range->index, exonStart[t], db->pos[last[t]] + 1,
+            (uint32_t)t << 1 | SEQ_GENERANGE_EXON));
+    if(first[t] != UINT32_MAX)
+      check_mem(seq_intervals_add(range->index, first[t], lastPos[t] + 1,
+            (uint32_t)t << 1 | SEQ_GENERANGE_TRANSCRIPT));
+  }
+  seq_intervals_index(range->index);
+
+  free(first);
+  free(lastPos);
+  free(last);
+  free(exonStart);
+  return range;
+
+error:
+  free(first);
+  free(lastPos);
+  free(last);
+  free(exonStart);
+  seq_generange_free(range);
+  return NULL;
+}
+
+void seq_generange_free( SEQ_GENERANGE *range )
+{
+  if(!range)
+    return;
+  seq_intervals_free(range->index);
+  free(range);
+}
+
+// position arguments are clamped to what the index and store hold
+static uint32_t clamp( long pos )
+{
+  return pos < 0 ? 0 : pos > (long)UINT32_MAX ? UINT32_MAX : (uint32_t)pos;
+}
+
+long seq_generange_overlap( const SEQ_GENERANGE *range, long start, long end,
+    SEQ_GENERANGE_HIT *out, long max )
+{
+  const SEQ_INTERVALS *index = range->index;
+  long idx[64];
+  long n = seq_intervals_overlap(index, clamp(start), clamp(end), idx, 64);
+  long *all = idx;
+
+  // the rare query over more than 64 features goes again, with room for all
+  if(n > 64 && max > 64)
+  {
+    all = (long *)malloc(sizeof(long) * n);
+    check_mem(all);
+    seq_intervals_overlap(index, clamp(start), clamp(end), all, n);
+  }
+  for(long i = 0; i < n && i < max; i++)
+  {
+    const SEQ_INTERVAL *iv = &index->iv[all[i]];
+    out[i].start = iv->start;
+    out[i].end = iv->end;
+    out[i].tx = iv->label >> 1;
+    out[i].kind = (int)(iv->label & 1);
+  }
+  if(all != idx)
+    free(all);
+  return n;
+
+error:
+  return 0;
+}
+
+long seq_generange_sites( const SEQ_GENERANGE *range, long start, long end, long *first )
+{
+  const SEQ_GENEDB *db = range->db;
+  long hit;
+
+  *first = 0;
+  if(end <= start || seq_intervals_overlap(range->index, clamp(start), clamp(end), &hit, 1) == 0)
+    return 0;
+  seq_genedb_find(db, start, first);
+  long last;
+  if(end > (long)UINT32_MAX)
+    last = db->header->n_site;
+  else
+    seq_genedb_find(db, end, &last);
+  return last - *first;
+}
+
+const char *seq_generange_indel_term( const SEQ_GENEDB *db, long row, int *coding )
+{
+  char codon[4];
+  long codonNumber;
+  int codonPosition;
+
+  *coding = seq_genedb_codon(db, row, codon, &codonNumber, &codonPosition);
+  if(*coding)
+  {
+    if(codonNumber == 1)
+      return "StartLoss";
+    if(strlen(codon) == 3 && seq_codon_to_aa(codon) == '*')
+      return "StopLoss";
+  }
+  return seq_gene_site_type[db->site[row].type];
+}
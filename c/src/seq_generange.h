@@ -0,0 +1,65 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_generange.h
+ * Description: Range queries over a gene site store, for indels: an interval
+ *  index (seq_interval.h) of the span of each transcript, splice sites
+ *  included, and of its exons, made from the sites in one pass.
+ *
+ *  A range that no transcript overlaps is answered by the index alone; one
+ *  that some do is a single slice of the store, since sites are sorted by
+ *  position, rather than a lookup per base.
+ */
+
+#ifndef __seq_generange_h__
+#define __seq_generange_h__
+
+#include "seq_genedb.h"
+#include "seq_interval.h"
+
+// kinds of feature
+enum
+{
+  SEQ_GENERANGE_TRANSCRIPT = 0,
+  SEQ_GENERANGE_EXON
+};
+
+typedef struct seq_generange
+{
+  const SEQ_GENEDB *db;
+  SEQ_INTERVALS *index;    // labels are tx << 1 | kind
+} SEQ_GENERANGE;
+
+typedef struct seq_generange_hit
+{
+  uint32_t start;          // [start, end)
+  uint32_t end;
+  uint32_t tx;             // ordinal in the gene site store
+  int kind;                // SEQ_GENERANGE_*
+} SEQ_GENERANGE_HIT;
+
+SEQ_GENERANGE *seq_generange_new( const SEQ_GENEDB *db );
+void seq_generange_free( SEQ_GENERANGE *range );
+
+// features overlapping [start, end), in order of start, up to max of them;
+//  returns how many there are
+long seq_generange_overlap( const SEQ_GENERANGE *range, long start, long end,
+    SEQ_GENERANGE_HIT *out, long max );
+
+// the sites in [start, end): returns how many and sets *first to the first
+long seq_generange_sites( const SEQ_GENERANGE *range, long start, long end, long *first );
+
+/*
+ * What Seq::Sites::Indels puts in an indel's annotation type for a site:
+ * StartLoss or StopLoss for the first and stop codons, otherwise the site
+ * type; *coding is set for coding sites
+ */
+const char *seq_generange_indel_term( const SEQ_GENEDB *db, long row, int *coding );
+
+#endif
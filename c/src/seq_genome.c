@@ -0,0 +1,273 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genome.c
+ * Description: Chromosome offsets and tracks of an assembly; see seq_genome.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_genome.h"
+
+SEQ_GENOME *seq_genome_new( void )
+{
+  SEQ_GENOME *genome = (SEQ_GENOME *)calloc(1, sizeof(SEQ_GENOME));
+  check_mem(genome);
+  return genome;
+
+error:
+  return NULL;
+}
+
+void seq_genome_free( SEQ_GENOME *genome )
+{
+  if(!genome)
+    return;
+  seq_track_close(genome->tracks.genome);
+  seq_track_close(genome->tracks.ngene);
+  for(int i = 0; i < genome->tracks.n_score; i++)
+    seq_track_close(genome->tracks.score[i]);
+  for(int i = 0; i < SEQ_CADD_TRACKS; i++)
+    seq_track_close(genome->tracks.cadd[i]);
+  for(int i = 0; i < genome->n_gene_name; i++)
+    free(genome->gene_name[i]);
+  free(genome->gene_name);
+  free(genome);
+}
+
+static int compare_offset( const void *a, const void *b )
+{
+  const SEQ_CHROM *aa = (const SEQ_CHROM *)a;
+  const SEQ_CHROM *bb = (const SEQ_CHROM *)b;
+  return (aa->offset > bb->offset) - (aa->offset < bb->offset);
+}
+
+static int compare_name( const void *a, const void *b )
+{
+  const SEQ_CHROM *aa = *(const SEQ_CHROM **)a;
+  const SEQ_CHROM *bb = *(const SEQ_CHROM **)b;
+  return strcmp(aa->name, bb->name);
+}
+
+int seq_genome_read_offsets( SEQ_GENOME *genome, const char *chr_file )
+{
+  FILE *chrFh = NULL;
+  char sss[4096];
+
+  check( ((chrFh = fopen(chr_file, "r")) != (FILE *)NULL),
+      "Cannot open chromosome offset file '%s' for reading.", chr_file );
+
+  genome->n_chrom = 0;
+  while(fgets(sss, sizeof(sss), chrFh))
+  {
+    // YAML::XS::Dump of a flat hash: a '---' line and then 'chr: offset' lines
+    if(strncmp(sss, "---", 3) == 0)
+      continue;
+    char *name = strtok(sss, ": \n\t'\"");
+    char *offset = strtok(NULL, ": \n\t'\"");
+    if(!name || !offset)
+      continue;
+
+    check( (genome->n_chrom < SEQ_MAX_CHROMS), "More than %d chromosomes in '%s'.",
+        SEQ_MAX_CHROMS, chr_file );
+    check( (strlen(name) < SEQ_MAX_NAME), "Chromosome name too long '%s'.", name );
+
+    SEQ_CHROM *chrom = &genome->chrom[genome->n_chrom++];
+    strcpy(chrom->name, name);
+    chrom->offset = atol(offset);
+  }
+  fclose(chrFh);
+  chrFh = NULL;
+
+  check( (genome->n_chrom > 0), "No chromosomes found in '%s'.", chr_file );
+
+  qsort(genome->chrom, genome->n_chrom, sizeof(SEQ_CHROM), compare_offset);
+  long genome_length = genome->tracks.genome ? genome->tracks.genome->length : LONG_MAX;
+  for(int i = 0; i < genome->n_chrom; i++)
+  {
+    genome->chrom[i].index = i;
+    genome->chrom[i].end = (i + 1 < genome->n_chrom) ? genome->chrom[i + 1].offset
+      : genome_length;
+    genome->by_name[i] = &genome->chrom[i];
+  }
+  qsort(genome->by_name, genome->n_chrom, sizeof(SEQ_CHROM *), compare_name);
+
+  return 0;
+
+error:
+  if(chrFh)
+    fclose(chrFh);
+  return 1;
+}
+
+const SEQ_CHROM *seq_genome_chrom_n( const SEQ_GENOME *genome, const char *name, int len )
+{
+  int lo = 0;
+  int hi = genome->n_chrom - 1;
+  while(lo <= hi)
+  {
+    int mid = (lo + hi) / 2;
+    const char *this = genome->by_name[mid]->name;
+    int c = strncmp(name, this, len);
+    if(c == 0 && this[len] != '\0')
+      c = -1;
+    if(c == 0)
+      return genome->by_name[mid];
+    if(c < 0)
+      hi = mid - 1;
+    else
+      lo = mid + 1;
+  }
+  return NULL;
+}
+
+const SEQ_CHROM *seq_genome_chrom( const SEQ_GENOME *genome, const char *name )
+{
+  return seq_genome_chrom_n(genome, name, (int)strlen(name));
+}
+
+int seq_genome_add_genome( SEQ_GENOME *genome, const char *idx_file )
+{
+  check( (genome->tracks.genome == NULL), "Genome track already loaded." );
+  genome->tracks.genome = seq_track_open(idx_file, SEQ_TRACK_CHAR);
+  check( (genome->tracks.genome != NULL), "Cannot load genome track '%s'.", idx_file );
+
+  // the last chr ends where the genome does
+  if(genome->n_chrom > 0)
+    genome->chrom[genome->n_chrom - 1].end = genome->tracks.genome->length;
+  return 0;
+
+error:
+  return 1;
+}
+
+int seq_genome_add_ngene( SEQ_GENOME *genome, const char *idx_file )
+{
+  check( (genome->tracks.ngene == NULL), "Ngene track already loaded." );
+  genome->tracks.ngene = seq_track_open(idx_file, SEQ_TRACK_NGENE);
+  check( (genome->tracks.ngene != NULL), "Cannot load ngene track '%s'.", idx_file );
+  return 0;
+
+error:
+  return 1;
+}
+
+int seq_genome_read_gene_names( SEQ_GENOME *genome, const char *dat_file )
+{
+  FILE *datFh = NULL;
+  char sss[4096];
+
+  check( (genome->gene_name == NULL), "Gene names already loaded." );
+  check( ((datFh = fopen(dat_file, "r")) != (FILE *)NULL),
+      "Cannot open gene region file '%s' for reading.", dat_file );
+
+  // the first line is the genome length
+  if(!fgets(sss, sizeof(sss), datFh))
+  {
+    fclose(datFh);
+    return 0;
+  }
+  while(fgets(sss, sizeof(sss), datFh))
+  {
+    char *name = strtok(sss, "\t\n");
+    char *num = strtok(NULL, "\t\n");
+    if(!name || !num)
+      continue;
+    int code = atoi(num);
+    check( (code > 0 && code < (1 << 16)), "Bad gene number '%s' in '%s'.", num, dat_file );
+    if(code >= genome->n_gene_name)
+    {
+      int n = code + 1 > 2 * genome->n_gene_name ? code + 1 : 2 * genome->n_gene_name;
+      char **names = (char **)realloc(genome->gene_name, n * sizeof(char *));
+      check_mem(names);
+      memset(names + genome->n_gene_name, 0, (n - genome->n_gene_name) * sizeof(char *));
+      genome->gene_name = names;
+      genome->n_gene_name = n;
+    }
+    free(genome->gene_name[code]);
+    check_mem((genome->gene_name[code] = strdup(name)));
+  }
+  fclose(datFh);
+  return 0;
+
+error:
+  if(datFh)
+    fclose(datFh);
+  return 1;
+}
+
+int seq_genome_add_score( SEQ_GENOME *genome, const char *name, const char *idx_file,
+    double min, double max, int R )
+{
+  SEQ_TRACK *track = NULL;
+  int t = genome->tracks.n_score;
+
+  check( (t < SEQ_MAX_SCORE_TRACKS), "At most %d score tracks.", SEQ_MAX_SCORE_TRACKS );
+  check( (strlen(name) < SEQ_MAX_NAME), "Score name too long '%s'.", name );
+  track = seq_track_open(idx_file, SEQ_TRACK_CHAR);
+  check( (track != NULL), "Cannot load score track '%s'.", idx_file );
+  check( (seq_track_set_score(track, min, max, R) == 0), "Bad score range for '%s'.", name );
+
+  strcpy(genome->score_name[t], name);
+  genome->tracks.score[t] = track;
+  genome->tracks.n_score++;
+  return 0;
+
+error:
+  seq_track_close(track);
+  return 1;
+}
+
+int seq_genome_add_cadd( SEQ_GENOME *genome, const char *idx_prefix,
+    double min, double max, int R )
+{
+  char file[4096];
+
+  check( (!genome->tracks.has_cadd), "Cadd tracks already loaded." );
+  for(int k = 0; k < SEQ_CADD_TRACKS; k++)
+  {
+    snprintf(file, sizeof(file), "%s.%d", idx_prefix, k);
+    genome->tracks.cadd[k] = seq_track_open(file, SEQ_TRACK_CHAR);
+    check( (genome->tracks.cadd[k] != NULL), "Cannot load cadd track '%s'.", file );
+    check( (seq_track_set_score(genome->tracks.cadd[k], min, max, R) == 0),
+        "Bad score range for '%s'.", file );
+  }
+  genome->tracks.has_cadd = 1;
+  return 0;
+
+error:
+  for(int k = 0; k < SEQ_CADD_TRACKS; k++)
+  {
+    seq_track_close(genome->tracks.cadd[k]);
+    genome->tracks.cadd[k] = NULL;
+  }
+  return 1;
+}
+
+int seq_cadd_index( char ref, char alt )
+{
+  static const char bases[] = "ACGT";
+  int i = 0;
+
+  if(ref == alt || !strchr(bases, ref) || !strchr(bases, alt) || !ref || !alt)
+    return -1;
+  for(const char *b = bases; *b; b++)
+  {
+    if(*b == ref)
+      continue;
+    if(*b == alt)
+      return i;
+    i++;
+  }
+  return -1;
+}
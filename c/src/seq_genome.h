@@ -0,0 +1,94 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genome.h
+ * Description: An assembly's chromosome offsets and its mapped genome-sized
+ *  tracks. The offsets come from the `.chr_len.dat` YAML file written by
+ *  Seq::Build ({chr: zero-indexed offset of the chr's first base}); the
+ *  tracks from the `.idx` files; the names of the genes the ngene track
+ *  numbers from the gene track's `genome.gene.dat` region file (see
+ *  Seq::Build::GeneTrack::build_tx_db_for_genome).
+ */
+
+#ifndef __seq_genome_h__
+#define __seq_genome_h__
+
+#include "seq_track.h"
+#include "seq_batch.h"
+
+#define SEQ_MAX_CHROMS 1000
+#define SEQ_MAX_NAME 256
+
+typedef struct seq_chrom
+{
+  char name[SEQ_MAX_NAME];
+  long offset;             // absolute position of the chr's first base
+  long end;                // absolute position one past the chr's last base
+  int index;               // order in the genome, i.e., sorted by offset
+} SEQ_CHROM;
+
+typedef struct seq_genome
+{
+  SEQ_CHROM chrom[SEQ_MAX_CHROMS];  // sorted by offset
+  SEQ_CHROM *by_name[SEQ_MAX_CHROMS];
+  int n_chrom;
+  SEQ_TRACKS tracks;                // owned by the genome
+  char score_name[SEQ_MAX_SCORE_TRACKS][SEQ_MAX_NAME];
+  char **gene_name;                 // by ngene code; NULL where there is none
+  int n_gene_name;
+} SEQ_GENOME;
+
+SEQ_GENOME *seq_genome_new( void );
+void seq_genome_free( SEQ_GENOME *genome );
+
+/*
+ * Reads the chr offset file; the end of the last chr is the length of the
+ * genome track, so load that first if it is known (otherwise it's LONG_MAX).
+ */
+int seq_genome_read_offsets( SEQ_GENOME *genome, const char *chr_file );
+
+int seq_genome_add_genome( SEQ_GENOME *genome, const char *idx_file );
+int seq_genome_add_ngene( SEQ_GENOME *genome, const char *idx_file );
+// the region file: the genome length, then 'name num start end' lines
+int seq_genome_read_gene_names( SEQ_GENOME *genome, const char *dat_file );
+int seq_genome_add_score( SEQ_GENOME *genome, const char *name, const char *idx_file,
+    double min, double max, int R );
+// expects idx_prefix.0, idx_prefix.1 and idx_prefix.2, see genome_cadd.c
+int seq_genome_add_cadd( SEQ_GENOME *genome, const char *idx_prefix,
+    double min, double max, int R );
+
+const SEQ_CHROM *seq_genome_chrom( const SEQ_GENOME *genome, const char *name );
+const SEQ_CHROM *seq_genome_chrom_n( const SEQ_GENOME *genome, const char *name, int len );
+
+// the name of an ngene code, or NULL when it has none
+static inline const char *seq_genome_gene_name( const SEQ_GENOME *genome, int code )
+{
+  return code > 0 && code < genome->n_gene_name ? genome->gene_name[code] : NULL;
+}
+
+/*
+ * Zero-indexed absolute position of a 1-indexed chr position, or -1 if the
+ * position is not on the chr.
+ */
+static inline long seq_genome_abs_pos( const SEQ_CHROM *chrom, long pos )
+{
+  long abs_pos = chrom->offset + pos - 1;
+  if( pos < 1 || abs_pos >= chrom->end )
+    return -1;
+  return abs_pos;
+}
+
+/*
+ * The cadd track index for a ref / alt pair, following the alphabetical
+ * order of the alternate alleles used by genome_cadd and
+ * Seq::Annotate::_build_cadd_lookup; -1 if there is none.
+ */
+int seq_cadd_index( char ref, char alt );
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genotype.c
+ * Description: Sample genotype codes and carrier sets; see seq_genotype.h
+ */
+
+#include <string.h>
+#include "seq_genotype.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEQ_HAVE_X86 1
+#endif
+
+const char seq_geno_char[16] = {
+  0, 'A', 'C', 'G', 'T', 'D', 'I', 'R', 'Y', 'S', 'W', 'K', 'M', 'E', 'H', 0 };
+
+// the code of each single character call, 0 for any that is not one
+static const uint8_t geno_code[256] = {
+  ['A'] = SEQ_GENO_A, ['C'] = SEQ_GENO_C, ['G'] = SEQ_GENO_G, ['T'] = SEQ_GENO_T,
+  ['D'] = SEQ_GENO_D, ['I'] = SEQ_GENO_I,
+  ['R'] = SEQ_GENO_R, ['Y'] = SEQ_GENO_Y, ['S'] = SEQ_GENO_S, ['W'] = SEQ_GENO_W,
+  ['K'] = SEQ_GENO_K, ['M'] = SEQ_GENO_M, ['E'] = SEQ_GENO_E, ['H'] = SEQ_GENO_H };
+
+uint8_t seq_geno_code( const char *s, size_t len )
+{
+  if(len == 0)
+    return SEQ_GENO_MISSING;
+  if(len > 1)
+    return SEQ_GENO_OTHER;
+  const uint8_t code = geno_code[(unsigned char)s[0]];
+  if(code)
+    return code;
+
+  // perl's false "0" and no call at all are skipped like empty fields
+  return s[0] == '0' || s[0] == 'N' ? SEQ_GENO_MISSING : SEQ_GENO_OTHER;
+}
+
+static inline void set_bit( uint64_t *set, long i )
+{
+  set[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static void carriers_scalar( const uint8_t *code, long from, long n, uint8_t ref,
+    uint64_t *het, uint64_t *hom, uint64_t *other )
+{
+  for(long i = from; i < n; i++)
+  {
+    const uint8_t c = code[i];
+    if(c == SEQ_GENO_MISSING || c == ref)
+      continue;
+    if(c <= SEQ_GENO_HOM_LAST)
+      set_bit(hom, i);
+    else if(c <= SEQ_GENO_HET_LAST)
+      set_bit(het, i);
+    else
+      set_bit(other, i);
+  }
+}
+
+#ifdef SEQ_HAVE_X86
+
+// codes are below 16, so the signed byte compares order them as well
+__attribute__((target("avx2")))
+static long carriers_avx2( const uint8_t *code, long n, uint8_t ref, uint64_t *het,
+    uint64_t *hom, uint64_t *other )
+{
+  const __m256i refCode = _mm256_set1_epi8((char)ref);
+  const __m256i missing = _mm256_setzero_si256();
+  const __m256i homLast = _mm256_set1_epi8(SEQ_GENO_HOM_LAST);
+  const __m256i hetLast = _mm256_set1_epi8(SEQ_GENO_HET_LAST);
+  long i = 0;
+
+  for(; i + 64 <= n; i += 64)
+  {
+    uint64_t setHom = 0, setHet = 0, setOther = 0;
+    for(int half = 0; half < 2; half++)
+    {
+      __m256i c = _mm256_loadu_si256((const __m256i *)(code + i + 32 * half));
+      __m256i skip = _mm256_or_si256(_mm256_cmpeq_epi8(c, missing),
+          _mm256_cmpeq_epi8(c, refCode));
+      __m256i overHom = _mm256_cmpgt_epi8(c, homLast);
+      __m256i overHet = _mm256_cmpgt_epi8(c, hetLast);
+      const uint64_t s = (uint32_t)_mm256_movemask_epi8(skip);
+      const uint64_t oHom = (uint32_t)_mm256_movemask_epi8(overHom);
+      const uint64_t oHet = (uint32_t)_mm256_movemask_epi8(overHet);
+      const int shift = 32 * half;
+      setHom |= (~oHom & ~s & 0xffffffffu) << shift;
+      setHet |= (oHom & ~oHet & ~s) << shift;
+      setOther |= (oHet & ~s) << shift;
+    }
+    het[i >> 6] = setHet;
+    hom[i >> 6] = setHom;
+    other[i >> 6] = setOther;
+  }
+  return i;
+}
+
+#endif
+
+void seq_geno_carriers( const uint8_t *code, long n, uint8_t ref, uint64_t *het,
+    uint64_t *hom, uint64_t *other )
+{
+  const long nWord = seq_geno_words(n);
+  long i = 0;
+
+  // a reference that is not one base can only be told from other calls by
+  //  their strings
+  if(ref == SEQ_GENO_OTHER)
+    ref = SEQ_GENO_MISSING;
+  memset(het, 0, sizeof(uint64_t) * nWord);
+  memset(hom, 0, sizeof(uint64_t) * nWord);
+  memset(other, 0, sizeof(uint64_t) * nWord);
+
+#ifdef SEQ_HAVE_X86
+  if(__builtin_cpu_supports("avx2"))
+    i = carriers_avx2(code, n, ref, het, hom, other);
+#endif
+  carriers_scalar(code, i, n, ref, het, hom, other);
+}
@@ -0,0 +1,61 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_genotype.h
+ * Description: Sample genotype calls of a snpfile row as a vector of small
+ *  codes, one per sample, and the carrier sets Seq::_minor_allele_carriers
+ *  works out from them.
+ *
+ *  The IUPAC and indel codes of Seq::Role::Genotypes fit in 4 bits and are
+ *  numbered so homozygous and heterozygous calls are two ranges; a row's
+ *  het, hom and unrecognized carriers are then a few compares per 32
+ *  samples, as bitsets in sample order.
+ */
+
+#ifndef __seq_genotype_h__
+#define __seq_genotype_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum
+{
+  SEQ_GENO_MISSING = 0,          // empty, "0" or N: never a carrier
+  SEQ_GENO_A, SEQ_GENO_C, SEQ_GENO_G, SEQ_GENO_T, SEQ_GENO_D, SEQ_GENO_I,
+  SEQ_GENO_R, SEQ_GENO_Y, SEQ_GENO_S, SEQ_GENO_W, SEQ_GENO_K, SEQ_GENO_M,
+  SEQ_GENO_E, SEQ_GENO_H,
+  SEQ_GENO_OTHER                 // anything else: a carrier, but unrecognized
+};
+
+#define SEQ_GENO_HOM_FIRST SEQ_GENO_A
+#define SEQ_GENO_HOM_LAST  SEQ_GENO_I
+#define SEQ_GENO_HET_FIRST SEQ_GENO_R
+#define SEQ_GENO_HET_LAST  SEQ_GENO_H
+
+// the call each code stands for, "" for missing and other
+extern const char seq_geno_char[16];
+
+uint8_t seq_geno_code( const char *s, size_t len );
+
+// 64 samples to a word
+static inline long seq_geno_words( long n )
+{
+  return (n + 63) >> 6;
+}
+
+/*
+ * Carriers among n codes: samples that are neither missing nor ref (the
+ * code of the reference base; SEQ_GENO_OTHER when it is not one base, in
+ * which case the caller compares the strings of the other calls). Each of
+ * het, hom and other gets seq_geno_words(n) words.
+ */
+void seq_geno_carriers( const uint8_t *code, long n, uint8_t ref, uint64_t *het,
+    uint64_t *hom, uint64_t *other );
+
+#endif
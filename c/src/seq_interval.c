@@ -0,0 +1,178 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_interval.c
+ * Description: Implicit augmented interval tree; see seq_interval.h
+ */
+
+#include <stdlib.h>
+#include "dbg.h"
+#include "seq_interval.h"
+
+// subtrees this low are scanned instead of descended
+#define SCAN_LEVEL 3
+
+SEQ_INTERVALS *seq_intervals_new( void )
+{
+  SEQ_INTERVALS *set = (SEQ_INTERVALS *)calloc(1, sizeof(SEQ_INTERVALS));
+  check_mem(set);
+  set->max_level = -1;
+  return set;
+
+error:
+  return NULL;
+}
+
+void seq_intervals_free( SEQ_INTERVALS *set )
+{
+  if(!set)
+    return;
+  free(set->iv);
+  free(set);
+}
+
+int seq_intervals_add( SEQ_INTERVALS *set, uint32_t start, uint32_t end, uint32_t label )
+{
+  if(end <= start)
+    return 1;
+  if(set->n == set->cap)
+  {
+    long cap = set->cap ? 2 * set->cap : 64;
+    SEQ_INTERVAL *iv = (SEQ_INTERVAL *)realloc(set->iv, cap * sizeof(SEQ_INTERVAL));
+    check_mem(iv);
+    set->iv = iv;
+    set->cap = cap;
+  }
+  set->iv[set->n].start = start;
+  set->iv[set->n].end = end;
+  set->iv[set->n].max = end;
+  set->iv[set->n].label = label;
+  set->n++;
+  set->max_level = -1;
+  return 1;
+
+error:
+  return 0;
+}
+
+static int compare_interval( const void *a, const void *b )
+{
+  const SEQ_INTERVAL *x = (const SEQ_INTERVAL *)a;
+  const SEQ_INTERVAL *y = (const SEQ_INTERVAL *)b;
+  if(x->start != y->start)
+    return (x->start > y->start) - (x->start < y->start);
+  if(x->end != y->end)
+    return (x->end > y->end) - (x->end < y->end);
+  return (x->label > y->label) - (x->label < y->label);
+}
+
+void seq_intervals_index( SEQ_INTERVALS *set )
+{
+  SEQ_INTERVAL *iv = set->iv;
+  const long n = set->n;
+  long lastIdx = 0;
+  uint32_t last = 0;
+  int k;
+
+  set->max_level = -1;
+  if(n == 0)
+    return;
+  qsort(iv, n, sizeof(SEQ_INTERVAL), compare_interval);
+
+  // leaves are the even indices; last is the max of the rightmost node of the
+  //  level below, which stands in for right children past the end
+  for(long i = 0; i < n; i += 2)
+  {
+    lastIdx = i;
+    last = iv[i].max = iv[i].end;
+  }
+  for(k = 1; (1L << k) <= n; k++)
+  {
+    const long x = 1L << (k - 1);
+    for(long i = (x << 1) - 1; i < n; i += x << 2)
+    {
+      uint32_t left = iv[i - x].max;
+      uint32_t right = i + x < n ? iv[i + x].max : last;
+      uint32_t max = iv[i].end;
+      if(left > max)
+        max = left;
+      if(right > max)
+        max = right;
+      iv[i].max = max;
+    }
+    lastIdx = (lastIdx >> k) & 1 ? lastIdx - x : lastIdx + x;
+    if(lastIdx < n && iv[lastIdx].max > last)
+      last = iv[lastIdx].max;
+  }
+  set->max_level = k - 1;
+}
+
+long seq_intervals_overlap( const SEQ_INTERVALS *set, uint32_t start, uint32_t end,
+    long *out, long max )
+{
+  const SEQ_INTERVAL *iv = set->iv;
+  const long n = set->n;
+  struct { long x; int k; int visited; } stack[64];
+  int top = 0;
+  long nHit = 0;
+
+  if(set->max_level < 0 || end <= start)
+    return 0;
+
+  stack[top].x = (1L << set->max_level) - 1;
+  stack[top].k = set->max_level;
+  stack[top++].visited = 0;
+  while(top)
+  {
+    const long x = stack[--top].x;
+    const int k = stack[top].k;
+    if(k <= SCAN_LEVEL)
+    {
+      // the whole subtree, in order
+      long i = x >> k << k;
+      long iEnd = i + (1L << (k + 1)) - 1;
+      if(iEnd > n)
+        iEnd = n;
+      for(; i < iEnd && iv[i].start < end; i++)
+      {
+        if(start < iv[i].end)
+        {
+          if(nHit < max)
+            out[nHit] = i;
+          nHit++;
+        }
+      }
+    }
+    else if(!stack[top].visited)
+    {
+      // come back for the node itself after its left subtree
+      const long left = x - (1L << (k - 1));
+      stack[top++].visited = 1;
+      if(left >= n || iv[left].max > start)
+      {
+        stack[top].x = left;
+        stack[top].k = k - 1;
+        stack[top++].visited = 0;
+      }
+    }
+    else if(x < n && iv[x].start < end)
+    {
+      if(start < iv[x].end)
+      {
+        if(nHit < max)
+          out[nHit] = x;
+        nHit++;
+      }
+      stack[top].x = x + (1L << (k - 1));
+      stack[top].k = k - 1;
+      stack[top++].visited = 0;
+    }
+  }
+  return nHit;
+}
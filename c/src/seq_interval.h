@@ -0,0 +1,59 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_interval.h
+ * Description: Implicit augmented interval tree over half-open [start, end)
+ *  intervals.
+ *
+ *  The intervals are kept in one array sorted by start, which is read as a
+ *  binary search tree in order: the node at index i of level k (the lowest k
+ *  bits of i set, bit k clear) has children at i -/+ 2^(k-1). Each node keeps
+ *  the maximum end of its subtree, so an overlap query skips any subtree that
+ *  ends before it and any right subtree that starts after it; it visits
+ *  O(log n + hits) nodes with no pointers and no allocation beyond the array.
+ */
+
+#ifndef __seq_interval_h__
+#define __seq_interval_h__
+
+#include <stdint.h>
+
+typedef struct seq_interval
+{
+  uint32_t start;
+  uint32_t end;
+  uint32_t max;            // max end over the subtree; set by seq_intervals_index
+  uint32_t label;          // the caller's
+} SEQ_INTERVAL;
+
+typedef struct seq_intervals
+{
+  SEQ_INTERVAL *iv;
+  long n;
+  long cap;
+  int max_level;           // level of the root, -1 until indexed
+} SEQ_INTERVALS;
+
+SEQ_INTERVALS *seq_intervals_new( void );
+void seq_intervals_free( SEQ_INTERVALS *set );
+
+// empty intervals are ignored; returns 0 when out of memory
+int seq_intervals_add( SEQ_INTERVALS *set, uint32_t start, uint32_t end, uint32_t label );
+
+// sorts the intervals and builds the tree; must come before any query
+void seq_intervals_index( SEQ_INTERVALS *set );
+
+/*
+ * Intervals overlapping [start, end), as indices into set->iv in order of
+ * start, up to max of them; returns how many there are
+ */
+long seq_intervals_overlap( const SEQ_INTERVALS *set, uint32_t start, uint32_t end,
+    long *out, long max );
+
+#endif
@@ -0,0 +1,459 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_pipe.c
+ * Description: Staged pipelines over bounded lock-free rings; see seq_pipe.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "dbg.h"
+#include "seq_pipe.h"
+
+static inline uint64_t now_ns( void )
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// spins a while, then yields, then sleeps, the longer the wait has been
+static inline void backoff( int *spin )
+{
+  if(*spin < 64)
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  }
+  else if(*spin < 96)
+    sched_yield();
+  else
+  {
+    struct timespec ts = { 0, 50000 };
+    nanosleep(&ts, NULL);
+  }
+  (*spin)++;
+}
+
+static int ring_init( SEQ_RING *r, long depth, int spsc )
+{
+  r->slot = (SEQ_PIPE_SLOT *)calloc((size_t)depth, sizeof(SEQ_PIPE_SLOT));
+  check_mem(r->slot);
+  r->mask = (uint64_t)depth - 1;
+  r->spsc = spsc;
+  for(long i = 0; i < depth; i++)
+    r->slot[i].turn = (uint64_t)i;
+  return 1;
+
+error:
+  return 0;
+}
+
+// 1 when the item went in, 0 when the ring is full
+static int ring_push( SEQ_RING *r, uint64_t order, void *item )
+{
+  if(r->spsc)
+  {
+    const uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    if(tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) > r->mask)
+      return 0;
+    r->slot[tail & r->mask].order = order;
+    r->slot[tail & r->mask].item = item;
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+  }
+
+  uint64_t pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  for(;;)
+  {
+    SEQ_PIPE_SLOT *s = &r->slot[pos & r->mask];
+    const int64_t dif = (int64_t)(__atomic_load_n(&s->turn, __ATOMIC_ACQUIRE) - pos);
+    if(dif == 0)
+    {
+      if(__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED))
+      {
+        s->order = order;
+        s->item = item;
+        __atomic_store_n(&s->turn, pos + 1, __ATOMIC_RELEASE);
+        return 1;
+      }
+    }
+    else if(dif < 0)
+      return 0;
+    else
+      pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  }
+}
+
+// 1 when an item came out, 0 when the ring is empty
+static int ring_pop( SEQ_RING *r, uint64_t *order, void **item )
+{
+  if(r->spsc)
+  {
+    const uint64_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    if(head == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE))
+      return 0;
+    *order = r->slot[head & r->mask].order;
+    *item = r->slot[head & r->mask].item;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+  }
+
+  uint64_t pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  for(;;)
+  {
+    SEQ_PIPE_SLOT *s = &r->slot[pos & r->mask];
+    const int64_t dif = (int64_t)(__atomic_load_n(&s->turn, __ATOMIC_ACQUIRE) - (pos + 1));
+    if(dif == 0)
+    {
+      if(__atomic_compare_exchange_n(&r->head, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+            __ATOMIC_RELAXED))
+      {
+        *order = s->order;
+        *item = s->item;
+        __atomic_store_n(&s->turn, pos + r->mask + 1, __ATOMIC_RELEASE);
+        return 1;
+      }
+    }
+    else if(dif < 0)
+      return 0;
+    else
+      pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  }
+}
+
+static inline long ring_depth( SEQ_RING *r )
+{
+  const uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+  const uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+  return tail > head ? (long)(tail - head) : 0;
+}
+
+static inline int failed( SEQ_PIPE *p )
+{
+  return __atomic_load_n(&p->failed, __ATOMIC_ACQUIRE);
+}
+
+static inline void drop( SEQ_PIPE *p, void *item )
+{
+  if(item && p->drop)
+    p->drop(item);
+}
+
+// hands an item on to stage i (or, past the last stage, drops it), waiting
+//  for room; 0 when the pipeline failed meanwhile
+static int hand_on( SEQ_PIPE *p, SEQ_STAGE *from, int i, uint64_t order, void *item )
+{
+  if(i >= p->n_stage)
+  {
+    drop(p, item);
+    return 1;
+  }
+
+  uint64_t start = 0;
+  int spin = 0;
+  while(!ring_push(&p->stage[i].in, order, item))
+  {
+    if(failed(p))
+    {
+      drop(p, item);
+      return 0;
+    }
+    if(!start)
+      start = now_ns();
+    backoff(&spin);
+  }
+  if(start)
+    __atomic_add_fetch(&from->wait_out_ns, now_ns() - start, __ATOMIC_RELAXED);
+  return 1;
+}
+
+static int work( SEQ_STAGE *st, int i, uint64_t order, void *item )
+{
+  // a dropped item still goes through, so ordered stages know not to wait
+  if(item)
+  {
+    const uint64_t start = now_ns();
+    item = st->fn(st->ctx, item);
+    __atomic_add_fetch(&st->busy_ns, now_ns() - start, __ATOMIC_RELAXED);
+  }
+  __atomic_add_fetch(&st->items, 1, __ATOMIC_RELAXED);
+  return hand_on(st->pipe, st, i + 1, order, item);
+}
+
+static void *stage_worker( void *arg )
+{
+  SEQ_STAGE *st = (SEQ_STAGE *)arg;
+  SEQ_PIPE *p = st->pipe;
+  const int i = (int)(st - p->stage);
+  SEQ_STAGE *prev = &p->stage[i - 1];
+
+  for(;;)
+  {
+    uint64_t order;
+    void *item;
+    uint64_t start = 0;
+    int spin = 0;
+    int got;
+
+    while(!(got = ring_pop(&st->in, &order, &item)))
+    {
+      if(failed(p))
+        break;
+      // once the stage before is done, what is left in the ring is all
+      if(__atomic_load_n(&prev->live, __ATOMIC_ACQUIRE) == 0)
+      {
+        got = ring_pop(&st->in, &order, &item);
+        break;
+      }
+      if(!start)
+        start = now_ns();
+      backoff(&spin);
+    }
+    if(start)
+      __atomic_add_fetch(&st->wait_in_ns, now_ns() - start, __ATOMIC_RELAXED);
+    if(!got)
+      break;
+
+    long depth = ring_depth(&st->in) + 1;
+    long max = __atomic_load_n(&st->max_depth, __ATOMIC_RELAXED);
+    while(depth > max && !__atomic_compare_exchange_n(&st->max_depth, &max, depth, 1,
+          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      ;
+
+    if(!st->ordered)
+    {
+      if(!work(st, i, order, item))
+        break;
+      continue;
+    }
+
+    // the source keeps order within the window of next, so slots don't clash
+    if(order != st->next)
+    {
+      SEQ_PIPE_SLOT *early = &st->early[order % p->window];
+      early->turn = 1;
+      early->order = order;
+      early->item = item;
+      continue;
+    }
+    int ok = work(st, i, order, item);
+    __atomic_store_n(&st->next, st->next + 1, __ATOMIC_RELEASE);
+    for(SEQ_PIPE_SLOT *early = &st->early[st->next % p->window];
+        ok && early->turn && early->order == st->next;
+        early = &st->early[st->next % p->window])
+    {
+      early->turn = 0;
+      ok = work(st, i, early->order, early->item);
+      __atomic_store_n(&st->next, st->next + 1, __ATOMIC_RELEASE);
+    }
+    if(!ok)
+      break;
+  }
+
+  __atomic_sub_fetch(&st->live, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+SEQ_PIPE *seq_pipe_new( const char *source, long depth, void (*drop)( void *item ) )
+{
+  SEQ_PIPE *p = (SEQ_PIPE *)calloc(1, sizeof(SEQ_PIPE));
+  check_mem(p);
+  p->depth = 2;
+  while(p->depth < depth)
+    p->depth *= 2;
+  p->drop = drop;
+  p->stage[0].name = source;
+  p->stage[0].threads = 1;
+  p->stage[0].pipe = p;
+  p->n_stage = 1;
+  return p;
+
+error:
+  return NULL;
+}
+
+int seq_pipe_add( SEQ_PIPE *p, const char *name, seq_stage_fn fn, void *ctx, int threads,
+    int ordered )
+{
+  check( (p->n_stage < SEQ_PIPE_STAGES && !p->started), "Cannot add stage %s.", name );
+  SEQ_STAGE *st = &p->stage[p->n_stage];
+  st->name = name;
+  st->fn = fn;
+  st->ctx = ctx;
+  st->threads = ordered || threads < 1 ? 1 : threads > SEQ_PIPE_THREADS ? SEQ_PIPE_THREADS
+    : threads;
+  st->ordered = ordered;
+  st->pipe = p;
+  p->n_stage++;
+  return 1;
+
+error:
+  return 0;
+}
+
+int seq_pipe_start( SEQ_PIPE *p )
+{
+  p->window = (uint64_t)(p->depth * p->n_stage);
+  p->stage[0].live = 1;
+  for(int i = 1; i < p->n_stage; i++)
+  {
+    SEQ_STAGE *st = &p->stage[i];
+    check_mem(ring_init(&st->in, p->depth, p->stage[i - 1].threads == 1 && st->threads == 1));
+    if(st->ordered)
+      check_mem((st->early = (SEQ_PIPE_SLOT *)calloc(p->window, sizeof(SEQ_PIPE_SLOT))));
+    st->live = st->threads;
+  }
+  p->started = 1;
+  p->mark = now_ns();
+  for(int i = 1; i < p->n_stage; i++)
+  {
+    SEQ_STAGE *st = &p->stage[i];
+    for(; st->n_thread < st->threads; st->n_thread++)
+    {
+      if(pthread_create(&st->thread[st->n_thread], NULL, stage_worker, st) != 0)
+      {
+        log_err("Cannot start a thread of stage %s.", st->name);
+        // the threads that won't run are not live either
+        __atomic_sub_fetch(&st->live, st->threads - st->n_thread, __ATOMIC_RELEASE);
+        seq_pipe_fail(p);
+        return 0;
+      }
+    }
+  }
+  return 1;
+
+error:
+  seq_pipe_fail(p);
+  return 0;
+}
+
+int seq_pipe_put( SEQ_PIPE *p, void *item )
+{
+  SEQ_STAGE *src = &p->stage[0];
+  uint64_t start = 0;
+  int spin = 0;
+
+  __atomic_add_fetch(&src->busy_ns, now_ns() - p->mark, __ATOMIC_RELAXED);
+
+  // keep the ordered stages' early arrivals within the window
+  for(;;)
+  {
+    uint64_t behind = p->order;
+    for(int i = 1; i < p->n_stage; i++)
+    {
+      if(p->stage[i].ordered)
+      {
+        const uint64_t next = __atomic_load_n(&p->stage[i].next, __ATOMIC_ACQUIRE);
+        if(next < behind)
+          behind = next;
+      }
+    }
+    if(p->order - behind < p->window || failed(p))
+      break;
+    if(!start)
+      start = now_ns();
+    backoff(&spin);
+  }
+  if(start)
+    __atomic_add_fetch(&src->wait_out_ns, now_ns() - start, __ATOMIC_RELAXED);
+  if(failed(p))
+  {
+    drop(p, item);
+    return 0;
+  }
+  __atomic_add_fetch(&src->items, 1, __ATOMIC_RELAXED);
+  const int ok = hand_on(p, src, 1, p->order++, item);
+  p->mark = now_ns();
+  return ok;
+}
+
+void seq_pipe_fail( SEQ_PIPE *p )
+{
+  __atomic_store_n(&p->failed, 1, __ATOMIC_RELEASE);
+}
+
+int seq_pipe_finish( SEQ_PIPE *p )
+{
+  if(!p->started)
+    return !failed(p);
+  __atomic_add_fetch(&p->stage[0].busy_ns, now_ns() - p->mark, __ATOMIC_RELAXED);
+  __atomic_store_n(&p->stage[0].live, 0, __ATOMIC_RELEASE);
+  for(int i = 1; i < p->n_stage; i++)
+  {
+    SEQ_STAGE *st = &p->stage[i];
+    for(int t = 0; t < st->n_thread; t++)
+      pthread_join(st->thread[t], NULL);
+    st->n_thread = 0;
+  }
+  p->started = 0;
+
+  // what a failed pipeline left behind
+  for(int i = 1; i < p->n_stage; i++)
+  {
+    SEQ_STAGE *st = &p->stage[i];
+    uint64_t order;
+    void *item;
+    while(st->in.slot && ring_pop(&st->in, &order, &item))
+      drop(p, item);
+    for(uint64_t k = 0; st->early && k < p->window; k++)
+    {
+      if(st->early[k].turn)
+        drop(p, st->early[k].item);
+      st->early[k].turn = 0;
+    }
+  }
+  return !failed(p);
+}
+
+void seq_pipe_free( SEQ_PIPE *p )
+{
+  if(!p)
+    return;
+  if(p->started)
+  {
+    seq_pipe_fail(p);
+    seq_pipe_finish(p);
+  }
+  for(int i = 1; i < p->n_stage; i++)
+  {
+    free(p->stage[i].in.slot);
+    free(p->stage[i].early);
+  }
+  free(p);
+}
+
+void seq_pipe_stats( SEQ_PIPE *p, int i, SEQ_PIPE_STATS *stats )
+{
+  SEQ_STAGE *st = &p->stage[i];
+  stats->name = st->name;
+  stats->threads = st->threads;
+  stats->items = __atomic_load_n(&st->items, __ATOMIC_RELAXED);
+  stats->depth = i && st->in.slot ? ring_depth(&st->in) : 0;
+  stats->max_depth = __atomic_load_n(&st->max_depth, __ATOMIC_RELAXED);
+  stats->wait_in = __atomic_load_n(&st->wait_in_ns, __ATOMIC_RELAXED) / 1e9;
+  stats->wait_out = __atomic_load_n(&st->wait_out_ns, __ATOMIC_RELAXED) / 1e9;
+  stats->busy = __atomic_load_n(&st->busy_ns, __ATOMIC_RELAXED) / 1e9;
+}
+
+void seq_pipe_report( SEQ_PIPE *p )
+{
+  for(int i = 0; i < p->n_stage; i++)
+  {
+    SEQ_PIPE_STATS s;
+    seq_pipe_stats(p, i, &s);
+    log_info("%-10s %2d thread(s) %10llu items, queue max %4ld, waited %.2fs for input "
+        "and %.2fs for output, busy %.2fs", s.name, s.threads, (unsigned long long)s.items,
+        s.max_depth, s.wait_in, s.wait_out, s.busy);
+  }
+}
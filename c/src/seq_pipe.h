@@ -0,0 +1,138 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_pipe.h
+ * Description: Staged pipelines over bounded lock-free rings.
+ *
+ *  A pipeline is a source, fed by the caller with seq_pipe_put, and stages
+ *  run by threads of their own, each taking the items of the one before from
+ *  a ring of depth items and handing them on through the next. A full ring
+ *  holds its producer back and an empty one its consumer, so no stage gets
+ *  more than a ring ahead of the next. Rings between one thread and one are
+ *  single-producer single-consumer; any other ring is the multi-producer
+ *  multi-consumer kind (a slot sequence per item, after D. Vyukov).
+ *
+ *  A stage of several threads sees items in no particular order; an ordered
+ *  stage (always one thread) gets them in the order they were put, holding
+ *  early arrivals until those before them come, and the source is held back
+ *  so they never number more than the window.
+ *
+ *  Each stage counts its items, the depth of its input ring, and the time
+ *  its threads spent waiting for input, waiting on a full output ring and
+ *  working (for the source, the time between puts); the stage that waits
+ *  least is the one bounding the job.
+ */
+
+#ifndef __seq_pipe_h__
+#define __seq_pipe_h__
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define SEQ_PIPE_STAGES  8
+#define SEQ_PIPE_THREADS 64            // of one stage, at most
+
+// one item in a ring: its place in the order of the source and the item
+typedef struct seq_pipe_slot
+{
+  uint64_t turn;           // the slot's sequence, for multi-producer rings
+  uint64_t order;
+  void *item;
+} SEQ_PIPE_SLOT;
+
+typedef struct seq_ring
+{
+  SEQ_PIPE_SLOT *slot;
+  uint64_t mask;
+  int spsc;
+  uint64_t head __attribute__((aligned(64)));    // next to take
+  uint64_t tail __attribute__((aligned(64)));    // next to fill
+} SEQ_RING;
+
+// the work of a stage, on an item: returns the item to hand on (the same or
+//  another), or NULL to drop it. It calls seq_pipe_fail to stop the pipeline.
+typedef void *(*seq_stage_fn)( void *ctx, void *item );
+
+typedef struct seq_pipe_stats
+{
+  const char *name;
+  int threads;
+  uint64_t items;
+  long depth;              // of the input ring, now
+  long max_depth;
+  double wait_in;          // seconds, all threads, for an item to work on
+  double wait_out;         // seconds held back by the next stage
+  double busy;             // seconds in the stage's work
+} SEQ_PIPE_STATS;
+
+typedef struct seq_stage
+{
+  const char *name;
+  seq_stage_fn fn;
+  void *ctx;
+  int threads;
+  int ordered;
+  SEQ_RING in;             // from the stage before; unused for the source
+  int live;                // threads still running
+  uint64_t next;           // an ordered stage's next item
+  SEQ_PIPE_SLOT *early;    // items of an ordered stage that came too soon
+  uint64_t items;
+  long max_depth;
+  uint64_t wait_in_ns;
+  uint64_t wait_out_ns;
+  uint64_t busy_ns;
+  struct seq_pipe *pipe;
+  pthread_t thread[SEQ_PIPE_THREADS];
+  int n_thread;
+} SEQ_STAGE;
+
+typedef struct seq_pipe
+{
+  SEQ_STAGE stage[SEQ_PIPE_STAGES];
+  int n_stage;
+  long depth;
+  uint64_t window;         // items between the source and an ordered stage
+  uint64_t order;          // items put so far
+  uint64_t mark;           // when the source last put an item
+  int started;
+  int failed;
+  void (*drop)( void *item );   // frees items left when the pipeline fails
+} SEQ_PIPE;
+
+// a pipeline of rings of depth items (rounded up to a power of two), whose
+//  source is fed by seq_pipe_put; drop frees items it cannot hand on
+SEQ_PIPE *seq_pipe_new( const char *source, long depth, void (*drop)( void *item ) );
+void seq_pipe_free( SEQ_PIPE *p );
+
+// adds a stage of threads (1 when ordered) after the last; returns 0 when
+//  out of memory or out of room
+int seq_pipe_add( SEQ_PIPE *p, const char *name, seq_stage_fn fn, void *ctx, int threads,
+    int ordered );
+
+// starts the stages; returns 0 when a thread cannot be started
+int seq_pipe_start( SEQ_PIPE *p );
+
+// hands item to the first stage, waiting for room; returns 0 (and drops
+//  item) once the pipeline has failed
+int seq_pipe_put( SEQ_PIPE *p, void *item );
+
+// no more items: waits for the stages to finish them; returns 1 when all
+//  went through, 0 when the pipeline failed
+int seq_pipe_finish( SEQ_PIPE *p );
+
+// stops the pipeline, from a stage or the source
+void seq_pipe_fail( SEQ_PIPE *p );
+
+// the counters of stage i, 0 being the source
+void seq_pipe_stats( SEQ_PIPE *p, int i, SEQ_PIPE_STATS *stats );
+
+// logs a line of counters per stage
+void seq_pipe_report( SEQ_PIPE *p );
+
+#endif
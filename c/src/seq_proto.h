@@ -0,0 +1,92 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_proto.h
+ * Description: Wire format of genome_server, the index-serving daemon. All
+ *  integers are little-endian and structures are packed; a client sends a
+ *  request header followed by its records and reads back a response header
+ *  followed by its records (or payload). A connection may carry any number
+ *  of requests, and may send them in pieces: the server buffers each
+ *  connection until a request has arrived in full.
+ *
+ *  SEQ_OP_INFO    request: header only (n = 0)
+ *                 response: payload of n bytes, one line per assembly:
+ *                   "<assembly id>\t<name>\t<score,names,..>\t<has cadd 0|1>\n"
+ *  SEQ_OP_LOOKUP  request: n SEQ_WIRE_SITE records
+ *                 response: n records of record_size bytes: a SEQ_WIRE_RESULT
+ *                   followed by one float per requested score track (ascending
+ *                   track id) and, when SEQ_TRACK_BIT_CADD is requested, one
+ *                   float for the cadd score of ref -> alt, and, when
+ *                   SEQ_TRACK_BIT_CADD_ALL is, the three cadd tracks' scores
+ *                   in the order of Seq::Annotate::_build_cadd_lookup. NAN
+ *                   means 'NA'.
+ */
+
+#ifndef __seq_proto_h__
+#define __seq_proto_h__
+
+#include <stdint.h>
+
+#define SEQ_PROTO_MAGIC_REQ  0x51514553u  // "SEQQ"
+#define SEQ_PROTO_MAGIC_RESP 0x52514553u  // "SEQR"
+#define SEQ_PROTO_VERSION 1
+
+#define SEQ_OP_INFO   1
+#define SEQ_OP_LOOKUP 2
+
+#define SEQ_STATUS_OK          0
+#define SEQ_STATUS_BAD_REQUEST 1
+#define SEQ_STATUS_NO_ASSEMBLY 2
+#define SEQ_STATUS_TOO_LARGE   3
+#define SEQ_STATUS_ERROR       4
+
+#define SEQ_TRACK_BIT_CADD     (1u << 31)
+#define SEQ_TRACK_BIT_CADD_ALL (1u << 30)
+#define SEQ_PROTO_MAX_SCORE_BITS 30      // bits 0..29 select score tracks
+
+#define SEQ_PROTO_MAX_SITES (1 << 20)  // per request
+
+typedef struct __attribute__((packed)) seq_wire_request
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t op;
+  uint16_t assembly;
+  uint16_t reserved;
+  uint32_t tracks;         // bitmask of score tracks, plus SEQ_TRACK_BIT_CADD(_ALL)
+  uint32_t n;              // number of SEQ_WIRE_SITE records that follow
+} SEQ_WIRE_REQUEST;
+
+typedef struct __attribute__((packed)) seq_wire_site
+{
+  int64_t abs_pos;         // zero-indexed absolute position
+  char ref;
+  char alt;                // only used for cadd
+  uint8_t reserved[6];
+} SEQ_WIRE_SITE;
+
+typedef struct __attribute__((packed)) seq_wire_response
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t status;
+  uint32_t n;              // records, or payload bytes for SEQ_OP_INFO
+  uint32_t record_size;    // bytes per record
+} SEQ_WIRE_RESPONSE;
+
+typedef struct __attribute__((packed)) seq_wire_result
+{
+  int64_t abs_pos;
+  int32_t nearest_gene;    // -1 without an ngene track
+  int16_t site_code;       // -1 when the position is outside the genome
+  char base;               // decoded reference base, 0 if invalid
+  uint8_t flags;           // the SEQ_SITE_* feature bits of the site code
+} SEQ_WIRE_RESULT;
+
+#endif
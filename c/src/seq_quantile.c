@@ -0,0 +1,144 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_quantile.c
+ * Description: Quantiles by selection; see seq_quantile.h
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "seq_quantile.h"
+
+#define SMALL 16                   // ranges sorted outright
+
+static void insertion_sort( double *v, long lo, long hi )
+{
+  for(long i = lo + 1; i < hi; i++)
+  {
+    double x = v[i];
+    long j = i;
+    for(; j > lo && v[j - 1] > x; j--)
+      v[j] = v[j - 1];
+    v[j] = x;
+  }
+}
+
+static double median3( double a, double b, double c )
+{
+  if(a < b)
+    return b < c ? b : (a < c ? c : a);
+  return a < c ? a : (b < c ? c : b);
+}
+
+// puts the values of ranks[0..n_rank) (ascending, all in [lo, hi)) in place
+static void select_ranks( double *v, long lo, long hi, const long *ranks, int n_rank )
+{
+  while(n_rank && hi - lo > SMALL)
+  {
+    double pivot = median3(v[lo], v[lo + (hi - lo) / 2], v[hi - 1]);
+
+    // [lo, lt) below the pivot, [lt, i) equal, (gt, hi) above
+    long lt = lo, i = lo, gt = hi - 1;
+    while(i <= gt)
+    {
+      double x = v[i];
+      if(x < pivot)
+      {
+        v[i++] = v[lt];
+        v[lt++] = x;
+      }
+      else if(x > pivot)
+      {
+        v[i] = v[gt];
+        v[gt--] = x;
+      }
+      else
+        i++;
+    }
+
+    // the ranks below lt and above gt are still to settle; go on with the
+    //  side that has more of them and recurse into the other
+    int below = 0, above = 0;
+    while(below < n_rank && ranks[below] < lt)
+      below++;
+    while(above < n_rank - below && ranks[n_rank - 1 - above] > gt)
+      above++;
+    if(below >= above)
+    {
+      select_ranks(v, gt + 1, hi, ranks + n_rank - above, above);
+      hi = lt;
+      n_rank = below;
+    }
+    else
+    {
+      select_ranks(v, lo, lt, ranks, below);
+      lo = gt + 1;
+      ranks += n_rank - above;
+      n_rank = above;
+    }
+  }
+  if(n_rank)
+    insertion_sort(v, lo, hi);
+}
+
+static int cmp_long( const void *a, const void *b )
+{
+  long x = *(const long *)a, y = *(const long *)b;
+  return (x > y) - (x < y);
+}
+
+int seq_quantiles( double *vals, long n, const double *th, int n_th, double *q )
+{
+  long ranks[SEQ_QUANTILE_MAX * 2];
+  int n_rank = 0;
+
+  if(n_th > SEQ_QUANTILE_MAX)
+    return 0;
+  if(n == 0)
+  {
+    for(int i = 0; i < n_th; i++)
+      q[i] = NAN;
+    return 1;
+  }
+
+  for(int i = 0; i < n_th; i++)
+  {
+    double at = (n - 1) * th[i];
+    ranks[n_rank++] = (long)floor(at);
+    ranks[n_rank++] = (long)ceil(at);
+  }
+  qsort(ranks, n_rank, sizeof(long), cmp_long);
+  int n_unique = 0;
+  for(int i = 0; i < n_rank; i++)
+    if(!n_unique || ranks[i] != ranks[n_unique - 1])
+      ranks[n_unique++] = ranks[i];
+  select_ranks(vals, 0, n, ranks, n_unique);
+
+  // the same arithmetic as _calcPercentile, so the same doubles come out
+  for(int i = 0; i < n_th; i++)
+  {
+    double at = (n - 1) * th[i];
+    long lo = (long)floor(at), hi = (long)ceil(at);
+    if(lo == hi)
+      q[i] = vals[hi];
+    else
+      q[i] = vals[lo] * (hi - at) + vals[hi] * (at - lo);
+  }
+  return 1;
+}
+
+long seq_quantile_outside( const double *vals, long n, double lower, double upper,
+    long *out )
+{
+  long n_out = 0;
+  for(long i = 0; i < n; i++)
+    if(vals[i] < lower || vals[i] > upper)
+      out[n_out++] = i;
+  return n_out;
+}
@@ -0,0 +1,38 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_quantile.h
+ * Description: Quantiles of the per-sample ratios, and the samples outside
+ *  them, for Seq::Statistics::Percentiles.
+ *
+ *  The quantile at fraction t of n values is the value at rank (n - 1) * t
+ *  in ascending order, interpolated between the ranks either side when that
+ *  is not whole, as Seq::Statistics::Percentiles::_calcPercentile has it.
+ *  Only those ranks are put in place, by selection (quickselect, with a
+ *  three-way partition since ratios repeat a lot), rather than sorting all
+ *  the values: each partition settles every rank asked for on one side of
+ *  it, so a handful of quantiles costs a few passes over the values.
+ */
+
+#ifndef __seq_quantile_h__
+#define __seq_quantile_h__
+
+#define SEQ_QUANTILE_MAX 64        // quantiles asked for at once
+
+// the quantiles at the n_th fractions th (in [0, 1], any order) of the n
+//  vals, in q; vals are reordered. With no vals the quantiles are NAN.
+//  Returns 0 when n_th is over SEQ_QUANTILE_MAX.
+int seq_quantiles( double *vals, long n, const double *th, int n_th, double *q );
+
+// the indices of the n vals below lower or above upper, in out (room for
+//  n); returns how many
+long seq_quantile_outside( const double *vals, long n, double lower, double upper,
+    long *out );
+
+#endif
@@ -0,0 +1,511 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_server.c
+ * Description: Index-serving daemon; see seq_server.h and seq_proto.h. The
+ *  wire format is little-endian, which is also the host order on every
+ *  machine we run on, so records are copied as-is.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_server.h"
+#include "seq_proto.h"
+#include "seq_sitecode.h"
+#include "seq_buf.h"
+
+#define MAX_EVENTS 64
+#define QUEUE_SIZE 1024
+
+// a connection and what it has sent of its next request
+typedef struct seq_client
+{
+  int fd;
+  SEQ_BUF in;
+} SEQ_CLIENT;
+
+// ready clients waiting for a worker
+typedef struct client_queue
+{
+  SEQ_CLIENT *client[QUEUE_SIZE];
+  int head;
+  int n;
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+} CLIENT_QUEUE;
+
+typedef struct server_ctx
+{
+  SEQ_SERVER *server;
+  int epfd;
+  CLIENT_QUEUE queue;
+} SERVER_CTX;
+
+SEQ_SERVER *seq_server_new( const char *socket_path, int threads )
+{
+  SEQ_SERVER *server = NULL;
+
+  check( (strlen(socket_path) < sizeof(server->socket_path)),
+      "Socket path too long '%s'.", socket_path );
+  check( (threads >= 1 && threads <= 256), "Impossible number of threads %d.", threads );
+  server = (SEQ_SERVER *)calloc(1, sizeof(SEQ_SERVER));
+  check_mem(server);
+  strcpy(server->socket_path, socket_path);
+  server->threads = threads;
+  return server;
+
+error:
+  return NULL;
+}
+
+void seq_server_free( SEQ_SERVER *server )
+{
+  if(!server)
+    return;
+  for(int i = 0; i < server->n_assembly; i++)
+    seq_genome_free(server->assembly[i]);
+  free(server);
+}
+
+int seq_server_load_manifest( SEQ_SERVER *server, const char *manifest )
+{
+  FILE *fh = NULL;
+  char sss[8192];
+  SEQ_GENOME *genome = NULL;
+  int lineNo = 0;
+
+  check( ((fh = fopen(manifest, "r")) != (FILE *)NULL),
+      "Cannot open manifest '%s' for reading.", manifest );
+
+  while(fgets(sss, sizeof(sss), fh))
+  {
+    lineNo++;
+    char *hash = strchr(sss, '#');
+    if(hash)
+      *hash = '\0';
+    char *key = strtok(sss, " \t\n");
+    if(!key)
+      continue;
+    char *arg[5] = { NULL };
+    int nArg = 0;
+    while(nArg < 5 && (arg[nArg] = strtok(NULL, " \t\n")))
+      nArg++;
+
+    if(strcmp(key, "assembly") == 0)
+    {
+      check( (nArg == 1), "%s:%d: expected 'assembly <name>'.", manifest, lineNo );
+      check( (server->n_assembly < SEQ_MAX_ASSEMBLIES), "At most %d assemblies.",
+          SEQ_MAX_ASSEMBLIES );
+      check( (strlen(arg[0]) < SEQ_MAX_NAME), "Assembly name too long '%s'.", arg[0] );
+      genome = seq_genome_new();
+      check( (genome != NULL), "Out of memory." );
+      strcpy(server->name[server->n_assembly], arg[0]);
+      server->assembly[server->n_assembly++] = genome;
+      continue;
+    }
+
+    check( (genome != NULL), "%s:%d: '%s' before any 'assembly'.", manifest, lineNo, key );
+    int err = 0;
+    if(strcmp(key, "chr") == 0 && nArg == 1)
+      err = seq_genome_read_offsets(genome, arg[0]);
+    else if(strcmp(key, "genome") == 0 && nArg == 1)
+      err = seq_genome_add_genome(genome, arg[0]);
+    else if(strcmp(key, "ngene") == 0 && nArg == 1)
+      err = seq_genome_add_ngene(genome, arg[0]);
+    else if(strcmp(key, "score") == 0 && (nArg == 4 || nArg == 5))
+      err = seq_genome_add_score(genome, arg[0], arg[1], atof(arg[2]), atof(arg[3]),
+          nArg == 5 ? atoi(arg[4]) : 255);
+    // cadd ranges default to Seq::Config::GenomeSizedTrack::BUILDARGS
+    else if(strcmp(key, "cadd") == 0 && nArg == 1)
+      err = seq_genome_add_cadd(genome, arg[0], 0, 127, 255);
+    else if(strcmp(key, "cadd") == 0 && nArg == 4)
+      err = seq_genome_add_cadd(genome, arg[0], atof(arg[1]), atof(arg[2]), atoi(arg[3]));
+    else
+      sentinel("%s:%d: cannot understand '%s'.", manifest, lineNo, key);
+    check( (err == 0), "%s:%d: cannot load '%s'.", manifest, lineNo, key );
+  }
+  fclose(fh);
+  fh = NULL;
+
+  check( (server->n_assembly > 0), "No assemblies in '%s'.", manifest );
+  for(int i = 0; i < server->n_assembly; i++)
+    check( (server->assembly[i]->tracks.genome && server->assembly[i]->n_chrom),
+        "Assembly %s needs a genome and a chr file.", server->name[i] );
+  return 0;
+
+error:
+  if(fh)
+    fclose(fh);
+  return 1;
+}
+
+// a client a worker writes to may stop reading for this long before it is
+//  dropped
+#define WRITE_TIMEOUT_MS 30000
+
+static int write_full( int fd, const void *buf, size_t len )
+{
+  const char *p = (const char *)buf;
+  while(len > 0)
+  {
+    ssize_t put = send(fd, p, len, MSG_NOSIGNAL);
+    if(put < 0 && errno == EINTR)
+      continue;
+    if(put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+      int ready = poll(&pfd, 1, WRITE_TIMEOUT_MS);
+      if(ready < 0 && errno == EINTR)
+        continue;
+      if(ready <= 0)
+        return 1;
+      continue;
+    }
+    if(put <= 0)
+      return 1;
+    p += put;
+    len -= (size_t)put;
+  }
+  return 0;
+}
+
+static int send_status( int fd, int status )
+{
+  SEQ_WIRE_RESPONSE resp = { SEQ_PROTO_MAGIC_RESP, SEQ_PROTO_VERSION, status, 0, 0 };
+  return write_full(fd, &resp, sizeof(resp));
+}
+
+static int serve_info( SEQ_SERVER *server, int fd )
+{
+  SEQ_BUF payload = { 0 };
+  int err = 0;
+
+  for(int i = 0; i < server->n_assembly; i++)
+  {
+    const SEQ_GENOME *genome = server->assembly[i];
+    err |= seq_buf_printf(&payload, "%d\t%s\t", i, server->name[i]);
+    for(int t = 0; t < genome->tracks.n_score; t++)
+      err |= seq_buf_printf(&payload, "%s%s", t ? "," : "", genome->score_name[t]);
+    err |= seq_buf_printf(&payload, "\t%d\n", genome->tracks.has_cadd);
+  }
+
+  SEQ_WIRE_RESPONSE resp = { SEQ_PROTO_MAGIC_RESP, SEQ_PROTO_VERSION,
+    err ? SEQ_STATUS_ERROR : SEQ_STATUS_OK, err ? 0 : (uint32_t)payload.len, 0 };
+  err = write_full(fd, &resp, sizeof(resp));
+  if(!err && resp.n)
+    err = write_full(fd, payload.s, payload.len);
+  seq_buf_free(&payload);
+  return err;
+}
+
+static int serve_lookup( SEQ_SERVER *server, int fd, const SEQ_WIRE_REQUEST *req,
+    const SEQ_WIRE_SITE *site )
+{
+  long *pos = NULL;
+  char *out = NULL;
+  SEQ_BATCH *batch = NULL;
+  int err = 1;
+  const uint32_t n = req->n;
+
+  if(req->assembly >= server->n_assembly)
+    return send_status(fd, SEQ_STATUS_NO_ASSEMBLY);
+
+  const SEQ_GENOME *genome = server->assembly[req->assembly];
+  const SEQ_TRACKS *tracks = &genome->tracks;
+  int scoreIdx[SEQ_MAX_SCORE_TRACKS];
+  int nScore = 0;
+  for(int t = 0; t < tracks->n_score && t < SEQ_PROTO_MAX_SCORE_BITS; t++)
+    if(req->tracks & (1u << t))
+      scoreIdx[nScore++] = t;
+  const int wantCadd = (req->tracks & SEQ_TRACK_BIT_CADD) && tracks->has_cadd;
+  const int nCadd = ((req->tracks & SEQ_TRACK_BIT_CADD_ALL) && tracks->has_cadd) ? 3 : 0;
+  const size_t recordSize = sizeof(SEQ_WIRE_RESULT)
+    + sizeof(float) * (nScore + wantCadd + nCadd);
+
+  SEQ_WIRE_RESPONSE resp = { SEQ_PROTO_MAGIC_RESP, SEQ_PROTO_VERSION, SEQ_STATUS_OK, n,
+    (uint32_t)recordSize };
+  if(n == 0)
+    return write_full(fd, &resp, sizeof(resp));
+
+  pos = (long *)malloc(sizeof(long) * n);
+  out = (char *)malloc(recordSize * n);
+  batch = seq_batch_new(n, tracks->n_score);
+  check_mem(pos && out && batch);
+
+  for(uint32_t i = 0; i < n; i++)
+    pos[i] = (long)site[i].abs_pos;
+  check( (seq_batch_lookup(tracks, pos, n, batch) == 0), "Lookup failed." );
+
+  for(uint32_t i = 0; i < n; i++)
+  {
+    char *rec = out + recordSize * i;
+    SEQ_WIRE_RESULT res;
+    int code = batch->site_code[i];
+    res.abs_pos = site[i].abs_pos;
+    res.site_code = (int16_t)code;
+    res.nearest_gene = batch->nearest_gene[i];
+    res.base = code < 0 ? 0 : seq_site_table[code].base;
+    res.flags = code < 0 ? 0 : (uint8_t)(code & ~SEQ_SITE_BASE_MASK);
+    memcpy(rec, &res, sizeof(res));
+
+    float val[SEQ_MAX_SCORE_TRACKS + 4];
+    int v = 0;
+    for(int s = 0; s < nScore; s++)
+      val[v++] = (float)batch->score[(long)scoreIdx[s] * batch->cap + i];
+    if(wantCadd)
+    {
+      int k = seq_cadd_index(site[i].ref, site[i].alt);
+      val[v++] = k < 0 ? NAN : (float)batch->cadd[(long)k * batch->cap + i];
+    }
+    for(int k = 0; k < nCadd; k++)
+      val[v++] = (float)batch->cadd[(long)k * batch->cap + i];
+    memcpy(rec + sizeof(res), val, sizeof(float) * v);
+  }
+
+  err = write_full(fd, &resp, sizeof(resp)) || write_full(fd, out, recordSize * n);
+
+error:
+  free(pos);
+  free(out);
+  seq_batch_free(batch);
+  return err;
+}
+
+// reads what the client has sent so far, without waiting for more; returns
+//  non-zero on an error or when the client has hung up
+static int read_client( SEQ_CLIENT *client )
+{
+  for(;;)
+  {
+    if(seq_buf_reserve(&client->in, 65536))
+      return 1;
+    ssize_t got = read(client->fd, client->in.s + client->in.len,
+        client->in.cap - client->in.len - 1);
+    if(got < 0 && errno == EINTR)
+      continue;
+    if(got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return 0;
+    if(got <= 0)
+      return 1;
+    client->in.len += (size_t)got;
+  }
+}
+
+// serves each whole request the client has sent and keeps what is left of
+//  the next one; returns non-zero when the client should be dropped
+static int serve_client( SEQ_SERVER *server, SEQ_CLIENT *client )
+{
+  size_t used = 0;
+  int err = 0;
+
+  while(!err && client->in.len - used >= sizeof(SEQ_WIRE_REQUEST))
+  {
+    SEQ_WIRE_REQUEST req;
+    memcpy(&req, client->in.s + used, sizeof(req));
+    if(req.magic != SEQ_PROTO_MAGIC_REQ || req.version != SEQ_PROTO_VERSION
+        || (req.op != SEQ_OP_INFO && req.op != SEQ_OP_LOOKUP))
+    {
+      send_status(client->fd, SEQ_STATUS_BAD_REQUEST);
+      return 1;
+    }
+    // the client would have us buffer too much; there is no reading past it
+    if(req.op == SEQ_OP_LOOKUP && req.n > SEQ_PROTO_MAX_SITES)
+    {
+      send_status(client->fd, SEQ_STATUS_TOO_LARGE);
+      return 1;
+    }
+    size_t frame = sizeof(req)
+      + (req.op == SEQ_OP_LOOKUP ? (size_t)req.n * sizeof(SEQ_WIRE_SITE) : 0);
+    if(client->in.len - used < frame)
+      break;
+
+    const char *body = client->in.s + used + sizeof(req);
+    if(req.op == SEQ_OP_INFO)
+      err = serve_info(server, client->fd);
+    else
+      err = serve_lookup(server, client->fd, &req, (const SEQ_WIRE_SITE *)body);
+    used += frame;
+  }
+
+  memmove(client->in.s, client->in.s + used, client->in.len - used);
+  client->in.len -= used;
+  return err;
+}
+
+static void close_client( SEQ_CLIENT *client )
+{
+  close(client->fd);
+  seq_buf_free(&client->in);
+  free(client);
+}
+
+static void *server_worker( void *arg )
+{
+  SERVER_CTX *ctx = (SERVER_CTX *)arg;
+  CLIENT_QUEUE *q = &ctx->queue;
+
+  for(;;)
+  {
+    pthread_mutex_lock(&q->lock);
+    while(q->n == 0 && !ctx->server->stop)
+      pthread_cond_wait(&q->ready, &q->lock);
+    if(q->n == 0)
+    {
+      pthread_mutex_unlock(&q->lock);
+      break;
+    }
+    SEQ_CLIENT *client = q->client[q->head];
+    q->head = (q->head + 1) % QUEUE_SIZE;
+    q->n--;
+    pthread_mutex_unlock(&q->lock);
+
+    // a hang up still leaves the requests sent before it to serve
+    int hungUp = read_client(client);
+    if(serve_client(ctx->server, client) || hungUp)
+    {
+      close_client(client);
+      continue;
+    }
+    // EPOLLONESHOT: hand the client back to epoll for the rest of its request,
+    //  or its next one
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = client };
+    if(epoll_ctl(ctx->epfd, EPOLL_CTL_MOD, client->fd, &ev) != 0)
+      close_client(client);
+  }
+  return NULL;
+}
+
+static int enqueue_client( CLIENT_QUEUE *q, SEQ_CLIENT *client )
+{
+  pthread_mutex_lock(&q->lock);
+  if(q->n == QUEUE_SIZE)
+  {
+    pthread_mutex_unlock(&q->lock);
+    return 1;
+  }
+  q->client[(q->head + q->n) % QUEUE_SIZE] = client;
+  q->n++;
+  pthread_cond_signal(&q->ready);
+  pthread_mutex_unlock(&q->lock);
+  return 0;
+}
+
+// a new client, non-blocking so that no worker ever waits on it
+static SEQ_CLIENT *accept_client( int listenFd )
+{
+  int fd = accept(listenFd, NULL, NULL);
+  if(fd < 0)
+    return NULL;
+  int flags = fcntl(fd, F_GETFL, 0);
+  SEQ_CLIENT *client = (SEQ_CLIENT *)calloc(1, sizeof(SEQ_CLIENT));
+  if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0 || !client)
+  {
+    free(client);
+    close(fd);
+    return NULL;
+  }
+  client->fd = fd;
+  return client;
+}
+
+int seq_server_run( SEQ_SERVER *server )
+{
+  SERVER_CTX ctx = { .server = server, .epfd = -1 };
+  pthread_t tid[256];
+  int nThreads = 0;
+  int listenFd = -1;
+  int status = 1;
+  struct sockaddr_un addr;
+  struct epoll_event events[MAX_EVENTS];
+
+  pthread_mutex_init(&ctx.queue.lock, NULL);
+  pthread_cond_init(&ctx.queue.ready, NULL);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, server->socket_path);
+  unlink(server->socket_path);
+
+  check( ((listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) != -1), "Cannot create socket." );
+  check( (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) == 0),
+      "Cannot bind '%s'.", server->socket_path );
+  check( (listen(listenFd, 128) == 0), "Cannot listen on '%s'.", server->socket_path );
+  check( ((ctx.epfd = epoll_create1(0)) != -1), "Cannot create epoll instance." );
+
+  // the listening socket is the one without a client
+  struct epoll_event lev = { .events = EPOLLIN, .data.ptr = NULL };
+  check( (epoll_ctl(ctx.epfd, EPOLL_CTL_ADD, listenFd, &lev) == 0), "Cannot watch socket." );
+
+  for(nThreads = 0; nThreads < server->threads; nThreads++)
+    check( (pthread_create(&tid[nThreads], NULL, server_worker, &ctx) == 0),
+        "Cannot start worker thread." );
+
+  log_info("Serving %d assemblies on %s with %d threads.", server->n_assembly,
+      server->socket_path, server->threads);
+
+  while(!server->stop)
+  {
+    // the timeout lets us notice server->stop
+    int n = epoll_wait(ctx.epfd, events, MAX_EVENTS, 500);
+    if(n < 0 && errno == EINTR)
+      continue;
+    check( (n >= 0), "epoll_wait failed." );
+
+    for(int i = 0; i < n; i++)
+    {
+      SEQ_CLIENT *client = (SEQ_CLIENT *)events[i].data.ptr;
+      if(!client)
+      {
+        if(!(client = accept_client(listenFd)))
+          continue;
+        struct epoll_event cev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = client };
+        if(epoll_ctl(ctx.epfd, EPOLL_CTL_ADD, client->fd, &cev) != 0)
+          close_client(client);
+      }
+      else if(events[i].events & (EPOLLHUP | EPOLLERR) && !(events[i].events & EPOLLIN))
+        close_client(client);
+      else if(enqueue_client(&ctx.queue, client))
+      {
+        log_warn("Too many pending clients; dropping one.");
+        close_client(client);
+      }
+    }
+  }
+  status = 0;
+
+error:
+  pthread_mutex_lock(&ctx.queue.lock);
+  server->stop = 1;
+  pthread_cond_broadcast(&ctx.queue.ready);
+  pthread_mutex_unlock(&ctx.queue.lock);
+  for(int i = 0; i < nThreads; i++)
+    pthread_join(tid[i], NULL);
+  if(ctx.epfd != -1)
+    close(ctx.epfd);
+  if(listenFd != -1)
+  {
+    close(listenFd);
+    unlink(server->socket_path);
+  }
+  pthread_mutex_destroy(&ctx.queue.lock);
+  pthread_cond_destroy(&ctx.queue.ready);
+  return status;
+}
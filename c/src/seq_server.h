@@ -0,0 +1,56 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_server.h
+ * Description: A daemon that maps the tracks of one or more assemblies once
+ *  and answers batched lookups over a Unix domain socket (see seq_proto.h).
+ *  An epoll loop watches the listening socket and the clients; each ready
+ *  client is handed to a pool of worker threads (EPOLLONESHOT, so a client is
+ *  only ever served by one worker at a time). Clients are non-blocking: a
+ *  worker takes what has arrived, serves the requests that are whole and
+ *  hands the client back to epoll, so a slow or stalled client never holds a
+ *  worker while it sends; one that stops reading is dropped after a timeout.
+ *
+ *  Assemblies are described in a manifest, one directive per line, '#' for
+ *  comments:
+ *    assembly <name>
+ *    chr      <chr_len.dat file>
+ *    genome   <idx file>
+ *    ngene    <idx file>
+ *    score    <name> <idx file> <min> <max> [R]
+ *    cadd     <idx prefix> [min max R]
+ *  every directive applies to the last 'assembly'.
+ */
+
+#ifndef __seq_server_h__
+#define __seq_server_h__
+
+#include "seq_genome.h"
+
+#define SEQ_MAX_ASSEMBLIES 16
+
+typedef struct seq_server
+{
+  char socket_path[108];   // sizeof(sun_path)
+  int threads;
+  SEQ_GENOME *assembly[SEQ_MAX_ASSEMBLIES];
+  char name[SEQ_MAX_ASSEMBLIES][SEQ_MAX_NAME];
+  int n_assembly;
+  volatile int stop;       // set (e.g., from a signal handler) to shut down
+} SEQ_SERVER;
+
+SEQ_SERVER *seq_server_new( const char *socket_path, int threads );
+void seq_server_free( SEQ_SERVER *server );
+
+int seq_server_load_manifest( SEQ_SERVER *server, const char *manifest );
+
+// serves until server->stop is set; returns 0 on a clean shutdown
+int seq_server_run( SEQ_SERVER *server );
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_sitecode.c
+ * Description: Bulk site code decoding; see seq_sitecode.h. The vector paths
+ *  are compiled with target attributes and chosen at runtime, so the library
+ *  still runs on machines without AVX2.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "seq_sitecode.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEQ_HAVE_X86 1
+#endif
+
+static void decode_scalar( const unsigned char *code, long from, long n, SEQ_SITE_BLOCK *out )
+{
+  for(long i = from; i < n; i++)
+  {
+    unsigned char c = code[i];
+    if(out->base)
+      out->base[i] = seq_site_table[c].base;
+    if(out->in_gan)
+      out->in_gan[i] = seq_site_table[c].in_gan;
+    if(out->in_exon)
+      out->in_exon[i] = seq_site_table[c].in_exon;
+    if(out->in_gene)
+      out->in_gene[i] = seq_site_table[c].in_gene;
+    if(out->in_snp)
+      out->in_snp[i] = seq_site_table[c].in_snp;
+  }
+}
+
+static long count_scalar( const unsigned char *code, long from, long n, unsigned char mask )
+{
+  long count = 0;
+  for(long i = from; i < n; i++)
+    count += ((code[i] & mask) == mask);
+  return count;
+}
+
+#ifdef SEQ_HAVE_X86
+
+// flag bytes are 0/1, so (code >> shift) & 1 gives them directly
+__attribute__((target("avx2")))
+static long decode_avx2( const unsigned char *code, long n, SEQ_SITE_BLOCK *out )
+{
+  const __m256i base_lu = _mm256_setr_epi8(
+      'N', 'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      'N', 'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+  const __m256i low3 = _mm256_set1_epi8(SEQ_SITE_BASE_MASK);
+  const __m256i one  = _mm256_set1_epi8(1);
+  long i = 0;
+
+  for(; i + 32 <= n; i += 32)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(code + i));
+    if(out->base)
+      _mm256_storeu_si256((__m256i *)(out->base + i),
+          _mm256_shuffle_epi8(base_lu, _mm256_and_si256(c, low3)));
+    // there is no 8-bit shift; 16-bit shifts are fine since we mask to bit 0
+    if(out->in_gan)
+      _mm256_storeu_si256((__m256i *)(out->in_gan + i),
+          _mm256_and_si256(_mm256_srli_epi16(c, 3), one));
+    if(out->in_exon)
+      _mm256_storeu_si256((__m256i *)(out->in_exon + i),
+          _mm256_and_si256(_mm256_srli_epi16(c, 4), one));
+    if(out->in_gene)
+      _mm256_storeu_si256((__m256i *)(out->in_gene + i),
+          _mm256_and_si256(_mm256_srli_epi16(c, 5), one));
+    if(out->in_snp)
+      _mm256_storeu_si256((__m256i *)(out->in_snp + i),
+          _mm256_and_si256(_mm256_srli_epi16(c, 6), one));
+  }
+  return i;
+}
+
+__attribute__((target("ssse3")))
+static long decode_ssse3( const unsigned char *code, long n, SEQ_SITE_BLOCK *out )
+{
+  const __m128i base_lu = _mm_setr_epi8(
+      'N', 'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+  const __m128i low3 = _mm_set1_epi8(SEQ_SITE_BASE_MASK);
+  const __m128i one  = _mm_set1_epi8(1);
+  long i = 0;
+
+  for(; i + 16 <= n; i += 16)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i *)(code + i));
+    if(out->base)
+      _mm_storeu_si128((__m128i *)(out->base + i),
+          _mm_shuffle_epi8(base_lu, _mm_and_si128(c, low3)));
+    if(out->in_gan)
+      _mm_storeu_si128((__m128i *)(out->in_gan + i), _mm_and_si128(_mm_srli_epi16(c, 3), one));
+    if(out->in_exon)
+      _mm_storeu_si128((__m128i *)(out->in_exon + i), _mm_and_si128(_mm_srli_epi16(c, 4), one));
+    if(out->in_gene)
+      _mm_storeu_si128((__m128i *)(out->in_gene + i), _mm_and_si128(_mm_srli_epi16(c, 5), one));
+    if(out->in_snp)
+      _mm_storeu_si128((__m128i *)(out->in_snp + i), _mm_and_si128(_mm_srli_epi16(c, 6), one));
+  }
+  return i;
+}
+
+__attribute__((target("avx2,popcnt")))
+static long count_avx2( const unsigned char *code, long n, unsigned char mask, long *done )
+{
+  const __m256i m = _mm256_set1_epi8((char)mask);
+  long count = 0;
+  long i = 0;
+
+  for(; i + 32 <= n; i += 32)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(code + i));
+    __m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(c, m), m);
+    count += __builtin_popcount((unsigned int)_mm256_movemask_epi8(hit));
+  }
+  *done = i;
+  return count;
+}
+
+__attribute__((target("sse2,popcnt")))
+static long count_sse2( const unsigned char *code, long n, unsigned char mask, long *done )
+{
+  const __m128i m = _mm_set1_epi8((char)mask);
+  long count = 0;
+  long i = 0;
+
+  for(; i + 16 <= n; i += 16)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i *)(code + i));
+    __m128i hit = _mm_cmpeq_epi8(_mm_and_si128(c, m), m);
+    count += __builtin_popcount((unsigned int)_mm_movemask_epi8(hit));
+  }
+  *done = i;
+  return count;
+}
+
+#endif
+
+void seq_site_decode_block( const unsigned char *code, long n, SEQ_SITE_BLOCK *out )
+{
+  long done = 0;
+
+#ifdef SEQ_HAVE_X86
+  if(__builtin_cpu_supports("avx2"))
+    done = decode_avx2(code, n, out);
+  else if(__builtin_cpu_supports("ssse3"))
+    done = decode_ssse3(code, n, out);
+#endif
+
+  decode_scalar(code, done, n, out);
+}
+
+long seq_site_count( const unsigned char *code, long n, unsigned char mask )
+{
+  long done = 0;
+  long count = 0;
+
+#ifdef SEQ_HAVE_X86
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    count = count_avx2(code, n, mask, &done);
+  else if(__builtin_cpu_supports("popcnt"))
+    count = count_sse2(code, n, mask, &done);
+#endif
+
+  return count + count_scalar(code, done, n, mask);
+}
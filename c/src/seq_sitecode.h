@@ -0,0 +1,90 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_sitecode.h
+ * Description: Decoding of the genome track site code. Each position of the
+ *  genome track is one byte: the base (0..4 for N,A,C,G,T, see the char_mask
+ *  of genome_hasher.c) plus the feature bits set by genome_hasher. This is
+ *  the same scheme Seq::Config::GenomeSizedTrack decodes into @idx_base,
+ *  @idx_in_gan, etc. at load time; here the 256-entry tables are built at
+ *  compile time and a block of codes can be decoded at once (AVX2 / SSSE3
+ *  when the CPU has them).
+ */
+
+#ifndef __seq_sitecode_h__
+#define __seq_sitecode_h__
+
+#include <stdint.h>
+
+#define SEQ_SITE_BASE_MASK 7
+#define SEQ_SITE_GAN  8    // annotated gene site (a record exists in the gene db)
+#define SEQ_SITE_EXON 16
+#define SEQ_SITE_GENE 32   // within a transcript's boundaries
+#define SEQ_SITE_SNP  64
+
+/*
+ * Decoded site code; base is 0 for the impossible base codes 5..7, which
+ * Seq::Config::GenomeSizedTrack leaves undefined.
+ */
+typedef struct seq_site
+{
+  char base;
+  unsigned int in_gan  : 1;
+  unsigned int in_exon : 1;
+  unsigned int in_gene : 1;
+  unsigned int in_snp  : 1;
+} SEQ_SITE;
+
+#define SEQ_SITE_BASE(c) \
+  ( ((c) & 7) == 0 ? 'N' : ((c) & 7) == 1 ? 'A' : ((c) & 7) == 2 ? 'C' : \
+    ((c) & 7) == 3 ? 'G' : ((c) & 7) == 4 ? 'T' : 0 )
+
+#define SEQ_SITE_DECODE(c) \
+  { SEQ_SITE_BASE(c), !!((c) & SEQ_SITE_GAN), !!((c) & SEQ_SITE_EXON), \
+    !!((c) & SEQ_SITE_GENE), !!((c) & SEQ_SITE_SNP) }
+
+#define SEQ_SITE_DECODE4(c) \
+  SEQ_SITE_DECODE(c), SEQ_SITE_DECODE(c + 1), SEQ_SITE_DECODE(c + 2), SEQ_SITE_DECODE(c + 3)
+#define SEQ_SITE_DECODE16(c) \
+  SEQ_SITE_DECODE4(c), SEQ_SITE_DECODE4(c + 4), SEQ_SITE_DECODE4(c + 8), SEQ_SITE_DECODE4(c + 12)
+#define SEQ_SITE_DECODE64(c) \
+  SEQ_SITE_DECODE16(c), SEQ_SITE_DECODE16(c + 16), SEQ_SITE_DECODE16(c + 32), \
+  SEQ_SITE_DECODE16(c + 48)
+
+static const SEQ_SITE seq_site_table[256] = {
+  SEQ_SITE_DECODE64(0), SEQ_SITE_DECODE64(64), SEQ_SITE_DECODE64(128), SEQ_SITE_DECODE64(192)
+};
+
+static inline SEQ_SITE seq_site_decode( unsigned char code )
+{
+  return seq_site_table[code];
+}
+
+/*
+ * Bulk decode of n site codes into a base array and one 0/1 array per
+ * feature; any output may be NULL if it isn't wanted.
+ */
+typedef struct seq_site_block
+{
+  char *base;
+  unsigned char *in_gan;
+  unsigned char *in_exon;
+  unsigned char *in_gene;
+  unsigned char *in_snp;
+} SEQ_SITE_BLOCK;
+
+void seq_site_decode_block( const unsigned char *code, long n, SEQ_SITE_BLOCK *out );
+
+/*
+ * Number of codes with every bit of mask set, e.g., the exonic snp sites in
+ * a region are seq_site_count( code + start, len, SEQ_SITE_EXON | SEQ_SITE_SNP ).
+ */
+long seq_site_count( const unsigned char *code, long n, unsigned char mask );
+
+#endif
@@ -0,0 +1,412 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_snpbuild.c
+ * Description: Native snp track build; see seq_snpbuild.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_snpbuild.h"
+#include "seq_snpdb.h"
+
+#define MAX_LINE (1 << 20)
+#define MAX_COLS 256
+#define NULL_FIELD "\\N"
+
+typedef struct build_pool
+{
+  const SEQ_SNP_BUILD *build;
+  const char **in_file;
+  int n_in;
+  char spill_dir[4096];
+  int next;
+  int *status;             // per input file (pass 1) or chromosome (pass 2)
+} BUILD_POOL;
+
+static void spill_path( char *path, size_t size, const BUILD_POOL *pool, int file, int chrom )
+{
+  snprintf(path, size, "%s/%d.%d", pool->spill_dir, file, chrom);
+}
+
+static int split_tabs( char *line, char **field, int max )
+{
+  int n = 0;
+  field[n++] = line;
+  for(char *p = line; *p; p++)
+  {
+    if(*p == '\t')
+    {
+      *p = '\0';
+      if(n == max)
+        return -1;
+      field[n++] = p + 1;
+    }
+  }
+  return n;
+}
+
+static int column( char **field, int n, const char *name )
+{
+  for(int i = 0; i < n; i++)
+    if(strcmp(field[i], name) == 0)
+      return i;
+  return -1;
+}
+
+/*
+ * The minor allele frequency the way Seq::Build::SnpTrack computes it; only
+ * for bi-allelic records
+ */
+static int write_maf( FILE *fh, const char *count, const char *freqs )
+{
+  if(!count || !freqs || atoi(count) != 2)
+    return fputs(NULL_FIELD, fh) < 0;
+
+  double max = 0;
+  int any = 0;
+  for(const char *p = freqs; *p; )
+  {
+    char *end;
+    double f = strtod(p, &end);
+    if(end == p)
+      break;
+    if(!any || f > max)
+      max = f;
+    any = 1;
+    p = (*end == ',') ? end + 1 : end;
+  }
+  if(!any)
+    return fputs(NULL_FIELD, fh) < 0;
+  return fprintf(fh, "%0.6f", 1 - max) < 0;
+}
+
+// pass 1: one input file into spill files by chromosome
+static int spill_file( BUILD_POOL *pool, int f )
+{
+  const SEQ_SNP_BUILD *build = pool->build;
+  const SEQ_GENOME *genome = build->genome;
+  const char *in_file = pool->in_file[f];
+  gzFile in = NULL;
+  FILE **spill = NULL;
+  char *line = NULL;
+  char *field[MAX_COLS];
+  int want[4 + SEQ_SNPDB_MAX_FEATURES];
+  int countCol = -1, freqsCol = -1, maxCol = 0;
+  long nLine = 0, nSkip = 0;
+  int status = 1;
+
+  line = (char *)malloc(MAX_LINE);
+  spill = (FILE **)calloc(genome->n_chrom, sizeof(FILE *));
+  check_mem(line && spill);
+  check( ((in = gzopen(in_file, "r")) != NULL), "Cannot open '%s' for reading.", in_file );
+  gzbuffer(in, 1 << 20);
+
+  // header; the same columns Seq::Build::SnpTrack checks for
+  check( (gzgets(in, line, MAX_LINE) != NULL), "'%s' is empty.", in_file );
+  line[strcspn(line, "\r\n")] = '\0';
+  int nHead = split_tabs(line, field, MAX_COLS);
+  check( (nHead > 0), "Too many columns in the header of '%s'.", in_file );
+  const char *required[4] = { "chrom", "chromStart", "chromEnd", "name" };
+  for(int i = 0; i < 4 + build->n_feature; i++)
+  {
+    const char *name = i < 4 ? required[i] : build->feature[i - 4];
+    want[i] = column(field, nHead, name);
+    check( (want[i] >= 0), "Missing expected header '%s' in '%s'.", name, in_file );
+    if(want[i] > maxCol)
+      maxCol = want[i];
+  }
+  countCol = column(field, nHead, "alleleFreqCount");
+  freqsCol = column(field, nHead, "alleleFreqs");
+
+  const SEQ_CHROM *chrom = NULL;
+  while(gzgets(in, line, MAX_LINE))
+  {
+    size_t len = strlen(line);
+    check( (len < MAX_LINE - 1 || line[len - 1] == '\n'), "Line %ld of '%s' is too long.",
+        nLine + 2, in_file );
+    line[strcspn(line, "\r\n")] = '\0';
+    nLine++;
+
+    int n = split_tabs(line, field, MAX_COLS);
+    if(n <= maxCol)
+    {
+      nSkip++;
+      continue;
+    }
+    // unknown chromosomes are skipped, as Seq::Build::SnpTrack only asks for
+    //  the chromosomes of the assembly
+    if(!chrom || strcmp(chrom->name, field[want[0]]) != 0)
+      chrom = seq_genome_chrom(genome, field[want[0]]);
+    if(!chrom)
+      continue;
+
+    FILE *fh = spill[chrom->index];
+    if(!fh)
+    {
+      char path[4200];
+      spill_path(path, sizeof(path), pool, f, chrom->index);
+      check( ((fh = spill[chrom->index] = fopen(path, "w")) != NULL),
+          "Cannot write spill file '%s'.", path );
+    }
+
+    int err = fprintf(fh, "%s\t%s\t%s\t", field[want[1]], field[want[2]], field[want[3]]) < 0;
+    err |= write_maf(fh, countCol >= 0 && countCol < n ? field[countCol] : NULL,
+        freqsCol >= 0 && freqsCol < n ? field[freqsCol] : NULL);
+    for(int k = 0; k < build->n_feature; k++)
+      err |= fprintf(fh, "\t%s", field[want[4 + k]]) < 0;
+    err |= fputc('\n', fh) == EOF;
+    check( (err == 0), "Cannot write spill file for %s.", chrom->name );
+  }
+  int gzErr;
+  gzerror(in, &gzErr);
+  check( (gzErr == Z_OK || gzErr == Z_STREAM_END), "Error reading '%s'.", in_file );
+
+  if(nSkip)
+    log_warn("Skipped %ld short lines in '%s'.", nSkip, in_file);
+  log_info("Read %ld records from '%s'.", nLine, in_file);
+  status = 0;
+
+error:
+  if(in)
+    gzclose(in);
+  if(spill)
+  {
+    for(int i = 0; i < genome->n_chrom; i++)
+      if(spill[i] && fclose(spill[i]) != 0)
+        status = 1;
+    free(spill);
+  }
+  free(line);
+  return status;
+}
+
+static int compare_u32( const void *a, const void *b )
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// site ranges in the format genome_hasher reads
+static int write_ranges( const char *path, int in_snp, uint32_t *pos, long n )
+{
+  FILE *fh = NULL;
+  int err = 0;
+
+  qsort(pos, n, sizeof(uint32_t), compare_u32);
+  check( ((fh = fopen(path, "w")) != NULL), "Cannot open '%s' for writing.", path );
+  err |= fprintf(fh, "%d\n", in_snp) < 0;
+  for(long i = 0; i < n; )
+  {
+    long j = i;
+    while(j + 1 < n && pos[j + 1] <= pos[j] + 1)
+      j++;
+    err |= fprintf(fh, "%u\t%u\n", pos[i], pos[j]) < 0;
+    i = j + 1;
+  }
+  // a trailing blank line, like Seq::Build::SnpTrack writes
+  err |= fputc('\n', fh) == EOF;
+  err |= fclose(fh) != 0;
+  check( (err == 0), "Cannot write '%s'.", path );
+  return 0;
+
+error:
+  return 1;
+}
+
+// pass 2: one chromosome from its spill files
+static int build_chrom( BUILD_POOL *pool, int c )
+{
+  const SEQ_SNP_BUILD *build = pool->build;
+  const SEQ_CHROM *chrom = &build->genome->chrom[c];
+  SEQ_SNPDB_WRITER *w = NULL;
+  FILE *fh = NULL;
+  char *line = NULL;
+  size_t cap = 0;
+  uint32_t *pos = NULL;
+  const char *name[SEQ_SNPDB_MAX_FEATURES];
+  const char *value[SEQ_SNPDB_MAX_FEATURES];
+  char *field[4 + SEQ_SNPDB_MAX_FEATURES];
+  char path[4200];
+  long nWide = 0, nOff = 0;
+  int status = 1;
+  const int nField = 4 + build->n_feature;
+
+  for(int k = 0; k < build->n_feature; k++)
+    name[k] = build->feature[k];
+  name[build->n_feature] = "maf";
+  w = seq_snpdb_writer_new(name, build->n_feature + 1);
+  check( (w != NULL), "Cannot create snp store writer." );
+
+  for(int f = 0; f < pool->n_in; f++)
+  {
+    spill_path(path, sizeof(path), pool, f, c);
+    if(!(fh = fopen(path, "r")))
+      continue;
+
+    ssize_t len;
+    while((len = getline(&line, &cap, fh)) > 0)
+    {
+      if(line[len - 1] == '\n')
+        line[len - 1] = '\0';
+      check( (split_tabs(line, field, nField) == nField), "Corrupt spill file '%s'.", path );
+      long start = atol(field[0]);
+      long end = atol(field[1]);
+      for(int k = 0; k < build->n_feature; k++)
+        value[k] = field[4 + k];
+      value[build->n_feature] = strcmp(field[3], NULL_FIELD) == 0 ? NULL : field[3];
+      if(end - start > 100)
+        nWide++;
+
+      for(long p = start + 1; p <= end; p++)
+      {
+        long abs_pos = seq_genome_abs_pos(chrom, p);
+        if(abs_pos < 0)
+        {
+          nOff++;
+          continue;
+        }
+        char ref = abs_pos < build->genome_str->length ? build->genome_str->data[abs_pos] : 'N';
+        check( (seq_snpdb_writer_add(w, abs_pos, field[2], ref, value) == 0),
+            "Cannot add %s to the %s snp store.", field[2], chrom->name );
+      }
+    }
+    fclose(fh);
+    fh = NULL;
+    unlink(path);
+  }
+
+  if(nWide)
+    log_info("%s: %ld records cover more than 100 sites.", chrom->name, nWide);
+  if(nOff)
+    log_warn("%s: %ld sites are off the end of the chromosome.", chrom->name, nOff);
+
+  pos = (uint32_t *)malloc(sizeof(uint32_t) * (w->n ? w->n : 1));
+  check_mem(pos);
+  memcpy(pos, w->pos, sizeof(uint32_t) * w->n);
+  snprintf(path, sizeof(path), "%s/%s.snp.%s.dat", build->out_dir, build->name, chrom->name);
+  check( (write_ranges(path, build->in_snp, pos, w->n) == 0), "Cannot write site ranges." );
+  snprintf(path, sizeof(path), "%s/%s.snp.%s.sdb", build->out_dir, build->name, chrom->name);
+  check( (seq_snpdb_writer_write(w, path) == 0), "Cannot write snp store." );
+  log_info("%s: wrote %ld snp sites.", chrom->name, w->n);
+  status = 0;
+
+error:
+  if(fh)
+    fclose(fh);
+  free(line);
+  free(pos);
+  seq_snpdb_writer_free(w);
+  return status;
+}
+
+static void *spill_worker( void *arg )
+{
+  BUILD_POOL *pool = (BUILD_POOL *)arg;
+  for(;;)
+  {
+    int i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    if(i >= pool->n_in)
+      break;
+    pool->status[i] = spill_file(pool, i);
+  }
+  return NULL;
+}
+
+static void *chrom_worker( void *arg )
+{
+  BUILD_POOL *pool = (BUILD_POOL *)arg;
+  for(;;)
+  {
+    int i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    if(i >= pool->build->genome->n_chrom)
+      break;
+    pool->status[i] = build_chrom(pool, i);
+  }
+  return NULL;
+}
+
+static int run_pool( BUILD_POOL *pool, void *(*worker)(void *), int n_job )
+{
+  pthread_t tid[256];
+  int nThreads = 0;
+  int status = 0;
+
+  pool->next = 0;
+  for(int i = 0; i < n_job; i++)
+    pool->status[i] = 1;
+  while(nThreads < pool->build->threads && nThreads < n_job)
+  {
+    if(pthread_create(&tid[nThreads], NULL, worker, pool) != 0)
+      break;
+    nThreads++;
+  }
+  // with no thread at all, do the work here
+  if(nThreads == 0)
+    worker(pool);
+  for(int i = 0; i < nThreads; i++)
+    pthread_join(tid[i], NULL);
+  for(int i = 0; i < n_job; i++)
+    status |= pool->status[i];
+  return status;
+}
+
+int seq_snp_build( const SEQ_SNP_BUILD *build, const char **in_file, int n_in )
+{
+  BUILD_POOL pool;
+  int status = 1;
+  int haveDir = 0;
+
+  check( (build->threads >= 1 && build->threads <= 256), "Impossible number of threads %d.",
+      build->threads );
+  check( (build->n_feature < SEQ_SNPDB_MAX_FEATURES), "Too many snp features." );
+  check( (build->genome->n_chrom > 0), "No chromosomes." );
+
+  memset(&pool, 0, sizeof(pool));
+  pool.build = build;
+  pool.in_file = in_file;
+  pool.n_in = n_in;
+  pool.status = (int *)calloc(n_in > build->genome->n_chrom ? n_in : build->genome->n_chrom,
+      sizeof(int));
+  check_mem(pool.status);
+
+  snprintf(pool.spill_dir, sizeof(pool.spill_dir), "%s/.%s.snp.XXXXXX", build->out_dir,
+      build->name);
+  check( (mkdtemp(pool.spill_dir) != NULL), "Cannot make spill directory in '%s'.",
+      build->out_dir );
+  haveDir = 1;
+
+  check( (run_pool(&pool, spill_worker, n_in) == 0), "Cannot read the snp files." );
+  check( (run_pool(&pool, chrom_worker, build->genome->n_chrom) == 0),
+      "Cannot build the snp stores." );
+  status = 0;
+
+error:
+  if(haveDir)
+  {
+    // leftovers from a failed build
+    char path[4200];
+    for(int f = 0; f < n_in; f++)
+      for(int c = 0; c < build->genome->n_chrom; c++)
+      {
+        spill_path(path, sizeof(path), &pool, f, c);
+        unlink(path);
+      }
+    rmdir(pool.spill_dir);
+  }
+  free(pool.status);
+  return status;
+}
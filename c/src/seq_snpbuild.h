@@ -0,0 +1,43 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_snpbuild.h
+ * Description: Native build of a snp track from UCSC snpNNN dumps; does what
+ *  Seq::Build::SnpTrack::build_snp_db does, for every chromosome at once.
+ *
+ *  Pass 1 reads every input file once - one thread per file - and spills the
+ *  wanted columns of each record into a file per (input file, chromosome).
+ *  Pass 2 builds the chromosomes concurrently: each reads its spill files in
+ *  input order, expands records to their sites and writes
+ *    <out_dir>/<name>.snp.<chr>.sdb   columnar snp store (seq_snpdb.h)
+ *    <out_dir>/<name>.snp.<chr>.dat   site ranges for genome_hasher
+ *  so only one chromosome per thread is ever held in memory.
+ */
+
+#ifndef __seq_snpbuild_h__
+#define __seq_snpbuild_h__
+
+#include "seq_genome.h"
+#include "seq_track.h"
+
+typedef struct seq_snp_build
+{
+  const SEQ_GENOME *genome;      // chromosome offsets
+  const SEQ_TRACK *genome_str;   // string genome (.str.dat), one base per byte
+  const char *name;              // track name
+  const char *out_dir;
+  const char **feature;          // feature columns; 'maf' is added
+  int n_feature;
+  int in_snp;                    // value written at the top of the site ranges
+  int threads;
+} SEQ_SNP_BUILD;
+
+int seq_snp_build( const SEQ_SNP_BUILD *build, const char **in_file, int n_in );
+
+#endif
@@ -0,0 +1,443 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_snpdb.c
+ * Description: Columnar snp store; see seq_snpdb.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_snpdb.h"
+
+#define ALIGN8(x) (((x) + 7) & ~(uint64_t)7)
+
+static int in_file( const SEQ_SNPDB *db, uint64_t off, uint64_t len )
+{
+  return off <= db->size && len <= db->size - off;
+}
+
+static int dict_in_file( const SEQ_SNPDB *db, const SEQ_SNPDB_DICT_LOC *loc )
+{
+  if(!in_file(db, loc->off, sizeof(uint32_t) * ((uint64_t)loc->n + 1)))
+    return 0;
+  const uint32_t *off = (const uint32_t *)(db->data + loc->off);
+  uint64_t strings = loc->off + sizeof(uint32_t) * ((uint64_t)loc->n + 1);
+  return off[0] == 0 && in_file(db, strings, off[loc->n]);
+}
+
+SEQ_SNPDB *seq_snpdb_open( const char *path )
+{
+  SEQ_SNPDB *db = NULL;
+  struct stat st;
+  void *map = MAP_FAILED;
+
+  check( strlen(path) < sizeof(db->path), "Path too long '%s'.", path );
+  db = (SEQ_SNPDB *)calloc(1, sizeof(SEQ_SNPDB));
+  check_mem(db);
+  db->fd = -1;
+  strcpy(db->path, path);
+
+  check( ((db->fd = open(path, O_RDONLY)) != -1), "Cannot open snp store '%s'.", path );
+  check( (fstat(db->fd, &st) == 0), "Cannot stat snp store '%s'.", path );
+  check( ((size_t)st.st_size >= sizeof(SEQ_SNPDB_HEADER)), "Snp store '%s' is truncated.",
+      path );
+
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, db->fd, 0);
+  check( (map != MAP_FAILED), "Cannot map snp store '%s'.", path );
+  madvise(map, (size_t)st.st_size, MADV_RANDOM);
+  db->data = (const char *)map;
+  db->size = (size_t)st.st_size;
+
+  const SEQ_SNPDB_HEADER *h = db->header = (const SEQ_SNPDB_HEADER *)db->data;
+  check( (memcmp(h->magic, SEQ_SNPDB_MAGIC, sizeof(SEQ_SNPDB_MAGIC)) == 0),
+      "'%s' is not a snp store.", path );
+  check( (h->n_feature <= SEQ_SNPDB_MAX_FEATURES && h->fence_step > 0
+        && h->n_fence == (h->n_row + h->fence_step - 1) / h->fence_step),
+      "Corrupt snp store header in '%s'.", path );
+  check( (in_file(db, sizeof(SEQ_SNPDB_HEADER), sizeof(SEQ_SNPDB_COLUMN) * h->n_feature)
+        && in_file(db, h->pos_off, sizeof(uint32_t) * (uint64_t)h->n_row)
+        && in_file(db, h->fence_off, sizeof(uint32_t) * (uint64_t)h->n_fence)
+        && in_file(db, h->id_off, sizeof(uint32_t) * (uint64_t)h->n_row)
+        && in_file(db, h->ref_off, h->n_row)
+        && dict_in_file(db, &h->id_dict)),
+      "Snp store '%s' is truncated.", path );
+
+  db->column = (const SEQ_SNPDB_COLUMN *)(db->data + sizeof(SEQ_SNPDB_HEADER));
+  for(uint32_t k = 0; k < h->n_feature; k++)
+  {
+    const SEQ_SNPDB_COLUMN *c = &db->column[k];
+    check( ((c->width == 1 || c->width == 2 || c->width == 4)
+          && in_file(db, c->code_off, (uint64_t)c->width * h->n_row)
+          && dict_in_file(db, &c->dict)),
+        "Corrupt column %u in snp store '%s'.", k, path );
+  }
+
+  db->pos   = (const uint32_t *)(db->data + h->pos_off);
+  db->fence = (const uint32_t *)(db->data + h->fence_off);
+  db->id    = (const uint32_t *)(db->data + h->id_off);
+  db->ref   = db->data + h->ref_off;
+  return db;
+
+error:
+  seq_snpdb_close(db);
+  return NULL;
+}
+
+void seq_snpdb_close( SEQ_SNPDB *db )
+{
+  if(!db)
+    return;
+  if(db->data)
+    munmap((void *)db->data, db->size);
+  if(db->fd != -1)
+    close(db->fd);
+  free(db);
+}
+
+long seq_snpdb_find( const SEQ_SNPDB *db, long abs_pos, long *first )
+{
+  const long n = db->header->n_row;
+  const long step = db->header->fence_step;
+  const long nFence = db->header->n_fence;
+
+  *first = 0;
+  if(abs_pos < 0 || abs_pos > (long)UINT32_MAX || n == 0)
+    return 0;
+  const uint32_t key = (uint32_t)abs_pos;
+
+  // first fence >= key; the fences are small enough to stay in cache
+  long lo = 0, hi = nFence;
+  while(lo < hi)
+  {
+    long mid = (lo + hi) >> 1;
+    if(db->fence[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  // so the first row >= key is in ((lo - 1) * step, lo * step]
+  long rlo = lo ? (lo - 1) * step + 1 : 0;
+  long rhi = lo < nFence ? lo * step : n;
+  while(rlo < rhi)
+  {
+    long mid = (rlo + rhi) >> 1;
+    if(db->pos[mid] < key)
+      rlo = mid + 1;
+    else
+      rhi = mid;
+  }
+
+  long count = 0;
+  while(rlo + count < n && db->pos[rlo + count] == key)
+    count++;
+  *first = rlo;
+  return count;
+}
+
+static const char *dict_str( const SEQ_SNPDB *db, const SEQ_SNPDB_DICT_LOC *loc,
+    uint32_t code, size_t *len )
+{
+  const uint32_t *off = (const uint32_t *)(db->data + loc->off);
+  const char *strings = (const char *)(off + loc->n + 1);
+  *len = off[code] - off[code - 1];
+  return strings + off[code - 1];
+}
+
+const char *seq_snpdb_snp_id( const SEQ_SNPDB *db, long row, char *buf, size_t *len )
+{
+  uint32_t id = db->id[row];
+  if(id & SEQ_SNPDB_ID_DICT)
+    return dict_str(db, &db->header->id_dict, id & ~SEQ_SNPDB_ID_DICT, len);
+  *len = (size_t)sprintf(buf, "rs%u", id);
+  return buf;
+}
+
+const char *seq_snpdb_feature( const SEQ_SNPDB *db, long row, int k, size_t *len )
+{
+  const SEQ_SNPDB_COLUMN *c = &db->column[k];
+  const char *codes = db->data + c->code_off;
+  uint32_t code;
+
+  if(c->width == 1)
+    code = ((const uint8_t *)codes)[row];
+  else if(c->width == 2)
+    code = ((const uint16_t *)codes)[row];
+  else
+    code = ((const uint32_t *)codes)[row];
+  if(code == 0 || code > c->dict.n)
+    return NULL;
+  return dict_str(db, &c->dict, code, len);
+}
+
+SEQ_SNPDB_WRITER *seq_snpdb_writer_new( const char **name, int n_feature )
+{
+  SEQ_SNPDB_WRITER *w = NULL;
+
+  check( (n_feature >= 0 && n_feature <= SEQ_SNPDB_MAX_FEATURES),
+      "At most %d snp features, got %d.", SEQ_SNPDB_MAX_FEATURES, n_feature );
+  w = (SEQ_SNPDB_WRITER *)calloc(1, sizeof(SEQ_SNPDB_WRITER));
+  check_mem(w);
+  w->n_feature = n_feature;
+  for(int k = 0; k < n_feature; k++)
+  {
+    check( (strlen(name[k]) < SEQ_SNPDB_MAX_NAME), "Feature name too long '%s'.", name[k] );
+    strcpy(w->name[k], name[k]);
+  }
+  return w;
+
+error:
+  free(w);
+  return NULL;
+}
+
+void seq_snpdb_writer_free( SEQ_SNPDB_WRITER *w )
+{
+  if(!w)
+    return;
+  seq_dict_free(&w->id_dict);
+  for(int k = 0; k < w->n_feature; k++)
+    seq_dict_free(&w->dict[k]);
+  free(w->pos);
+  free(w->id);
+  free(w->ref);
+  free(w->code);
+  free(w);
+}
+
+// 'rs<number>' without leading zeros round trips through the integer column
+static int rs_number( const char *snp_id, uint32_t *number )
+{
+  uint64_t v = 0;
+  const char *p = snp_id + 2;
+
+  if(snp_id[0] != 'r' || snp_id[1] != 's' || *p < '1' || *p > '9')
+    return 0;
+  for(; *p; p++)
+  {
+    if(*p < '0' || *p > '9')
+      return 0;
+    v = v * 10 + (uint64_t)(*p - '0');
+    if(v >= SEQ_SNPDB_ID_DICT)
+      return 0;
+  }
+  *number = (uint32_t)v;
+  return 1;
+}
+
+int seq_snpdb_writer_add( SEQ_SNPDB_WRITER *w, long abs_pos, const char *snp_id, char ref,
+    const char **value )
+{
+  check( (abs_pos >= 0 && abs_pos <= (long)UINT32_MAX),
+      "Position %ld does not fit the snp store.", abs_pos );
+  check( (w->n < (long)UINT32_MAX), "Too many rows for one snp store." );
+
+  if(w->n == w->cap)
+  {
+    long cap = w->cap ? 2 * w->cap : 65536;
+    uint32_t *pos = (uint32_t *)realloc(w->pos, sizeof(uint32_t) * cap);
+    check_mem(pos);
+    w->pos = pos;
+    uint32_t *id = (uint32_t *)realloc(w->id, sizeof(uint32_t) * cap);
+    check_mem(id);
+    w->id = id;
+    char *refs = (char *)realloc(w->ref, cap);
+    check_mem(refs);
+    w->ref = refs;
+    if(w->n_feature)
+    {
+      uint32_t *code = (uint32_t *)realloc(w->code, sizeof(uint32_t) * w->n_feature * cap);
+      check_mem(code);
+      w->code = code;
+    }
+    w->cap = cap;
+  }
+
+  uint32_t id;
+  if(!rs_number(snp_id, &id))
+  {
+    id = seq_dict_intern(&w->id_dict, snp_id, strlen(snp_id));
+    check( (id != 0 && id < SEQ_SNPDB_ID_DICT), "Cannot intern snp id '%s'.", snp_id );
+    id |= SEQ_SNPDB_ID_DICT;
+  }
+
+  for(int k = 0; k < w->n_feature; k++)
+  {
+    uint32_t code = 0;
+    if(value[k])
+    {
+      code = seq_dict_intern(&w->dict[k], value[k], strlen(value[k]));
+      check( (code != 0), "Cannot intern '%s' value '%s'.", w->name[k], value[k] );
+    }
+    w->code[(long)w->n_feature * w->n + k] = code;
+  }
+  w->pos[w->n] = (uint32_t)abs_pos;
+  w->id[w->n] = id;
+  w->ref[w->n] = ref;
+  w->n++;
+  return 0;
+
+error:
+  return 1;
+}
+
+static int compare_key( const void *a, const void *b )
+{
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int write_at( FILE *fh, uint64_t *at, const void *data, uint64_t len )
+{
+  static const char zero[8] = { 0 };
+  if(len && fwrite(data, 1, len, fh) != len)
+    return 1;
+  *at += len;
+  uint64_t pad = ALIGN8(*at) - *at;
+  if(pad && fwrite(zero, 1, pad, fh) != pad)
+    return 1;
+  *at += pad;
+  return 0;
+}
+
+static uint64_t dict_bytes( const SEQ_DICT *dict )
+{
+  return ALIGN8(sizeof(uint32_t) * ((uint64_t)dict->n + 1) + dict->len);
+}
+
+static int write_dict( FILE *fh, uint64_t *at, const SEQ_DICT *dict )
+{
+  uint32_t zero = 0;
+  const uint32_t *off = dict->n ? dict->off : &zero;
+  if(fwrite(off, sizeof(uint32_t), dict->n + 1, fh) != dict->n + 1)
+    return 1;
+  *at += sizeof(uint32_t) * ((uint64_t)dict->n + 1);
+  return write_at(fh, at, dict->buf, dict->len);
+}
+
+int seq_snpdb_writer_write( SEQ_SNPDB_WRITER *w, const char *path )
+{
+  FILE *fh = NULL;
+  uint64_t *key = NULL;
+  void *buf = NULL;
+  SEQ_SNPDB_HEADER h;
+  SEQ_SNPDB_COLUMN col[SEQ_SNPDB_MAX_FEATURES];
+  const long n = w->n;
+
+  // stable sort: position, then the order rows were added
+  key = (uint64_t *)malloc(sizeof(uint64_t) * (n ? n : 1));
+  check_mem(key);
+  for(long i = 0; i < n; i++)
+    key[i] = ((uint64_t)w->pos[i] << 32) | (uint64_t)i;
+  qsort(key, n, sizeof(uint64_t), compare_key);
+
+  memset(&h, 0, sizeof(h));
+  memset(col, 0, sizeof(col));
+  memcpy(h.magic, SEQ_SNPDB_MAGIC, sizeof(SEQ_SNPDB_MAGIC));
+  h.n_row = (uint32_t)n;
+  h.n_feature = (uint32_t)w->n_feature;
+  h.fence_step = SEQ_SNPDB_FENCE;
+  h.n_fence = (uint32_t)((n + SEQ_SNPDB_FENCE - 1) / SEQ_SNPDB_FENCE);
+
+  // lay out the sections
+  uint64_t at = ALIGN8(sizeof(h) + sizeof(SEQ_SNPDB_COLUMN) * w->n_feature);
+  h.pos_off = at;
+  at += ALIGN8(sizeof(uint32_t) * (uint64_t)n);
+  h.fence_off = at;
+  at += ALIGN8(sizeof(uint32_t) * (uint64_t)h.n_fence);
+  h.id_off = at;
+  at += ALIGN8(sizeof(uint32_t) * (uint64_t)n);
+  h.ref_off = at;
+  at += ALIGN8((uint64_t)n);
+  for(int k = 0; k < w->n_feature; k++)
+  {
+    strcpy(col[k].name, w->name[k]);
+    col[k].width = w->dict[k].n <= 0xff ? 1 : w->dict[k].n <= 0xffff ? 2 : 4;
+    col[k].code_off = at;
+    at += ALIGN8((uint64_t)col[k].width * n);
+  }
+  h.id_dict.off = at;
+  h.id_dict.n = w->id_dict.n;
+  at += dict_bytes(&w->id_dict);
+  for(int k = 0; k < w->n_feature; k++)
+  {
+    col[k].dict.off = at;
+    col[k].dict.n = w->dict[k].n;
+    at += dict_bytes(&w->dict[k]);
+  }
+
+  buf = malloc(sizeof(uint32_t) * (n ? n : 1));
+  check_mem(buf);
+  check( ((fh = fopen(path, "wb")) != NULL), "Cannot open '%s' for writing.", path );
+
+  at = 0;
+  check( (write_at(fh, &at, &h, sizeof(h)) == 0
+        && write_at(fh, &at, col, sizeof(SEQ_SNPDB_COLUMN) * w->n_feature) == 0),
+      "Cannot write '%s'.", path );
+
+  uint32_t *u32 = (uint32_t *)buf;
+  for(long i = 0; i < n; i++)
+    u32[i] = w->pos[key[i] & 0xffffffff];
+  check( (write_at(fh, &at, u32, sizeof(uint32_t) * n) == 0), "Cannot write '%s'.", path );
+  for(long i = 0; i < (long)h.n_fence; i++)
+    u32[i] = u32[i * SEQ_SNPDB_FENCE];
+  check( (write_at(fh, &at, u32, sizeof(uint32_t) * h.n_fence) == 0), "Cannot write '%s'.",
+      path );
+
+  for(long i = 0; i < n; i++)
+    u32[i] = w->id[key[i] & 0xffffffff];
+  check( (write_at(fh, &at, u32, sizeof(uint32_t) * n) == 0), "Cannot write '%s'.", path );
+
+  char *c8 = (char *)buf;
+  for(long i = 0; i < n; i++)
+    c8[i] = w->ref[key[i] & 0xffffffff];
+  check( (write_at(fh, &at, c8, n) == 0), "Cannot write '%s'.", path );
+
+  for(int k = 0; k < w->n_feature; k++)
+  {
+    for(long i = 0; i < n; i++)
+    {
+      uint32_t code = w->code[(long)w->n_feature * (long)(key[i] & 0xffffffff) + k];
+      if(col[k].width == 1)
+        ((uint8_t *)buf)[i] = (uint8_t)code;
+      else if(col[k].width == 2)
+        ((uint16_t *)buf)[i] = (uint16_t)code;
+      else
+        ((uint32_t *)buf)[i] = code;
+    }
+    check( (write_at(fh, &at, buf, (uint64_t)col[k].width * n) == 0), "Cannot write '%s'.",
+        path );
+  }
+
+  check( (write_dict(fh, &at, &w->id_dict) == 0), "Cannot write '%s'.", path );
+  for(int k = 0; k < w->n_feature; k++)
+    check( (write_dict(fh, &at, &w->dict[k]) == 0), "Cannot write '%s'.", path );
+
+  check( (fclose(fh) == 0), "Cannot close '%s'.", path );
+  fh = NULL;
+  free(key);
+  free(buf);
+  return 0;
+
+error:
+  if(fh)
+    fclose(fh);
+  free(key);
+  free(buf);
+  return 1;
+}
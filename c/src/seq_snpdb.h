@@ -0,0 +1,124 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_snpdb.h
+ * Description: Immutable, position-sorted columnar store of snp sites; the
+ *  replacement for the per-chromosome snp kch files. One row per record that
+ *  Seq::Build::SnpTrack would have put into the kch (a position may have
+ *  several), laid out column by column:
+ *
+ *    header, column descriptors
+ *    pos       uint32[n_row]   abs_pos, sorted ascending
+ *    fence     uint32[n_fence] pos[i * fence_step], searched before pos
+ *    snp_id    uint32[n_row]   the number of 'rs<number>' ids, or
+ *                              SEQ_SNPDB_ID_DICT | code into the id dictionary
+ *    ref_base  char[n_row]
+ *    for each feature (allele, maf, ...): codes of width 1, 2 or 4 bytes into
+ *      the column's dictionary; code 0 means the feature was not defined
+ *    dictionaries: uint32 off[n + 1] followed by the strings (see seq_dict.h)
+ *
+ *  Every section starts on an 8 byte boundary; integers are host order.
+ */
+
+#ifndef __seq_snpdb_h__
+#define __seq_snpdb_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seq_dict.h"
+
+#define SEQ_SNPDB_MAGIC "SEQSNP1"
+#define SEQ_SNPDB_FENCE 64
+#define SEQ_SNPDB_MAX_FEATURES 64
+#define SEQ_SNPDB_MAX_NAME 56
+#define SEQ_SNPDB_ID_DICT (1u << 31)
+
+typedef struct seq_snpdb_dict_loc
+{
+  uint64_t off;
+  uint32_t n;
+  uint32_t reserved;
+} SEQ_SNPDB_DICT_LOC;
+
+typedef struct seq_snpdb_header
+{
+  char magic[8];
+  uint32_t n_row;
+  uint32_t n_feature;
+  uint32_t fence_step;
+  uint32_t n_fence;
+  uint64_t pos_off;
+  uint64_t fence_off;
+  uint64_t id_off;
+  uint64_t ref_off;
+  SEQ_SNPDB_DICT_LOC id_dict;
+} SEQ_SNPDB_HEADER;
+
+typedef struct seq_snpdb_column
+{
+  char name[SEQ_SNPDB_MAX_NAME];
+  uint32_t width;
+  uint32_t reserved;
+  uint64_t code_off;
+  SEQ_SNPDB_DICT_LOC dict;
+} SEQ_SNPDB_COLUMN;
+
+// reader
+typedef struct seq_snpdb
+{
+  char path[4096];
+  int fd;
+  const char *data;
+  size_t size;
+  const SEQ_SNPDB_HEADER *header;
+  const SEQ_SNPDB_COLUMN *column;
+  const uint32_t *pos;
+  const uint32_t *fence;
+  const uint32_t *id;
+  const char *ref;
+} SEQ_SNPDB;
+
+SEQ_SNPDB *seq_snpdb_open( const char *path );
+void seq_snpdb_close( SEQ_SNPDB *db );
+
+// returns the number of rows at abs_pos and sets *first to the first of them
+long seq_snpdb_find( const SEQ_SNPDB *db, long abs_pos, long *first );
+
+// writes the id of the row into buf (at least 16 bytes) or points into the
+//  id dictionary; returns the id and sets *len
+const char *seq_snpdb_snp_id( const SEQ_SNPDB *db, long row, char *buf, size_t *len );
+
+// returns the value of feature k at the row, NULL when it is not defined
+const char *seq_snpdb_feature( const SEQ_SNPDB *db, long row, int k, size_t *len );
+
+// writer; rows may be added in any order, they are sorted (stably) on write
+typedef struct seq_snpdb_writer
+{
+  int n_feature;
+  char name[SEQ_SNPDB_MAX_FEATURES][SEQ_SNPDB_MAX_NAME];
+  SEQ_DICT id_dict;
+  SEQ_DICT dict[SEQ_SNPDB_MAX_FEATURES];
+  uint32_t *pos;
+  uint32_t *id;
+  char *ref;
+  uint32_t *code;          // n_feature codes per row
+  long n;
+  long cap;
+} SEQ_SNPDB_WRITER;
+
+SEQ_SNPDB_WRITER *seq_snpdb_writer_new( const char **name, int n_feature );
+void seq_snpdb_writer_free( SEQ_SNPDB_WRITER *w );
+
+// value[k] is the NUL-terminated value of feature k, or NULL when undefined
+int seq_snpdb_writer_add( SEQ_SNPDB_WRITER *w, long abs_pos, const char *snp_id, char ref,
+    const char **value );
+
+int seq_snpdb_writer_write( SEQ_SNPDB_WRITER *w, const char *path );
+
+#endif
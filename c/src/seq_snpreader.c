@@ -0,0 +1,624 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_snpreader.c
+ * Description: Streaming snpfile reader; see seq_snpreader.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_snpreader.h"
+#include "seq_vcf.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEQ_HAVE_X86 1
+#endif
+
+/*
+ * The characters get_clean_fields takes, [+,.-=:/\t\s\w], as two nibble
+ * tables: c is one of them when lo[c & 15] & hi[c >> 4] is not 0. Each bit
+ * stands for the set of low nibbles one or more high nibbles take.
+ */
+static const unsigned char clean_lo[16] = {
+  0x36, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c,
+  0x3c, 0x3d, 0x3d, 0x0b, 0x0b, 0x0f, 0x0a, 0x1a };
+static const unsigned char clean_hi[16] = {
+  0x01, 0x00, 0x02, 0x04, 0x08, 0x10, 0x08, 0x20,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static inline int clean_char( unsigned char c )
+{
+  return (clean_lo[c & 15] & clean_hi[c >> 4]) != 0;
+}
+
+static inline void add_field( SEQ_SNPFIELD *out, long max, long *nField, uint32_t base,
+    size_t start, size_t end )
+{
+  if(*nField < max)
+  {
+    out[*nField].off = base + (uint32_t)start;
+    out[*nField].len = (uint32_t)(end - start);
+  }
+  (*nField)++;
+}
+
+#ifdef SEQ_HAVE_X86
+
+// returns the bytes done, or (size_t)-1 at an unclean character
+__attribute__((target("avx2")))
+static size_t split_avx2( const char *line, size_t n, uint32_t base, SEQ_SNPFIELD *out,
+    long max, long *nField, size_t *start )
+{
+  const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)clean_lo));
+  const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)clean_hi));
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for(; i + 32 <= n; i += 32)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(line + i));
+    __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(c, nibble));
+    __m256i h = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(c, 4), nibble));
+    if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero)))
+      return (size_t)-1;
+    uint32_t tabs = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, tab));
+    while(tabs)
+    {
+      size_t at = i + (size_t)__builtin_ctz(tabs);
+      add_field(out, max, nField, base, *start, at);
+      *start = at + 1;
+      tabs &= tabs - 1;
+    }
+  }
+  return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t split_ssse3( const char *line, size_t n, uint32_t base, SEQ_SNPFIELD *out,
+    long max, long *nField, size_t *start )
+{
+  const __m128i lo = _mm_loadu_si128((const __m128i *)clean_lo);
+  const __m128i hi = _mm_loadu_si128((const __m128i *)clean_hi);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+
+  for(; i + 16 <= n; i += 16)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i *)(line + i));
+    __m128i l = _mm_shuffle_epi8(lo, _mm_and_si128(c, nibble));
+    __m128i h = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(c, 4), nibble));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(l, h), zero)))
+      return (size_t)-1;
+    uint32_t tabs = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, tab));
+    while(tabs)
+    {
+      size_t at = i + (size_t)__builtin_ctz(tabs);
+      add_field(out, max, nField, base, *start, at);
+      *start = at + 1;
+      tabs &= tabs - 1;
+    }
+  }
+  return i;
+}
+
+#endif
+
+long seq_snp_split( const char *line, size_t n, uint32_t base, SEQ_SNPFIELD *out,
+    long max )
+{
+  long nField = 0;
+  size_t start = 0;
+  size_t i = 0;
+
+  // the taint check wants at least one character
+  if(n == 0)
+    return -1;
+
+#ifdef SEQ_HAVE_X86
+  if(__builtin_cpu_supports("avx2"))
+    i = split_avx2(line, n, base, out, max, &nField, &start);
+  else if(__builtin_cpu_supports("ssse3"))
+    i = split_ssse3(line, n, base, out, max, &nField, &start);
+  if(i == (size_t)-1)
+    return -1;
+#endif
+
+  for(; i < n; i++)
+  {
+    const unsigned char c = (unsigned char)line[i];
+    if(!clean_char(c))
+      return -1;
+    if(c == '\t')
+    {
+      add_field(out, max, &nField, base, start, i);
+      start = i + 1;
+    }
+  }
+  add_field(out, max, &nField, base, start, n);
+
+  // like perl's split, without the empty fields at the end
+  if(nField > max)
+    return nField;
+  while(nField > 0 && out[nField - 1].len == 0)
+    nField--;
+  return nField;
+}
+
+static void *read_worker( void *arg )
+{
+  SEQ_SNPREADER *r = (SEQ_SNPREADER *)arg;
+  int next = 0;
+
+  for(;;)
+  {
+    pthread_mutex_lock(&r->lock);
+    while(r->n_full == SEQ_SNPREADER_CHUNKS && !r->stop)
+      pthread_cond_wait(&r->drained, &r->lock);
+    const int stop = r->stop;
+    pthread_mutex_unlock(&r->lock);
+    if(stop)
+      break;
+
+    // the chunk is free, so it is ours until it is handed over
+    SEQ_SNPCHUNK *chunk = &r->chunk[next];
+    long got;
+    long long offset;
+    if(r->bgzf)
+    {
+      got = seq_bgzf_read(r->bgzf, chunk->data, SEQ_SNPREADER_CHUNK);
+      offset = (long long)r->bgzf->offset;
+    }
+    else
+    {
+      const size_t want = r->left < SEQ_SNPREADER_CHUNK ? (size_t)r->left : SEQ_SNPREADER_CHUNK;
+      got = want ? gzread(r->gz, chunk->data, want) : 0;
+      offset = gzoffset(r->gz);
+      if(got > 0)
+        r->left -= (uint64_t)got;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    if(offset >= 0)
+      r->offset = (uint64_t)offset;
+    if(got <= 0)
+    {
+      r->error = got < 0;
+      r->eof = 1;
+      pthread_cond_signal(&r->filled);
+      pthread_mutex_unlock(&r->lock);
+      break;
+    }
+    chunk->len = (size_t)got;
+    r->n_full++;
+    pthread_cond_signal(&r->filled);
+    pthread_mutex_unlock(&r->lock);
+    next = (next + 1) % SEQ_SNPREADER_CHUNKS;
+  }
+  return NULL;
+}
+
+SEQ_SNPREADER *seq_snpreader_open( const char *path )
+{
+  return seq_snpreader_open_range(path, 0, 0);
+}
+
+SEQ_SNPREADER *seq_snpreader_open_range( const char *path, uint64_t start, uint64_t end )
+{
+  const int ranged = start || end;
+  SEQ_SNPREADER *r = (SEQ_SNPREADER *)calloc(1, sizeof(SEQ_SNPREADER));
+  check_mem(r);
+  for(int i = 0; i < SEQ_SNP_N_COL; i++)
+    r->col[i] = -1;
+  r->left = UINT64_MAX;
+
+  if(!ranged && seq_bgzf_check(path))
+  {
+    check( ((r->bgzf = seq_bgzf_open(path, 0)) != NULL), "Cannot open '%s' for reading.", path );
+  }
+  else
+  {
+    check( ((r->gz = gzopen(path, "r")) != NULL), "Cannot open '%s' for reading.", path );
+    gzbuffer(r->gz, 1 << 17);
+  }
+  if(ranged)
+  {
+    // offsets into a compressed file are not where its lines are
+    check( (gzdirect(r->gz)), "'%s' is compressed; only a plain file is read by range.",
+        path );
+    check( (end == 0 || end >= start), "Range %llu to %llu of '%s' is backwards.",
+        (unsigned long long)start, (unsigned long long)end, path );
+    check( (gzseek(r->gz, (z_off_t)start, SEEK_SET) == (z_off_t)start),
+        "Cannot seek to %llu in '%s'.", (unsigned long long)start, path );
+    if(end)
+      r->left = end - start;
+  }
+  for(int i = 0; i < SEQ_SNPREADER_CHUNKS; i++)
+  {
+    r->chunk[i].data = (char *)malloc(SEQ_SNPREADER_CHUNK);
+    check_mem(r->chunk[i].data);
+  }
+  pthread_mutex_init(&r->lock, NULL);
+  pthread_cond_init(&r->filled, NULL);
+  pthread_cond_init(&r->drained, NULL);
+  if(pthread_create(&r->thread, NULL, read_worker, r) != 0)
+  {
+    log_err("Cannot start the reader of '%s'.", path);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->filled);
+    pthread_cond_destroy(&r->drained);
+    goto error;
+  }
+  return r;
+
+error:
+  if(r)
+  {
+    if(r->gz)
+      gzclose(r->gz);
+    seq_bgzf_close(r->bgzf);
+    for(int i = 0; i < SEQ_SNPREADER_CHUNKS; i++)
+      free(r->chunk[i].data);
+    free(r);
+  }
+  return NULL;
+}
+
+void seq_snpreader_close( SEQ_SNPREADER *r )
+{
+  if(!r)
+    return;
+  pthread_mutex_lock(&r->lock);
+  r->stop = 1;
+  pthread_cond_signal(&r->drained);
+  pthread_mutex_unlock(&r->lock);
+  pthread_join(r->thread, NULL);
+
+  pthread_mutex_destroy(&r->lock);
+  pthread_cond_destroy(&r->filled);
+  pthread_cond_destroy(&r->drained);
+  if(r->gz)
+    gzclose(r->gz);
+  seq_bgzf_close(r->bgzf);
+  for(int i = 0; i < SEQ_SNPREADER_CHUNKS; i++)
+    free(r->chunk[i].data);
+  free(r->carry);
+  free(r->sample);
+  seq_vcf_free(r->vcf);
+  free(r);
+}
+
+void seq_snpreader_set_columns( SEQ_SNPREADER *r, const int col[SEQ_SNP_N_COL] )
+{
+  for(int i = 0; i < SEQ_SNP_N_COL; i++)
+    r->col[i] = col[i];
+  r->have_col = 1;
+}
+
+int seq_snpreader_set_samples( SEQ_SNPREADER *r, const int *col, long n )
+{
+  int *sample = (int *)malloc(sizeof(int) * (n ? n : 1));
+  check_mem(sample);
+  memcpy(sample, col, sizeof(int) * n);
+  free(r->sample);
+  r->sample = sample;
+  r->n_sample = n;
+  if(r->vcf)
+    r->vcf->slot_for = NULL;
+  return 1;
+
+error:
+  return 0;
+}
+
+uint64_t seq_snpreader_offset( SEQ_SNPREADER *r )
+{
+  pthread_mutex_lock(&r->lock);
+  uint64_t offset = r->offset;
+  pthread_mutex_unlock(&r->lock);
+  return offset;
+}
+
+void seq_snpbatch_free( SEQ_SNPBATCH *batch )
+{
+  free(batch->text);
+  free(batch->field);
+  free(batch->row);
+  free(batch->geno);
+  free(batch->call);
+  memset(batch, 0, sizeof(SEQ_SNPBATCH));
+}
+
+// gives back the chunk the caller was splitting; 1 while there are more
+static int next_chunk( SEQ_SNPREADER *r )
+{
+  pthread_mutex_lock(&r->lock);
+  if(r->have)
+  {
+    r->have = 0;
+    r->n_full--;
+    r->head = (r->head + 1) % SEQ_SNPREADER_CHUNKS;
+    pthread_cond_signal(&r->drained);
+  }
+  while(r->n_full == 0 && !r->eof)
+    pthread_cond_wait(&r->filled, &r->lock);
+  r->have = r->n_full > 0;
+  r->at = 0;
+  pthread_mutex_unlock(&r->lock);
+  return r->have;
+}
+
+static int carry_add( SEQ_SNPREADER *r, const char *s, size_t n )
+{
+  if(r->carry_len + n > r->carry_cap)
+  {
+    size_t cap = r->carry_cap ? r->carry_cap : 4096;
+    while(r->carry_len + n > cap)
+      cap *= 2;
+    char *carry = (char *)realloc(r->carry, cap);
+    check_mem(carry);
+    r->carry = carry;
+    r->carry_cap = cap;
+  }
+  memcpy(r->carry + r->carry_len, s, n);
+  r->carry_len += n;
+  return 1;
+
+error:
+  return 0;
+}
+
+// the next line, without its newline; 0 at the end, -1 on error
+static int next_line( SEQ_SNPREADER *r, const char **line, size_t *len )
+{
+  r->carry_len = 0;
+  for(;;)
+  {
+    if(!r->have || r->at == r->chunk[r->head].len)
+    {
+      if(!next_chunk(r))
+      {
+        if(r->error)
+          return -1;
+        if(r->carry_len == 0)
+          return 0;
+        *line = r->carry;
+        *len = r->carry_len;
+        return 1;
+      }
+    }
+    const SEQ_SNPCHUNK *chunk = &r->chunk[r->head];
+    const char *from = chunk->data + r->at;
+    const size_t left = chunk->len - r->at;
+    const char *nl = (const char *)memchr(from, '\n', left);
+    if(!nl)
+    {
+      // the rest of the line is in the next chunk
+      if(!carry_add(r, from, left))
+        return -1;
+      r->at = chunk->len;
+      continue;
+    }
+    const size_t n = (size_t)(nl - from);
+    r->at += n + 1;
+    if(r->carry_len)
+    {
+      if(!carry_add(r, from, n))
+        return -1;
+      *line = r->carry;
+      *len = r->carry_len;
+    }
+    else
+    {
+      *line = from;
+      *len = n;
+    }
+    return 1;
+  }
+}
+
+static int batch_reserve( SEQ_SNPBATCH *batch, size_t text, long fields, long samples )
+{
+  if(batch->len + text > batch->cap)
+  {
+    size_t cap = batch->cap ? batch->cap : 1 << 16;
+    while(batch->len + text > cap)
+      cap *= 2;
+    char *s = (char *)realloc(batch->text, cap);
+    check_mem(s);
+    batch->text = s;
+    batch->cap = cap;
+  }
+  if(batch->n_field + fields > batch->cap_field)
+  {
+    long cap = batch->cap_field ? batch->cap_field : 1024;
+    while(batch->n_field + fields > cap)
+      cap *= 2;
+    SEQ_SNPFIELD *f = (SEQ_SNPFIELD *)realloc(batch->field, cap * sizeof(SEQ_SNPFIELD));
+    check_mem(f);
+    batch->field = f;
+    batch->cap_field = cap;
+  }
+  if(batch->n_row == batch->cap_row)
+  {
+    long cap = batch->cap_row ? 2 * batch->cap_row : 256;
+    SEQ_SNPROW *row = (SEQ_SNPROW *)realloc(batch->row, cap * sizeof(SEQ_SNPROW));
+    check_mem(row);
+    batch->row = row;
+    batch->cap_row = cap;
+  }
+  if((batch->n_row + 1) * samples > batch->cap_geno)
+  {
+    long cap = batch->cap_geno ? batch->cap_geno : 1 << 16;
+    while((batch->n_row + 1) * samples > cap)
+      cap *= 2;
+    uint8_t *geno = (uint8_t *)realloc(batch->geno, cap);
+    check_mem(geno);
+    batch->geno = geno;
+    batch->cap_geno = cap;
+  }
+  return 1;
+
+error:
+  return 0;
+}
+
+// fills in the snp columns; 0 when the row lacks one annotate_snpfile needs
+static int snp_columns( const SEQ_SNPREADER *r, const SEQ_SNPBATCH *batch, SEQ_SNPROW *row )
+{
+  for(int c = 0; c < SEQ_SNP_N_COL; c++)
+  {
+    const int f = r->col[c];
+    row->snp[c] = f >= 0 && (uint32_t)f < row->n_field ? (int32_t)(row->field + f) : -1;
+    if(c == SEQ_SNP_ALLELE_COUNT)
+      continue;
+
+    // perl truth: neither missing, empty nor "0"
+    if(row->snp[c] < 0)
+      return 0;
+    size_t len;
+    const char *s = seq_snpbatch_field(batch, row->snp[c], &len);
+    if(len == 0 || (len == 1 && s[0] == '0'))
+      return 0;
+  }
+  size_t len;
+  const char *s = seq_snpbatch_field(batch, row->snp[SEQ_SNP_POS], &len);
+  row->pos = 0;
+  for(size_t i = 0; i < len && s[i] >= '0' && s[i] <= '9'; i++)
+    row->pos = 10 * row->pos + (s[i] - '0');
+  return 1;
+}
+
+long seq_snpreader_add_row( SEQ_SNPREADER *r, SEQ_SNPBATCH *batch, const char *line,
+    size_t len )
+{
+  // a field per 8 bytes is a guess; a line with more is split again
+  long guess = (long)(len / 8) + 2;
+  check_mem(batch_reserve(batch, len, guess, r->n_sample));
+  const uint32_t base = (uint32_t)batch->len;
+  long n = seq_snp_split(line, len, base, batch->field + batch->n_field, guess);
+  if(n > guess)
+  {
+    check_mem(batch_reserve(batch, len, n, r->n_sample));
+    n = seq_snp_split(line, len, base, batch->field + batch->n_field, n);
+  }
+  if(n < 2)
+    return -1;
+
+  SEQ_SNPROW *row = &batch->row[batch->n_row];
+  row->field = (uint32_t)batch->n_field;
+  row->n_field = (uint32_t)n;
+  row->call = (uint32_t)batch->n_call;
+  row->n_call = 0;
+  row->pos = 0;
+  for(int c = 0; c < SEQ_SNP_N_COL; c++)
+    row->snp[c] = -1;
+  memcpy(batch->text + batch->len, line, len);
+  if(r->have_col && !snp_columns(r, batch, row))
+    return -1;
+  batch->len += len;
+  batch->n_field += n;
+  return batch->n_row++;
+
+error:
+  return -2;
+}
+
+long seq_snpbatch_add_field( SEQ_SNPBATCH *batch, const char *s, size_t len )
+{
+  check_mem(batch_reserve(batch, len, 1, 0));
+  memcpy(batch->text + batch->len, s, len);
+  batch->field[batch->n_field].off = (uint32_t)batch->len;
+  batch->field[batch->n_field].len = (uint32_t)len;
+  batch->len += len;
+  return batch->n_field++;
+
+error:
+  return -1;
+}
+
+int seq_snpbatch_add_call( SEQ_SNPBATCH *batch, long sample, long field )
+{
+  if(batch->n_call == batch->cap_call)
+  {
+    long cap = batch->cap_call ? 2 * batch->cap_call : 256;
+    SEQ_SNPCALL *call = (SEQ_SNPCALL *)realloc(batch->call, cap * sizeof(SEQ_SNPCALL));
+    check_mem(call);
+    batch->call = call;
+    batch->cap_call = cap;
+  }
+  batch->call[batch->n_call].sample = (uint32_t)sample;
+  batch->call[batch->n_call].field = (uint32_t)field;
+  batch->n_call++;
+  batch->row[batch->n_row - 1].n_call++;
+  return 1;
+
+error:
+  return 0;
+}
+
+// a missing sample column is no call, as an undefined field is to perl
+static int geno_codes( const SEQ_SNPREADER *r, SEQ_SNPBATCH *batch, long row )
+{
+  const SEQ_SNPROW *at = &batch->row[row];
+  uint8_t *code = batch->geno + row * r->n_sample;
+
+  for(long i = 0; i < r->n_sample; i++)
+  {
+    const int f = r->sample[i];
+    size_t len = 0;
+    const char *s = f >= 0 && (uint32_t)f < at->n_field
+      ? seq_snpbatch_field(batch, at->field + f, &len) : NULL;
+    code[i] = seq_geno_code(s, len);
+    if(code[i] == SEQ_GENO_OTHER && !seq_snpbatch_add_call(batch, i, at->field + f))
+      return 0;
+  }
+  return 1;
+}
+
+long seq_snpreader_read( SEQ_SNPREADER *r, SEQ_SNPBATCH *batch, long max )
+{
+  const char *line;
+  size_t len;
+  int got = 0;
+
+  batch->len = 0;
+  batch->n_field = 0;
+  batch->n_row = 0;
+  batch->n_call = 0;
+  batch->n_sample = r->n_sample;
+  while(batch->n_row < max && (got = next_line(r, &line, &len)) > 0)
+  {
+    r->lines++;
+    check( (len < UINT32_MAX), "Line %ld is too long.", r->lines );
+    if(r->lines == 1 && seq_vcf_check(line, len))
+      check_mem((r->vcf = seq_vcf_new()));
+    if(r->vcf)
+    {
+      check_mem(seq_vcf_line(r->vcf, r, batch, line, len) >= 0);
+      continue;
+    }
+
+    const long row = seq_snpreader_add_row(r, batch, line, len);
+    check_mem(row != -2);
+    if(row >= 0 && r->n_sample)
+      check_mem(geno_codes(r, batch, row));
+  }
+  check( (got >= 0), "Error reading the snpfile." );
+  return batch->n_row;
+
+error:
+  return -1;
+}
@@ -0,0 +1,194 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_snpreader.h
+ * Description: Streaming reader of snpfiles (plain, gzipped or bgzipped),
+ *  handing out batches of rows already split into fields.
+ *
+ *  A reader thread inflates the file into a few fixed chunks while the caller
+ *  splits the last ones, so memory is bounded by the chunks and one batch
+ *  whatever the size of the file. Lines are checked and split the way
+ *  Seq::Role::IO::get_clean_fields does it: a line with any character
+ *  outside [+,.-=:/ \t\w\s] is dropped, as are lines of fewer than two
+ *  fields, and trailing empty fields are not kept. Both the check and the
+ *  search for tabs look at 16 or 32 bytes at a time where the cpu allows.
+ *
+ *  Once the snp columns are set (Chr, Position, Reference, Type, Alleles and
+ *  Allele_Counts, in the order of Seq::Role::ProcessFile's allSnpFieldIdx),
+ *  each row also carries them as native fields, and rows missing any of the
+ *  first five, as Seq::annotate_snpfile would skip them, are dropped too.
+ *
+ *  Given the sample columns as well, each kept row's calls are coded as it is
+ *  split (seq_genotype.h), one byte per sample in the order given, so the
+ *  carriers of a row are found without going back to its fields.
+ *
+ *  A VCF is read as the snpfile bin/Vcf2SeqAnt_SNP_4_1.pl would make of it
+ *  (seq_vcf.h), without the file ever being written; a bgzipped one, as
+ *  VCFs usually are, is inflated a round of blocks at a time by a few
+ *  threads (seq_bgzf.h).
+ */
+
+#ifndef __seq_snpreader_h__
+#define __seq_snpreader_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "seq_genotype.h"
+#include "seq_bgzf.h"
+
+// the snp columns, in the order of allSnpFieldIdx
+enum
+{
+  SEQ_SNP_CHR = 0,
+  SEQ_SNP_POS,
+  SEQ_SNP_REF,
+  SEQ_SNP_TYPE,
+  SEQ_SNP_ALLELES,
+  SEQ_SNP_ALLELE_COUNT,
+  SEQ_SNP_N_COL
+};
+
+#define SEQ_SNPREADER_CHUNK  (1 << 20)
+#define SEQ_SNPREADER_CHUNKS 4
+
+typedef struct seq_snpfield
+{
+  uint32_t off;            // into the batch's text
+  uint32_t len;
+} SEQ_SNPFIELD;
+
+// a call that is not one of the codes, in a field of the batch
+typedef struct seq_snpcall
+{
+  uint32_t sample;
+  uint32_t field;
+} SEQ_SNPCALL;
+
+typedef struct seq_snprow
+{
+  uint32_t field;          // first of n_field fields in batch->field
+  uint32_t n_field;
+  uint32_t call;           // first of n_call calls in batch->call, by sample
+  uint32_t n_call;
+  int32_t snp[SEQ_SNP_N_COL];   // field index of each snp column, -1 if missing
+  long pos;                // Position, parsed
+} SEQ_SNPROW;
+
+typedef struct seq_snpbatch
+{
+  char *text;
+  size_t len;
+  size_t cap;
+  SEQ_SNPFIELD *field;
+  long n_field;
+  long cap_field;
+  SEQ_SNPROW *row;
+  long n_row;
+  long cap_row;
+  uint8_t *geno;           // n_sample codes per row, when samples are set
+  long n_sample;
+  long cap_geno;
+  SEQ_SNPCALL *call;
+  long n_call;
+  long cap_call;
+} SEQ_SNPBATCH;
+
+typedef struct seq_snpchunk
+{
+  char *data;
+  size_t len;
+} SEQ_SNPCHUNK;
+
+typedef struct seq_snpreader
+{
+  gzFile gz;
+  SEQ_BGZF *bgzf;                // in place of gz for a BGZF file
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t filled;         // a chunk is ready, or the reader is done
+  pthread_cond_t drained;        // a chunk is free again
+  SEQ_SNPCHUNK chunk[SEQ_SNPREADER_CHUNKS];
+  int head;                      // next chunk to split
+  int n_full;
+  int eof;
+  int error;
+  int stop;
+  uint64_t offset;               // compressed bytes read so far
+  uint64_t left;                 // bytes of the range still to read
+  int have;                      // the caller holds chunk[head]
+  size_t at;                     // how far into it lines have been taken
+  char *carry;                   // a line that runs across chunks
+  size_t carry_len;
+  size_t carry_cap;
+  long lines;                    // lines seen, kept or not
+  int col[SEQ_SNP_N_COL];        // -1 until set
+  int have_col;
+  int *sample;                   // the column of each sample's call
+  long n_sample;
+  struct seq_vcf *vcf;           // set once the file is seen to be a VCF
+} SEQ_SNPREADER;
+
+SEQ_SNPREADER *seq_snpreader_open( const char *path );
+
+// reads only the bytes [start, end) of a plain (uncompressed) file, end 0 for
+//  the rest of it; start should be just after a newline. Workers annotating a
+//  snpfile in parallel each read a range of it this way.
+SEQ_SNPREADER *seq_snpreader_open_range( const char *path, uint64_t start, uint64_t end );
+void seq_snpreader_close( SEQ_SNPREADER *r );
+
+// the input column of each snp column, -1 for any that is missing
+void seq_snpreader_set_columns( SEQ_SNPREADER *r, const int col[SEQ_SNP_N_COL] );
+
+// the columns of the sample calls to code, in the order the carrier sets are
+//  wanted in; returns 0 when out of memory
+int seq_snpreader_set_samples( SEQ_SNPREADER *r, const int *col, long n );
+
+// fills batch with up to max rows; returns how many, 0 at the end of the file
+//  and -1 when it cannot be read
+long seq_snpreader_read( SEQ_SNPREADER *r, SEQ_SNPBATCH *batch, long max );
+
+// compressed bytes read so far, for progress against the size of the file
+uint64_t seq_snpreader_offset( SEQ_SNPREADER *r );
+
+void seq_snpbatch_free( SEQ_SNPBATCH *batch );
+
+// adds line (len bytes, no newline) to batch as a row, checked and split as
+//  the lines of a snpfile are; returns the row, -1 when it is dropped and -2
+//  when out of memory. Its sample codes are left to the caller.
+long seq_snpreader_add_row( SEQ_SNPREADER *r, SEQ_SNPBATCH *batch, const char *line,
+    size_t len );
+
+// a copy of s as a field of batch, outside any row; -1 when out of memory
+long seq_snpbatch_add_field( SEQ_SNPBATCH *batch, const char *s, size_t len );
+
+// sample's call in the last row of batch is field, and not one of the codes;
+//  calls are added in the order of samples. Returns 0 when out of memory.
+int seq_snpbatch_add_call( SEQ_SNPBATCH *batch, long sample, long field );
+
+static inline const char *seq_snpbatch_field( const SEQ_SNPBATCH *batch, long f,
+    size_t *len )
+{
+  *len = batch->field[f].len;
+  return batch->text + batch->field[f].off;
+}
+
+static inline const uint8_t *seq_snpbatch_geno( const SEQ_SNPBATCH *batch, long row )
+{
+  return batch->geno + row * batch->n_sample;
+}
+
+// splits line (n bytes, no newline) at tabs into at most max fields of
+//  [off, off + len) after base; returns the number of fields, or -1 if the
+//  line has a character get_clean_fields would not take
+long seq_snp_split( const char *line, size_t n, uint32_t base, SEQ_SNPFIELD *out,
+    long max );
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_stats.c
+ * Description: Dense per-sample annotation counts; see seq_stats.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_stats.h"
+
+SEQ_STATS *seq_stats_new( void )
+{
+  SEQ_STATS *stats = (SEQ_STATS *)calloc(1, sizeof(SEQ_STATS));
+  check_mem(stats);
+  return stats;
+
+error:
+  return NULL;
+}
+
+void seq_stats_free( SEQ_STATS *stats )
+{
+  if(!stats)
+    return;
+  seq_dict_free(&stats->samples);
+  seq_dict_free(&stats->cells);
+  free(stats->count);
+  free(stats->seen);
+  free(stats);
+}
+
+// makes room for rows samples of cells cells
+static int grow( SEQ_STATS *stats, long rows, long cells )
+{
+  long capSample = stats->cap_sample ? stats->cap_sample : 64;
+  long capCell = stats->cap_cell ? stats->cap_cell : 16;
+  while(capSample < rows)
+    capSample *= 2;
+  while(capCell < cells)
+    capCell *= 2;
+  if(capSample == stats->cap_sample && capCell == stats->cap_cell)
+    return 1;
+
+  uint32_t *count = (uint32_t *)calloc((size_t)(capSample * capCell), sizeof(uint32_t));
+  check_mem(count);
+  uint8_t *seen = (uint8_t *)realloc(stats->seen, (size_t)capSample);
+  if(!seen)
+  {
+    free(count);
+    check_mem(seen);
+  }
+  memset(seen + stats->cap_sample, 0, (size_t)(capSample - stats->cap_sample));
+  for(long r = 0; r < stats->cap_sample; r++)
+    memcpy(count + r * capCell, stats->count + r * stats->cap_cell,
+        (size_t)stats->cap_cell * sizeof(uint32_t));
+  free(stats->count);
+  stats->count = count;
+  stats->seen = seen;
+  stats->cap_sample = capSample;
+  stats->cap_cell = capCell;
+  return 1;
+
+error:
+  return 0;
+}
+
+long seq_stats_sample( SEQ_STATS *stats, const char *id, size_t len )
+{
+  uint32_t code = seq_dict_intern(&stats->samples, id, len);
+  if(!code || !grow(stats, (long)code, stats->cap_cell))
+    return -1;
+  return (long)code - 1;
+}
+
+long seq_stats_cell( SEQ_STATS *stats, const char *path, size_t len )
+{
+  uint32_t code = seq_dict_intern(&stats->cells, path, len);
+  if(!code || !grow(stats, stats->cap_sample, (long)code))
+    return -1;
+  return (long)code - 1;
+}
+
+// transitions (1) and transversions (0) as one call, and as a reference base
+//  and call; anything else is -1
+static int trtv_one( char g )
+{
+  switch(g)
+  {
+    case 'R': case 'Y':
+      return 1;
+    case 'S': case 'W': case 'K': case 'M':
+      return 0;
+  }
+  return -1;
+}
+
+static int trtv_pair( char a, char b )
+{
+  static const char *const tr[] = { "AG", "GA", "CT", "TC" };
+  static const char *const tv[] = { "AT", "TA", "AC", "CA", "GT", "TG", "GC", "CG" };
+  for(int i = 0; i < 4; i++)
+    if(tr[i][0] == a && tr[i][1] == b)
+      return 1;
+  for(int i = 0; i < 8; i++)
+    if(tv[i][0] == a && tv[i][1] == b)
+      return 0;
+  return -1;
+}
+
+int seq_stats_trtv( char ref, const char *geno, size_t len )
+{
+  if(len == 1)
+  {
+    int t = trtv_one(geno[0]);
+    return t >= 0 ? t : trtv_pair(ref, geno[0]);
+  }
+  // a call of two characters can only be one of the pairs itself
+  if(len == 2)
+    return trtv_pair(geno[0], geno[1]);
+  return -1;
+}
+
+void seq_stats_carrier( SEQ_STATS *stats, long sample, const SEQ_STATS_SITE *site,
+    const char *geno, size_t len )
+{
+  if(len == 1 && geno[0] == site->ref)
+    return;
+
+  uint32_t *row = stats->count + sample * stats->cap_cell;
+  stats->seen[sample] = 1;
+
+  int t = seq_stats_trtv(site->ref, geno, len);
+  if(t >= 0 && site->trtv[t] >= 0)
+    row[site->trtv[t]]++;
+  if(site->snp >= 0)
+    row[site->snp]++;
+
+  if(site->n_feature)
+  {
+    // homozygous calls count both alleles
+    const uint32_t alleles = len == 1 && geno[0] && strchr("ACGTDI", geno[0]) ? 2 : 1;
+    for(int f = 0; f < site->n_feature; f++)
+      row[site->feature[f]] += alleles;
+  }
+}
+
+void seq_stats_reset( SEQ_STATS *stats )
+{
+  if(stats->count)
+    memset(stats->count, 0, (size_t)(stats->cap_sample * stats->cap_cell) * sizeof(uint32_t));
+  if(stats->seen)
+    memset(stats->seen, 0, (size_t)stats->cap_sample);
+}
+
+int seq_stats_merge( SEQ_STATS *to, const SEQ_STATS *from )
+{
+  long *cell = NULL;
+  size_t len;
+  const char *name;
+
+  if(!from->cells.n)
+    return 1;
+  cell = (long *)malloc(from->cells.n * sizeof(long));
+  check_mem(cell);
+  for(uint32_t c = 0; c < from->cells.n; c++)
+  {
+    name = seq_dict_str(&from->cells, c + 1, &len);
+    check_mem(((cell[c] = seq_stats_cell(to, name, len)) >= 0));
+  }
+
+  for(uint32_t s = 0; s < from->samples.n; s++)
+  {
+    name = seq_dict_str(&from->samples, s + 1, &len);
+    long row = seq_stats_sample(to, name, len);
+    check_mem(row >= 0);
+    uint32_t *dst = to->count + row * to->cap_cell;
+    const uint32_t *src = from->count + (long)s * from->cap_cell;
+    to->seen[row] |= from->seen[s];
+    for(uint32_t c = 0; c < from->cells.n; c++)
+      dst[cell[c]] += src[c];
+  }
+  free(cell);
+  return 1;
+
+error:
+  free(cell);
+  return 0;
+}
+
+static int dump_dict( const SEQ_DICT *dict, SEQ_BUF *out )
+{
+  static const uint32_t zero = 0;
+  if(!dict->n)
+    return seq_buf_add(out, (const char *)&zero, sizeof(zero));
+  return seq_buf_add(out, (const char *)dict->off, (dict->n + 1) * sizeof(uint32_t))
+    || seq_buf_add(out, dict->buf, dict->off[dict->n]);
+}
+
+int seq_stats_dump( const SEQ_STATS *stats, SEQ_BUF *out )
+{
+  SEQ_STATS_HEADER head;
+  memset(&head, 0, sizeof(head));
+  memcpy(head.magic, SEQ_STATS_MAGIC, sizeof(SEQ_STATS_MAGIC));
+  head.n_sample = stats->samples.n;
+  head.n_cell = stats->cells.n;
+  head.sample_len = stats->samples.n ? stats->samples.off[stats->samples.n] : 0;
+  head.cell_len = stats->cells.n ? stats->cells.off[stats->cells.n] : 0;
+
+  check_mem(seq_buf_add(out, (const char *)&head, sizeof(head)) == 0);
+  check_mem(dump_dict(&stats->samples, out) == 0);
+  check_mem(dump_dict(&stats->cells, out) == 0);
+  if(head.n_sample)
+  {
+    check_mem(seq_buf_add(out, (const char *)stats->seen, head.n_sample) == 0);
+  }
+  for(uint32_t s = 0; s < head.n_sample; s++)
+  {
+    check_mem(seq_buf_add(out, (const char *)(stats->count + (long)s * stats->cap_cell),
+          head.n_cell * sizeof(uint32_t)) == 0);
+  }
+  return 1;
+
+error:
+  return 0;
+}
+
+static inline uint32_t off_at( const char *off, uint32_t i )
+{
+  uint32_t v;
+  memcpy(&v, off + (size_t)i * sizeof(uint32_t), sizeof(v));
+  return v;
+}
+
+// interns the n strings of a dumped dictionary, in order, so codes match
+static const char *load_dict( SEQ_STATS *stats, int cells, const char *p, const char *end,
+    uint32_t n, uint32_t len )
+{
+  check( ((size_t)(end - p) >= ((size_t)n + 1) * sizeof(uint32_t)),
+      "Statistics dump is cut short." );
+  const char *str = p + ((size_t)n + 1) * sizeof(uint32_t);
+  check( ((size_t)(end - str) >= len && off_at(p, 0) == 0 && off_at(p, n) == len),
+      "Statistics dump is cut short." );
+  for(uint32_t i = 0; i < n; i++)
+  {
+    const uint32_t a = off_at(p, i), b = off_at(p, i + 1);
+    check( (a <= b && b <= len), "Statistics dump is corrupt." );
+    long at = cells ? seq_stats_cell(stats, str + a, b - a)
+      : seq_stats_sample(stats, str + a, b - a);
+    check( (at == (long)i), "Statistics dump repeats a name." );
+  }
+  return str + len;
+
+error:
+  return NULL;
+}
+
+SEQ_STATS *seq_stats_load( const char *bytes, size_t len )
+{
+  SEQ_STATS *stats = NULL;
+  SEQ_STATS_HEADER head;
+  const char *p = bytes, *end = bytes + len;
+
+  check( (len >= sizeof(head)), "Statistics dump is cut short." );
+  memcpy(&head, p, sizeof(head));
+  p += sizeof(head);
+  check( (memcmp(head.magic, SEQ_STATS_MAGIC, sizeof(SEQ_STATS_MAGIC)) == 0),
+      "Not a statistics dump." );
+  check_mem((stats = seq_stats_new()));
+
+  check( ((p = load_dict(stats, 0, p, end, head.n_sample, head.sample_len)) != NULL),
+      "Cannot read the samples of a statistics dump." );
+  check( ((p = load_dict(stats, 1, p, end, head.n_cell, head.cell_len)) != NULL),
+      "Cannot read the cells of a statistics dump." );
+  check( ((size_t)(end - p) == head.n_sample * (1 + (size_t)head.n_cell * sizeof(uint32_t))),
+      "Statistics dump is cut short." );
+
+  if(head.n_sample)
+  {
+    memcpy(stats->seen, p, head.n_sample);
+    p += head.n_sample;
+  }
+  for(uint32_t s = 0; s < head.n_sample; s++)
+  {
+    memcpy(stats->count + (long)s * stats->cap_cell, p, head.n_cell * sizeof(uint32_t));
+    p += head.n_cell * sizeof(uint32_t);
+  }
+  return stats;
+
+error:
+  seq_stats_free(stats);
+  return NULL;
+}
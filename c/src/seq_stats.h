@@ -0,0 +1,104 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_stats.h
+ * Description: Per-sample annotation counts, as Seq::Statistics::Record keeps
+ *  them, in one dense table.
+ *
+ *  Record nests a hash per sample, feature and feature under it, and counts
+ *  at each level; here each such place is a cell, named by the path of
+ *  features to it joined by tabs ("SNP", "SNP\tExonic", "Transitions"), and
+ *  the counts are a row of cells per sample. Samples and cells are interned
+ *  as they come (seq_dict.h), so a site costs a few increments per carrier
+ *  in its sample's row and the hashes are made once, from the table.
+ *
+ *  Tables kept apart, by the workers of a job or the jobs of a cohort split
+ *  across nodes, merge by name, in any order and grouping, into the table
+ *  one job would have kept. A table dumps as a header, the dictionaries of
+ *  samples and cells (their offsets, then their strings), a byte per sample
+ *  for seen and the counts, a row of n_cell per sample.
+ */
+
+#ifndef __seq_stats_h__
+#define __seq_stats_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seq_dict.h"
+#include "seq_buf.h"
+
+#define SEQ_STATS_MAGIC "SEQSTA1"
+#define SEQ_STATS_FEATURES 8
+
+typedef struct seq_stats_header
+{
+  char magic[8];
+  uint32_t n_sample;
+  uint32_t n_cell;
+  uint32_t sample_len;     // bytes of the samples' strings
+  uint32_t cell_len;
+} SEQ_STATS_HEADER;
+
+typedef struct seq_stats
+{
+  SEQ_DICT samples;        // code - 1 is the row
+  SEQ_DICT cells;          // code - 1 is the column
+  uint32_t *count;         // cap_sample rows of cap_cell
+  uint8_t *seen;           // of each sample: a call other than ref was counted
+  long cap_sample;
+  long cap_cell;
+} SEQ_STATS;
+
+// what a site counts for each carrier: 1 in the transversion or transition
+//  cell (trtv[0], trtv[1]) of the call, 1 in the cell of the site's snp
+//  annotation (rs or noRs), and the carrier's alleles in each feature cell;
+//  -1 for cells not counted
+typedef struct seq_stats_site
+{
+  char ref;
+  int trtv[2];
+  int snp;
+  int feature[SEQ_STATS_FEATURES];
+  int n_feature;
+} SEQ_STATS_SITE;
+
+SEQ_STATS *seq_stats_new( void );
+void seq_stats_free( SEQ_STATS *stats );
+
+// the row of a sample, or column of a cell, added as needed; -1 when out of
+//  memory
+long seq_stats_sample( SEQ_STATS *stats, const char *id, size_t len );
+long seq_stats_cell( SEQ_STATS *stats, const char *path, size_t len );
+
+// 1 when a call is a transition at ref, 0 a transversion, -1 neither, as
+//  Record::countCustomFeatures decides
+int seq_stats_trtv( char ref, const char *geno, size_t len );
+
+// counts a sample's call at a site, unless it is the reference
+void seq_stats_carrier( SEQ_STATS *stats, long sample, const SEQ_STATS_SITE *site,
+    const char *geno, size_t len );
+
+static inline uint32_t seq_stats_get( const SEQ_STATS *stats, long sample, long cell )
+{
+  return stats->count[sample * stats->cap_cell + cell];
+}
+
+// zeroes the counts, keeping the samples and cells
+void seq_stats_reset( SEQ_STATS *stats );
+
+// adds the counts of from into to, matching samples and cells by name; 0
+//  when out of memory
+int seq_stats_merge( SEQ_STATS *to, const SEQ_STATS *from );
+
+// the table as bytes, appended to out, and back; 0 (NULL) when out of memory
+//  or the bytes are not a table
+int seq_stats_dump( const SEQ_STATS *stats, SEQ_BUF *out );
+SEQ_STATS *seq_stats_load( const char *bytes, size_t len );
+
+#endif
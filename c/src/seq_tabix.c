@@ -0,0 +1,348 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_tabix.c
+ * Description: Tabix index, made inline; see seq_tabix.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "dbg.h"
+#include "seq_bgzf.h"
+#include "seq_tabix.h"
+
+#define TBX_META '#'
+
+SEQ_TABIX *seq_tabix_new( int col_seq, int col_beg )
+{
+  SEQ_TABIX *ix = (SEQ_TABIX *)calloc(1, sizeof(SEQ_TABIX));
+  check_mem(ix);
+  ix->col_seq = col_seq;
+  ix->col_beg = col_beg;
+  check_mem((ix->bin_at = (uint32_t *)calloc(SEQ_TABIX_BINS, sizeof(uint32_t))));
+  return ix;
+
+error:
+  seq_tabix_free(ix);
+  return NULL;
+}
+
+void seq_tabix_free( SEQ_TABIX *ix )
+{
+  if(!ix)
+    return;
+  for(uint32_t r = 0; r < ix->n_ref; r++)
+  {
+    for(uint32_t b = 0; b < ix->ref[r].n_bin; b++)
+      free(ix->ref[r].bin[b].chunk);
+    free(ix->ref[r].bin);
+    free(ix->ref[r].ioff);
+  }
+  free(ix->ref);
+  free(ix->bin_at);
+  seq_dict_free(&ix->names);
+  seq_buf_free(&ix->line);
+  free(ix);
+}
+
+// the smallest bin holding [beg, end), as in the SAM specification
+static uint32_t reg2bin( long beg, long end )
+{
+  --end;
+  if(beg >> 14 == end >> 14)
+    return ((1 << 15) - 1) / 7 + (uint32_t)(beg >> 14);
+  if(beg >> 17 == end >> 17)
+    return ((1 << 12) - 1) / 7 + (uint32_t)(beg >> 17);
+  if(beg >> 20 == end >> 20)
+    return ((1 << 9) - 1) / 7 + (uint32_t)(beg >> 20);
+  if(beg >> 23 == end >> 23)
+    return ((1 << 6) - 1) / 7 + (uint32_t)(beg >> 23);
+  if(beg >> 26 == end >> 26)
+    return ((1 << 3) - 1) / 7 + (uint32_t)(beg >> 26);
+  return 0;
+}
+
+static void *grow( void *p, uint32_t *cap, uint32_t need, size_t size )
+{
+  if(need <= *cap)
+    return p;
+  uint32_t c = *cap ? *cap : 4;
+  while(c < need)
+    c *= 2;
+  void *q = realloc(p, c * size);
+  if(q)
+    *cap = c;
+  return q;
+}
+
+// the row covering [beg, end) of the sequence chr, at [voff, vend) in the file
+static int add_row( SEQ_TABIX *ix, const char *chr, size_t chrLen, long beg, long end,
+    uint64_t voff, uint64_t vend )
+{
+  uint32_t code = seq_dict_find(&ix->names, chr, chrLen);
+  if(!code || code != ix->n_ref)
+  {
+    // a new sequence; one seen before means the rows are not sorted
+    if(code)
+    {
+      ix->bad = 1;
+      return 1;
+    }
+    check_mem((code = seq_dict_intern(&ix->names, chr, chrLen)));
+    check_mem((ix->ref = (SEQ_TABIX_REF *)grow(ix->ref, &ix->cap_ref, code,
+          sizeof(SEQ_TABIX_REF))));
+    memset(&ix->ref[code - 1], 0, sizeof(SEQ_TABIX_REF));
+    ix->n_ref = code;
+    memset(ix->bin_at, 0, SEQ_TABIX_BINS * sizeof(uint32_t));
+    ix->last_beg = 0;
+  }
+  if(beg < ix->last_beg || end > SEQ_TABIX_MAX_POS)
+  {
+    ix->bad = 1;
+    return 1;
+  }
+  ix->last_beg = beg;
+
+  SEQ_TABIX_REF *ref = &ix->ref[code - 1];
+  uint32_t bin = reg2bin(beg, end);
+  if(!ix->bin_at[bin])
+  {
+    check_mem((ref->bin = (SEQ_TABIX_BIN *)grow(ref->bin, &ref->cap_bin, ref->n_bin + 1,
+          sizeof(SEQ_TABIX_BIN))));
+    memset(&ref->bin[ref->n_bin], 0, sizeof(SEQ_TABIX_BIN));
+    ref->bin[ref->n_bin].bin = bin;
+    ix->bin_at[bin] = ++ref->n_bin;
+  }
+  SEQ_TABIX_BIN *b = &ref->bin[ix->bin_at[bin] - 1];
+  if(b->n_chunk && b->chunk[b->n_chunk - 1].end == voff)
+    b->chunk[b->n_chunk - 1].end = vend;
+  else
+  {
+    check_mem((b->chunk = (SEQ_TABIX_CHUNK *)grow(b->chunk, &b->cap_chunk, b->n_chunk + 1,
+          sizeof(SEQ_TABIX_CHUNK))));
+    b->chunk[b->n_chunk].beg = voff;
+    b->chunk[b->n_chunk++].end = vend;
+  }
+
+  uint32_t first = (uint32_t)(beg >> SEQ_TABIX_SHIFT), last = (uint32_t)((end - 1) >> SEQ_TABIX_SHIFT);
+  if(last >= ref->n_intv)
+  {
+    check_mem((ref->ioff = (uint64_t *)grow(ref->ioff, &ref->cap_intv, last + 1,
+          sizeof(uint64_t))));
+    for(uint32_t w = ref->n_intv; w <= last; w++)
+      ref->ioff[w] = UINT64_MAX;
+    ref->n_intv = last + 1;
+  }
+  for(uint32_t w = first; w <= last; w++)
+    if(ref->ioff[w] == UINT64_MAX)
+      ref->ioff[w] = voff;
+  ix->rows++;
+  return 1;
+
+error:
+  return 0;
+}
+
+// the field'th (1-based) tab separated field of the line, or NULL
+static const char *field( const char *line, size_t len, int col, size_t *fieldLen )
+{
+  const char *p = line, *end = line + len;
+  for(int i = 1; i < col; i++)
+  {
+    const char *tab = memchr(p, '\t', (size_t)(end - p));
+    if(!tab)
+      return NULL;
+    p = tab + 1;
+  }
+  const char *tab = memchr(p, '\t', (size_t)(end - p));
+  *fieldLen = (size_t)((tab ? tab : end) - p);
+  return p;
+}
+
+static int add_line( SEQ_TABIX *ix, const char *line, size_t len, uint64_t voff, uint64_t vend )
+{
+  size_t chrLen = 0, posLen = 0;
+  const char *chr = field(line, len, ix->col_seq, &chrLen);
+  const char *pos = field(line, len, ix->col_beg, &posLen);
+  long beg = 0;
+  int ok = chr && chrLen && pos && posLen && posLen < 12;
+
+  for(size_t i = 0; ok && i < posLen; i++)
+  {
+    ok = pos[i] >= '0' && pos[i] <= '9';
+    beg = beg * 10 + (pos[i] - '0');
+  }
+  if(!ok || beg < 1)
+  {
+    if(len && line[0] == TBX_META)
+      return 1;
+    // a header; past the first row, a line tabix could not read either
+    if(ix->rows)
+      ix->bad = 1;
+    else
+      ix->skip++;
+    return 1;
+  }
+  return add_row(ix, chr, chrLen, beg - 1, beg, voff, vend);
+}
+
+static inline uint64_t voff_at( size_t at, size_t len, const uint64_t *block_off,
+    uint64_t next_off )
+{
+  if(at >= len)
+    return next_off << 16;
+  return block_off[at / SEQ_BGZF_TEXT] << 16 | (at % SEQ_BGZF_TEXT);
+}
+
+int seq_tabix_text( SEQ_TABIX *ix, const char *text, size_t len, const uint64_t *block_off,
+    uint64_t next_off )
+{
+  size_t at = 0;
+  while(at < len && !ix->bad)
+  {
+    const char *nl = memchr(text + at, '\n', len - at);
+    if(!nl)
+    {
+      // the rest of the line comes with the next text
+      if(!ix->line.len)
+        ix->line_voff = voff_at(at, len, block_off, next_off);
+      check_mem(seq_buf_add(&ix->line, text + at, len - at) == 0);
+      return 1;
+    }
+    size_t end = (size_t)(nl - text) + 1;
+    uint64_t vend = voff_at(end, len, block_off, next_off);
+    if(ix->line.len)
+    {
+      check_mem(seq_buf_add(&ix->line, text + at, end - at - 1) == 0);
+      check_mem(add_line(ix, ix->line.s, ix->line.len, ix->line_voff, vend));
+      ix->line.len = 0;
+    }
+    else
+    {
+      check_mem(add_line(ix, text + at, end - at - 1, voff_at(at, len, block_off, next_off),
+            vend));
+    }
+    at = end;
+  }
+  return 1;
+
+error:
+  return 0;
+}
+
+int seq_tabix_end( SEQ_TABIX *ix, uint64_t end_off )
+{
+  if(!ix->line.len || ix->bad)
+    return 1;
+  int ok = add_line(ix, ix->line.s, ix->line.len, ix->line_voff, end_off << 16);
+  ix->line.len = 0;
+  return ok;
+}
+
+static int put32( SEQ_BUF *out, int32_t v )
+{
+  unsigned char b[4] = { v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (uint32_t)v >> 24 };
+  return seq_buf_add(out, (const char *)b, 4);
+}
+
+static int put64( SEQ_BUF *out, uint64_t v )
+{
+  return put32(out, (int32_t)(v & 0xffffffff)) | put32(out, (int32_t)(v >> 32));
+}
+
+int seq_tabix_write( SEQ_TABIX *ix, const char *path, int level )
+{
+  SEQ_BUF out = { 0 };
+  FILE *fh = NULL;
+  z_stream zs;
+  int inited = 0;
+  unsigned char *block = NULL;
+  int err = 0;
+
+  check( (!ix->bad), "The rows are not sorted; not indexing them." );
+
+  // the header: tabix's generic format, the columns, '#' for comments
+  err |= seq_buf_add(&out, "TBI\1", 4);
+  err |= put32(&out, (int32_t)ix->n_ref);
+  err |= put32(&out, 0);
+  err |= put32(&out, ix->col_seq);
+  err |= put32(&out, ix->col_beg);
+  err |= put32(&out, 0);
+  err |= put32(&out, TBX_META);
+  err |= put32(&out, ix->skip);
+  err |= put32(&out, (int32_t)(ix->n_ref ? ix->names.off[ix->n_ref] + ix->n_ref : 0));
+  for(uint32_t r = 1; r <= ix->n_ref; r++)
+  {
+    size_t len;
+    const char *name = seq_dict_str(&ix->names, r, &len);
+    err |= seq_buf_add(&out, name, len);
+    err |= seq_buf_putc(&out, '\0');
+  }
+
+  for(uint32_t r = 0; r < ix->n_ref; r++)
+  {
+    SEQ_TABIX_REF *ref = &ix->ref[r];
+    err |= put32(&out, (int32_t)ref->n_bin);
+    for(uint32_t b = 0; b < ref->n_bin; b++)
+    {
+      err |= put32(&out, (int32_t)ref->bin[b].bin);
+      err |= put32(&out, (int32_t)ref->bin[b].n_chunk);
+      for(uint32_t c = 0; c < ref->bin[b].n_chunk; c++)
+        err |= put64(&out, ref->bin[b].chunk[c].beg) | put64(&out, ref->bin[b].chunk[c].end);
+    }
+
+    // windows no row starts in read from where the one before did
+    err |= put32(&out, (int32_t)ref->n_intv);
+    uint64_t last = ref->n_intv ? UINT64_MAX : 0;
+    for(uint32_t w = 0; w < ref->n_intv && last == UINT64_MAX; w++)
+      last = ref->ioff[w];
+    for(uint32_t w = 0; w < ref->n_intv; w++)
+    {
+      if(ref->ioff[w] != UINT64_MAX)
+        last = ref->ioff[w];
+      err |= put64(&out, last);
+    }
+  }
+  check_mem(!err);
+
+  memset(&zs, 0, sizeof(zs));
+  check( (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK),
+      "Cannot start compressing." );
+  inited = 1;
+  check_mem((block = (unsigned char *)malloc(SEQ_BGZF_MAX)));
+  check( ((fh = fopen(path, "wb")) != NULL), "Cannot write the index '%s'.", path );
+  for(size_t at = 0; at < out.len; at += SEQ_BGZF_TEXT)
+  {
+    size_t len = out.len - at < SEQ_BGZF_TEXT ? out.len - at : SEQ_BGZF_TEXT;
+    size_t size = seq_bgzf_deflate(&zs, level, out.s + at, len, block);
+    check( (size && fwrite(block, 1, size, fh) == size), "Cannot write the index '%s'.", path );
+  }
+  check( (fwrite(seq_bgzf_eof, 1, SEQ_BGZF_EOF_LEN, fh) == SEQ_BGZF_EOF_LEN),
+      "Cannot write the index '%s'.", path );
+  check( (fclose(fh) == 0), "Cannot write the index '%s'.", path );
+  fh = NULL;
+
+  deflateEnd(&zs);
+  free(block);
+  seq_buf_free(&out);
+  return 1;
+
+error:
+  if(fh)
+  {
+    fclose(fh);
+    remove(path);
+  }
+  if(inited)
+    deflateEnd(&zs);
+  free(block);
+  seq_buf_free(&out);
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_tabix.h
+ * Description: A tabix (.tbi) index of a BGZF file of tab separated rows,
+ *  made as the rows are written.
+ *
+ *  Each row is a 1-based position on a sequence, in columns col_seq and
+ *  col_beg, taken as covering that one base. The index keeps, for each
+ *  sequence, the chunks of the file (virtual offsets, see seq_bgzf.h) whose
+ *  rows fall in each bin of the UCSC binning scheme (bins of 16K, 128K, 1M,
+ *  8M, 64M and 512M bases), and, for each 16K window, the offset of the
+ *  first row reaching it; tabix, htslib and the readers built on them seek
+ *  to a region with it.
+ *
+ *  Rows must come sorted by position with the rows of a sequence together,
+ *  as they are in a sorted snpfile; once they are not, or a position is past
+ *  what a .tbi holds (2^29), the index is given up (bad is set). Leading
+ *  lines without a position (the header) are skipped, as are lines that
+ *  start with '#'.
+ */
+
+#ifndef __seq_tabix_h__
+#define __seq_tabix_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seq_buf.h"
+#include "seq_dict.h"
+
+#define SEQ_TABIX_MAX_POS  (1L << 29)
+#define SEQ_TABIX_SHIFT    14          // of the linear index's windows
+#define SEQ_TABIX_BINS     37450       // 4681 * 8 + 1 bins per sequence
+
+typedef struct seq_tabix_chunk
+{
+  uint64_t beg;
+  uint64_t end;
+} SEQ_TABIX_CHUNK;
+
+typedef struct seq_tabix_bin
+{
+  uint32_t bin;
+  uint32_t n_chunk;
+  uint32_t cap_chunk;
+  SEQ_TABIX_CHUNK *chunk;
+} SEQ_TABIX_BIN;
+
+typedef struct seq_tabix_ref
+{
+  SEQ_TABIX_BIN *bin;
+  uint32_t n_bin;
+  uint32_t cap_bin;
+  uint64_t *ioff;          // of each window; UINT64_MAX until a row reaches it
+  uint32_t n_intv;
+  uint32_t cap_intv;
+} SEQ_TABIX_REF;
+
+typedef struct seq_tabix
+{
+  int col_seq;             // 1-based
+  int col_beg;
+  int skip;                // leading lines that are not rows
+  int bad;
+  long rows;
+  SEQ_DICT names;          // the code of a sequence is 1 + its ref
+  SEQ_TABIX_REF *ref;
+  uint32_t n_ref;
+  uint32_t cap_ref;
+  uint32_t *bin_at;        // 1 + the place in the last ref's bins of each bin
+  long last_beg;
+  SEQ_BUF line;            // a line whose text has not all come yet
+  uint64_t line_voff;
+} SEQ_TABIX;
+
+SEQ_TABIX *seq_tabix_new( int col_seq, int col_beg );
+void seq_tabix_free( SEQ_TABIX *ix );
+
+// indexes the lines of len bytes of text, the text of consecutive blocks of
+//  SEQ_BGZF_TEXT bytes (the last of what is left) starting at the file
+//  offsets block_off, next_off being where the block after them starts. A
+//  line the text ends within is finished by the next call, or seq_tabix_end.
+//  Returns 0 when out of memory.
+int seq_tabix_text( SEQ_TABIX *ix, const char *text, size_t len, const uint64_t *block_off,
+    uint64_t next_off );
+
+// no more text: indexes a last line without a newline, ending at end_off
+int seq_tabix_end( SEQ_TABIX *ix, uint64_t end_off );
+
+// writes the index to path, BGZF compressed at level; 1 when written
+int seq_tabix_write( SEQ_TABIX *ix, const char *path, int level );
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_track.c
+ * Description: Memory-mapped genome-sized track reader; see seq_track.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include "dbg.h"
+#include "seq_track.h"
+
+SEQ_TRACK *seq_track_open( const char *path, int width )
+{
+  SEQ_TRACK *track = NULL;
+  struct stat st;
+  void *map = MAP_FAILED;
+
+  check( (width == SEQ_TRACK_CHAR || width == SEQ_TRACK_NGENE),
+      "Impossible track width %d for '%s'.", width, path );
+  check( strlen(path) < sizeof(track->path), "Path too long '%s'.", path );
+
+  track = (SEQ_TRACK *)calloc(1, sizeof(SEQ_TRACK));
+  check_mem(track);
+  track->fd = -1;
+  strcpy(track->path, path);
+
+  check( ((track->fd = open(path, O_RDONLY)) != -1), "Cannot open track '%s'.", path );
+  check( (fstat(track->fd, &st) == 0), "Cannot stat track '%s'.", path );
+  check( (st.st_size > 0), "Track '%s' is zero-sized.", path );
+
+  // MAP_SHARED so every process that maps the file reads the same pages
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, track->fd, 0);
+  check( (map != MAP_FAILED), "Cannot map track '%s'.", path );
+
+  // lookups are scattered over the genome; don't let the kernel read ahead
+  madvise(map, (size_t)st.st_size, MADV_RANDOM);
+
+  track->data   = (const unsigned char *)map;
+  track->size   = (long)st.st_size;
+  track->width  = width;
+  track->length = track->size / width;
+
+  for(int i = 0; i < 256; i++)
+    track->score[i] = NAN;
+
+  return track;
+
+error:
+  if(track)
+  {
+    if(track->fd != -1)
+      close(track->fd);
+    free(track);
+  }
+  return NULL;
+}
+
+void seq_track_close( SEQ_TRACK *track )
+{
+  if(!track)
+    return;
+  if(track->data)
+    munmap((void *)track->data, (size_t)track->size);
+  if(track->fd != -1)
+    close(track->fd);
+  free(track);
+}
+
+int seq_track_set_score( SEQ_TRACK *track, double min, double max, int R )
+{
+  check( (min < max), "Impossible max = %g  min = %g.", max, min );
+  check( ((R >= 5) && (R < 256)), "Impossible R [5..255] = %d.", R );
+
+  double beta = (double)(R - 1) / (max - min);
+
+  track->score[0] = NAN;
+  for(int i = 1; i < 256; i++)
+    track->score[i] = (i <= R) ? ((double)(i - 1) / beta) + min : NAN;
+  for(int i = 0; i < 256; i++)
+  {
+    int len = isnan(track->score[i]) ? snprintf(track->score_text[i], SEQ_TRACK_SCORE_TEXT, "NA")
+      : snprintf(track->score_text[i], SEQ_TRACK_SCORE_TEXT, "%0.3f", track->score[i]);
+    check( (len > 0 && len < SEQ_TRACK_SCORE_TEXT), "Impossible score %g.", track->score[i] );
+    track->score_len[i] = (unsigned char)len;
+  }
+  track->has_score = 1;
+  return 0;
+
+error:
+  return 1;
+}
+
+double seq_track_get_score( const SEQ_TRACK *track, long pos )
+{
+  int code = seq_track_get_base(track, pos);
+  if(code < 0)
+    return NAN;
+  return track->score[code];
+}
@@ -0,0 +1,84 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_track.h
+ * Description: Read-only, memory-mapped access to the genome-sized tracks
+ *  written by genome_hasher, genome_scorer, genome_cadd and the ngene helper.
+ *  A track is one byte per genome position (genome, score, cadd) or two bytes
+ *  per position in network order (ngene). Mapping the files instead of
+ *  reading them means startup costs nothing and forked annotation workers
+ *  share one page-cache copy of each track.
+ */
+
+#ifndef __seq_track_h__
+#define __seq_track_h__
+
+#include <stdint.h>
+
+#define SEQ_TRACK_CHAR 1
+#define SEQ_TRACK_NGENE 2
+#define SEQ_TRACK_SCORE_TEXT 24        // bytes of a score's text, at most
+
+typedef struct seq_track
+{
+  char path[4096];
+  int fd;
+  const unsigned char *data;
+  long size;               // bytes in the mapped file
+  long length;             // number of positions, i.e., size / width
+  int width;               // bytes per position, SEQ_TRACK_CHAR or SEQ_TRACK_NGENE
+  int has_score;           // set once seq_track_set_score() has been called
+  double score[256];       // decoded value of each code; NAN for 'NA'
+  char score_text[256][SEQ_TRACK_SCORE_TEXT];   // each as output has it
+  unsigned char score_len[256];
+} SEQ_TRACK;
+
+SEQ_TRACK *seq_track_open( const char *path, int width );
+void seq_track_close( SEQ_TRACK *track );
+
+/*
+ * Mirrors Seq::Config::GenomeSizedTrack::_build_score_lu: code 0 is 'NA',
+ * codes 1..R map linearly onto [min, max] and codes above R are 'NA'. The
+ * text of each code, 'NA' or %0.3f as Seq::GenomeBin::get_score renders it,
+ * is made here too, so output copies it rather than printing the double.
+ */
+int seq_track_set_score( SEQ_TRACK *track, double min, double max, int R );
+
+/*
+ * Accessors take the zero-indexed absolute position and return -1 (or NAN
+ * for scores) when the position is outside the track.
+ */
+static inline int seq_track_get_base( const SEQ_TRACK *track, long pos )
+{
+  if( pos < 0 || pos >= track->length )
+    return -1;
+  return track->data[pos];
+}
+
+static inline int seq_track_get_nearest_gene( const SEQ_TRACK *track, long pos )
+{
+  if( pos < 0 || pos >= track->length )
+    return -1;
+  const unsigned char *p = track->data + pos * SEQ_TRACK_NGENE;
+  return (p[0] << 8) | p[1];
+}
+
+double seq_track_get_score( const SEQ_TRACK *track, long pos );
+
+// the text of the score at pos ('NA' outside the track), of *len bytes
+static inline const char *seq_track_score_text( const SEQ_TRACK *track, long pos, int *len )
+{
+  int code = seq_track_get_base(track, pos);
+  if(code < 0)
+    code = 0;
+  *len = track->score_len[code];
+  return track->score_text[code];
+}
+
+#endif
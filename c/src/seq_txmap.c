@@ -0,0 +1,348 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_txmap.c
+ * Description: Transcript coordinate mapper; see seq_txmap.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_txmap.h"
+
+// a transcript site, i.e., one that has an offset into its transcript
+static int tx_site( const SEQ_GENEDB_SITE *site )
+{
+  return site->type != SEQ_GENE_SPLICE_ACCEPTOR && site->type != SEQ_GENE_SPLICE_DONOR;
+}
+
+static int compare_tx( const void *a, const void *b )
+{
+  const SEQ_TXMAP_TX *x = (const SEQ_TXMAP_TX *)a;
+  const SEQ_TXMAP_TX *y = (const SEQ_TXMAP_TX *)b;
+  if(x->start != y->start)
+    return (x->start > y->start) - (x->start < y->start);
+  return (x->tx > y->tx) - (x->tx < y->tx);
+}
+
+SEQ_TXMAP *seq_txmap_new( const SEQ_GENEDB *db )
+{
+  const long nTx = db->header->n_tx;
+  const long nSite = db->header->n_site;
+  SEQ_TXMAP *map = NULL;
+  long *last = NULL;             // per transcript: last site seen, or -1
+  long *next = NULL;             // per transcript: where its next exon goes
+  SEQ_TXMAP_EXON *exon = NULL;
+
+  map = (SEQ_TXMAP *)calloc(1, sizeof(SEQ_TXMAP));
+  check_mem(map);
+  map->db = db;
+  map->n_tx = nTx;
+  map->tx = (SEQ_TXMAP_TX *)calloc(nTx ? nTx : 1, sizeof(SEQ_TXMAP_TX));
+  map->max_end = (uint32_t *)calloc(nTx ? nTx : 1, sizeof(uint32_t));
+  last = (long *)malloc(sizeof(long) * (nTx ? nTx : 1));
+  next = (long *)malloc(sizeof(long) * (nTx ? nTx : 1));
+  check_mem(map->tx && map->max_end && last && next);
+
+  for(long t = 0; t < nTx; t++)
+  {
+    map->tx[t].tx = (uint32_t)t;
+    map->tx[t].strand = db->tx[t].strand;
+    map->tx[t].cds_start = db->tx[t].cds_start;
+    map->tx[t].cds_end = -1;
+    last[t] = -1;
+  }
+
+  // sites come in genomic order, so each transcript's do too; an exon ends
+  //  where either position stops stepping by one
+  for(int pass = 0; pass < 2; pass++)
+  {
+    for(long t = 0; t < nTx; t++)
+      last[t] = -1;
+    for(long i = 0; i < nSite; i++)
+    {
+      const SEQ_GENEDB_SITE *site = &db->site[i];
+      if(!tx_site(site))
+        continue;
+      SEQ_TXMAP_TX *tx = &map->tx[site->tx];
+      const int step = tx->strand == '-' ? -1 : 1;
+      const long prev = last[site->tx];
+      last[site->tx] = i;
+      if(prev >= 0 && db->pos[prev] + 1 == db->pos[i]
+          && (long)db->site[prev].offset + step == (long)site->offset)
+      {
+        if(pass)
+        {
+          exon[next[site->tx]].end = db->pos[i] + 1;
+          if(step < 0)
+            exon[next[site->tx]].tx_off = site->offset;
+        }
+        continue;
+      }
+      if(pass == 0)
+      {
+        if(tx->n_exon == 0)
+          tx->start = db->pos[i];
+        tx->n_exon++;
+        continue;
+      }
+      next[site->tx] = prev >= 0 ? next[site->tx] + 1 : tx->exon;
+      exon[next[site->tx]].start = db->pos[i];
+      exon[next[site->tx]].end = db->pos[i] + 1;
+      exon[next[site->tx]].tx_off = site->offset;
+    }
+
+    if(pass == 0)
+    {
+      // the span and cds end need every site, not just the exon starts
+      for(long i = 0; i < nSite; i++)
+      {
+        const SEQ_GENEDB_SITE *site = &db->site[i];
+        SEQ_TXMAP_TX *tx = &map->tx[site->tx];
+        if(!tx_site(site))
+          continue;
+        tx->end = db->pos[i] + 1;
+        if(site->type == SEQ_GENE_CODING && (int32_t)site->offset >= tx->cds_end)
+          tx->cds_end = (int32_t)site->offset + 1;
+      }
+      for(long t = 0; t < nTx; t++)
+      {
+        map->tx[t].exon = (uint32_t)map->n_exon;
+        map->n_exon += map->tx[t].n_exon;
+      }
+      exon = map->exon = (SEQ_TXMAP_EXON *)calloc(map->n_exon ? map->n_exon : 1,
+          sizeof(SEQ_TXMAP_EXON));
+      check_mem(exon);
+    }
+  }
+
+  // transcripts without a single transcript site cannot be mapped
+  long n = 0;
+  for(long t = 0; t < nTx; t++)
+  {
+    if(map->tx[t].n_exon)
+      map->tx[n++] = map->tx[t];
+  }
+  map->n_tx = n;
+  qsort(map->tx, n, sizeof(SEQ_TXMAP_TX), compare_tx);
+  for(long t = 0; t < n; t++)
+    map->max_end[t] = t && map->max_end[t - 1] > map->tx[t].end ? map->max_end[t - 1]
+      : map->tx[t].end;
+
+  free(last);
+  free(next);
+  return map;
+
+error:
+  free(last);
+  free(next);
+  seq_txmap_free(map);
+  return NULL;
+}
+
+SEQ_TXMAP *seq_txmap_open( const char *path )
+{
+  SEQ_GENEDB *db = seq_genedb_open(path);
+  SEQ_TXMAP *map = db ? seq_txmap_new(db) : NULL;
+  if(!map)
+  {
+    seq_genedb_close(db);
+    return NULL;
+  }
+  map->own_db = db;
+  return map;
+}
+
+void seq_txmap_free( SEQ_TXMAP *map )
+{
+  if(!map)
+    return;
+  seq_genedb_close(map->own_db);
+  free(map->tx);
+  free(map->max_end);
+  free(map->exon);
+  free(map);
+}
+
+// transcript offset of an exonic position
+static long exon_offset( const SEQ_TXMAP_EXON *e, char strand, long abs_pos )
+{
+  if(strand == '-')
+    return e->tx_off + ((long)e->end - 1 - abs_pos);
+  return e->tx_off + (abs_pos - e->start);
+}
+
+int seq_txmap_map( const SEQ_TXMAP *map, long t, long abs_pos, SEQ_TXMAP_POS *out )
+{
+  const SEQ_TXMAP_TX *tx = &map->tx[t];
+  const SEQ_TXMAP_EXON *exon = map->exon + tx->exon;
+
+  if(abs_pos < tx->start || abs_pos >= tx->end)
+    return 0;
+
+  // last exon starting at or before the position
+  long lo = 0, hi = tx->n_exon;
+  while(hi - lo > 1)
+  {
+    long mid = (lo + hi) >> 1;
+    if(exon[mid].start <= abs_pos)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  out->tx = tx->tx;
+  out->intron = 0;
+  if(abs_pos < exon[lo].end)
+    out->tx_offset = exon_offset(&exon[lo], tx->strand, abs_pos);
+  else
+  {
+    // in the intron after exon lo; numbered from the nearest exon base, the
+    //  upstream one (in the direction of transcription) on a tie
+    const SEQ_TXMAP_EXON *left = &exon[lo], *right = &exon[lo + 1];
+    long dLeft = abs_pos - ((long)left->end - 1);
+    long dRight = (long)right->start - abs_pos;
+    if(tx->strand == '-')
+    {
+      if(dRight <= dLeft)
+      {
+        out->tx_offset = exon_offset(right, '-', right->start);
+        out->intron = dRight;
+      }
+      else
+      {
+        out->tx_offset = exon_offset(left, '-', left->end - 1);
+        out->intron = -dLeft;
+      }
+    }
+    else
+    {
+      if(dLeft <= dRight)
+      {
+        out->tx_offset = exon_offset(left, '+', left->end - 1);
+        out->intron = dLeft;
+      }
+      else
+      {
+        out->tx_offset = exon_offset(right, '+', right->start);
+        out->intron = -dRight;
+      }
+    }
+  }
+
+  const long off = out->tx_offset;
+  out->p_pos = 0;
+  if(tx->cds_start < 0 || tx->cds_end <= tx->cds_start)
+  {
+    out->kind = SEQ_TXMAP_NONCODING;
+    out->c_pos = off + 1;
+  }
+  else if(off < tx->cds_start)
+  {
+    out->kind = SEQ_TXMAP_UTR5;
+    out->c_pos = off - tx->cds_start;
+  }
+  else if(off >= tx->cds_end)
+  {
+    out->kind = SEQ_TXMAP_UTR3;
+    out->c_pos = off - tx->cds_end + 1;
+  }
+  else
+  {
+    out->kind = SEQ_TXMAP_CDS;
+    out->c_pos = off - tx->cds_start + 1;
+    if(out->intron == 0)
+      out->p_pos = (out->c_pos + 2) / 3;
+  }
+  return 1;
+}
+
+// index of the first transcript that starts after abs_pos
+static long upper_bound( const SEQ_TXMAP *map, long abs_pos )
+{
+  long lo = 0, hi = map->n_tx;
+  while(lo < hi)
+  {
+    long mid = (lo + hi) >> 1;
+    if(map->tx[mid].start <= abs_pos)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// index of the first transcript whose running maximum end is past abs_pos
+static long first_over( const SEQ_TXMAP *map, long abs_pos, long lo, long hi )
+{
+  while(lo < hi)
+  {
+    long mid = (lo + hi) >> 1;
+    if(map->max_end[mid] <= abs_pos)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+long seq_txmap_find( const SEQ_TXMAP *map, long abs_pos, SEQ_TXMAP_POS *out, long max )
+{
+  long hi = upper_bound(map, abs_pos);
+  long n = 0;
+  for(long t = first_over(map, abs_pos, 0, hi); t < hi; t++)
+  {
+    SEQ_TXMAP_POS pos;
+    if(seq_txmap_map(map, t, abs_pos, &pos))
+    {
+      if(n < max)
+        out[n] = pos;
+      n++;
+    }
+  }
+  return n;
+}
+
+long seq_txmap_find_sorted( const SEQ_TXMAP *map, const long *abs_pos, long n,
+    SEQ_TXMAP_POS *out, long *idx, long max )
+{
+  long lo = 0, hi = 0, nHit = 0;
+  for(long i = 0; i < n; i++)
+  {
+    // both ends of the window only move forward
+    while(hi < map->n_tx && map->tx[hi].start <= abs_pos[i])
+      hi++;
+    while(lo < hi && map->max_end[lo] <= abs_pos[i])
+      lo++;
+    for(long t = lo; t < hi; t++)
+    {
+      SEQ_TXMAP_POS pos;
+      if(seq_txmap_map(map, t, abs_pos[i], &pos))
+      {
+        if(nHit < max)
+        {
+          out[nHit] = pos;
+          idx[nHit] = i;
+        }
+        nHit++;
+      }
+    }
+  }
+  return nHit;
+}
+
+int seq_txmap_format( const SEQ_TXMAP_POS *pos, char *buf, size_t size )
+{
+  const char *prefix = pos->kind == SEQ_TXMAP_NONCODING ? "n." : pos->kind == SEQ_TXMAP_UTR3
+    ? "c.*" : "c.";
+  if(pos->intron)
+    return snprintf(buf, size, "%s%ld%+ld", prefix, pos->c_pos, pos->intron);
+  return snprintf(buf, size, "%s%ld", prefix, pos->c_pos);
+}
@@ -0,0 +1,103 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_txmap.h
+ * Description: Genomic to cDNA and protein coordinates (the positions of HGVS
+ *  c., n. and p. names) for the transcripts of a gene site store.
+ *
+ *  The exons of each transcript are recovered from its sites once, when the
+ *  map is made: runs of transcript sites whose genomic and transcript
+ *  positions both step by one. Each exon keeps its genomic range and the
+ *  transcript offset of its 5' base, so mapping a position is a binary search
+ *  over a handful of exons and some arithmetic. Transcripts are kept sorted
+ *  by start, with the running maximum of their ends, to find the ones over a
+ *  position; sorted batches walk that list once.
+ */
+
+#ifndef __seq_txmap_h__
+#define __seq_txmap_h__
+
+#include <stdint.h>
+#include "seq_genedb.h"
+
+// where a position falls in its transcript
+enum
+{
+  SEQ_TXMAP_CDS = 0,       // c.N
+  SEQ_TXMAP_UTR5,          // c.-N
+  SEQ_TXMAP_UTR3,          // c.*N
+  SEQ_TXMAP_NONCODING      // n.N
+};
+
+typedef struct seq_txmap_exon
+{
+  uint32_t start;          // genomic range [start, end)
+  uint32_t end;
+  uint32_t tx_off;         // transcript offset of the 5' base
+} SEQ_TXMAP_EXON;
+
+typedef struct seq_txmap_tx
+{
+  uint32_t start;          // genomic span of the exons [start, end)
+  uint32_t end;
+  uint32_t exon;           // first of n_exon exons, in genomic order
+  uint32_t n_exon;
+  int32_t cds_start;       // transcript offsets of the cds [start, end), -1
+  int32_t cds_end;         //  for non-coding transcripts
+  uint32_t tx;             // ordinal in the gene site store
+  char strand;
+} SEQ_TXMAP_TX;
+
+typedef struct seq_txmap
+{
+  const SEQ_GENEDB *db;
+  SEQ_GENEDB *own_db;      // opened by seq_txmap_open
+  SEQ_TXMAP_TX *tx;        // sorted by start
+  uint32_t *max_end;       // max(tx[0..i].end)
+  long n_tx;
+  SEQ_TXMAP_EXON *exon;
+  long n_exon;
+} SEQ_TXMAP;
+
+typedef struct seq_txmap_pos
+{
+  uint32_t tx;             // ordinal in the gene site store
+  int kind;                // SEQ_TXMAP_*
+  long tx_offset;          // transcript offset of the position, or, for an
+  long intron;             //  intronic one, of the nearest exon base and the
+                           //  distance from it (+ downstream, - upstream)
+  long c_pos;              // the number of the c. or n. name: 12 for c.12,
+                           //  -3 for c.-3, 7 for c.*7, 5 for n.5
+  long p_pos;              // codon number for exonic cds positions, else 0
+} SEQ_TXMAP_POS;
+
+SEQ_TXMAP *seq_txmap_new( const SEQ_GENEDB *db );
+void seq_txmap_free( SEQ_TXMAP *map );
+
+// a map over a gene site store of its own, closed by seq_txmap_free
+SEQ_TXMAP *seq_txmap_open( const char *path );
+
+// maps abs_pos on the transcript at index t of map->tx; 0 outside its span
+int seq_txmap_map( const SEQ_TXMAP *map, long t, long abs_pos, SEQ_TXMAP_POS *out );
+
+// every transcript over abs_pos, up to max of them; returns how many there are
+long seq_txmap_find( const SEQ_TXMAP *map, long abs_pos, SEQ_TXMAP_POS *out, long max );
+
+/*
+ * The same for n positions sorted ascending: hits are written in position
+ * order, each with the index of its position in idx; returns the number of
+ * hits, which may be more than max (only max are written)
+ */
+long seq_txmap_find_sorted( const SEQ_TXMAP *map, const long *abs_pos, long n,
+    SEQ_TXMAP_POS *out, long *idx, long max );
+
+// the c./n. name of a position, e.g., "c.-3", "c.88+2", "c.*7", "n.5"
+int seq_txmap_format( const SEQ_TXMAP_POS *pos, char *buf, size_t size );
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_vcf.c
+ * Description: VCF records as snpfile rows; see seq_vcf.h
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "dbg.h"
+#include "seq_vcf.h"
+
+#define VCF_FIXED 9              // CHROM POS ID REF ALT QUAL FILTER INFO FORMAT
+#define VCF_SAMPLE_COL 6         // of the first sample in the snpfile header
+
+static const char vcf_header[] = "Fragment\tPosition\tReference\tAlleles\tAllele_Counts\tType";
+
+int seq_vcf_check( const char *line, size_t len )
+{
+  static const char magic[] = "##fileformat=VCF";
+  return len >= sizeof(magic) - 1 && memcmp(line, magic, sizeof(magic) - 1) == 0;
+}
+
+SEQ_VCF *seq_vcf_new( void )
+{
+  SEQ_VCF *vcf = (SEQ_VCF *)calloc(1, sizeof(SEQ_VCF));
+  check_mem(vcf);
+  return vcf;
+
+error:
+  return NULL;
+}
+
+void seq_vcf_free( SEQ_VCF *vcf )
+{
+  if(!vcf)
+    return;
+  free(vcf->slot);
+  free(vcf->alt);
+  free(vcf->site);
+  free(vcf->count);
+  free(vcf->call);
+  free(vcf->text);
+  free(vcf);
+}
+
+static int grow( void **p, long *cap, long n, size_t size )
+{
+  if(n <= *cap)
+    return 1;
+  long c = *cap ? *cap : 16;
+  while(c < n)
+    c *= 2;
+  void *q = realloc(*p, c * size);
+  check_mem(q);
+  *p = q;
+  *cap = c;
+  return 1;
+
+error:
+  return 0;
+}
+
+static int text_add( SEQ_VCF *vcf, const char *s, size_t n )
+{
+  if(vcf->len + n > vcf->cap)
+  {
+    size_t cap = vcf->cap ? vcf->cap : 256;
+    while(vcf->len + n > cap)
+      cap *= 2;
+    char *text = (char *)realloc(vcf->text, cap);
+    check_mem(text);
+    vcf->text = text;
+    vcf->cap = cap;
+  }
+  memcpy(vcf->text + vcf->len, s, n);
+  vcf->len += n;
+  return 1;
+
+error:
+  return 0;
+}
+
+static int text_long( SEQ_VCF *vcf, long v )
+{
+  char num[24];
+  int n = snprintf(num, sizeof(num), "%ld", v);
+  return text_add(vcf, num, (size_t)n);
+}
+
+static inline char upper( char c )
+{
+  return c >= 'a' && c <= 'z' ? (char)(c - 'a' + 'A') : c;
+}
+
+static inline int is_base( char c )
+{
+  return c == 'A' || c == 'C' || c == 'G' || c == 'T';
+}
+
+// n bases of a and b are the same, whatever their case
+static int same_bases( const char *a, const char *b, size_t n )
+{
+  for(size_t i = 0; i < n; i++)
+    if(upper(a[i]) != upper(b[i]))
+      return 0;
+  return 1;
+}
+
+// what alt of the record at pos with reference ref changes, and where
+static void normalize( SEQ_VCFALT *alt, long pos, const char *ref, size_t refLen,
+    const char *seq, size_t len )
+{
+  memset(alt, 0, sizeof(SEQ_VCFALT));
+  for(size_t i = 0; i < len; i++)
+    if(!is_base(upper(seq[i])) && upper(seq[i]) != 'N')
+      return;
+  if(len == 0 || refLen == 0)
+    return;
+
+  size_t lr = refLen, la = len;
+  while(lr > 1 && la > 1 && upper(ref[lr - 1]) == upper(seq[la - 1]))
+  {
+    lr--;
+    la--;
+  }
+  alt->pos = pos + (long)lr - 1;
+  alt->ref = upper(ref[lr - 1]);
+  if(lr == la)
+  {
+    const char base = upper(seq[la - 1]);
+    if(!same_bases(ref, seq, lr - 1) || !is_base(base) || base == alt->ref)
+      return;
+    alt->kind = SEQ_VCF_SNP;
+    alt->seq = seq + la - 1;
+    alt->len = 1;
+    alt->code = seq_geno_code(&base, 1);
+  }
+  else if(la < lr)
+  {
+    if(!same_bases(ref, seq, la))
+      return;
+    alt->kind = SEQ_VCF_DEL;
+    alt->del = (long)(lr - la);
+    alt->code = SEQ_GENO_D;
+  }
+  else
+  {
+    if(!same_bases(ref, seq, lr))
+      return;
+    alt->kind = SEQ_VCF_INS;
+    alt->seq = seq + lr;
+    alt->len = la - lr;
+    alt->code = SEQ_GENO_I;
+  }
+}
+
+// the code of two alleles, each one of the base, D or I codes
+static uint8_t pair_code( uint8_t a, uint8_t b )
+{
+  static const uint8_t het[5][5] = {
+    [SEQ_GENO_A][SEQ_GENO_C] = SEQ_GENO_M, [SEQ_GENO_A][SEQ_GENO_G] = SEQ_GENO_R,
+    [SEQ_GENO_A][SEQ_GENO_T] = SEQ_GENO_W, [SEQ_GENO_C][SEQ_GENO_G] = SEQ_GENO_S,
+    [SEQ_GENO_C][SEQ_GENO_T] = SEQ_GENO_Y, [SEQ_GENO_G][SEQ_GENO_T] = SEQ_GENO_K };
+
+  if(a == SEQ_GENO_MISSING || b == SEQ_GENO_MISSING)
+    return SEQ_GENO_MISSING;
+  if(a == b)
+    return a;
+  if(a > b)
+  {
+    uint8_t t = a;
+    a = b;
+    b = t;
+  }
+  if(b <= SEQ_GENO_T)
+    return het[a][b];
+  if(a <= SEQ_GENO_T)
+    return b == SEQ_GENO_D ? SEQ_GENO_E : SEQ_GENO_H;
+  return SEQ_GENO_OTHER;
+}
+
+// the GT of a sample's field, up to the first ':'
+static void parse_call( SEQ_VCFCALL *call, const char *s, size_t len, long nAllele )
+{
+  size_t end = 0;
+  while(end < len && s[end] != ':')
+    end++;
+  call->gt = s;
+  call->gt_len = (uint32_t)end;
+  call->n = 0;
+
+  int n = 0;
+  size_t i = 0;
+  while(i < end)
+  {
+    if(s[i] == '.')
+    {
+      call->n = 0;
+      return;
+    }
+    if(s[i] < '0' || s[i] > '9')
+    {
+      call->n = 3;
+      return;
+    }
+    uint32_t a = 0;
+    for(; i < end && s[i] >= '0' && s[i] <= '9'; i++)
+      a = 10 * a + (uint32_t)(s[i] - '0');
+    if(a >= (uint32_t)nAllele)
+    {
+      call->n = 3;
+      return;
+    }
+    if(n < 2)
+      call->allele[n] = a;
+    else if(a != call->allele[0] || call->allele[1] != call->allele[0])
+    {
+      call->n = 3;
+      return;
+    }
+    n++;
+    if(i < end && s[i] != '/' && s[i] != '|')
+    {
+      call->n = 3;
+      return;
+    }
+    i++;
+  }
+
+  // more than two of the same allele read as a hom call
+  call->n = n > 2 ? 1 : n;
+}
+
+// the code of allele a in the row of site
+static inline uint8_t allele_code( const SEQ_VCF *vcf, int site, uint32_t a )
+{
+  if(a > 0 && vcf->alt[a - 1].kind && vcf->alt[a - 1].site == site)
+    return vcf->alt[a - 1].code;
+  return vcf->site[site].ref_code;
+}
+
+// where the reader wants each sample of the file among a row's codes
+static int map_samples( SEQ_VCF *vcf, const SEQ_SNPREADER *r )
+{
+  check_mem(grow((void **)&vcf->slot, &vcf->slot_n, vcf->n_sample ? vcf->n_sample : 1,
+        sizeof(int)));
+  for(long i = 0; i < vcf->n_sample; i++)
+    vcf->slot[i] = -1;
+  for(long k = 0; k < r->n_sample; k++)
+  {
+    const long col = r->sample[k] - VCF_SAMPLE_COL;
+    if(col >= 0 && col % 2 == 0 && col / 2 < vcf->n_sample)
+      vcf->slot[col / 2] = (int)k;
+  }
+  vcf->slot_for = r->sample;
+  return 1;
+
+error:
+  return 0;
+}
+
+// the #CHROM line, as the header Vcf2SeqAnt writes
+static long header_line( SEQ_VCF *vcf, SEQ_SNPREADER *r, SEQ_SNPBATCH *batch,
+    const char *line, size_t len )
+{
+  long col = 0;
+  size_t start = 0;
+
+  vcf->len = 0;
+  check_mem(text_add(vcf, vcf_header, sizeof(vcf_header) - 1));
+  for(size_t i = 0; i <= len; i++)
+  {
+    if(i < len && line[i] != '\t')
+      continue;
+    if(col >= VCF_FIXED)
+    {
+      check_mem(text_add(vcf, "\t", 1) && text_add(vcf, line + start, i - start)
+          && text_add(vcf, "\t", 1));
+      vcf->n_sample++;
+    }
+    col++;
+    start = i + 1;
+  }
+  vcf->have_header = 1;
+
+  const long row = seq_snpreader_add_row(r, batch, vcf->text, vcf->len);
+  check_mem(row != -2);
+  return row >= 0;
+
+error:
+  return -1;
+}
+
+long seq_vcf_line( SEQ_VCF *vcf, SEQ_SNPREADER *r, SEQ_SNPBATCH *batch,
+    const char *line, size_t len )
+{
+  const char *col[VCF_FIXED];
+  size_t colLen[VCF_FIXED];
+  long nCol = 0;
+  size_t at = 0;
+  long nRow = 0;
+
+  if(len && line[len - 1] == '\r')
+    len--;
+  if(len > 1 && line[0] == '#' && line[1] == '#')
+    return 0;
+  if(len && line[0] == '#')
+    return vcf->have_header ? 0 : header_line(vcf, r, batch, line, len);
+  if(!vcf->have_header)
+    return 0;
+
+  // the fixed columns; the samples follow at
+  while(nCol < VCF_FIXED && at <= len)
+  {
+    const char *tab = (const char *)memchr(line + at, '\t', len - at);
+    const size_t end = tab ? (size_t)(tab - line) : len;
+    col[nCol] = line + at;
+    colLen[nCol++] = end - at;
+    at = end + 1;
+    if(!tab)
+      break;
+  }
+  if(nCol < 5)
+    return 0;
+  long pos = 0;
+  for(size_t i = 0; i < colLen[1] && col[1][i] >= '0' && col[1][i] <= '9'; i++)
+    pos = 10 * pos + (col[1][i] - '0');
+
+  // the ALTs, and the positions they change
+  long nAlt = 0, nSite = 0;
+  for(size_t i = 0, start = 0; i <= colLen[4]; i++)
+  {
+    if(i < colLen[4] && col[4][i] != ',')
+      continue;
+    check_mem(grow((void **)&vcf->alt, &vcf->cap_alt, nAlt + 1, sizeof(SEQ_VCFALT)));
+    SEQ_VCFALT *alt = &vcf->alt[nAlt++];
+    normalize(alt, pos, col[3], colLen[3], col[4] + start, i - start);
+    start = i + 1;
+    if(!alt->kind)
+      continue;
+
+    long s = 0;
+    while(s < nSite && vcf->site[s].pos != alt->pos)
+      s++;
+    if(s == nSite)
+    {
+      check_mem(grow((void **)&vcf->site, &vcf->cap_site, nSite + 1, sizeof(SEQ_VCFSITE)));
+      SEQ_VCFSITE *site = &vcf->site[nSite++];
+      site->pos = alt->pos;
+      site->ref = alt->ref;
+      site->ref_code = is_base(alt->ref) ? seq_geno_code(&alt->ref, 1) : SEQ_GENO_MISSING;
+      site->kinds = 0;
+    }
+    vcf->site[s].kinds |= 1 << alt->kind;
+    alt->site = (int)s;
+  }
+  if(nSite == 0)
+    return 0;
+
+  // rows go in order of position; alt->site follows its row
+  for(long s = 1; s < nSite; s++)
+    for(long t = s; t > 0 && vcf->site[t - 1].pos > vcf->site[t].pos; t--)
+    {
+      SEQ_VCFSITE swap = vcf->site[t];
+      vcf->site[t] = vcf->site[t - 1];
+      vcf->site[t - 1] = swap;
+      for(long a = 0; a < nAlt; a++)
+        if(vcf->alt[a].kind && vcf->alt[a].site == t)
+          vcf->alt[a].site = (int)(t - 1);
+        else if(vcf->alt[a].kind && vcf->alt[a].site == t - 1)
+          vcf->alt[a].site = (int)t;
+    }
+
+  // the calls, when FORMAT leads with GT, and the copies of each allele
+  const int haveGt = nCol == VCF_FIXED && colLen[8] >= 2 && col[8][0] == 'G'
+    && col[8][1] == 'T' && (colLen[8] == 2 || col[8][2] == ':');
+  check_mem(grow((void **)&vcf->call, &vcf->cap_call, vcf->n_sample ? vcf->n_sample : 1,
+        sizeof(SEQ_VCFCALL)));
+  check_mem(grow((void **)&vcf->count, &vcf->cap_count, nAlt + 1, sizeof(long)));
+  memset(vcf->count, 0, sizeof(long) * (nAlt + 1));
+  for(long i = 0; i < vcf->n_sample; i++)
+  {
+    SEQ_VCFCALL *call = &vcf->call[i];
+    call->n = 0;
+    call->gt_len = 0;
+    if(!haveGt || nCol < VCF_FIXED || at > len)
+      continue;
+    const char *tab = (const char *)memchr(line + at, '\t', len - at);
+    const size_t end = tab ? (size_t)(tab - line) : len;
+    parse_call(call, line + at, end - at, nAlt + 1);
+    at = tab ? end + 1 : len + 1;
+    if(call->n == 1 || call->n == 2)
+      for(int k = 0; k < call->n; k++)
+        vcf->count[call->allele[k]]++;
+  }
+
+  if(r->n_sample && (vcf->slot_for != r->sample || vcf->slot_n < vcf->n_sample))
+    check_mem(map_samples(vcf, r));
+
+  for(long s = 0; s < nSite; s++)
+  {
+    const SEQ_VCFSITE *site = &vcf->site[s];
+    long refCount = vcf->count[0];
+    for(long a = 0; a < nAlt; a++)
+      if(!vcf->alt[a].kind || vcf->alt[a].site != s)
+        refCount += vcf->count[a + 1];
+
+    // chr, position, reference, alleles, allele counts, type
+    vcf->len = 0;
+    check_mem(text_add(vcf, col[0], colLen[0]) && text_add(vcf, "\t", 1)
+        && text_long(vcf, site->pos) && text_add(vcf, "\t", 1)
+        && text_add(vcf, &site->ref, 1) && text_add(vcf, "\t", 1)
+        && text_add(vcf, &site->ref, 1));
+    for(long a = 0; a < nAlt; a++)
+    {
+      const SEQ_VCFALT *alt = &vcf->alt[a];
+      if(!alt->kind || alt->site != s)
+        continue;
+      check_mem(text_add(vcf, ",", 1));
+      if(alt->kind == SEQ_VCF_DEL)
+      {
+        check_mem(text_add(vcf, "-", 1) && text_long(vcf, alt->del));
+      }
+      else
+      {
+        if(alt->kind == SEQ_VCF_INS)
+          check_mem(text_add(vcf, "+", 1));
+        for(size_t i = 0; i < alt->len; i++)
+        {
+          const char c = upper(alt->seq[i]);
+          check_mem(text_add(vcf, &c, 1));
+        }
+      }
+    }
+    check_mem(text_add(vcf, "\t", 1) && text_long(vcf, refCount));
+    for(long a = 0; a < nAlt; a++)
+      if(vcf->alt[a].kind && vcf->alt[a].site == s)
+        check_mem(text_add(vcf, ",", 1) && text_long(vcf, vcf->count[a + 1]));
+    const int kinds = site->kinds;
+    const char *type = kinds == 1 << SEQ_VCF_SNP ? "SNP" : kinds == 1 << SEQ_VCF_DEL
+      ? "DEL" : kinds == 1 << SEQ_VCF_INS ? "INS" : "MULTIALLELIC";
+    check_mem(text_add(vcf, "\t", 1) && text_add(vcf, type, strlen(type)));
+
+    const long row = seq_snpreader_add_row(r, batch, vcf->text, vcf->len);
+    check_mem(row != -2);
+    if(row < 0)
+      continue;
+    nRow++;
+    if(!r->n_sample)
+      continue;
+
+    // the codes, and calls no code stands for in the order of samples
+    uint8_t *code = batch->geno + row * r->n_sample;
+    memset(code, SEQ_GENO_MISSING, r->n_sample);
+    for(long i = 0; i < vcf->n_sample; i++)
+    {
+      const int k = vcf->slot[i];
+      const SEQ_VCFCALL *call = &vcf->call[i];
+      if(k < 0)
+        continue;
+      if(call->n == 1)
+        code[k] = allele_code(vcf, (int)s, call->allele[0]);
+      else if(call->n == 2)
+        code[k] = pair_code(allele_code(vcf, (int)s, call->allele[0]),
+            allele_code(vcf, (int)s, call->allele[1]));
+      else if(call->n == 3)
+        code[k] = SEQ_GENO_OTHER;
+    }
+    for(long k = 0; k < r->n_sample; k++)
+    {
+      if(code[k] != SEQ_GENO_OTHER)
+        continue;
+      const long i = (r->sample[k] - VCF_SAMPLE_COL) / 2;
+      const SEQ_VCFCALL *call = &vcf->call[i];
+      const long field = call->n == 3
+        ? seq_snpbatch_add_field(batch, call->gt, call->gt_len)
+        : seq_snpbatch_add_field(batch, "J", 1);
+      check_mem(field >= 0 && seq_snpbatch_add_call(batch, k, field));
+    }
+  }
+  return nRow;
+
+error:
+  return -1;
+}
@@ -0,0 +1,106 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_vcf.h
+ * Description: VCF records as snpfile rows, for seq_snpreader, in place of
+ *  rewriting the file with bin/Vcf2SeqAnt_SNP_4_1.pl first.
+ *
+ *  The #CHROM line becomes the header that script writes (Fragment,
+ *  Position, Reference, Alleles, Allele_Counts, Type, then each sample and
+ *  an empty column), so the sample calls are where they would be in its
+ *  output. Each record becomes a row per position it changes:
+ *
+ *  - an ALT is first trimmed of the bases it shares with REF at the end;
+ *    what is left is a SNP when one base differs, a deletion of "-N" at the
+ *    last base deleted, as Seq::Sites::Indels reads it, when ALT is a prefix
+ *    of REF, and an insertion of "+bases" at the base before it when REF is
+ *    a prefix of ALT. Other ALTs (symbolic, '*', complex) are skipped.
+ *  - ALTs at the same position share a row, whose Alleles are the reference
+ *    base and theirs, Allele_Counts the copies of each among the calls, and
+ *    Type SNP, DEL or INS, or MULTIALLELIC when they are of more than one.
+ *  - GT calls are coded straight into the row's sample codes
+ *    (seq_genotype.h): two alleles make an IUPAC code, E or H for a base and
+ *    a deletion or insertion; any '.' is no call. An allele of another row,
+ *    or a skipped one, counts as the reference. Calls no code stands for
+ *    (a deletion with an insertion, J to the script, or more than two
+ *    alleles that differ) are kept as text among the row's calls.
+ */
+
+#ifndef __seq_vcf_h__
+#define __seq_vcf_h__
+
+#include "seq_snpreader.h"
+
+typedef struct seq_vcfalt
+{
+  long pos;                // the row's position
+  char ref;                // reference base there
+  int kind;                // SEQ_VCF_*, or 0 when skipped
+  uint8_t code;            // SEQ_GENO_* of it in its row
+  const char *seq;         // a SNP's base or the inserted bases
+  size_t len;
+  long del;                // bases deleted
+  int site;                // the row it is in
+} SEQ_VCFALT;
+
+typedef struct seq_vcfcall
+{
+  uint32_t allele[2];
+  int n;                   // 0 for no call, 1 or 2, 3 for more than two
+  const char *gt;
+  uint32_t gt_len;
+} SEQ_VCFCALL;
+
+typedef struct seq_vcfsite
+{
+  long pos;
+  char ref;
+  uint8_t ref_code;
+  int kinds;               // 1 << SEQ_VCF_* of its ALTs
+} SEQ_VCFSITE;
+
+enum
+{
+  SEQ_VCF_SNP = 1,
+  SEQ_VCF_DEL,
+  SEQ_VCF_INS
+};
+
+typedef struct seq_vcf
+{
+  long n_sample;           // in the file
+  int have_header;
+  int *slot;               // the place of each in a row's codes, or -1
+  const int *slot_for;     // the reader's sample columns slot was made for
+  long slot_n;
+  SEQ_VCFALT *alt;
+  long cap_alt;
+  SEQ_VCFSITE *site;
+  long cap_site;
+  long *count;             // copies of each allele among the calls
+  long cap_count;
+  SEQ_VCFCALL *call;
+  long cap_call;
+  char *text;              // the line of a row
+  size_t len;
+  size_t cap;
+} SEQ_VCF;
+
+// 1 for the first line of a VCF
+int seq_vcf_check( const char *line, size_t len );
+
+SEQ_VCF *seq_vcf_new( void );
+void seq_vcf_free( SEQ_VCF *vcf );
+
+// adds the rows of a line of the VCF to batch; returns how many, or -1 when
+//  out of memory
+long seq_vcf_line( SEQ_VCF *vcf, SEQ_SNPREADER *r, SEQ_SNPBATCH *batch,
+    const char *line, size_t len );
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_writer.c
+ * Description: Pipelined, optionally gzipped, output; see seq_writer.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "dbg.h"
+#include "seq_bgzf.h"
+#include "seq_writer.h"
+
+SEQ_WRITEBATCH *seq_writebatch_new( void )
+{
+  SEQ_WRITEBATCH *batch = (SEQ_WRITEBATCH *)calloc(1, sizeof(SEQ_WRITEBATCH));
+  check_mem(batch);
+  return batch;
+
+error:
+  return NULL;
+}
+
+void seq_writebatch_free( void *arg )
+{
+  SEQ_WRITEBATCH *batch = (SEQ_WRITEBATCH *)arg;
+  if(!batch)
+    return;
+  seq_buf_free(&batch->text);
+  seq_buf_free(&batch->z);
+  free(batch->in);
+  free(batch->block);
+  free(batch);
+}
+
+// makes the batch's text BGZF blocks
+static void *compress_stage( void *ctx, void *item )
+{
+  SEQ_WRITER *w = (SEQ_WRITER *)ctx;
+  SEQ_WRITEBATCH *batch = (SEQ_WRITEBATCH *)item;
+  z_stream zs;
+  int inited = 0;
+
+  memset(&zs, 0, sizeof(zs));
+  check( (deflateInit2(&zs, w->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK),
+      "Cannot start compressing." );
+  inited = 1;
+
+  uint32_t nBlock = (uint32_t)((batch->text.len + SEQ_BGZF_TEXT - 1) / SEQ_BGZF_TEXT);
+  batch->z.len = 0;
+  batch->n_block = 0;
+  check_mem(seq_buf_reserve(&batch->z, (size_t)nBlock * SEQ_BGZF_MAX) == 0);
+  if(nBlock > batch->cap_block)
+  {
+    uint32_t *block = (uint32_t *)realloc(batch->block, nBlock * sizeof(uint32_t));
+    check_mem(block);
+    batch->block = block;
+    batch->cap_block = nBlock;
+  }
+  for(size_t at = 0; at < batch->text.len; at += SEQ_BGZF_TEXT)
+  {
+    size_t len = batch->text.len - at < SEQ_BGZF_TEXT ? batch->text.len - at : SEQ_BGZF_TEXT;
+    size_t size = seq_bgzf_deflate(&zs, w->level, batch->text.s + at, len,
+        (unsigned char *)batch->z.s + batch->z.len);
+    check( (size), "Cannot compress a batch." );
+    batch->z.len += size;
+    batch->block[batch->n_block++] = (uint32_t)size;
+  }
+  deflateEnd(&zs);
+
+  // the blocks are what is written now; the text stays, to index
+  SEQ_BUF text = batch->text;
+  batch->text = batch->z;
+  batch->z = text;
+  return batch;
+
+error:
+  if(inited)
+    deflateEnd(&zs);
+  seq_pipe_fail(w->pipe);
+  batch->text.len = 0;
+  batch->n_block = 0;
+  return batch;
+}
+
+// the rows of the batch just written, at the offsets its blocks went to
+static void index_batch( SEQ_WRITER *w, SEQ_WRITEBATCH *batch, uint64_t offset )
+{
+  if(!batch->n_block || w->index->bad)
+    return;
+  if(batch->n_block > w->cap_block_off)
+  {
+    uint64_t *off = (uint64_t *)realloc(w->block_off, batch->n_block * sizeof(uint64_t));
+    check_mem(off);
+    w->block_off = off;
+    w->cap_block_off = batch->n_block;
+  }
+  for(uint32_t b = 0; b < batch->n_block; b++)
+  {
+    w->block_off[b] = offset;
+    offset += batch->block[b];
+  }
+  check_mem(seq_tabix_text(w->index, batch->z.s, batch->z.len, w->block_off, offset));
+  return;
+
+error:
+  // the output is fine without its index
+  w->index->bad = 1;
+}
+
+static void *write_stage( void *ctx, void *item )
+{
+  SEQ_WRITER *w = (SEQ_WRITER *)ctx;
+  SEQ_WRITEBATCH *batch = (SEQ_WRITEBATCH *)item;
+
+  if(batch->text.len && fwrite(batch->text.s, 1, batch->text.len, w->fh) != batch->text.len)
+  {
+    log_err("Cannot write the output.");
+    seq_pipe_fail(w->pipe);
+  }
+  if(w->index)
+    index_batch(w, batch, w->offset);
+  w->offset += batch->text.len;
+  // it has gone as far as it goes
+  return batch;
+}
+
+SEQ_WRITER *seq_writer_open( const char *path, SEQ_PIPE *pipe, int threads )
+{
+  SEQ_WRITER *w = (SEQ_WRITER *)calloc(1, sizeof(SEQ_WRITER));
+  check_mem(w);
+  size_t len = strlen(path);
+  w->gz = len > 3 && strcmp(path + len - 3, ".gz") == 0;
+  w->level = Z_DEFAULT_COMPRESSION;
+  if(threads <= 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (int)cpus : 1;
+  }
+  if(threads > SEQ_WRITER_THREADS)
+    threads = SEQ_WRITER_THREADS;
+
+  check_mem((w->path = strdup(path)));
+  check( ((w->fh = fopen(path, "w")) != NULL), "Cannot write output to '%s'.", path );
+  // the batches are big already
+  setvbuf(w->fh, NULL, _IONBF, 0);
+
+  if(pipe)
+    w->pipe = pipe;
+  else
+  {
+    check_mem((w->pipe = seq_pipe_new("format", SEQ_WRITER_DEPTH, seq_writebatch_free)));
+    w->own = 1;
+  }
+  if(w->gz)
+  {
+    check_mem(seq_pipe_add(w->pipe, "compress", compress_stage, w, threads, 0));
+  }
+  check_mem(seq_pipe_add(w->pipe, "write", write_stage, w, 1, 1));
+  if(w->own)
+  {
+    check( (seq_pipe_start(w->pipe)), "Cannot start writing '%s'.", path );
+  }
+  return w;
+
+error:
+  if(w)
+  {
+    if(w->own)
+      seq_pipe_free(w->pipe);
+    if(w->fh)
+      fclose(w->fh);
+    free(w->path);
+    free(w);
+  }
+  return NULL;
+}
+
+int seq_writer_index( SEQ_WRITER *w, int col_seq, int col_beg )
+{
+  if(!w->gz)
+    return 0;
+  if(!w->index)
+  {
+    check_mem((w->index = seq_tabix_new(col_seq, col_beg)));
+  }
+  return 1;
+
+error:
+  return 0;
+}
+
+SEQ_BUF *seq_writer_text( SEQ_WRITER *w )
+{
+  if(!w->batch)
+  {
+    check_mem((w->batch = seq_writebatch_new()));
+    // about a batch's worth, so filling it does not realloc all the way up
+    check_mem(seq_buf_reserve(&w->batch->text, SEQ_WRITER_BATCH + SEQ_WRITER_BATCH / 8) == 0);
+  }
+  return &w->batch->text;
+
+error:
+  seq_pipe_fail(w->pipe);
+  return NULL;
+}
+
+int seq_writer_commit( SEQ_WRITER *w )
+{
+  if(w->batch && w->batch->text.len >= SEQ_WRITER_BATCH)
+  {
+    SEQ_WRITEBATCH *batch = w->batch;
+    w->batch = NULL;
+    return seq_pipe_put(w->pipe, batch);
+  }
+  return 1;
+}
+
+int seq_writer_add( SEQ_WRITER *w, const char *s, size_t len )
+{
+  SEQ_BUF *text = seq_writer_text(w);
+  if(!text)
+    return 0;
+  check_mem(seq_buf_add(text, s, len) == 0);
+  return seq_writer_commit(w);
+
+error:
+  seq_pipe_fail(w->pipe);
+  return 0;
+}
+
+int seq_writer_close( SEQ_WRITER *w )
+{
+  int ok = 1;
+  if(!w || !w->fh)
+    return 1;
+  if(w->own)
+  {
+    if(w->batch && w->batch->text.len)
+    {
+      ok = seq_pipe_put(w->pipe, w->batch);
+      w->batch = NULL;
+    }
+    ok = seq_pipe_finish(w->pipe) && ok;
+  }
+  if(w->gz && fwrite(seq_bgzf_eof, 1, SEQ_BGZF_EOF_LEN, w->fh) != SEQ_BGZF_EOF_LEN)
+    ok = 0;
+  if(fclose(w->fh) != 0)
+    ok = 0;
+  if(!ok)
+    log_err("Cannot finish writing the output.");
+  w->fh = NULL;
+
+  if(ok && w->index)
+  {
+    size_t len = strlen(w->path) + 5;
+    char *tbi = (char *)malloc(len);
+    if(!seq_tabix_end(w->index, w->offset) || w->index->bad)
+      log_warn("The rows of '%s' are not sorted; they are not indexed.", w->path);
+    else if(!tbi || snprintf(tbi, len, "%s.tbi", w->path) < 0
+        || !seq_tabix_write(w->index, tbi, w->level))
+      log_warn("Cannot write the index of '%s'.", w->path);
+    free(tbi);
+  }
+  return ok;
+}
+
+void seq_writer_free( SEQ_WRITER *w )
+{
+  if(!w)
+    return;
+  if(w->own)
+    seq_pipe_free(w->pipe);
+  if(w->fh)
+    fclose(w->fh);
+  seq_writebatch_free(w->batch);
+  seq_tabix_free(w->index);
+  free(w->block_off);
+  free(w->path);
+  free(w);
+}
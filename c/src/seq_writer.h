@@ -0,0 +1,94 @@
+/*
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version. This library is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * Name: seq_writer.h
+ * Description: Output written by the last stages of a pipeline (seq_pipe.h),
+ *  so whoever makes the text never waits on compression or the disk.
+ *
+ *  Text goes out in batches of about SEQ_WRITER_BATCH bytes. When the file
+ *  ends in .gz a compress stage of a few threads makes each batch BGZF
+ *  blocks (seq_bgzf.h), gzip members of up to 64K that read as one file by
+ *  gzip and zlib alike; an ordered write stage then writes them in the
+ *  order they came, and an empty block ends the file. The write stage can
+ *  index the rows as it goes (seq_tabix.h), so a sorted output is ready for
+ *  tabix when it is closed, with no second pass over it.
+ *
+ *  The writer either adds its stages to a pipeline of the caller's, whose
+ *  items are SEQ_WRITEBATCHes, or runs a pipeline of its own fed by
+ *  seq_writer_add.
+ */
+
+#ifndef __seq_writer_h__
+#define __seq_writer_h__
+
+#include <stdio.h>
+#include "seq_buf.h"
+#include "seq_pipe.h"
+#include "seq_tabix.h"
+
+#define SEQ_WRITER_BATCH   (1 << 20)
+#define SEQ_WRITER_THREADS 8           // compressing, at most
+#define SEQ_WRITER_DEPTH   16
+
+typedef struct seq_writebatch
+{
+  SEQ_BUF text;            // to write
+  SEQ_BUF z;               // room to compress it into
+  char *in;                // what stages before the writer's work from, if any
+  size_t in_len;
+  uint32_t *block;         // the size of each BGZF block of the text
+  uint32_t n_block;
+  uint32_t cap_block;
+} SEQ_WRITEBATCH;
+
+typedef struct seq_writer
+{
+  FILE *fh;
+  int gz;
+  int level;               // of compression
+  SEQ_PIPE *pipe;
+  int own;                 // the pipeline is the writer's
+  SEQ_WRITEBATCH *batch;   // being filled, for a pipeline of its own
+  char *path;
+  uint64_t offset;         // bytes written so far
+  SEQ_TABIX *index;        // of the rows written, when asked for
+  uint64_t *block_off;     // of the blocks of the batch being written
+  uint32_t cap_block_off;
+} SEQ_WRITER;
+
+SEQ_WRITEBATCH *seq_writebatch_new( void );
+void seq_writebatch_free( void *batch );
+
+// writes path, gzipped when it ends in .gz, with threads compressing (0 for
+//  one per cpu, up to SEQ_WRITER_THREADS). Adds the stages to pipe, which the
+//  caller starts and finishes, or with pipe NULL starts a pipeline of its own.
+SEQ_WRITER *seq_writer_open( const char *path, SEQ_PIPE *pipe, int threads );
+
+// indexes the rows of a .gz output by the sequence in column col_seq and the
+//  1-based position in col_beg, writing path.tbi on close (when the rows
+//  were sorted); before any text. Returns 0 when the output is not .gz.
+int seq_writer_index( SEQ_WRITER *w, int col_seq, int col_beg );
+
+// adds text to a writer with a pipeline of its own; 0 once it has failed
+int seq_writer_add( SEQ_WRITER *w, const char *s, size_t len );
+
+// the text of the batch being filled, for a caller that formats straight
+//  into it (NULL when out of memory), and, once it has added whole lines,
+//  seq_writer_commit to hand the batch on if it is full; 0 when it is and
+//  the pipeline has failed
+SEQ_BUF *seq_writer_text( SEQ_WRITER *w );
+int seq_writer_commit( SEQ_WRITER *w );
+
+// writes what is left (finishing a pipeline of its own) and closes the file;
+//  1 when all was written. The counters of the pipeline are kept until the
+//  writer is freed.
+int seq_writer_close( SEQ_WRITER *w );
+void seq_writer_free( SEQ_WRITER *w );
+
+#endif
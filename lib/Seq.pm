@@ -33,7 +33,13 @@ use namespace::autoclean;
 
 use DDP;
 
+use IO::File;
+use IO::Select;
+use IO::Uncompress::AnyUncompress qw/ $AnyUncompressError /;
+use POSIX ();
+
 use Seq::Annotate;
+use Seq::GenomeBin;
 use Seq::Progress;
 
 has snpfile => (
@@ -119,6 +125,71 @@ has write_batch => (
   lazy    => 1,
 );
 
+# number of sites whose genome-sized track data is fetched in one native call
+# before they are annotated; see Seq::Annotate::prefetch_sites
+has lookup_batch => (
+  is      => 'ro',
+  isa     => 'Int',
+  default => 5000,
+  lazy    => 1,
+);
+
+# processes annotating a plain snpfile, each a task of it at a time; 1
+# annotates it in this process, as compressed snpfiles and VCFs always are
+has workers => (
+  is      => 'ro',
+  isa     => 'Int',
+  default => 1,
+  lazy    => 1,
+);
+
+# a task is at most chunk_bytes of the snpfile and, when the genome track is
+# mapped, about task_cost of annotation (see Seq::Annotate::cost_tasks; an
+# intergenic snp without samples costs 2, an exonic one 16, a deletion that
+# per base it covers)
+has chunk_bytes => (
+  is      => 'ro',
+  isa     => 'Int',
+  default => 4 * 1024 * 1024,
+  lazy    => 1,
+);
+
+# also write the statistics counts, unsummarized, as output_path.counts; the
+# counts of jobs over parts of one snpfile merge with bin/merge_stats.pl
+has store_counts => (
+  is      => 'ro',
+  isa     => 'Bool',
+  default => 0,
+  lazy    => 1,
+);
+
+has task_cost => (
+  is      => 'ro',
+  isa     => 'Int',
+  default => 20_000,
+  lazy    => 1,
+);
+
+# the genome_annotate program (c/bin): given, it annotates the genome-sized
+# tracks of the snpfile, in C with workers threads, and only the gene and snp
+# records, the carriers and the statistics of each row are added here
+has genome_annotate => (
+  is      => 'ro',
+  isa     => 'Maybe[Str]',
+  default => undef,
+  lazy    => 1,
+);
+
+# the socket of a genome_server (c/bin) serving the assembly: given, the
+# genome-sized tracks of each batch of sites come from it; see
+# Seq::Annotate::genome_server
+has genome_server => (
+  is      => 'ro',
+  isa     => 'Maybe[Str]',
+  default => undef,
+  lazy    => 1,
+);
+
 #come after all attributes to meet "requires '<attribute>'"
 with 'Seq::Role::ProcessFile', 'Seq::Role::Genotypes', 'Seq::Role::Message';
 
@@ -139,6 +210,7 @@ sub annotate_snpfile {
       debug            => $self->debug,
       messanger        => $self->messanger,
       publisherAddress => $self->publisherAddress,
+      genome_server    => $self->genome_server,
     }
   );
 
@@ -157,13 +229,42 @@ sub annotate_snpfile {
 
   $self->tee_logger( 'info', "Loaded assembly " . $annotator->genome_name );
 
-  #a file slurper that is compression-aware
-  $self->tee_logger( 'info', "Reading input file" );
+  if ( $self->genome_annotate ) {
+    $self->_annotateGenomeRows($annotator);
+    return $self->_finishAnnotation($annotator);
+  }
 
-  my $fileLines = $self->get_file_lines( $self->snpfile_path );
+  # the snpfile is streamed rather than read whole: Seq::Native::SnpReader
+  #   inflates it in a thread of its own and hands out rows already split and
+  #   checked, otherwise lines are read one at a time; either way only a batch
+  #   of rows is held at once. The native reader also takes a VCF (plain or
+  #   bgzipped) as the snpfile bin/Vcf2SeqAnt_SNP_4_1.pl would make of it.
+  $self->tee_logger( 'info', "Reading input file" );
 
-  $self->tee_logger( 'info',
-    sprintf( "Finished reading input file, found %s lines", scalar @$fileLines ) );
+  my $snpfile = $self->snpfile_path;
+  my ( $reader, $rawFh, $fh, $header_aref, $ranges_aref, $headerLines );
+  ( $header_aref, $ranges_aref, $headerLines ) = $self->_lineRanges( $snpfile, $annotator )
+    if $self->workers > 1;
+  if ($ranges_aref) {
+    $self->tee_logger( 'info',
+      sprintf( 'Annotating %d tasks with %d workers', scalar @$ranges_aref, $self->workers ) );
+  }
+  elsif ( Seq::GenomeBin->native_available ) {
+    $reader = Seq::Native::SnpReader->new($snpfile);
+  }
+  else {
+    # the raw handle tells how far into the (maybe compressed) file we are
+    $rawFh = IO::File->new( $snpfile, 'r' )
+      or $self->tee_logger( 'error', "Unable to open file $snpfile" );
+    binmode $rawFh;
+    # bgzipped files are many gzip members
+    $fh = IO::Uncompress::AnyUncompress->new( $rawFh, Transparent => 1, MultiStream => 1 )
+      or $self->tee_logger( 'error', "Unable to read $snpfile: $AnyUncompressError" );
+  }
+  my $bytesRead =
+      $reader ? sub { $reader->offset }
+    : $rawFh  ? sub { tell $rawFh }
+    :           undef;
 
   my $defPos = -9; #default value, indicating out of bounds or not set
   # variables
@@ -174,13 +275,18 @@ sub annotate_snpfile {
   # progress counters
   my ( $pubProg, $writeProg );
 
+  # where a worker of a parallel run writes the annotations of its chunk
+  my $chunkFh;
+
   if ( $self->hasPublisher ) {
+    # progress is in bytes of the file, as its lines aren't known until it
+    #   has all been read
     $pubProg = Seq::Progress->new(
       {
         progressBatch  => 200,
-        fileLines      => scalar @$fileLines,
+        fileLines      => -s $snpfile,
         progressAction => sub {
-          $pubProg->recordProgress( $pubProg->progressCounter );
+          $pubProg->progress( $bytesRead->() );
           $self->publishMessage( { progress => $pubProg->progressFraction } );
         },
       }
@@ -193,53 +299,75 @@ sub annotate_snpfile {
       progressAction => sub {
         $self->publishMessage( 'Writing ' . $self->write_batch . ' lines to disk' )
           if $self->hasPublisher;
-        $self->print_annotations( \@snp_annotations );
+        $self->print_annotations( \@snp_annotations, $chunkFh );
         @snp_annotations = ();
       },
     }
   );
 
-  my ( @fields, $abs_pos, $foundVarType );
-  for my $line (@$fileLines) {
-    #if we wish to save cycles, can move this to original position, below
-    #many conditionals, and then upon completion, set progress(1).
-    $pubProg->incProgressCounter if $pubProg;
-    #expects chomped lines
+  # sites are annotated in batches so the genome-sized tracks can be read for
+  # the whole batch at once
+  my @pending;
+  my $annotatePending = sub {
+    $annotator->prefetch_sites( [ map { $_->[3] } @pending ] );
+    for my $args_aref (@pending) {
+      my $record_href = $annotator->annotate(@$args_aref);
+      if ( defined $record_href ) {
+        if ( $self->debug > 1 ) {
+          say 'In seq.pm record_href is';
+          p $record_href;
+        }
+        push @snp_annotations, $record_href;
+        $writeProg->incProgressCounter;
+      }
+    }
+    @pending = ();
+  };
 
-    # taint check the snpfile's data
-    @fields = $self->get_clean_fields($line);
+  # API: snp files contain column names in the first row
+  # check that these match the expected, which is based on $self->file_type
+  # then, get everything else
+  my $readHeader = sub {
+    my $fields_aref = shift;
 
-    # skip lines that don't return any usable data
-    next unless $#fields;
-    # API: snp files contain column names in the first row
-    # check that these match the expected, which is based on $self->file_type
-    # then, get everything else
-    if ( !%ids ) {
-      $self->checkHeader( \@fields );
+    $self->checkHeader($fields_aref);
 
-      %ids = $self->getSampleNamesIdx( \@fields );
+    %ids = $self->getSampleNamesIdx($fields_aref);
 
-      # save list of ids within the snpfile
-      @sample_ids = sort( keys %ids );
-      next;
-    }
-    # process the snpfile line
-    my ( $chr, $pos, $ref_allele, $var_type, $all_allele_str, $allele_count ) =
-      $self->getSnpFields( \@fields );
+    # save list of ids within the snpfile
+    @sample_ids = sort( keys %ids );
+  };
+
+  # annotates one row of the snpfile, given its fields and the snp ones
+  my ( $abs_pos, $foundVarType );
+  my $annotateRow = sub {
+    my ( $fields_aref, $chr, $pos, $ref_allele, $var_type, $all_allele_str, $allele_count,
+      $carriers_aref )
+      = @_;
+
+    $pubProg->incProgressCounter if $pubProg;
 
     # not checking for $allele_count for now, because it isn't in use
-    next unless $chr && $pos && $ref_allele && $var_type && $all_allele_str;
+    return unless $chr && $pos && $ref_allele && $var_type && $all_allele_str;
 
     # get carrier ids for variant; returns hom_ids_href for use in statistics calculator
-    #   later (hets currently ignored)
-    my ( $het_ids, $hom_ids, $id_genos_href ) =
-      $self->_minor_allele_carriers( \@fields, \%ids, \@sample_ids, $ref_allele );
+    #   later (hets currently ignored); the native reader has found them already
+    my ( $het_ids, $hom_ids, $id_genos_href );
+    if ($carriers_aref) {
+      ( $het_ids, $hom_ids, $id_genos_href ) = @$carriers_aref;
+      $self->tee_logger( 'warn', "$_ was not recognized, skipping" )
+        for @{ $carriers_aref->[3] };
+    }
+    else {
+      ( $het_ids, $hom_ids, $id_genos_href ) =
+        $self->_minor_allele_carriers( $fields_aref, \%ids, \@sample_ids, $ref_allele );
+    }
 
     # check that $chr is an allowable chromosome
     # decide if we plow through the error or if we stop
     # if we allow plow through, don't write log, to avoid performance hit
     if ( !exists $chr_len_href->{$chr} ) {
-      next if $self->ignore_unknown_chr;
+      return if $self->ignore_unknown_chr;
       $self->tee_logger( 'error',
         sprintf( "Error: unrecognized chromosome: '%s', pos: %d", $chr, $pos ) );
     }
@@ -275,7 +403,7 @@ sub annotate_snpfile {
       $self->tee_logger( 'error', $msg );
     }
 
-    # save the current chr for next iteration of the loop
+    # save the current chr for the next row
     $last_chr = $chr;
 
     # Annotate variant sites
@@ -303,24 +431,151 @@ sub annotate_snpfile {
     }
 
     if ($foundVarType) {
-      my $record_href = $annotator->annotate(
+      push @pending,
+        [
         $chr,        $chr_index,    $pos,            $abs_pos,
         $ref_allele, $foundVarType, $all_allele_str, $allele_count,
         $het_ids,    $hom_ids,      $id_genos_href
-      );
-      if ( defined $record_href ) {
-        if ( $self->debug > 1 ) {
-          say 'In seq.pm record_href is';
-          p $record_href;
-        }
-        push @snp_annotations, $record_href;
-        $writeProg->incProgressCounter;
-      }
+        ];
+      $annotatePending->() if @pending == $self->lookup_batch;
     }
     elsif ( index( $var_type, 'MESS' ) == -1 && index( $var_type, 'LOW' ) == -1 ) {
       $self->tee_logger( 'warn', "Unrecognized variant type: $var_type" );
     }
+  };
+
+  # the rows the native reader hands out, once the header has been read
+  my $annotateBatches = sub {
+    my $rowReader = shift;
+    $rowReader->set_columns( [ $self->allSnpFieldIdx ] );
+    $rowReader->set_samples( [ @ids{@sample_ids} ], \@sample_ids );
+    while ( my $rows_aref = $rowReader->next_batch( $self->lookup_batch ) ) {
+      # chr, pos, ref, type, alleles, allele count, then in place of the
+      #   fields the carriers of the row
+      $annotateRow->( @$_[ 6, 0 .. 5, 7 ] ) for @$rows_aref;
+    }
+  };
+
+  my $lines;
+  if ($ranges_aref) {
+    $readHeader->($header_aref);
+
+    # each worker annotates whole tasks, into a buffer the parent writes out
+    #   in the order of the file; statistics are kept per worker and added up
+    #   at the end
+    my $annotateChunk = sub {
+      my ( $start, $end ) = @{ $ranges_aref->[ shift @_ ] };
+      my ( $text, $chunkLines ) = ( '', 0 );
+      open $chunkFh, '>', \$text or die "Cannot buffer annotations: $!";
+      if ( Seq::GenomeBin->native_available ) {
+        my $rowReader = Seq::Native::SnpReader->new( $snpfile, $start, $end );
+        $annotateBatches->($rowReader);
+        $chunkLines = $rowReader->lines;
+      }
+      else {
+        my $in = IO::File->new( $snpfile, 'r' ) or die "Unable to open file $snpfile";
+        binmode $in;
+        seek $in, $start, 0;
+        while ( tell($in) < $end && defined( my $line = <$in> ) ) {
+          $chunkLines++;
+          chomp $line;
+          my @fields = $self->get_clean_fields($line);
+          next unless $#fields;
+          $annotateRow->( \@fields, $self->getSnpFields( \@fields ) );
+        }
+        close $in;
+      }
+      $annotatePending->() if @pending;
+      $self->print_annotations( \@snp_annotations, $chunkFh );
+      @snp_annotations = ();
+      close $chunkFh;
+      undef $chunkFh;
+      return ( $chunkLines, $text );
+    };
+
+    # with Seq::Native the counts go back as a table the parent merges into
+    #   its own, otherwise as the nested record
+    my $workerStats = sub {
+      my $partial = $annotator->statsPartial;
+      return pack(
+        'N/a* a*',
+        encode_json(
+          {
+            stats => defined $partial ? undef : $annotator->statsRecord,
+            discordant => $annotator->discordant_bases // 0,
+          }
+        ),
+        $partial // ''
+      );
+    };
+
+    # progress is in bytes of the file written out
+    my $bytesWritten = $ranges_aref->[0][0];
+    $bytesRead = sub { $bytesWritten };
+    $lines = $headerLines;
+    my $writeChunk = sub {
+      my ( $i, $chunkLines, $text ) = @_;
+      print { $self->_out_fh } $text;
+      $lines += $chunkLines;
+      $bytesWritten = $ranges_aref->[$i][1];
+      $pubProg->callProgressAction if $pubProg;
+    };
+
+    # the workers publish no progress of their own
+    my $parentProg = $pubProg;
+    undef $pubProg;
+    my @workerStats =
+      $self->_runWorkers( [ map { $_->[2] } @$ranges_aref ],
+      $annotateChunk, $workerStats, $writeChunk );
+    $pubProg = $parentProg;
+
+    for (@workerStats) {
+      my ( $json, $partial ) = unpack 'N/a* a*', $_;
+      my $href = decode_json($json);
+      $annotator->mergeStats( $href->{stats} ) if $href->{stats};
+      $annotator->mergePartial($partial) if length $partial;
+      $annotator->count_discordant( $href->{discordant} ) if $href->{discordant};
+    }
+  }
+  elsif ($reader) {
+    if ( my $header = $reader->header ) {
+      $readHeader->($header);
+      $annotateBatches->($reader);
+    }
+    $lines = $reader->lines;
   }
+  else {
+    my ( $haveHeader, @fields );
+    while ( my $line = <$fh> ) {
+      #expects chomped lines
+      chomp $line;
+
+      $self->tee_logger( 'error',
+        "$snpfile is a VCF; convert it with bin/Vcf2SeqAnt_SNP_4_1.pl or build Seq::Native" )
+        if $. == 1 && index( $line, '##fileformat=VCF' ) == 0;
+
+      # taint check the snpfile's data
+      @fields = $self->get_clean_fields($line);
+
+      # skip lines that don't return any usable data
+      next unless $#fields;
+
+      if ( !$haveHeader ) {
+        $readHeader->( \@fields );
+        $haveHeader = 1;
+        next;
+      }
+      $annotateRow->( \@fields, $self->getSnpFields( \@fields ) );
+    }
+    $lines = $.;
+    close $fh;
+  }
+
+  $self->tee_logger( 'info',
+    sprintf( "Finished reading input file, found %s lines", $lines ) );
+
+
+  $annotatePending->() if @pending;
 
   # finished printing the final snp annotations
   if (@snp_annotations) {
@@ -331,6 +586,30 @@ sub annotate_snpfile {
     @snp_annotations = ();
   }
 
+  return $self->_finishAnnotation($annotator);
+}
+
+# _finishAnnotation closes the output and stores and summarizes the
+# statistics, whichever way the snpfile was annotated; returns the statistics
+sub _finishAnnotation {
+  my ( $self, $annotator ) = @_;
+
+  # the output is whole once closed; the native writer's counters tell which
+  #   of its stages, formatting (this process) included, bounded the job
+  if ( $self->output_path ) {
+    close $self->_out_fh;
+    if ( my $writer = tied *{ $self->_out_fh } ) {
+      my $stats = $writer->stats;
+      $self->tee_logger( 'info',
+        sprintf( '%s: %d batches, waited %.2fs for input and %.2fs for output, busy %.2fs',
+          $_, @{ $stats->{$_} }{qw/ items wait_in wait_out busy /} ) )
+        for grep { $stats->{$_} } qw/ format compress write /;
+    }
+  }
+
+  # the counts of a job over part of a cohort's sites, to merge with the rest
+  $annotator->storeCounts( $self->output_path ) if $self->store_counts;
+
   $self->tee_logger( 'info', 'Summarizing statistics' );
   $annotator->summarizeStats;
 
@@ -351,6 +630,294 @@ sub annotate_snpfile {
   return $annotator->statsRecord;
 }
 
+# _annotateGenomeRows has genome_annotate write the genome-sized track fields
+# of the snpfile's rows, each followed by its snpfile line (--fields), and adds
+# to each the records of the gene and snp tracks and the carriers its line has,
+# counting it in the statistics as annotate_snpfile does (see
+# Seq::Annotate::annotate_genome_row)
+sub _annotateGenomeRows {
+  my ( $self, $annotator ) = @_;
+
+  my $rowsFile = Path::Tiny->tempfile( SUFFIX => '.txt' );
+  my @cmd = (
+    $self->genome_annotate, $annotator->genome_annotate_args,
+    '--in',      $self->snpfile_path,
+    '--out',     $rowsFile->stringify,
+    '--threads', $self->workers,
+    '--fields'
+  );
+  $self->tee_logger( 'info', "Annotating genome-sized tracks: @cmd" );
+  system(@cmd) == 0
+    or $self->tee_logger( 'error', sprintf( "genome_annotate failed with %d", $? >> 8 ) );
+
+  # the engine's columns, then the snpfile's line
+  my @columns = $annotator->genome_annotate_columns;
+  my $rowsFh  = $self->get_read_fh($rowsFile);
+  my $header  = <$rowsFh>;
+  $self->tee_logger( 'error', 'genome_annotate wrote no header' ) unless defined $header;
+  chomp $header;
+  my @head = split /\t/, $header, @columns + 1;
+  $self->tee_logger( 'error', "genome_annotate wrote an unexpected header: $header" )
+    unless @head == @columns + 1 && join( "\t", @head[ 0 .. $#columns ] ) eq join "\t", @columns;
+
+  my @fields = $self->get_clean_fields( $head[-1] );
+  $self->checkHeader( \@fields );
+  my %ids        = $self->getSampleNamesIdx( \@fields );
+  my @sample_ids = sort( keys %ids );
+
+  my ( @snp_annotations, $lines );
+  while ( my $line = <$rowsFh> ) {
+    chomp $line;
+    my @values = split /\t/, $line, @columns + 1;
+    next unless @values == @columns + 1;
+
+    # the snpfile line, skipped and checked as annotate_snpfile would
+    @fields = $self->get_clean_fields( pop @values );
+    next unless $#fields;
+    my ( $chr, $pos, $ref_allele, $var_type, $all_allele_str ) = $self->getSnpFields( \@fields );
+    next unless $chr && $pos && $ref_allele && $var_type && $all_allele_str;
+
+    my %row;
+    @row{@columns} = @values;
+    my $record_href =
+      $annotator->annotate_genome_row( \%row, $ref_allele,
+      $self->_minor_allele_carriers( \@fields, \%ids, \@sample_ids, $ref_allele ) );
+    next unless defined $record_href;
+    push @snp_annotations, $record_href;
+    $lines++;
+    if ( @snp_annotations == $self->write_batch ) {
+      $self->print_annotations( \@snp_annotations );
+      @snp_annotations = ();
+    }
+  }
+  close $rowsFh;
+  $self->print_annotations( \@snp_annotations ) if @snp_annotations;
+  $self->tee_logger( 'info', sprintf( "Annotated %d sites", $lines // 0 ) );
+}
+
+# _lineRanges splits a plain snpfile, after the header, into tasks of whole
+# lines: of about task_cost each by the hints of Seq::Annotate::cost_tasks when
+# the genome track is mapped, otherwise of about chunk_bytes, costing their
+# bytes. Returns the header's fields, the tasks ([start, end, cost], start and
+# end in bytes) and the lines up to the end of the header, or nothing when the
+# file is compressed or a VCF (which are annotated by one process, as a range
+# of them cannot be read on its own)
+sub _lineRanges {
+  my ( $self, $snpfile, $annotator ) = @_;
+
+  my $in = IO::File->new( $snpfile, 'r' )
+    or $self->tee_logger( 'error', "Unable to open file $snpfile" );
+  binmode $in;
+  read $in, my $magic, 2;
+  return if $magic eq "\x1f\x8b";
+  seek $in, 0, 0;
+
+  my ( @header, $line );
+  while ( defined( $line = <$in> ) ) {
+    return if $. == 1 && index( $line, '##fileformat=VCF' ) == 0;
+    chomp $line;
+    @header = $self->get_clean_fields($line);
+    last if @header > 1;
+  }
+  return unless @header > 1;
+  my $headerLines = $.;
+
+  my $size  = -s $snpfile;
+  my $start = tell $in;
+  my $tasks_aref =
+    Seq::GenomeBin->native_available
+    ? $annotator->cost_tasks( $snpfile, \@header, $start, $self->task_cost, $self->chunk_bytes )
+    : undef;
+  if ( !$tasks_aref ) {
+    my @ranges;
+    while ( $start < $size ) {
+      my $end = $start + $self->chunk_bytes;
+      if ( $end < $size ) {
+        # to the end of the line the chunk ends in
+        seek $in, $end - 1, 0;
+        <$in>;
+        $end = tell $in;
+      }
+      else {
+        $end = $size;
+      }
+      push @ranges, [ $start, $end, $end - $start ];
+      $start = $end;
+    }
+    $tasks_aref = \@ranges;
+  }
+  close $in;
+
+  return ( \@header, $tasks_aref, $headerLines );
+}
+
+# _runWorkers forks workers processes that share the annotation data already
+# loaded (the native tracks are mapped, not read), and has them do the tasks
+# 0 .. n - 1, whose costs (hints, in any unit) are @$costs_aref. The cost of a
+# row varies by orders of magnitude, so tasks are scheduled by work stealing:
+# they are dealt out in rounds, each round cut into one run of neighbouring
+# tasks per worker, of about equal cost; a worker does its own run front to
+# back, and one that has run out steals the back half of the run with the most
+# cost left. Each worker mostly moves forward through the file, where the gene
+# and snp db pages it needs are those it just read, and none sits idle behind
+# an unlucky run while tasks are queued anywhere.
+#
+# $work->($task) runs in a worker and returns the lines read and the
+# annotations of the task as text; $write->($task, $lines, $text) runs in this
+# process, in the order of the tasks. A round is dealt once every run is done
+# with, and only as far as 4 rounds past the next task to write, which bounds
+# the annotations held waiting for an earlier task. Once out of tasks each
+# worker returns $finish->(), a string; they are returned in the order of the
+# workers.
+sub _runWorkers {
+  my ( $self, $costs_aref, $work, $finish, $write ) = @_;
+
+  my $nTasks = @$costs_aref;
+  my $round  = 2 * $self->workers;
+  my $ahead  = 4 * $round;
+  my $done   = 0xFFFFFFFF;
+  my $failed = 0xFFFFFFFE;
+
+  # what was printed so far is not printed again by each child
+  $self->_out_fh->flush;
+  STDOUT->flush;
+
+  my ( @workers, %byFh );
+  for my $n ( 1 .. ( $self->workers < $nTasks ? $self->workers : $nTasks ) ) {
+    pipe( my $jobIn,    my $jobOut )    or $self->tee_logger( 'error', "Cannot pipe: $!" );
+    pipe( my $resultIn, my $resultOut ) or $self->tee_logger( 'error', "Cannot pipe: $!" );
+    my $pid = fork;
+    $self->tee_logger( 'error', "Cannot fork: $!" ) unless defined $pid;
+
+    if ( !$pid ) {
+      close $_ for $jobOut, $resultIn, map { @$_{qw/ jobOut resultIn /} } @workers;
+      binmode $resultOut;
+      my $send = sub {
+        my ( $tag, $lines, $text ) = @_;
+        syswrite( $resultOut, pack( 'NNN', $tag, $lines, length $text ) . $text ) // die $!;
+      };
+      my $ok = eval {
+        while ( sysread( $jobIn, my $job, 4 ) == 4 ) {
+          my $task = unpack 'N', $job;
+          $send->( $task, $work->($task) );
+        }
+        $send->( $done, 0, $finish->() );
+        1;
+      };
+      $send->( $failed, 0, $@ ) unless $ok;
+      # leave the parent's handles and objects alone
+      POSIX::_exit( $ok ? 0 : 1 );
+    }
+
+    close $jobIn;
+    close $resultOut;
+    binmode $resultIn;
+    push @workers,
+      {
+      pid      => $pid,
+      n        => $n,
+      jobOut   => $jobOut,
+      resultIn => $resultIn,
+      busy     => 0,
+      run      => [],
+      };
+    $byFh{ fileno $resultIn } = $workers[-1];
+  }
+
+  my ( $nextTask, $nextWrite, $steals, %waiting, @finished, $error ) = ( 0, 0, 0 );
+
+  # the next round, cut where the running cost passes each worker's share
+  my $deal = sub {
+    my $last = $nextTask + $round;
+    $last = $nextWrite + $ahead if $last > $nextWrite + $ahead;
+    $last = $nTasks             if $last > $nTasks;
+    return if $last <= $nextTask;
+
+    my $total = 0;
+    $total += $costs_aref->[$_] for $nextTask .. $last - 1;
+    my ( $w, $sum ) = ( 0, 0 );
+    for my $task ( $nextTask .. $last - 1 ) {
+      push @{ $workers[$w]{run} }, $task;
+      $sum += $costs_aref->[$task];
+      $w++ if $w < $#workers && $sum >= $total * ( $w + 1 ) / @workers;
+    }
+    $nextTask = $last;
+  };
+
+  my $steal = sub {
+    my $thief = shift;
+    my ( $victim, $most ) = ( undef, 0 );
+    for my $worker (@workers) {
+      my $cost = 0;
+      $cost += $costs_aref->[$_] for @{ $worker->{run} };
+      ( $victim, $most ) = ( $worker, $cost ) if @{ $worker->{run} } && $cost >= $most;
+    }
+    return unless $victim;
+    my $half = int( ( @{ $victim->{run} } + 1 ) / 2 );
+    push @{ $thief->{run} }, splice( @{ $victim->{run} }, -$half );
+    $steals++;
+  };
+
+  my $readAll = sub {
+    my ( $fh, $len ) = @_;
+    my $buf = '';
+    while ( length $buf < $len ) {
+      my $got = sysread( $fh, $buf, $len - length $buf, length $buf );
+      return unless $got;
+    }
+    return $buf;
+  };
+
+  my $select = IO::Select->new( map { $_->{resultIn} } @workers );
+  while ( $select->count ) {
+    for my $worker (@workers) {
+      next if $worker->{busy} || !$worker->{jobOut};
+      if ( !$error ) {
+        $deal->() unless grep { @{ $_->{run} } } @workers;
+        $steal->($worker) unless @{ $worker->{run} };
+      }
+      if ( @{ $worker->{run} } && !$error ) {
+        syswrite( $worker->{jobOut}, pack( 'N', shift @{ $worker->{run} } ) );
+        $worker->{busy} = 1;
+      }
+      elsif ( ( $nextTask == $nTasks && !grep { @{ $_->{run} } } @workers ) || $error ) {
+        # no more work; the worker sends what it finishes with
+        close $worker->{jobOut};
+        $worker->{jobOut} = undef;
+      }
+    }
+
+    for my $fh ( $select->can_read ) {
+      my $worker = $byFh{ fileno $fh };
+      my $head   = $readAll->( $fh, 12 );
+      my ( $tag, $lines, $len ) = $head ? unpack( 'NNN', $head ) : ( $failed, 0, 0 );
+      my $text = $len ? $readAll->( $fh, $len ) : '';
+      $worker->{busy} = 0;
+
+      if ( $tag == $done || $tag == $failed ) {
+        $select->remove($fh);
+        close $fh;
+        if ( $tag == $done ) {
+          $finished[ $worker->{n} - 1 ] = $text;
+        }
+        else {
+          $error //= $text || "worker $worker->{n} stopped";
+        }
+        next;
+      }
+
+      $waiting{$tag} = [ $lines, $text ];
+      while ( my $task_aref = delete $waiting{$nextWrite} ) {
+        $write->( $nextWrite++, @$task_aref ) unless $error;
+      }
+    }
+  }
+  waitpid $_->{pid}, 0 for @workers;
+
+  $self->tee_logger( 'error', "Annotation worker failed: $error" ) if defined $error;
+  $self->tee_logger( 'info', sprintf( 'Workers stole from each other %d times', $steals ) );
+  return @finished;
+}
 # _minor_allele_carriers assumes the following spec for indels:
 # Allele listed in sample column is one of D,E,I,H, or whatever single base
 # codes are defined in Seq::Role::Genotypes
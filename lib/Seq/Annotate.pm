@@ -108,6 +108,10 @@ has statisticsCalculator => (
     summarizeStats => 'summarize',
     statsRecord    => 'statsRecord',
     storeStats     => 'storeStats',
+    storeCounts    => 'storeCounts',
+    mergeStats     => 'mergeRecord',
+    statsPartial   => 'statsPartial',
+    mergePartial   => 'mergePartial',
   },
   lazy     => 1,
   required => 1,
@@ -148,7 +152,7 @@ has _genome => (
   handles  => [
     'get_abs_pos',    'char_genome_length', 'genome_length',   'get_base',
     'get_idx_base',   'get_idx_in_gan',     'get_idx_in_gene', 'get_idx_in_exon',
-    'get_idx_in_snp', 'chr_len',            'next_chr',
+    'get_idx_in_snp', 'get_idx_site',       'chr_len',         'next_chr',
   ]
 );
 
@@ -202,13 +206,9 @@ sub _load_genome_sized_track {
   }
 
   my $idx_file = $gst->genome_bin_file;
-  my $idx_fh   = $self->get_read_fh($idx_file);
-  binmode $idx_fh;
-
-  # read genome
-  my $seq           = '';
+  my $width = ( $gst->type eq 'ngene' ) ? 2 : 1;
+  my ( $bin_attr, $bin_data ) = $self->_read_bin_file( $idx_file, $width );
   my $genome_length = -s $idx_file;
-  read $idx_fh, $seq, $genome_length;
 
   # read yml chr offsets
   my $yml_file     = $gst->genome_offset_file;
@@ -221,7 +221,7 @@ sub _load_genome_sized_track {
       genome_chrs   => $gst->genome_chrs,
       genome_length => $genome_length,
       chr_len       => $chr_len_href,
-      bin_seq       => \$seq,
+      $bin_attr     => $bin_data,
     }
   );
 
@@ -280,14 +280,8 @@ sub _load_cadd_score {
       croak join( "\n", @$msg_aref );
     }
 
-    # read the file
-    my $idx_fh = $self->get_read_fh($idx_file);
-    binmode $idx_fh;
-
-    # read genome
-    my $seq           = '';
+    my ( $bin_attr, $bin_data ) = $self->_read_bin_file( $idx_file, 1 );
     my $genome_length = -s $idx_file;
-    read $idx_fh, $seq, $genome_length;
 
     # read yml chr offsets
     my $yml_file     = $gst->genome_offset_file;
@@ -300,7 +294,7 @@ sub _load_cadd_score {
         genome_chrs   => $gst->genome_chrs,
         genome_length => $genome_length,
         chr_len       => $chr_len_href,
-        bin_seq       => \$seq,
+        $bin_attr     => $bin_data,
       }
     );
     push @cadd_scores, $obj;
@@ -314,6 +308,25 @@ sub _load_cadd_score {
   return \@cadd_scores;
 }
 
+# _read_bin_file maps a genome-sized track with Seq::Native when it is built,
+# otherwise it reads the whole file into a scalar; returns the Seq::GenomeBin
+# attribute name and value to use
+sub _read_bin_file {
+  my ( $self, $idx_file, $width ) = @_;
+
+  if ( Seq::GenomeBin->native_available ) {
+    my $track = Seq::Native::Track->new( "$idx_file", $width );
+    return ( bin_track => $track );
+  }
+
+  my $idx_fh = $self->get_read_fh($idx_file);
+  binmode $idx_fh;
+
+  my $seq = '';
+  read $idx_fh, $seq, -s $idx_file;
+  return ( bin_seq => \$seq );
+}
+
 sub _check_genome_sized_files {
   my ( $self, $files_aref ) = @_;
 
@@ -332,12 +345,15 @@ sub _check_genome_sized_files {
   return \@msg;
 }
 
+# get_cadd_score takes an optional aref of the 3 cadd scores at the site, as
+# cached by prefetch_sites, to avoid going back to the tracks
 sub get_cadd_score {
-  my ( $self, $abs_pos, $ref, $allele ) = @_;
+  my ( $self, $abs_pos, $ref, $allele, $cadd_aref ) = @_;
 
   my $key = join ":", $ref, $allele;
   my $i = $self->get_cadd_index($key);
   if ( defined $i ) {
+    return $cadd_aref->[$i] if $cadd_aref;
     my $cadd_track = $self->_get_cadd_track($i);
     return $cadd_track->get_score($abs_pos);
   }
@@ -346,6 +362,148 @@ sub get_cadd_score {
   }
 }
 
+=property @private {HashRef} _site_cache
+
+  Genome-sized track data for the current batch of sites, keyed by absolute
+  position; filled by @method prefetch_sites. Values are array references:
+  [ site_code, nearest_gene_code, { score_name => score }, [ cadd_0..2 ] ]
+
+=cut
+
+has _site_cache => (
+  is      => 'rw',
+  isa     => 'HashRef',
+  traits  => ['Hash'],
+  handles => { _cached_site => 'get', },
+  default => sub { {} },
+);
+
+=property @public {Str} genome_server
+
+  The Unix domain socket of a genome_server (c/bin) that serves this assembly
+  under its genome_name (see @method genome_server_manifest). Given, @method
+  prefetch_sites asks it for the genome-sized tracks of each batch rather than
+  looking them up in the tracks mapped here.
+
+=cut
+
+has genome_server => (
+  is      => 'ro',
+  isa     => 'Maybe[Str]',
+  default => undef,
+);
+
+# the client of genome_server, with the server's id of the assembly, the
+#   tracks to ask for and their names; a forked worker connects anew
+has _server => (
+  is       => 'ro',
+  isa      => 'HashRef',
+  lazy     => 1,
+  init_arg => undef,
+  builder  => '_connect_server',
+  clearer  => '_clear_server',
+);
+
+sub _connect_server {
+  my $self = shift;
+
+  require Seq::Native::Client;
+  my $client = Seq::Native::Client->new( $self->genome_server );
+  my $served = $client->info->{ $self->genome_name };
+  croak sprintf( "genome_server on %s does not serve %s", $self->genome_server,
+    $self->genome_name )
+    unless $served;
+
+  my %want = map { $_->name => 1 } $self->_all_genome_scores;
+  my @names = grep { $want{$_} } @{ $served->{scores} };
+  croak sprintf( "genome_server on %s lacks score tracks or cadd of %s",
+    $self->genome_server, $self->genome_name )
+    if @names != keys %want || ( $self->has_cadd_track && !$served->{cadd} );
+
+  my $tracks = 0;
+  for my $i ( 0 .. $#{ $served->{scores} } ) {
+    $tracks |= 1 << $i if $want{ $served->{scores}[$i] };
+  }
+  $tracks |= Seq::Native::Client::TRACK_CADD_ALL() if $self->has_cadd_track;
+  return { client => $client, id => $served->{id}, tracks => $tracks, names => \@names };
+}
+
+=method @public prefetch_sites
+
+  Looks up every genome-sized track for a batch of absolute positions with a
+  single call into Seq::Native (see Seq::Native::lookup_batch), or a single
+  request to @property genome_server, and caches the results for @method
+  annotate. Replaces the previous batch's cache. Does nothing when the tracks
+  were read into memory rather than mapped and there is no genome_server.
+
+@param {ArrayRef<Int>} $abs_pos_aref
+  Zero-indexed absolute positions, ideally sorted
+
+=cut
+
+sub prefetch_sites {
+  my ( $self, $abs_pos_aref ) = @_;
+
+  my %cache;
+  $self->_site_cache( \%cache );
+
+  my ( $batch, @score_names );
+  if ( $self->genome_server ) {
+    $self->_clear_server if $self->_server->{client}->pid != $$;
+    my $server = $self->_server;
+    $batch = $server->{client}->lookup( $server->{id}, $abs_pos_aref, $server->{tracks} );
+    @score_names = @{ $server->{names} };
+  }
+  else {
+    return if !$self->_genome->has_bin_track;
+
+    my @score_tracks = $self->_all_genome_scores;
+    my $ngene        = $self->_ngene;
+    $batch = Seq::Native::lookup_batch(
+      $self->_genome->bin_track,
+      $ngene ? $ngene->bin_track : undef,
+      [ map { $_->bin_track } @score_tracks ],
+      [ map { $_->bin_track } @{ $self->_genome_cadd } ], $abs_pos_aref
+    );
+    @score_names = map { $_->name } @score_tracks;
+  }
+
+  for my $i ( 0 .. $#$abs_pos_aref ) {
+    # out of range positions are left to the usual accessors, which croak
+    next unless defined $batch->{site_code}[$i];
+
+    my %scores;
+    for my $j ( 0 .. $#score_names ) {
+      $scores{ $score_names[$j] } = $batch->{scores}[$j][$i];
+    }
+    $cache{ $abs_pos_aref->[$i] } = [
+      $batch->{site_code}[$i], $batch->{nearest_gene}[$i],
+      \%scores, [ map { $_->[$i] } @{ $batch->{cadd} || [] } ]
+    ];
+  }
+}
+
+=method @public cost_tasks
+
+  Cuts the rows of a plain snpfile, from $start on, into tasks of about
+  $task_cost each (and no more than $max_bytes), the cost of a row hinted by
+  the site code of its position and the bases it covers (see
+  Seq::Native::Track::cost_tasks). Returns nothing when the genome track was
+  read into memory rather than mapped.
+
+@returns {ArrayRef} [ start, end, cost ] of each task, in bytes of the file
+
+=cut
+
+sub cost_tasks {
+  my ( $self, $snpfile, $header_aref, $start, $task_cost, $max_bytes ) = @_;
+
+  return if !$self->_genome->has_bin_track;
+
+  return $self->_genome->bin_track->cost_tasks( $snpfile, $header_aref, $self->chr_len,
+    $start, 0, $task_cost, $max_bytes );
+}
+
 =property @private {HashRef} _cadd_lookup
 
   Defines delegate @method @public get_cadd_index
@@ -397,18 +555,21 @@ sub _build_cadd_lookup {
 
 =cut
 
+# Seq::KCManager or Seq::Native::GeneDb; both answer db_get( $abs_pos ) and
+#   db_bulk_get( \@keys, $reverse )
 has dbm_gene => (
   is      => 'ro',
-  isa     => 'ArrayRef[ArrayRef[Maybe[Seq::KCManager]]]',
+  isa     => 'ArrayRef[ArrayRef[Maybe[Object]]]',
   builder => '_build_dbm_gene',
   traits  => ['Array'],
   handles => { _all_dbm_gene => 'elements', },
   lazy    => 1,
 );
 
+# Seq::KCManager or Seq::Native::SnpDb; both answer db_get( $abs_pos )
 has dbm_snp => (
   is      => 'ro',
-  isa     => 'ArrayRef[ArrayRef[Maybe[Seq::KCManager]]]',
+  isa     => 'ArrayRef[ArrayRef[Maybe[Object]]]',
   builder => '_build_dbm_snp',
   traits  => ['Array'],
   handles => { _all_dbm_snp => 'elements', },
@@ -502,20 +663,38 @@ sub _build_dbm_array {
   return \@array;
 }
 
+# prefer the columnar snp store, when it was built, over the kch files
 sub _build_dbm_snp {
   my $self = shift;
   my @array;
   for my $snp_track ( $self->all_snp_tracks ) {
-    push @array, $self->_build_dbm_array($snp_track);
+    my $dbm_aref = $self->_build_dbm_array($snp_track);
+    if ( Seq::GenomeBin->native_available ) {
+      my @chrs = $snp_track->all_genome_chrs;
+      for my $i ( 0 .. $#chrs ) {
+        my $sdb = $snp_track->get_sdb_file( $chrs[$i] );
+        $dbm_aref->[$i] = Seq::Native::SnpDb->new($sdb) if -f $sdb;
+      }
+    }
+    push @array, $dbm_aref;
   }
   return \@array;
 }
 
+# likewise, prefer the gene site store over the kch files
 sub _build_dbm_gene {
   my $self = shift;
   my @array;
   for my $gene_track ( $self->all_gene_tracks ) {
-    push @array, $self->_build_dbm_array($gene_track);
+    my $dbm_aref = $self->_build_dbm_array($gene_track);
+    if ( Seq::GenomeBin->native_available ) {
+      my @chrs = $gene_track->all_genome_chrs;
+      for my $i ( 0 .. $#chrs ) {
+        my $gdb = $gene_track->get_gdb_file( $chrs[$i] );
+        $dbm_aref->[$i] = Seq::Native::GeneDb->new($gdb) if -f $gdb;
+      }
+    }
+    push @array, $dbm_aref;
   }
   return \@array;
 }
@@ -760,6 +939,78 @@ sub _var_alleles {
 #   return \@var_alleles;
 # }
 
+# _sparse_data returns the records of the gene and snp tracks at a site, as
+# Seq::Site::Annotation (or Seq::Site::Indel) and Seq::Site::Snp objects, for
+# the site's gan and snp flags and its variant alleles
+sub _sparse_data {
+  my ( $self, $chr_index, $abs_pos, $base, $gan, $snp, $snpAllelesAref, $indelAnnotator ) =
+    @_;
+
+  my ( @gene_data, @snp_data ) = ();
+
+  # get gene annotations at site
+  if ($gan) {
+    for my $gene_dbs ( $self->_all_dbm_gene ) {
+      my $kch = $gene_dbs->[$chr_index];
+
+      # if there's no file for the track then it will be undef
+      next unless defined $kch;
+
+      $indelAnnotator->findGeneData( $abs_pos, $kch ) if ($indelAnnotator);
+
+      # the native store does the codon substitution of each snp allele, so
+      #   the records need no more work in Seq::Site::Annotation
+      my $native = @$snpAllelesAref && $kch->can('db_get_alleles');
+      if ($native) {
+        push @gene_data, map { Seq::Site::Annotation->new($_) }
+          @{ $kch->db_get_alleles( $abs_pos, $snpAllelesAref ) // [] };
+        next unless defined $indelAnnotator;
+      }
+
+      # all kc values come as aref's of href's
+      my $rec_aref = $kch->db_get($abs_pos);
+
+      if ( defined $rec_aref ) {
+        for my $rec_href (@$rec_aref) {
+          if ( @$snpAllelesAref && !$native ) {
+            for my $snpAllele (@$snpAllelesAref) {
+              $rec_href->{minor_allele} = $snpAllele;
+              push @gene_data, Seq::Site::Annotation->new($rec_href);
+            }
+          }
+          if ( defined $indelAnnotator ) {
+            for my $iAllele ( $indelAnnotator->allAlleles ) {
+              $rec_href->{minor_allele}    = $iAllele->minor_allele;
+              $rec_href->{annotation_type} = $iAllele->annotation_type;
+              push @gene_data, Seq::Site::Indel->new($rec_href);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  # get snp annotations at site
+  if ($snp) {
+    for my $snp_dbs ( $self->_all_dbm_snp ) {
+      my $kch = $snp_dbs->[$chr_index];
+
+      # if there's no file for the track then it will be undef
+      next unless defined $kch;
+
+      # all kc values come as aref's of href's
+      my $firstBase;
+      my $rec_aref = $kch->db_get($abs_pos);
+      if ( defined $rec_aref ) {
+        for my $rec_href (@$rec_aref) {
+          push @snp_data, Seq::Site::Snp->new($rec_href);
+        }
+      }
+    }
+  }
+  return ( \@gene_data, \@snp_data );
+}
+
 # annotate_snp_site returns a hash reference of the annotation data for a
 # given position and variant alleles
 sub annotate {
@@ -769,12 +1020,9 @@ sub annotate {
     $hom_ids,    $id_genos_href, $return_obj
   ) = @_;
 
-  my $site_code = $self->get_base($abs_pos);
-  my $base      = $self->get_idx_base($site_code);
-  my $gan       = $self->get_idx_in_gan($site_code);
-  my $gene      = $self->get_idx_in_gene($site_code);
-  my $exon      = $self->get_idx_in_exon($site_code);
-  my $snp       = $self->get_idx_in_snp($site_code);
+  my $site      = $self->_cached_site($abs_pos);
+  my $site_code = $site ? $site->[0] : $self->get_base($abs_pos);
+  my ( $base, $gan, $gene, $exon, $snp ) = $self->get_idx_site($site_code);
 
   if ( $base ne $ref_allele ) {
     $self->count_discordant;
@@ -811,7 +1059,8 @@ sub annotate {
     else {
       $record{genomic_type} = 'Intronic';
       if ( $self->_ngene ) {
-        my $nearest_gene_code = $self->get_nearest_gene($abs_pos) || '-9';
+        my $nearest_gene_code =
+          ( $site ? $site->[1] : $self->get_nearest_gene($abs_pos) ) || '-9';
         if ( $nearest_gene_code != -9 ) {
           $record{nearest_gene} = $self->gene_num_2_str($nearest_gene_code);
         }
@@ -822,7 +1071,8 @@ sub annotate {
   else {
     $record{genomic_type} = 'Intergenic';
     if ( $self->_ngene ) {
-      my $nearest_gene_code = $self->get_nearest_gene($abs_pos) || '-9';
+      my $nearest_gene_code =
+        ( $site ? $site->[1] : $self->get_nearest_gene($abs_pos) ) || '-9';
       if ( $nearest_gene_code != -9 ) {
         $record{nearest_gene} = $self->gene_num_2_str($nearest_gene_code);
       }
@@ -831,74 +1081,30 @@ sub annotate {
   }
 
   # get scores at site
-  for my $gs ( $self->_all_genome_scores ) {
-    $record{scores}{ $gs->name } = $gs->get_score($abs_pos);
+  if ($site) {
+    $record{scores}{$_} = $site->[2]{$_} for keys %{ $site->[2] };
   }
-
-  if ( @$snpAllelesAref && $self->has_cadd_track ) {
-    for my $sAllele (@$snpAllelesAref) {
-      $record{scores}{cadd} = $self->get_cadd_score( $abs_pos, $base, $sAllele );
+  else {
+    for my $gs ( $self->_all_genome_scores ) {
+      $record{scores}{ $gs->name } = $gs->get_score($abs_pos);
     }
   }
 
-  my ( @gene_data, @snp_data ) = ();
-
-  # get gene annotations at site
-  if ($gan) {
-    for my $gene_dbs ( $self->_all_dbm_gene ) {
-      my $kch = $gene_dbs->[$chr_index];
-
-      # if there's no file for the track then it will be undef
-      next unless defined $kch;
-
-      # all kc values come as aref's of href's
-      my $rec_aref = $kch->db_get($abs_pos);
-
-      $indelAnnotator->findGeneData( $abs_pos, $kch ) if ($indelAnnotator);
-
-      if ( defined $rec_aref ) {
-        for my $rec_href (@$rec_aref) {
-          if (@$snpAllelesAref) {
-            for my $sAllele (@$snpAllelesAref) {
-              $rec_href->{minor_allele} = $sAllele;
-              push @gene_data, Seq::Site::Annotation->new($rec_href);
-            }
-          }
-          if ( defined $indelAnnotator ) {
-            for my $iAllele ( $indelAnnotator->allAlleles ) {
-              $rec_href->{minor_allele}    = $iAllele->minor_allele;
-              $rec_href->{annotation_type} = $iAllele->annotation_type;
-              push @gene_data, Seq::Site::Indel->new($rec_href);
-            }
-          }
-        }
-      }
+  if ( @$snpAllelesAref && $self->has_cadd_track ) {
+    for my $sAllele (@$snpAllelesAref) {
+      $record{scores}{cadd} =
+        $self->get_cadd_score( $abs_pos, $base, $sAllele, $site ? $site->[3] : undef );
     }
   }
-  $record{gene_data} = \@gene_data;
 
-  # get snp annotations at site
-  if ($snp) {
-    for my $snp_dbs ( $self->_all_dbm_snp ) {
-      my $kch = $snp_dbs->[$chr_index];
-
-      # if there's no file for the track then it will be undef
-      next unless defined $kch;
-
-      # all kc values come as aref's of href's
-      my $firstBase;
-      my $rec_aref = $kch->db_get($abs_pos);
-      if ( defined $rec_aref ) {
-        for my $rec_href (@$rec_aref) {
-          push @snp_data, Seq::Site::Snp->new($rec_href);
-        }
-      }
-    }
-  }
-  $record{snp_data} = \@snp_data;
+  my ( $gene_data_aref, $snp_data_aref ) =
+    $self->_sparse_data( $chr_index, $abs_pos, $base, $gan, $snp, $snpAllelesAref,
+    $indelAnnotator );
+  $record{gene_data} = $gene_data_aref;
+  $record{snp_data}  = $snp_data_aref;
 
   $self->recordStat( $id_genos_href, [ $record{var_type}, $record{genomic_type} ],
-    $record{ref_base}, \@gene_data, \@snp_data );
+    $record{ref_base}, $gene_data_aref, $snp_data_aref );
   # create object for href export
   my $obj = Seq::Annotate::All->new( \%record );
 
@@ -927,6 +1133,164 @@ sub annotate {
   }
 }
 
+=method @public genome_annotate_args
+
+  The arguments genome_annotate (c/bin) needs for the genome-sized tracks of
+  the assembly, the score tracks in the order of the header; the caller adds
+  the snpfile, output and threads.
+
+=cut
+
+sub genome_annotate_args {
+  my $self = shift;
+  my @args;
+
+  for my $gst ( $self->all_genome_sized_tracks ) {
+    my $idx_file = $gst->genome_bin_file->stringify;
+    if ( $gst->type eq 'genome' ) {
+      push @args, '--genome', $idx_file, '--chr', $gst->genome_offset_file->stringify;
+    }
+    elsif ( $gst->type eq 'score' ) {
+      push @args, '--score', join( ':',
+        $gst->name . "=$idx_file", $gst->score_min, $gst->score_max, $gst->score_R );
+    }
+    elsif ( $gst->type eq 'cadd' ) {
+      push @args, '--cadd', $idx_file;
+    }
+  }
+
+  # the nearest genes are named as gene_num_2_str names them, from the region
+  #   file the ngene track was built with
+  if ( $self->_ngene && $self->dbm_ngene ) {
+    for my $gst ( $self->all_genome_sized_tracks ) {
+      next unless $gst->type eq 'ngene';
+      for my $gene_track ( $self->all_gene_tracks ) {
+        my $dat_file = $gene_track->get_dat_file( 'genome', 'gene' );
+        next unless -f $dat_file;
+        push @args, '--ngene', $gst->genome_bin_file->stringify, '--genes', "$dat_file";
+        last;
+      }
+      last;
+    }
+  }
+  return @args;
+}
+
+=method @public genome_server_manifest
+
+  The lines of a genome_server (c/bin) manifest that serve the genome-sized
+  tracks of the assembly under its genome_name; see @property genome_server.
+
+=cut
+
+sub genome_server_manifest {
+  my $self  = shift;
+  my @lines = ( join ' ', 'assembly', $self->genome_name );
+
+  for my $gst ( $self->all_genome_sized_tracks ) {
+    my $idx_file = $gst->genome_bin_file->absolute->stringify;
+    if ( $gst->type eq 'genome' ) {
+      push @lines, "genome $idx_file",
+        join( ' ', 'chr', $gst->genome_offset_file->absolute->stringify );
+    }
+    elsif ( $gst->type eq 'ngene' ) {
+      push @lines, "ngene $idx_file";
+    }
+    elsif ( $gst->type eq 'score' || $gst->type eq 'cadd' ) {
+      push @lines, join( ' ', $gst->type, ( $gst->type eq 'score' ? $gst->name : () ),
+        $idx_file, $gst->score_min, $gst->score_max, $gst->score_R );
+    }
+  }
+  return map { "$_\n" } @lines;
+}
+
+has _chr_index => (
+  is       => 'ro',
+  isa      => 'HashRef',
+  lazy     => 1,
+  init_arg => undef,
+  default  => sub {
+    my $self = shift;
+    my @chrs = $self->all_genome_chrs;
+    return { map { $chrs[$_] => $_ } 0 .. $#chrs };
+  },
+);
+
+=method @public genome_annotate_columns
+
+  The columns genome_annotate (c/bin) writes for the assembly, in its order;
+  with --fields the snpfile's fields follow them.
+
+=cut
+
+sub genome_annotate_columns {
+  my $self = shift;
+  return (
+    qw/ chr pos var_type alleles allele_count genomic_type ref_base nearest_gene var_allele /,
+    ( map { $_->name } $self->_all_genome_scores ),
+    ( $self->has_cadd_track ? 'cadd' : () )
+  );
+}
+
+=method @public annotate_genome_row
+
+  Completes a row of genome_annotate, given as a hash reference keyed by its
+  header, with the reference allele and the carriers of its snpfile line
+  (see Seq::_minor_allele_carriers): genome_annotate has the fields of the
+  genome-sized tracks, as annotate would have them, and the records of the
+  gene and snp tracks are added here. Like annotate, counts a discordant
+  base and records the row's statistics; returns what annotate returns, or
+  nothing for a row without variant alleles or a chromosome the assembly
+  lacks.
+
+=cut
+
+sub annotate_genome_row {
+  my ( $self, $row_href, $ref_allele, $het_ids, $hom_ids, $id_genos_href ) = @_;
+
+  my $chr       = $row_href->{chr};
+  my $chr_index = $self->_chr_index->{$chr};
+  my $chr_start = $self->chr_len->{$chr};
+  return unless defined $chr_index && defined $chr_start;
+
+  my $abs_pos = $chr_start + $row_href->{pos} - 1;
+  my $base    = $row_href->{ref_base};
+  my ( undef, $gan, undef, undef, $snp ) = $self->get_idx_site( $self->get_base($abs_pos) );
+
+  $self->count_discordant if $base ne $ref_allele;
+  return unless length $row_href->{var_allele};
+
+  # var_allele has the alleles of _var_alleles, snp ones first
+  my ( @snpAlleles, @indelAlleles );
+  for my $allele ( split /\,/, $row_href->{var_allele} ) {
+    if   ( length $allele == 1 ) { push @snpAlleles,   $allele; }
+    else                         { push @indelAlleles, $allele; }
+  }
+  my $indelAnnotator =
+    @indelAlleles ? Seq::Sites::Indels->new( alleles => \@indelAlleles ) : undef;
+
+  my %record = map { $_ => $row_href->{$_} }
+    qw/ chr pos var_allele allele_count alleles var_type ref_base genomic_type /;
+  $record{abs_pos} = $abs_pos;
+  $record{het_ids} = $het_ids;
+  $record{hom_ids} = $hom_ids;
+  $record{nearest_gene} = $row_href->{nearest_gene} if $row_href->{nearest_gene} ne 'NA';
+  for my $name ( ( map { $_->name } $self->_all_genome_scores ),
+    ( $self->has_cadd_track ? 'cadd' : () ) )
+  {
+    $record{scores}{$name} = $row_href->{$name} if defined $row_href->{$name};
+  }
+
+  ( $record{gene_data}, $record{snp_data} ) =
+    $self->_sparse_data( $chr_index, $abs_pos, $base, $gan, $snp, \@snpAlleles,
+    $indelAnnotator );
+
+  $self->recordStat( $id_genos_href, [ $record{var_type}, $record{genomic_type} ],
+    $record{ref_base}, $record{gene_data}, $record{snp_data} );
+
+  return Seq::Annotate::All->new( \%record )->as_href;
+}
+
 __PACKAGE__->meta->make_immutable;
 
 1;
@@ -48,6 +48,7 @@ use YAML::XS qw/ Dump /;
 use Seq::Build::SnpTrack;
 use Seq::Build::GeneTrack;
 use Seq::Build::GenomeSizedTrackStr;
+use Seq::GenomeBin;
 use Seq::KCManager;
 
 extends 'Seq::Assembly';
@@ -85,6 +86,29 @@ has ngene_bin => (
   coerce => 1,
 );
 
+# optional; when given (and Seq::Native is available to read the stores) snp
+#   tracks are built for all chromosomes in one pass, see c/src/seq_snpbuild.h
+has genome_snpdb => (
+  is        => 'ro',
+  isa       => AbsFile,
+  coerce    => 1,
+  predicate => 'has_genome_snpdb',
+);
+
+# optional; likewise for gene tracks, see c/src/seq_genebuild.h
+has genome_genedb => (
+  is        => 'ro',
+  isa       => AbsFile,
+  coerce    => 1,
+  predicate => 'has_genome_genedb',
+);
+
+has threads => (
+  is      => 'ro',
+  isa     => 'Int',
+  default => 1,
+);
+
 has wanted_chr => (
   is      => 'ro',
   isa     => 'Str',
@@ -98,6 +122,8 @@ sub BUILD {
   $self->_logger->info( "genome_scorer: " . ( $self->genome_scorer || 'NA' ) );
   $self->_logger->info( "genome_cadd: " .   ( $self->genome_cadd   || 'NA' ) );
   $self->_logger->info( "ngene_bin " .      ( $self->ngene_bin     || 'NA' ) );
+  $self->_logger->info( "genome_snpdb: " .  ( $self->genome_snpdb  || 'NA' ) );
+  $self->_logger->info( "genome_genedb: " . ( $self->genome_genedb || 'NA' ) );
   $self->_logger->info( "wanted_chr: " .    ( $self->wanted_chr    || 'all' ) );
 }
 
@@ -194,6 +220,12 @@ sub build_snp_sites {
   $self->_logger->info('build snp tracks: start');
   my $wanted_chr = $self->wanted_chr;
 
+  if ( $self->has_genome_snpdb and !$wanted_chr and Seq::GenomeBin->native_available ) {
+    $self->_build_snp_sites_native($_) for $self->all_snp_tracks;
+    $self->_logger->info('build snp tracks: done');
+    return;
+  }
+
   for my $snp_track ( $self->all_snp_tracks ) {
 
     # extract keys from snp_track for creation of Seq::Build::SnpTrack
@@ -226,6 +258,48 @@ sub build_snp_sites {
   $self->_logger->info('build snp tracks: done');
 }
 
+# builds the snp stores and site range files of every chromosome with one
+#   pass over the snp track's files
+sub _build_snp_sites_native {
+  my ( $self, $snp_track ) = @_;
+
+  my @dat_files = map { $snp_track->get_dat_file( $_, $snp_track->type ) }
+    $self->all_genome_chrs;
+  if ( !$self->force and !grep { !-s $_ } @dat_files ) {
+    $self->_logger->info( "found site range files for snp track: " . $snp_track->name );
+    return;
+  }
+
+  # the builder reads the string genome from disk; make it if needed
+  my ($genome_gst) = grep { $_->type eq 'genome' } $self->all_genome_sized_tracks;
+  unless ( -s $genome_gst->genome_str_file and -s $genome_gst->genome_offset_file ) {
+    $self->genome_str_track;
+  }
+
+  $self->genome_index_dir->mkpath unless ( -d $self->genome_index_dir );
+
+  my $cmd = join " ", $self->genome_snpdb,
+    '-c', $genome_gst->genome_offset_file,
+    '-g', $genome_gst->genome_str_file,
+    '-n', $snp_track->name,
+    '-d', $self->genome_index_dir->absolute->stringify,
+    '-t', $self->threads,
+    '--in_snp', $genome_gst->in_snp_val,
+    ( map { ( '-f', $_ ) } $snp_track->all_features ),
+    ( map { ( '-i', $_ ) } $snp_track->all_local_files );
+
+  $self->_logger->info("running command: $cmd");
+
+  my $exit_code = system $cmd;
+
+  if ($exit_code) {
+    my $msg =
+      sprintf( "error building snp track with %s: %d", $self->genome_snpdb, $exit_code );
+    $self->_logger->error($msg);
+    croak $msg;
+  }
+}
+
 sub build_gene_sites {
   my ( $self, $chr ) = @_;
 
@@ -233,6 +307,12 @@ sub build_gene_sites {
 
   my $wanted_chr = $self->wanted_chr;
 
+  if ( $self->has_genome_genedb and !$wanted_chr and Seq::GenomeBin->native_available ) {
+    $self->_build_gene_sites_native($_) for $self->all_gene_tracks;
+    $self->_logger->info('build gene track: done');
+    return;
+  }
+
   for my $gene_track ( $self->all_gene_tracks ) {
 
     # extract keys from snp_track for creation of Seq::Build::GeneTrack
@@ -265,6 +345,50 @@ sub build_gene_sites {
   $self->_logger->info('build gene track: done');
 }
 
+# builds the gene site stores and site range files of every chromosome, the
+#   chromosomes in parallel, and the consequence track of the gene track
+sub _build_gene_sites_native {
+  my ( $self, $gene_track ) = @_;
+
+  my @dat_files = map { ( $gene_track->get_dat_file( $_, 'gan' ),
+      $gene_track->get_dat_file( $_, 'exon' ) ) } $self->all_genome_chrs;
+  if ( !$self->force and !grep { !-s $_ } @dat_files ) {
+    $self->_logger->info( "found site range files for gene track: " . $gene_track->name );
+    return;
+  }
+
+  # the builder reads the string genome from disk; make it if needed
+  my ($genome_gst) = grep { $_->type eq 'genome' } $self->all_genome_sized_tracks;
+  unless ( -s $genome_gst->genome_str_file and -s $genome_gst->genome_offset_file ) {
+    $self->genome_str_track;
+  }
+
+  $self->genome_index_dir->mkpath unless ( -d $self->genome_index_dir );
+
+  my $cmd = join " ", $self->genome_genedb,
+    '-c', $genome_gst->genome_offset_file,
+    '-g', $genome_gst->genome_str_file,
+    '-n', $gene_track->name,
+    '-d', $self->genome_index_dir->absolute->stringify,
+    '-t', $self->threads,
+    '--in_gan',  $genome_gst->in_gan_val,
+    '--in_exon', $genome_gst->in_exon_val,
+    '--csq',
+    ( map { ( '-f', $_ ) } $gene_track->all_features ),
+    ( map { ( '-i', $_ ) } $gene_track->all_local_files );
+
+  $self->_logger->info("running command: $cmd");
+
+  my $exit_code = system $cmd;
+
+  if ($exit_code) {
+    my $msg =
+      sprintf( "error building gene track with %s: %d", $self->genome_genedb, $exit_code );
+    $self->_logger->error($msg);
+    croak $msg;
+  }
+}
+
 sub build_conserv_scores_index {
   my $self = shift;
 
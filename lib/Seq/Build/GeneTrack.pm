@@ -35,6 +35,7 @@ use File::Spec;
 use namespace::autoclean;
 
 use Seq::Gene;
+use Seq::GenomeBin;
 use Seq::KCManager;
 
 use Data::Dump qw/dump/;
@@ -176,8 +177,9 @@ sub build_tx_db_for_genome {
     # bnum => bucket number => 50-400% of expected items in the hash is optimal
     # annotated sites for hg38 is 22727477 (chr1) to 13222 (chrM) with avg of
     # 9060664 and sd of 4925631; thus, took ~1/2 of maximal number of entries
-    bnum => 1_000_000,
-    msiz => 512_000_000,
+    bnum    => 1_000_000,
+    msiz    => 512_000_000,
+    compact => Seq::KCManager->compact_available,
   );
 
   # create dbm object for nearest neighbor gene list
@@ -212,7 +214,7 @@ sub build_tx_db_for_genome {
     };
 
     # save gene attr in dbm
-    $db_tx->db_put( $record_href->{transcript_id}, $record_href );
+    $db_tx->bulk_put( $record_href->{transcript_id}, $record_href );
 
     # save tx start/stop for gene
     say {$gene_region_fh} join "\t", $gene->transcript_start, $gene->transcript_end;
@@ -268,6 +270,9 @@ sub build_tx_db_for_genome {
 
   }
 
+  # write the transcripts, each key once
+  $db_tx->bulk_finish;
+
   # now, the helper program will sort this so it's not strictly necessary to do so here
   my @sorted_genes = map { $_->[0] }
     sort { $a->[1] <=> $b->[1] }
@@ -291,6 +296,11 @@ sub build_tx_db_for_genome {
   }
   close($regionFh);
 
+  # the dbs are done: their codecs are written and they are flushed here, not
+  #   whenever their objects happen to be destroyed
+  $db_tx->sync;
+  $db_nn->sync;
+
   $msg = sprintf(
     "genes: %d; first gene: %s, last gene: %s",
     ( scalar @sorted_genes ),
@@ -323,9 +333,11 @@ sub build_gene_db_for_chr {
   $msg = sprintf( "writing to: '%s'", $ex_file );
   $self->_logger->info($msg);
 
-  # dbm file
+  # dbm file, or gene site store when the native runtime is available
   my $dbm_file = $self->get_kch_file($wanted_chr);
-  $msg = sprintf( "writing to: '%s'", $dbm_file );
+  my $gdb_file = $self->get_gdb_file($wanted_chr);
+  my $native   = Seq::GenomeBin->native_available;
+  $msg = sprintf( "writing to: '%s'", $native ? $gdb_file : $dbm_file );
   $self->_logger->info($msg);
 
   # check if we've already build site range files unless forced to overwrite
@@ -335,15 +347,24 @@ sub build_gene_db_for_chr {
       && $self->_has_site_range_file($ex_file) );
   }
 
-  my $db = Seq::KCManager->new(
-    filename => $dbm_file,
-    mode     => 'create',
-    # bnum => bucket number => 50-400% of expected items in the hash is optimal
-    # annotated sites for hg38 is 22727477 (chr1) to 13222 (chrM) with avg of
-    # 9060664 and sd of 4925631; thus, took ~1/2 of maximal number of entries
-    bnum => 12_000_000,
-    msiz => 512_000_000,
-  );
+  # the store keeps each transcript once and a small entry per site that
+  #   refers to it; the kch keeps the whole site record
+  my $db;
+  if ($native) {
+    $db = Seq::Native::GeneWriter->new;
+  }
+  else {
+    $db = Seq::KCManager->new(
+      filename => $dbm_file,
+      mode     => 'create',
+      # bnum => bucket number => 50-400% of expected items in the hash is optimal
+      # annotated sites for hg38 is 22727477 (chr1) to 13222 (chrM) with avg of
+      # 9060664 and sd of 4925631; thus, took ~1/2 of maximal number of entries
+      bnum    => 12_000_000,
+      msiz    => 512_000_000,
+      compact => Seq::KCManager->compact_available,
+    );
+  }
 
   # write header for region file
   # NOTE: 1st line needs to be value that should be added to encoded genome for
@@ -359,12 +380,30 @@ sub build_gene_db_for_chr {
 
     my ( @fl_sites, @ex_sites ) = ();
 
+    my $tx;
+    if ($native) {
+      $tx = $db->add_transcript(
+        {
+          transcript_id         => $gene->transcript_id,
+          strand                => $gene->strand,
+          transcript_seq        => $gene->transcript_seq,
+          transcript_annotation => $gene->transcript_annotation,
+          alt_names             => $gene->alt_names,
+          error_code            => $gene->transcript_error,
+        }
+      );
+    }
+
     # get intronic flanking site annotations
     my @flank_exon_sites = $gene->all_flanking_sites;
     for my $site (@flank_exon_sites) {
-      my $site_href = $site->as_href;
-      my $abs_pos   = $site_href->{abs_pos};
-      $db->db_put( $abs_pos, $site_href );
+      my $abs_pos = $site->abs_pos;
+      if ($native) {
+        $db->add_site( $abs_pos, $tx, $site->site_type, $site->ref_base );
+      }
+      else {
+        $db->bulk_put( $abs_pos, $site->as_href );
+      }
       push @fl_sites, $abs_pos;
     }
 
@@ -372,12 +411,19 @@ sub build_gene_db_for_chr {
     say {$gan_fh} join "\n", @{ $self->_get_range_list( \@fl_sites ) } if @fl_sites;
 
     # get exon annotations
-    my @exon_sites = $gene->all_transcript_sites;
-    for my $site (@exon_sites) {
-      my $site_href = $site->as_href;
-      my $abs_pos   = $site_href->{abs_pos};
-      $db->db_put( $abs_pos, $site_href );
-      push @ex_sites, $abs_pos;
+    if ($native) {
+      $db->add_transcript_sites( $tx, $gene->transcript_abs_position,
+        $gene->transcript_annotation );
+      push @ex_sites, $gene->all_transcript_abs_position;
+    }
+    else {
+      my @exon_sites = $gene->all_transcript_sites;
+      for my $site (@exon_sites) {
+        my $site_href = $site->as_href;
+        my $abs_pos   = $site_href->{abs_pos};
+        $db->bulk_put( $abs_pos, $site_href );
+        push @ex_sites, $abs_pos;
+      }
     }
 
     # exonic annotations need to be written to both gan and exon files
@@ -385,6 +431,15 @@ sub build_gene_db_for_chr {
     say {$gan_fh} join "\n", @{ $self->_get_range_list( \@ex_sites ) };
   }
 
+  # write every site once, with all of its records
+  if ($native) {
+    $db->write($gdb_file);
+  }
+  else {
+    $db->bulk_finish;
+    $db->sync;
+  }
+
   # - add a final blank line to the region file; this is a bit of a hack so
   # the c hasher will not crash if there are no entries (after the initial
   # idx mask)
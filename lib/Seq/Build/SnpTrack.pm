@@ -24,6 +24,10 @@ our $VERSION = '0.001';
   write the data in the proper format from a sql server (e.g., UCSC's public
   mysql server).
 
+  When Seq::Native is available the records are written to a columnar snp
+  store (see c/src/seq_snpdb.h) instead of a kch file; Seq::Annotate prefers
+  the store when it finds one.
+
   @example  my $snp_db = Seq::Build::SnpTrack->new($record);
 
 Used in:
@@ -40,6 +44,7 @@ use File::Path qw/ make_path /;
 use File::Spec;
 use namespace::autoclean;
 
+use Seq::GenomeBin;
 use Seq::Site::Snp;
 
 extends 'Seq::Build::SparseTrack';
@@ -59,6 +64,8 @@ sub build_snp_db {
   # get the names of the output files
   my $snp_dat_file = $self->get_dat_file( $wanted_chr, $self->type );
   my $dbm_file = $self->get_kch_file($wanted_chr);
+  my $sdb_file = $self->get_sdb_file($wanted_chr);
+  my @store_features = ( $self->all_features, 'maf' );
 
   # check if we need to make the site range file
   #   skip build if site range file is present or we're forced to overwrite
@@ -119,15 +126,21 @@ sub build_snp_db {
         # write the site-range value for the genome encoder
         say {$snp_dat_fh} $self->in_snp_val;
 
-        # create dbm file
-        $self->_logger->info("dbm_file: $dbm_file");
-        $db = Seq::KCManager->new(
-          filename => $dbm_file,
-          mode     => 'create',
-          # chosed as ~ 50% of the largest number of SNPs on a chr (chr 2)
-          bnum => 3_000_000,
-          msiz => 512_000_000,
-        );
+        # create snp store or dbm file
+        if ( Seq::GenomeBin->native_available ) {
+          $self->_logger->info("sdb_file: $sdb_file");
+          $db = Seq::Native::SnpWriter->new( \@store_features );
+        }
+        else {
+          $self->_logger->info("dbm_file: $dbm_file");
+          $db = Seq::KCManager->new(
+            filename => $dbm_file,
+            mode     => 'create',
+            # chosed as ~ 50% of the largest number of SNPs on a chr (chr 2)
+            bnum => 3_000_000,
+            msiz => 512_000_000,
+          );
+        }
       }
 
       my ( $allele_freq_count, @alleles, @allele_freqs, $min_allele_freq );
@@ -172,9 +185,12 @@ sub build_snp_db {
 
         push @snp_sites, $abs_pos;
 
-        my $site_href = $snp_site->as_href;
-
-        $db->db_put( $abs_pos, $site_href );
+        if ( $db->isa('Seq::Native::SnpWriter') ) {
+          $db->add( $abs_pos, $snp_id, $base, [ @feature_hash{@store_features} ] );
+        }
+        else {
+          $db->bulk_put( $abs_pos, $snp_site->as_href );
+        }
         $self->inc_counter;
 
         if ( $self->counter > $self->bulk_insert_threshold ) {
@@ -187,6 +203,15 @@ sub build_snp_db {
     }
   }
 
+  # the store and the kch are both written in one go, each position once
+  if ( $db and $db->isa('Seq::Native::SnpWriter') ) {
+    $db->write($sdb_file);
+  }
+  elsif ($db) {
+    $db->bulk_finish;
+    $db->sync;
+  }
+
   # add a final blank line to the region file; this is a bit of a hack so the c
   # hasher will not crash if there are no entries (after the initial idx mask)
   say {$snp_dat_fh} '';
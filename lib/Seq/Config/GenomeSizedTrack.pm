@@ -119,7 +119,8 @@ enum GenomeSizedTrackType => [ 'genome', 'score', 'cadd', 'ngene' ];
 # encoded values since we can use a bit-wise OR opperator wihtout needing to
 # check the value is already set.
 
-my ( @idx_codes, @idx_base, @idx_in_gan, @idx_in_gene, @idx_in_exon, @idx_in_snp );
+my ( @idx_codes, @idx_base, @idx_in_gan, @idx_in_gene, @idx_in_exon, @idx_in_snp,
+  @idx_site );
 
 =variable {Hash} @private %base_char_2_txt
 
@@ -173,6 +174,13 @@ foreach my $base_char ( keys %base_char_2_txt ) {
           $idx_in_exon[$char_code] = ($exon) ? 1 : 0;
           $idx_in_snp[$char_code]  = ($snp)  ? 1 : 0;
 
+          # everything at once, for callers that want all of the features
+          $idx_site[$char_code] = [
+            $idx_base[$char_code],    $idx_in_gan[$char_code],
+            $idx_in_gene[$char_code], $idx_in_exon[$char_code],
+            $idx_in_snp[$char_code]
+          ];
+
           # @example:
           # 0 + 0 + 0 + 64 == 'N',no gan, not in a gene, not in an exon, is a snp
         }
@@ -404,6 +412,27 @@ sub get_idx_in_exon {
   return $idx_in_exon[$char];
 }
 
+=method @public get_idx_site
+
+  Takes an integer code representing the features at a genomic position and
+  returns all of them with one call, in place of calling get_idx_base,
+  get_idx_in_gan, get_idx_in_gene, get_idx_in_exon and get_idx_in_snp.
+
+  my ( $base, $gan, $gene, $exon, $snp ) = $self->get_idx_site($site_code);
+
+@param {Int} $char
+
+@returns {List} base, in_gan, in_gene, in_exon, in_snp; empty for codes
+  that are not valid
+
+=cut
+
+sub get_idx_site {
+  my ( $self, $char ) = @_;
+  return unless defined $idx_site[$char];
+  return @{ $idx_site[$char] };
+}
+
 =method @public get_idx_in_snp
 
   Takes an integer code representing the features at a genomic position.
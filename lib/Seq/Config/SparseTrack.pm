@@ -162,7 +162,7 @@ sub _get_file {
     }
   }
   elsif ( grep { /\A$chr\z/ } ( $self->all_genome_chrs ) ) {
-    if ( $self->type eq 'gene' and $ext ne 'kch' ) {
+    if ( $self->type eq 'gene' and defined $var ) {
       $file_name = join ".", $self->name, $self->type, $chr, $var, $ext;
     }
     else {
@@ -190,6 +190,26 @@ sub get_kch_file {
   return $self->_get_file( $chr, 'kch', $var );
 }
 
+# columnar snp store, see Seq::Native::SnpDb
+sub get_sdb_file {
+  my ( $self, $chr ) = @_;
+  return $self->_get_file( $chr, 'sdb', undef );
+}
+
+# gene site store, see Seq::Native::GeneDb
+sub get_gdb_file {
+  my ( $self, $chr ) = @_;
+  return $self->_get_file( $chr, 'gdb', undef );
+}
+
+# consequence track of a gene track, one file for each of the 3 alternate
+#   bases like the cadd track; see Seq::Native::GeneDb
+sub get_csq_file {
+  my ( $self, $num ) = @_;
+  my $file_name = join ".", $self->name, 'csq', 'idx', $num;
+  return $self->genome_index_dir->child($file_name)->absolute->stringify;
+}
+
 =method @public snp_fields_aref
 
   Returns array reference containing all (attribute_name => attribute_value}
@@ -42,6 +42,9 @@ use File::Spec;
 use namespace::autoclean;
 use Scalar::Util qw/ reftype /;
 
+# the XS runtime is optional; without it tracks are read into perl scalars
+my $have_native = eval { require Seq::Native; 1 };
+
 # enum BinType => [ 'C', 'n' ];
 extends 'Seq::Config::GenomeSizedTrack';
 with 'Seq::Role::IO', 'Seq::Role::Genome';
@@ -84,11 +87,37 @@ Used in:
 =cut
 
 has bin_seq => (
-  is       => 'ro',
-  isa      => 'ScalarRef',
-  required => 1,
+  is        => 'ro',
+  isa       => 'ScalarRef',
+  predicate => 'has_bin_seq',
 );
 
+=property @public {Seq::Native::Track} bin_track
+
+  The memory-mapped alternative to bin_seq; when present all accessors read
+  through it. One of bin_seq or bin_track is required.
+
+@see @method native_available
+
+=cut
+
+has bin_track => (
+  is        => 'ro',
+  isa       => 'Object',
+  predicate => 'has_bin_track',
+);
+
+=method @public {Bool} native_available
+
+  Class method; true when Seq::Native (c/perl) could be loaded, meaning
+  tracks can be mapped with Seq::Native::Track rather than read into memory.
+
+=cut
+
+sub native_available {
+  return $have_native;
+}
+
 # dropped defining the binary type and just have different methods
 #   that work for differently encoded strings
 #has bin => (
@@ -107,9 +136,22 @@ has genome_length => (
 
 sub _get_genome_length {
   my $self = shift;
+  return $self->bin_track->size if $self->has_bin_track;
   return length ${ $self->bin_seq };
 }
 
+sub BUILD {
+  my $self = shift;
+
+  if ( !( $self->has_bin_seq or $self->has_bin_track ) ) {
+    confess "Seq::GenomeBin requires either bin_seq or bin_track";
+  }
+
+  if ( $self->has_bin_track and ( $self->type eq 'score' or $self->type eq 'cadd' ) ) {
+    $self->bin_track->set_score( $self->score_min, $self->score_max, $self->score_R );
+  }
+}
+
 =method @public get_base
 
   Returns the genome index code for the absolute position of the genome supplied; 
@@ -129,6 +171,9 @@ sub _get_genome_length {
 
 sub get_base {
   my ( $self, $pos ) = @_;
+
+  return $self->bin_track->get_base($pos) if $self->has_bin_track;
+
   state $genome_length = $self->_get_genome_length;
 
   if ( $pos >= 0 and $pos < $genome_length ) {
@@ -159,6 +204,8 @@ sub get_base {
 sub get_nearest_gene {
   my ( $self, $pos ) = @_;
 
+  return $self->bin_track->get_nearest_gene($pos) if $self->has_bin_track;
+
   state $genome_length = $self->_get_genome_length;
 
   if ( $pos >= 0 and $pos < $genome_length ) {
@@ -182,6 +229,8 @@ sub get_score {
     unless $self->type eq 'score'
     or $self->type eq 'cadd';
 
+  return $self->bin_track->get_score($pos) if $self->has_bin_track;
+
   my $char            = $self->get_base($pos);
   my $score           = $self->get_score_lu($char);
   my $formatted_score = ( $score eq 'NA' ) ? $score : sprintf( "%0.3f", $score );
@@ -30,12 +30,22 @@ use Moose::Util::TypeConstraints;
 
 use Carp;
 use Cpanel::JSON::XS;
+use File::Basename qw/ dirname /;
+use File::Temp qw/ tempfile /;
 use KyotoCabinet;
 use Type::Params qw/ compile /;
 use Types::Standard qw/ :types /;
 
 enum db_type => [qw/ hash btree /];
 
+# the XS codec is optional; databases written with it need it to be read
+my $have_codec = eval { require Seq::Native; 1 };
+
+# reserved keys of a compact db: the codec schema (the key sets records are
+# written against, which also marks the db as compact) and its dictionary
+my $codec_key = '__seq_codec__';
+my $dict_key  = '__seq_dict__';
+
 with 'Seq::Role::IO';
 
 has filename => (
@@ -67,11 +77,59 @@ has msiz => (
   default => 1_280_000_000,
 );
 
+# memory, in bytes of encoded records, that bulk_put buffers before it sorts
+# the buffer and spills it to a run file next to the db
+has bulk_mem => (
+  is      => 'ro',
+  isa     => 'Int',
+  default => 256_000_000,
+);
+
+# compact: - at creation, store records with Seq::Native::Codec (interned
+#   strings and binary numbers) rather than JSON; readers find out from the db
+#   itself, so only builders set this
+has compact => (
+  is      => 'ro',
+  isa     => 'Bool',
+  default => 0,
+);
+
+has _codec => (
+  is        => 'rw',
+  isa       => 'Maybe[Object]',
+  predicate => '_has_codec',
+);
+
+has _bulk_buf => (
+  is      => 'ro',
+  isa     => 'ArrayRef[Str]',
+  default => sub { [] },
+);
+
+has _bulk_runs => (
+  is      => 'ro',
+  isa     => 'ArrayRef[Str]',
+  default => sub { [] },
+);
+
+has _bulk_bytes => (
+  is      => 'rw',
+  isa     => 'Int',
+  default => 0,
+);
+
+has _bulk_seq => (
+  is      => 'rw',
+  isa     => 'Int',
+  default => 0,
+);
+
 has _db => (
   is      => 'ro',
   isa     => 'Maybe[KyotoCabinet::DB]',
-  lazy    => 1,
-  builder => '_build_db',
+  lazy      => 1,
+  builder   => '_build_db',
+  predicate => '_has_db',
 );
 
 sub _build_db {
@@ -90,6 +148,10 @@ sub _build_db {
     my $db               = new KyotoCabinet::DB;
 
     if ( $db->open( $file_with_params, $db->OWRITER | $db->OCREATE ) ) {
+      if ( $self->compact or defined $db->get($codec_key) ) {
+        $self->_load_codec($db);
+        $db->set( $codec_key, $self->_codec->schema_dump );
+      }
       return $db;
     }
     else {
@@ -102,6 +164,7 @@ sub _build_db {
     my $db = new KyotoCabinet::DB;
 
     if ( $db->open( $file_with_params, $db->OREADER ) ) {
+      $self->_load_codec($db) if defined $db->get($codec_key);
       return $db;
     }
     else {
@@ -114,6 +177,61 @@ sub _build_db {
   }
 }
 
+# compact_available: - whether compact dbs can be written (and read) here
+sub compact_available {
+  return $have_codec;
+}
+
+sub _load_codec {
+  my ( $self, $db ) = @_;
+
+  croak "ERROR: " . $self->filename . " is a compact db and needs Seq::Native"
+    unless $have_codec;
+
+  my $codec  = Seq::Native::Codec->new;
+  my $schema = $db->get($codec_key);
+  my $dict   = $db->get($dict_key);
+  # '1' marked a compact db before records had shapes
+  $codec->schema_load($schema) if defined $schema and $schema ne '1';
+  $codec->dict_load($dict)     if defined $dict;
+  $self->_codec($codec);
+}
+
+# the schema and dictionary only grow, so records written earlier stay
+# readable; they are written by bulk_finish and sync (dict_dump marks the
+# codec clean, so it goes last)
+sub _save_codec {
+  my $self = shift;
+
+  my $codec = $self->_codec;
+  return 1 unless defined $codec and $codec->dirty;
+  return $self->_db->set( $codec_key, $codec->schema_dump )
+    && $self->_db->set( $dict_key, $codec->dict_dump );
+}
+
+# sync: - writes what a compact db's codec has learned and flushes the db;
+#   whoever writes with db_put calls it when done, as the builders do
+sub sync {
+  my $self = shift;
+
+  my $dbm = $self->_db;
+  croak "ERROR: cannot sync " . $self->filename unless defined $dbm;
+  $self->_save_codec or croak "ERROR: cannot write dictionary: " . $dbm->error;
+  return $dbm->synchronize(0);
+}
+
+sub _encode {
+  my ( $self, $aref ) = @_;
+  my $codec = $self->_codec;
+  return defined $codec ? $codec->encode($aref) : encode_json($aref);
+}
+
+sub _decode {
+  my ( $self, $val ) = @_;
+  my $codec = $self->_codec;
+  return defined $codec ? $codec->decode($val) : decode_json($val);
+}
+
 # db_put_string writes an entry for the key-value pair, which will overwrite
 #   existing data and write the string
 #   -> retrieve this data using db_get_string
@@ -154,10 +272,123 @@ sub db_put {
   if ( defined $existing_aref ) {
     my @data = @$existing_aref;
     push @data, $href;
-    return $self->_db->set( $key, encode_json( \@data ) );
+    return $self->_db->set( $key, $self->_encode( \@data ) );
+  }
+  else {
+    return $self->_db->set( $key, $self->_encode( [$href] ) );
+  }
+}
+
+# bulk_put is the write-once alternative to db_put for building a db: records
+#   are encoded once and buffered as "key\tseq\tjson" lines; once bulk_mem is
+#   reached the buffer is sorted and spilled to a run file. bulk_finish merges
+#   the runs, so all records of a key arrive together and in the order they
+#   were put, and writes each key once. Nothing is in the db until bulk_finish.
+sub bulk_put {
+  my ( $self, $key, $href ) = @_;
+
+  my $seq = $self->_bulk_seq;
+  $self->_bulk_seq( $seq + 1 );
+
+  # the zero-padded sequence keeps records of a key in order through the sort
+  my $line = join "\t", $key, sprintf( "%012d", $seq ), encode_json($href);
+  push @{ $self->_bulk_buf }, $line;
+  $self->_bulk_bytes( $self->_bulk_bytes + length $line );
+
+  $self->_spill_bulk_run if $self->_bulk_bytes > $self->bulk_mem;
+  return 1;
+}
+
+sub _spill_bulk_run {
+  my $self = shift;
+
+  my ( $fh, $run_file ) =
+    tempfile( 'kch_bulk_XXXXXX', DIR => dirname( $self->filename ), UNLINK => 0 );
+  say {$fh} $_ for sort @{ $self->_bulk_buf };
+  close $fh or croak "ERROR: cannot write bulk run file $run_file: $!";
+
+  push @{ $self->_bulk_runs }, $run_file;
+  @{ $self->_bulk_buf } = ();
+  $self->_bulk_bytes(0);
+}
+
+sub bulk_finish {
+  my $self = shift;
+
+  my $dbm = $self->_db;
+  croak "ERROR: cannot bulk load " . $self->filename unless defined $dbm;
+
+  # one source per run file plus the sorted buffer
+  my @sources;
+  for my $run_file ( @{ $self->_bulk_runs } ) {
+    open my $fh, '<', $run_file or croak "ERROR: cannot read bulk run file $run_file: $!";
+    push @sources, sub { my $line = <$fh>; chomp $line if defined $line; return $line };
+  }
+  my @buf = sort @{ $self->_bulk_buf };
+  @{ $self->_bulk_buf } = ();
+  my $i = 0;
+  push @sources, sub { return $i < @buf ? $buf[ $i++ ] : undef };
+
+  my @heads = map { $_->() } @sources;
+  my ( $this_key, @records );
+  my $n_keys = 0;
+
+  my $write = sub {
+
+    # keep whatever db_put already wrote at the key
+    my $existing = $dbm->get($this_key);
+    my @data = defined $existing ? @{ $self->_decode($existing) } : ();
+    push @data, map { decode_json($_) } @records;
+    $dbm->set( $this_key, $self->_encode( \@data ) )
+      or croak "ERROR: cannot write key $this_key: " . $dbm->error;
+    $n_keys++;
+  };
+
+  while (1) {
+
+    # k-way merge; there are few enough runs for a linear scan
+    my $min;
+    for my $j ( 0 .. $#heads ) {
+      next unless defined $heads[$j];
+      $min = $j if !defined $min or $heads[$j] lt $heads[$min];
+    }
+    last unless defined $min;
+
+    my ( $key, undef, $json ) = split /\t/, $heads[$min], 3;
+    $heads[$min] = $sources[$min]->();
+
+    if ( defined $this_key and $key ne $this_key ) {
+      $write->();
+      @records = ();
+    }
+    $this_key = $key;
+    push @records, $json;
+  }
+  $write->() if @records;
+
+  unlink @{ $self->_bulk_runs };
+  @{ $self->_bulk_runs } = ();
+  $self->_bulk_bytes(0);
+  $self->_save_codec or croak "ERROR: cannot write dictionary: " . $dbm->error;
+  return $n_keys;
+}
+
+# only a safety net: in global destruction the db handle may already be gone,
+# so bulk_finish or sync are what write the codec
+sub DEMOLISH {
+  my ( $self, $in_global_destruction ) = @_;
+  if ( @{ $self->_bulk_buf } or @{ $self->_bulk_runs } ) {
+    carp "WARNING: bulk_put records for " . $self->filename . " were never written";
+    unlink @{ $self->_bulk_runs };
+  }
+  my $codec = $self->_has_codec ? $self->_codec : undef;
+  return unless defined $codec and $codec->dirty;
+  if ( $in_global_destruction or !defined $self->_db ) {
+    carp "WARNING: dictionary of " . $self->filename . " was never written; call sync";
   }
   else {
-    return $self->_db->set( $key, encode_json( [$href] ) );
+    carp "WARNING: dictionary of " . $self->filename . " written on destruction; call sync";
+    $self->_save_codec or carp "WARNING: cannot write dictionary for " . $self->filename;
   }
 }
 
@@ -180,9 +411,9 @@ sub db_bulk_get {
     # does the value exist within the dbm?
     if ( defined $val ) {
       if ($reverse) {
-        return map { decode_json( $val->{$_} ) } sort { $b <=> $a } keys(%$val);
+        return map { $self->_decode( $val->{$_} ) } sort { $b <=> $a } keys(%$val);
       }
-      return map { decode_json( $val->{$_} ) } sort { $a <=> $b } keys(%$val);
+      return map { $self->_decode( $val->{$_} ) } sort { $a <=> $b } keys(%$val);
     }
     else {
       return;
@@ -209,7 +440,7 @@ sub db_get {
 
     # does the value exist within the dbm?
     if ( defined $val ) {
-      return decode_json $val;
+      return $self->_decode($val);
     }
     else {
       return;
@@ -14,8 +14,12 @@ use Moose::Util::TypeConstraints;
 use File::Which qw(which);
 use File::Basename;
 use List::MoreUtils qw(firstidx);
+use Symbol qw/ gensym /;
 use namespace::autoclean;
 use DDP;
+
+use Seq::GenomeBin;
+
 requires 'output_path';
 requires 'out_file';
 requires 'debug';
@@ -39,6 +43,14 @@ has file_type => (
   writer   => 'setFileType',
 );
 
+# with Seq::Native, a .gz output is BGZF with a tabix index (output_path.tbi)
+#   made as it is written, when its rows come sorted
+has index_output => (
+  is      => 'ro',
+  isa     => 'Bool',
+  default => 1,
+);
+
 # @pseudo-protected; using _header to designate that only the methods are public
 # stores everything after the minimum required; this comes from Seq::Annotate.pm
 # add_header_attr called in Seq.pm
@@ -90,6 +102,21 @@ has _out_fh => (
   builder  => '_build_out_fh',
 );
 
+# with Seq::Native, rows are formatted in C by a plan of the header made on
+#   the first print (see Seq::Native::Formatter)
+has _formatter => (
+  is       => 'ro',
+  lazy     => 1,
+  init_arg => undef,
+  builder  => '_build_formatter',
+);
+
+sub _build_formatter {
+  my $self = shift;
+  return unless Seq::GenomeBin->native_available;
+  return Seq::Native::Formatter->new( [ $self->all_header_attr ] );
+}
+
 # the minimum required snp headers that we actually have
 has _snpHeader => (
   traits  => ['Array'],
@@ -125,9 +152,11 @@ sub _build_headers {
 # _print_annotations takes an array reference of annotations and hash
 # reference of header attributes and writes the header (if needed) to the
 # output file and flattens the hash references for each entry and writes
-# them to the output file
+# them to the output file, or to $fh when given (as the workers of a parallel
+# annotation do, each into a buffer of its own)
 sub print_annotations {
-  my ( $self, $annotations_aref ) = @_;
+  my ( $self, $annotations_aref, $fh ) = @_;
+  $fh //= $self->_out_fh;
 
   # print header
   if ( !$self->_flagHeaderPrinted ) {
@@ -135,6 +164,18 @@ sub print_annotations {
     return;
   }
 
+  # straight into the batch the native writer is filling, when that is $fh
+  if ( my $formatter = $self->_formatter ) {
+    my $writer = tied *$fh;
+    if ( $writer && $writer->isa('Seq::Native::Writer') ) {
+      $formatter->write( $annotations_aref, $writer );
+    }
+    else {
+      print {$fh} $formatter->format($annotations_aref);
+    }
+    return;
+  }
+
   # cache header attributes
   my @header = $self->all_header_attr;
 
@@ -149,7 +190,7 @@ sub print_annotations {
         push @prt_record, 'NA';
       }
     }
-    say { $self->_out_fh } join "\t", @prt_record;
+    say {$fh} join "\t", @prt_record;
   }
 }
 
@@ -163,6 +204,11 @@ sub compress_output {
     return;
   }
 
+  # the tarball holds the whole output directory (the output, its statistics
+  #   and logs). A .gz output the native writer made is BGZF with its .tbi
+  #   beside it; both go in byte for byte, and so come out of the tarball
+  #   still indexed.
+
   # my($filename, $dirs) = fileparse($self->output_path);
 
   my $tar = which('tar') or $self->tee_logger( 'error', 'No tar program found' );
@@ -173,17 +219,18 @@ sub compress_output {
   my $baseFileName   = $self->out_file->basename;
   my $compressName   = $baseFileName . $self->_compressExtension;
 
+  # tar's --transform and --exclude only apply to the names after them
   my $outcome = system(
     sprintf(
-      "$tar -cf %s -C %s %s --transform=s/%s/%s/ --exclude '.*' --exclude %s; mv %s %s",
+      "$tar -cf %s --transform=s/%s/%s/ --exclude '.*' --exclude %s -C %s %s; mv %s %s",
       $compressName,
-      $self->out_file->parent(2)
-        ->stringify, #change to parent of folder containing output files
-      $baseFolderName, #the name of the directory we want to compress
       #transform and exclude
       $baseFolderName, #inside the tarball, transform  that directory name
       $baseFileName,   #to one named as our file basename
       $compressName,   #and don't include our new compressed file in our tarball
+      $self->out_file->parent(2)
+        ->stringify, #change to parent of folder containing output files
+      $baseFolderName, #the name of the directory we want to compress
       #move our file into the original output directory
       $compressName,
       $self->out_file->parent->stringify,
@@ -292,6 +339,14 @@ sub _build_out_fh {
     return \*STDOUT;
   }
 
+  # with Seq::Native, compressing (for .gz) and writing run on threads of their
+  #   own, fed through a tied handle (see Seq::Native::Writer)
+  if ( Seq::GenomeBin->native_available ) {
+    my $fh = gensym;
+    tie *$fh, 'Seq::Native::Writer', $self->output_path, 0, $self->index_output;
+    return $fh;
+  }
+
   # can't use is_file or is_dir check before file made, unless it alraedy exists
   return $self->get_write_bin_fh( $self->output_path );
 }
@@ -33,6 +33,10 @@ has alleles => (
 sub findGeneData {
   my ( $self, $abs_pos, $db ) = @_;
 
+  #a Seq::Native::GeneDb answers the whole range in one query, in place of a
+  #lookup per base; see _findGeneDataNative
+  return $self->_findGeneDataNative( $abs_pos, $db ) if $db->can('indel_sites');
+
   my @data;
   my @range; #can't pass list to db_get
   my $annotationType;
@@ -79,6 +83,33 @@ sub findGeneData {
   }
 }
 
+#the same, with the sugar, the coding flag and the reference bases under each
+#range worked out by the gene site store; it skips ranges no transcript
+#overlaps using its interval index, so the cost no longer grows with the
+#length of the deletion
+sub _findGeneDataNative {
+  my ( $self, $abs_pos, $db ) = @_;
+
+  for my $allele ( $self->allAlleles ) {
+    if ( $allele->indType eq '-' ) {
+      my ( $sugar, $hasCoding, $refBases ) =
+        $db->indel_sites( $abs_pos - $allele->indLength + 1, $abs_pos, 1 );
+
+      next unless defined $sugar;
+
+      $self->_setAnnotationType( $allele, $sugar, $hasCoding );
+      $allele->renameMinorAllele($refBases) if $refBases;
+    }
+    else {
+      my ( $sugar, $hasCoding ) = $db->indel_sites( $abs_pos, $abs_pos + 1, 0 );
+
+      next unless defined $sugar;
+
+      $self->_setAnnotationType( $allele, $sugar, $hasCoding );
+    }
+  }
+}
+
 state $delim = '|';      #can't be ; or will get split, unless we prepend Type-Frame-
 #Thomas, I noticed that we can potentially have many interesting variants
 #Say indels that hit start and stop, so I want to grab them all, in order
@@ -95,7 +126,6 @@ sub _annotateSugar {
   my $sugar;
   my $siteType  = '';
   my $hasCoding = 0;
-  my $frame     = '';
   # getSiteType defined in Seq::Site::Gene::Definitions Role
   # used to determine whether to call something FrameShift, InFrame, or no frame type
   state $codingName = $self->getSiteType(0); #for API: Coding type always first
@@ -148,6 +178,13 @@ sub _annotateSugar {
   }
 
   chop $sugar;
+  $self->_setAnnotationType( $allele, $sugar, $hasCoding );
+}
+
+sub _setAnnotationType {
+  my ( $self, $allele, $sugar, $hasCoding ) = @_;
+
+  my $frame = '';
   #frameshift only matters for coding regions; lookup in order of frequency
   $frame = $allele->frameType if $hasCoding;
 
@@ -72,6 +72,7 @@ sub summarize {
   my $self = shift;
   my ( $percentilesHref, $destHref );
 
+  $self->_flushCounts;
   $self->makeRatios;
 
   if ( $self->debug ) {
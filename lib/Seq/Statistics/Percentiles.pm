@@ -15,6 +15,8 @@ use Carp qw/cluck confess/;
 use POSIX; #ceil, floor
 use DDP;
 
+use Seq::GenomeBin;
+
 has percentilesKey => (
   is      => 'ro',
   isa     => 'Str',
@@ -171,6 +173,12 @@ sub BUILD {
     p $self->preScreened;
   }
 
+  # qc takes its bounds from the first and third thresholds
+  if ( Seq::GenomeBin->native_available && @{ $self->percentileThresholds } >= 3 ) {
+    $self->selectPercentiles;
+    return;
+  }
+
   $self->sortRatios; #asc order
 
   if ( $self->debug ) {
@@ -192,6 +200,22 @@ sub makePercentiles {
   }
 }
 
+# selectPercentiles is makePercentiles without the sort: Seq::Native::Quantiles
+# selects just the ranks the thresholds fall between, and screens the ratios
+# against the 5th and 95th (see c/src/seq_quantile.h) for qc
+sub selectPercentiles {
+  my $self = shift;
+
+  my ( $values, $outside ) =
+    Seq::Native::Quantiles::screen( $self->ratios, $self->percentileThresholds, 0, 2 );
+
+  my $thIdx = 0;
+  for my $val (@$values) {
+    push @{ $self->percentiles }, [ $self->getThresholdName( $thIdx++ ), $val ];
+  }
+  $self->outsideIDs($outside);
+}
+
 sub storeAndQc {
   my $self = shift;
 
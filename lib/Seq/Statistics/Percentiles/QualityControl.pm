@@ -39,6 +39,14 @@ has preScreened => (
   default => sub { [] }
 );
 
+# the ids of ratios outside the percentiles, when they were found in
+# selecting them (Seq::Statistics::Percentiles::selectPercentiles)
+has outsideIDs => (
+  is        => 'rw',
+  isa       => 'ArrayRef[Str|Num]',
+  predicate => 'hasOutsideIDs',
+);
+
 #could also do this by checking index in ratios array
 #but wouldn't work for interpolated values
 sub qc {
@@ -48,6 +56,24 @@ sub qc {
   my $mesage    = $self->failMessage;
   my $ratioName = $self->ratioName;
 
+  if ( $self->hasOutsideIDs ) {
+    for my $id ( @{ $self->outsideIDs } ) {
+      push @{ $self->target->{$failKey}{$id} }, "$ratioName $mesage";
+    }
+  }
+  else {
+    $self->_screen( $failKey, "$ratioName $mesage" );
+  }
+
+  if ( !$self->blacklistedIDs ) { return; }
+  for my $id ( $self->blacklistedIDs ) {
+    push @{ $self->target->{$failKey}{$id} }, "$ratioName $mesage";
+  }
+}
+
+sub _screen {
+  my ( $self, $failKey, $message ) = @_;
+
   my $lower = $self->getPercVal(0);
   my $upper = $self->getPercVal(2);
 
@@ -56,14 +82,9 @@ sub qc {
     $id  = $ratio->[0];
     $val = $ratio->[1];
     if ( $val < $lower || $val > $upper ) {
-      push @{ $self->target->{$failKey}{$id} }, "$ratioName $mesage";
+      push @{ $self->target->{$failKey}{$id} }, $message;
     }
   }
-
-  if ( !$self->blacklistedIDs ) { return; }
-  for my $id ( $self->blacklistedIDs ) {
-    push @{ $self->target->{$failKey}{$id} }, "$ratioName $mesage";
-  }
 }
 
 no Moose::Role;
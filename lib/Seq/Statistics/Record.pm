@@ -19,6 +19,8 @@ use syntax 'junction';
 
 use DDP;
 
+use Seq::GenomeBin;
+
 #provides deconvoluteGeno, hasGeno, isHomo, isHet
 with 'Seq::Role::Genotypes', 'Seq::Role::Message';
 
@@ -92,6 +94,39 @@ has _snpAnnotationsAref => (
   init_arg => undef,
 );
 
+# with Seq::Native, record counts into a dense table of samples by places in
+# the record (Seq::Native::Stats) instead of walking the nested hashes for each
+# sample; the table is added into statsRecord when that is next read
+has _counts => (
+  is       => 'ro',
+  lazy     => 1,
+  init_arg => undef,
+  builder  => '_buildCounts',
+);
+
+sub _buildCounts {
+  return Seq::GenomeBin->native_available ? Seq::Native::Stats->new : undef;
+}
+
+# the table's cell of each path of features joined by tabs, e.g. "SNP\tExonic"
+has _cells => (
+  is       => 'ro',
+  isa      => 'HashRef',
+  init_arg => undef,
+  default  => sub { {} },
+);
+
+has _countsPending => (
+  is       => 'rw',
+  isa      => 'Bool',
+  init_arg => undef,
+  default  => 0,
+);
+
+before statsRecord => sub {
+  $_[0]->_flushCounts;
+};
+
 # at every level in the has, record whether transition or transversion
 # assumes that only non-reference alleles are passed, hence it is a role
 sub record {
@@ -100,6 +135,12 @@ sub record {
   #by order of complexity of left operand
   return unless defined $refAllele && @$featuresAref && @$geneDataAref;
 
+  if ( my $counts = $self->_counts ) {
+    return unless %$idGenoHref;
+    return $self->_recordCounts( $counts, $idGenoHref, $featuresAref, $refAllele,
+      $geneDataAref, $snpDataAref );
+  }
+
   my @genoKeys = keys %$idGenoHref; #sampleIDs
   return unless @genoKeys;
 
@@ -178,6 +219,67 @@ sub storeCount {
   goto &storeCount; #tail call opt
 }
 
+# _recordCounts is record over the table: the places the site counts in are
+# worked out once, and each sample's call is counted in C
+sub _recordCounts {
+  my ( $self, $counts, $idGenoHref, $featuresAref, $refAllele, $geneDataAref,
+    $snpDataAref )
+    = @_;
+
+  my $cells = $self->_cells;
+  my $cell = sub { $cells->{ $_[0] } //= $counts->cell( $_[0] ) };
+
+  # the same levels storeCount walks, down to the first bad feature
+  my ( @featureCells, $path );
+  if ( @$geneDataAref == 1 ) {
+    for my $feature ( @$featuresAref, $geneDataAref->[0]->annotation_type ) {
+      last if $self->isBadFeature($feature);
+      $path = defined $path ? "$path\t$feature" : $feature;
+      push @featureCells, $cell->($path);
+    }
+  }
+
+  $counts->record(
+    $idGenoHref,
+    $refAllele,
+    $cell->( $self->trTvKey(0) ),
+    $cell->( $self->trTvKey(1) ),
+    defined $snpDataAref ? $cell->( $self->snpKey( int( !!@$snpDataAref ) ) ) : -1,
+    @featureCells ? \@featureCells : undef
+  );
+  $self->_countsPending(1);
+}
+
+# _flushCounts adds the table into statsRecord and empties it
+sub _flushCounts {
+  my $self = shift;
+  return unless $self->_countsPending;
+
+  # statsRecord, read by mergeRecord, comes back here
+  $self->_countsPending(0);
+  $self->mergeRecord( $self->_counts->export( $self->statsKey, $self->countKey ) );
+  $self->_counts->reset;
+}
+
+# statsPartial is the table as bytes (Seq::Native::Stats::dump) that
+# mergePartial, in another process or on another node, adds into its own;
+# partials merge in any order into what one process would have counted. It
+# holds what was counted since statsRecord was last read, which is all of it
+# until summarize. Nothing without Seq::Native.
+sub statsPartial {
+  my $self = shift;
+  my $counts = $self->_counts or return;
+  return $counts->dump;
+}
+
+sub mergePartial {
+  my ( $self, $bytes ) = @_;
+  my $counts = $self->_counts
+    or $self->tee_logger( 'error', 'Merging counts needs Seq::Native' );
+  $counts->merge( Seq::Native::Stats->load($bytes) );
+  $self->_countsPending(1);
+}
+
 # transitions are dependent only on the reference base and sample allele,
 # they are, unlike geneDataAref features, a StatsCalculator created feature
 # they should only be inserted in a single locaiton, else they'll be counted
@@ -211,6 +313,22 @@ sub countCustomFeatures {
   $targetHref->{$snpKey}{ $self->statsKey }{ $self->countKey } += 1;
 }
 
+# adds the counts of another record into this one, e.g., those a worker of a
+# parallel annotation kept; records are nested hashes with counts at the leaves
+sub mergeRecord {
+  my ( $self, $fromHref, $targetHref ) = @_;
+  $targetHref //= $self->statsRecord;
+
+  for my $key ( keys %$fromHref ) {
+    if ( ref $fromHref->{$key} ) {
+      $self->mergeRecord( $fromHref->{$key}, \%{ $targetHref->{$key} } );
+    }
+    else {
+      $targetHref->{$key} += $fromHref->{$key};
+    }
+  }
+}
+
 # if it's a het; currently supports only diploid organisms
 # 2nd if isn't strictly necessary, but safer, and allows this to be used
 # as an alternative to isHet, isHomo
@@ -13,6 +13,7 @@ with 'Seq::Role::IO';
 
 requires 'statsRecord';
 requires 'hasStats';
+requires 'statsPartial';
 
 use namespace::autoclean;
 
@@ -22,6 +23,12 @@ has statsExtension => (
   default => 'json'
 );
 
+has countsExtension => (
+  is      => 'rw',
+  lazy    => 1,
+  default => 'counts'
+);
+
 has statsFH => (
   is       => 'ro',
   lazy     => 1,
@@ -40,6 +47,22 @@ sub storeStats {
   }
 }
 
+# storeCounts writes the counts, before summarize, as a partial that those of
+# other jobs over the same samples' other sites merge with (see
+# bin/merge_stats.pl)
+sub storeCounts {
+  my ( $self, $outBasePath ) = @_;
+  my $partial = $self->statsPartial;
+  if ( !defined $partial ) {
+    $self->tee_logger( 'warn', 'Counts can only be stored with Seq::Native' );
+    return;
+  }
+  my $fh = $self->_buildFh( $outBasePath . '.' . $self->countsExtension );
+  binmode $fh;
+  print $fh $partial;
+  close $fh;
+}
+
 sub _buildFh {
   my ( $self, $outPath ) = @_;
 
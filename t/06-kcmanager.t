@@ -5,11 +5,12 @@ use warnings;
 
 use Data::Dump qw/ dump /;
 use Lingua::EN::Inflect qw/ A PL_N /;
+use File::Temp qw/ tempdir /;
 use Path::Tiny;
 use Test::More;
 use YAML qw/ LoadFile /;
 
-plan tests => 30;
+plan tests => 40;
 
 my %attr_2_type = (
   filename => 'Str',
@@ -62,6 +63,66 @@ ok( $obj, 'object creation' );
 
 # Methods tests
 
+# bulk loading; a small bulk_mem forces several run files to be merged
+{
+  my $dir = tempdir( CLEANUP => 1 );
+  my $file = path($dir)->child('bulk.kch')->stringify;
+  my $db = $package->new( filename => $file, mode => 'create', bulk_mem => 1_000 );
+
+  $db->db_put( 3, { pre => 'existing' } );
+  # whatever JSON is at a key is merged with, not appended to as text
+  $db->db_put_string( 4, '[]' );
+  $db->db_put_string( 6, qq{[ {"pre":"spaced"} ]\n} );
+  my %expect = ( 3 => [ { pre => 'existing' } ], 6 => [ { pre => 'spaced' } ] );
+  for my $i ( 1 .. 500 ) {
+    my $key = $i % 13;
+    my $href = { abs_pos => $key, i => $i };
+    $db->bulk_put( $key, $href );
+    push @{ $expect{$key} }, $href;
+  }
+  ok( !defined $db->db_get(5), 'bulk_put defers writes to bulk_finish' );
+  is( $db->bulk_finish, 13, 'bulk_finish writes each key once' );
+  is_deeply( $db->db_get(5), $expect{5}, 'records of a key keep their order' );
+  is_deeply( $db->db_get(3), $expect{3}, 'bulk_finish appends to existing records' );
+  is_deeply( $db->db_get(4), $expect{4}, 'to an empty list' );
+  is_deeply( $db->db_get(6), $expect{6}, 'and to JSON with space around it' );
+}
+
+# compact dbs; readers pick the codec up from the db
+SKIP: {
+  skip 'Seq::Native is not built', 4 unless $package->compact_available;
+
+  my $dir = tempdir( CLEANUP => 1 );
+  my $file = path($dir)->child('compact.kch')->stringify;
+  my %expect;
+  {
+    my $db = $package->new( filename => $file, mode => 'create', compact => 1 );
+    for my $i ( 1 .. 50 ) {
+      my $href = {
+        abs_pos       => $i,
+        transcript_id => 'NM_' . ( $i % 3 ),
+        codon_number  => $i,
+        alt_names     => { geneSymbol => 'GENE' . ( $i % 3 ) },
+        error_code    => [],
+      };
+      $db->bulk_put( $i % 7, $href );
+      push @{ $expect{ $i % 7 } }, $href;
+    }
+    $db->bulk_finish;
+    $db->db_put( 0, { late => 'NEW_STRING', shape => 'new' } );
+    push @{ $expect{0} }, { late => 'NEW_STRING', shape => 'new' };
+    $db->sync;
+  }
+
+  my $db = $package->new( filename => $file, mode => 'read' );
+  is_deeply( $db->db_get(1), $expect{1}, 'compact db_get' );
+  is_deeply( [ $db->db_bulk_get( [ 1, 2, 3 ] ) ],
+    [ @expect{ 1, 2, 3 } ], 'compact db_bulk_get' );
+  is_deeply( [ $db->db_bulk_get( [ 1, 2, 3 ], 1 ) ],
+    [ @expect{ 3, 2, 1 } ], 'compact db_bulk_get in reverse' );
+  is_deeply( $db->db_get(0), $expect{0}, 'strings and shapes added after bulk_finish are saved by sync' );
+}
+
 ###############################################################################
 # sub routines
 ###############################################################################
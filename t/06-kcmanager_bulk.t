@@ -0,0 +1,142 @@
+#!perl -T
+use 5.10.0;
+use strict;
+use warnings;
+
+use File::Spec;
+use File::Temp qw/ tempdir /;
+use Test::More;
+
+# bulk_put and bulk_finish against an in-memory stand-in for KyotoCabinet, so
+#   the merge with what is already in a db is tested where KyotoCabinet is not
+#   installed; t/06-kcmanager.t runs the same cases against the real thing
+
+BEGIN {
+  $INC{'KyotoCabinet.pm'} = __FILE__;
+
+  package KyotoCabinet::DB;
+
+  # the dbs, by file name, so a db opened again finds what was written
+  my %files;
+
+  sub OREADER { 1 }
+  sub OWRITER { 2 }
+  sub OCREATE { 4 }
+
+  sub new { return bless { data => undef }, shift }
+
+  sub open {
+    my ( $self, $path, $mode ) = @_;
+    my ($file) = split /#/, $path;
+    return 0 unless exists $files{$file} or $mode & OCREATE();
+    $self->{data} = $files{$file} //= {};
+    return 1;
+  }
+
+  sub get { my ( $self, $key ) = @_; return $self->{data}{$key} }
+
+  sub set {
+    my ( $self, $key, $val ) = @_;
+    $self->{data}{$key} = "$val";
+    return 1;
+  }
+
+  sub get_bulk {
+    my ( $self, $keys ) = @_;
+    my %found = map { $_ => $self->{data}{$_} } grep { exists $self->{data}{$_} } @$keys;
+    return \%found;
+  }
+
+  sub synchronize { return 1 }
+  sub error       { return 'no error' }
+}
+
+plan tests => 14;
+
+my $package = "Seq::KCManager";
+use_ok($package) || die "$package cannot be loaded";
+
+# a small bulk_mem forces several run files to be merged
+{
+  my $dir = tempdir( CLEANUP => 1 );
+  my $file = File::Spec->catfile( $dir, 'bulk.kch' );
+  my $db = $package->new( filename => $file, mode => 'create', bulk_mem => 1_000 );
+
+  $db->db_put( 3, { pre => 'existing' } );
+  # whatever JSON is at a key is merged with, not appended to as text
+  $db->db_put_string( 4, '[]' );
+  $db->db_put_string( 6, qq{[ {"pre":"spaced"} ]\n} );
+  my %expect = ( 3 => [ { pre => 'existing' } ], 6 => [ { pre => 'spaced' } ] );
+  for my $i ( 1 .. 500 ) {
+    my $key = $i % 13;
+    my $href = { abs_pos => $key, i => $i };
+    $db->bulk_put( $key, $href );
+    push @{ $expect{$key} }, $href;
+  }
+  ok( !defined $db->db_get(5), 'bulk_put defers writes to bulk_finish' );
+  is( $db->bulk_finish, 13, 'bulk_finish writes each key once' );
+  is_deeply( [ glob File::Spec->catfile( $dir, 'kch_bulk_*' ) ], [], 'and removes its run files' );
+  is_deeply( $db->db_get(5), $expect{5}, 'records of a key keep their order' );
+  is_deeply( $db->db_get(3), $expect{3}, 'bulk_finish appends to existing records' );
+  is_deeply( $db->db_get(4), $expect{4}, 'to an empty list' );
+  is_deeply( $db->db_get(6), $expect{6}, 'and to JSON with space around it' );
+
+  # a second load merges with the first
+  $db->bulk_put( 5, { again => 1 } );
+  $db->bulk_finish;
+  is_deeply( $db->db_get(5), [ @{ $expect{5} }, { again => 1 } ],
+    'a second bulk_finish appends to the first' );
+}
+
+# a compact db, merged with what db_put wrote and read back by a new reader
+SKIP: {
+  skip 'Seq::Native is not built', 5 unless $package->compact_available;
+
+  my $dir = tempdir( CLEANUP => 1 );
+  my $file = File::Spec->catfile( $dir, 'compact.kch' );
+  my %expect;
+  {
+    my $db = $package->new( filename => $file, mode => 'create', compact => 1, bulk_mem => 500 );
+    $db->db_put( 2, { pre => 'existing', codon_number => 0 } );
+    push @{ $expect{2} }, { pre => 'existing', codon_number => 0 };
+    for my $i ( 1 .. 50 ) {
+      my $href = {
+        abs_pos       => $i,
+        transcript_id => 'NM_' . ( $i % 3 ),
+        codon_number  => $i,
+        alt_names     => { geneSymbol => 'GENE' . ( $i % 3 ) },
+        error_code    => [],
+      };
+      $db->bulk_put( $i % 7, $href );
+      push @{ $expect{ $i % 7 } }, $href;
+    }
+    $db->bulk_finish;
+  }
+
+  my $db = $package->new( filename => $file, mode => 'read' );
+  is_deeply( $db->db_get(2), $expect{2}, 'compact bulk_finish appends to existing records' );
+  is_deeply( $db->db_get(1), $expect{1}, 'and keeps the order of the rest' );
+  is_deeply( [ $db->db_bulk_get( [ 0 .. 6 ] ) ], [ @expect{ 0 .. 6 } ], 'every key' );
+
+  # records whose keys are not those of the first record written, with undef
+  #   and missing fields, read back through the schema kept in the db
+  my $shapesFile = File::Spec->catfile( $dir, 'shapes.kch' );
+  my @shapes = (
+    { abs_pos => 1, snp_id => 'rs1', snp_feature => { maf => '0.1' } },
+    { abs_pos => 2 },
+    { abs_pos => 3, snp_id => undef, snp_feature => { maf => undef, alleles => 'A/G' } },
+    { snp_id => 'rs4', extra => [ 1, 'two' ] },
+  );
+  {
+    my $writer = $package->new( filename => $shapesFile, mode => 'create', compact => 1 );
+    $writer->db_put( 1, $_ ) for @shapes[ 0, 1 ];
+    $writer->bulk_put( 1, $_ ) for @shapes[ 2, 3 ];
+    $writer->bulk_finish;
+    $writer->db_put( 2, { late => 'NEW_STRING', abs_pos => undef } );
+    $writer->sync;
+  }
+  my $reader = $package->new( filename => $shapesFile, mode => 'read' );
+  is_deeply( $reader->db_get(1), \@shapes, 'compact records of different shapes round trip' );
+  is_deeply( $reader->db_get(2), [ { late => 'NEW_STRING', abs_pos => undef } ],
+    'including one whose shape comes after bulk_finish' );
+}
@@ -0,0 +1,101 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use Cpanel::JSON::XS;
+use Path::Tiny;
+use Test::More;
+use YAML qw/ LoadFile /;
+
+# genome_annotate (c/bin) against Seq::Annotate: the same snpfile (of four
+#   samples) annotated in perl, by genome_annotate alone and by genome_annotate
+#   with the gene and snp records, carriers and statistics added in perl,
+#   compared column by column and by the statistics each wrote
+
+my $ga_config   = path('./t/hg38_test.yml')->absolute->stringify;
+my $config_href = LoadFile($ga_config);
+my $engine      = path('./c/bin/genome_annotate')->absolute;
+
+my ($genome) = grep { $_->{type} eq 'genome' } @{ $config_href->{genome_sized_tracks} };
+my $genome_idx =
+  path( $config_href->{genome_index_dir} )->child( join '.', $genome->{name}, 'genome', 'idx' );
+plan skip_all => 'needs the test assembly built and c/bin/genome_annotate'
+  unless -f $genome_idx && -x $engine;
+
+my $package = 'Seq';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir     = Path::Tiny->tempdir;
+my $snpfile = path('./t/snp_test.snp')->absolute->stringify;
+
+# the header and rows of an annotation
+sub read_rows {
+  my @lines = path(shift)->lines( { chomp => 1 } );
+  my @header = split /\t/, shift @lines;
+  return ( \@header, [ map { [ split /\t/, $_, -1 ] } @lines ] );
+}
+
+# the values of each column, by name
+sub by_column {
+  my ( $header, $rows ) = @_;
+  my %column;
+  for my $i ( 0 .. $#$header ) {
+    $column{ $header->[$i] } = [ map { $_->[$i] } @$rows ];
+  }
+  return \%column;
+}
+
+sub annotate {
+  my ( $out, %opt ) = @_;
+  $package->new(
+    {
+      config_file => $ga_config,
+      snpfile     => $snpfile,
+      out_file    => "$dir/$out",
+      file_type   => 'snp_2',
+      %opt
+    }
+  )->annotate_snpfile;
+  return read_rows("$dir/$out");
+}
+
+my ( $perlHeader, $perlRows ) = annotate('perl.txt');
+ok( scalar @$perlRows, 'perl annotated the snpfile' );
+my $perl = by_column( $perlHeader, $perlRows );
+
+# genome_annotate alone: the genome-sized track columns of the perl output,
+#   in its order, with its values
+{
+  my $annotator = Seq::Annotate->new_with_config( { configfile => $ga_config } );
+  my $out = "$dir/engine.txt";
+  is( system( "$engine", $annotator->genome_annotate_args, '--in', $snpfile, '--out', $out,
+      '--threads', 2 ),
+    0, 'genome_annotate ran' );
+  my ( $header, $rows ) = read_rows($out);
+  my %at = map { $perlHeader->[$_] => $_ } 0 .. $#$perlHeader;
+  my @missing = grep { !exists $at{$_} } @$header;
+  is( "@missing", '', 'genome_annotate has no column perl lacks' );
+  is_deeply( [ sort { $at{$a} <=> $at{$b} } grep { exists $at{$_} } @$header ],
+    $header, 'its columns are in the order of the perl header' );
+  is( scalar @$rows, scalar @$perlRows, 'it has a row for each perl row' );
+  my $columns = by_column( $header, $rows );
+  is_deeply( $columns->{$_}, $perl->{$_}, "$_ matches" ) for grep { exists $at{$_} } @$header;
+}
+
+# with the gene and snp records, carriers and statistics added in perl: the
+#   perl output and statistics
+{
+  my ( $header, $rows ) = annotate( 'native.txt', genome_annotate => "$engine", workers => 2 );
+  is_deeply( $header, $perlHeader, 'the header is the perl header' );
+  is( scalar @$rows, scalar @$perlRows, 'a row for each perl row' );
+  my $native = by_column( $header, $rows );
+  is_deeply( $native->{$_}, $perl->{$_}, "$_ matches" ) for @$header;
+  ok( ( grep { $_ ne 'NA' } @{ $native->{het_ids} }, @{ $native->{hom_ids} } ),
+    'with carriers' );
+
+  my %stats = map { $_ => decode_json( path("$dir/$_.txt.json")->slurp_raw ) } qw/ perl native /;
+  ok( scalar %{ $stats{perl} }, 'perl wrote statistics' );
+  is_deeply( $stats{native}, $stats{perl}, 'the same statistics' );
+}
+
+done_testing();
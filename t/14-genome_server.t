@@ -0,0 +1,67 @@
+use 5.10.0;
+use strict;
+use warnings;
+
+use Path::Tiny;
+use Test::More;
+use YAML qw/ LoadFile /;
+
+# Seq with the genome-sized tracks from genome_server (c/bin) against Seq
+#   with them from the tracks mapped in perl: the same snpfile, the same
+#   output
+
+my $ga_config   = path('./t/hg38_test.yml')->absolute->stringify;
+my $config_href = LoadFile($ga_config);
+my $daemon      = path('./c/bin/genome_server')->absolute;
+
+my ($genome) = grep { $_->{type} eq 'genome' } @{ $config_href->{genome_sized_tracks} };
+my $genome_idx =
+  path( $config_href->{genome_index_dir} )->child( join '.', $genome->{name}, 'genome', 'idx' );
+plan skip_all => 'needs the test assembly built and c/bin/genome_server'
+  unless -f $genome_idx && -x $daemon;
+
+my $package = 'Seq';
+use_ok($package) || die "$package cannot be loaded";
+
+my $dir     = Path::Tiny->tempdir;
+my $snpfile = path('./t/snp_test.snp')->absolute->stringify;
+
+my $annotator = Seq::Annotate->new_with_config( { configfile => $ga_config } );
+my $manifest = $dir->child('manifest');
+$manifest->spew( $annotator->genome_server_manifest );
+
+my $socket = $dir->child('server.sock')->stringify;
+my $pid = fork // die "cannot fork: $!";
+if ( !$pid ) {
+  open STDERR, '>', '/dev/null';
+  exec "$daemon", '--socket', $socket, '--manifest', "$manifest", '--threads', 2;
+  exit 127;
+}
+END { kill 'TERM', $pid and waitpid $pid, 0 if $pid }
+for ( 1 .. 100 ) { last if -S $socket; select undef, undef, undef, 0.05 }
+ok( -S $socket, 'genome_server serves the test assembly' );
+
+sub annotate {
+  my ( $out, %opt ) = @_;
+  $package->new(
+    {
+      config_file => $ga_config,
+      snpfile     => $snpfile,
+      out_file    => "$dir/$out",
+      file_type   => 'snp_2',
+      %opt
+    }
+  )->annotate_snpfile;
+  return [ path("$dir/$out")->lines ];
+}
+
+my $perl   = annotate('perl.txt');
+my $served = annotate( 'served.txt', genome_server => $socket );
+ok( @$perl > 1, 'perl annotated the snpfile' );
+is_deeply( $served, $perl, 'the same annotation with the tracks from genome_server' );
+
+# a forked worker has a connection of its own
+my $workers = annotate( 'workers.txt', genome_server => $socket, workers => 2 );
+is_deeply( $workers, $perl, 'and with workers' );
+
+done_testing();